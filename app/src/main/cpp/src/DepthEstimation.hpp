@@ -1,18 +1,31 @@
 #pragma once
 
 #include "onnx/OnnxRuntime.hpp"
+#include "processing/LazyDepth.hpp"
+#include "processing/MotionGate.hpp"
+#include "processing/Postprocessing.hpp"
+#include "processing/Preprocessing.hpp"
+#include "processing/RobustNormalization.hpp"
 #include "tflite/TfLiteRuntime.hpp"
 #include "utils/Exceptions.hpp"
 #include <span>
+#include <vector>
 
-constexpr size_t RGB_CHANNELS = 3;
+/// how the output of a model is mapped to relative depth
+struct DepthNormalization {
+	/// min_max_scaling if null
+	RobustDepthNormalizer* robust_normalizer = nullptr;
+	/// runs the robust normalization
+	ThreadPool* thread_pool = nullptr;
+};
 
 void run_depth_estimation(
 	TfLiteRuntime& tflite_runtime,
 	std::span<float> input,
 	std::span<float> output,
 	std::array<float, RGB_CHANNELS> mean,
-	std::array<float, RGB_CHANNELS> stddev
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
 );
 
 void run_depth_estimation(
@@ -20,23 +33,95 @@ void run_depth_estimation(
 	std::span<float> input_data,
 	std::span<float> output_data,
 	std::array<float, RGB_CHANNELS> mean,
-	std::array<float, RGB_CHANNELS> stddev
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
 );
 
-/// normalizes rgb input values (3 floats for r, g and b) based on their mean
-/// and standard deviation values
-void normalize_rgb(
-	std::span<float> values,
+/// runs a model with append_depth_postprocessing, which writes the
+/// colormapped depth as argb ints (of the downscaled size) in the same run
+void run_depth_colormap_estimation(
+	OnnxRuntime& onnx_runtime,
+	std::span<float> input_data,
+	std::span<int32_t> pixels,
 	std::array<float, RGB_CHANNELS> mean,
 	std::array<float, RGB_CHANNELS> stddev
 );
 
-/// rescales values from [min, max] to [0, 1]
-void min_max_scaling(std::span<float> values);
+/// runs the depth estimation but only reduces the range of the output (or
+/// updates the robust bounds), the output stays in the output buffer of the
+/// runtime (valid until its next inference)
+LazyDepthFrame run_lazy_depth_estimation(
+	TfLiteRuntime& tflite_runtime,
+	std::span<float> input,
+	size_t output_width,
+	size_t output_height,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
+);
+
+LazyDepthFrame run_lazy_depth_estimation(
+	OnnxRuntime& onnx_runtime,
+	std::span<float> input_data,
+	size_t output_width,
+	size_t output_height,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
+);
 
-/// computes the int representation of the inferno colormap of the depth at each
-/// pixel
-void depth_colormap(
-	std::span<const float> depth_values,
-	std::span<int> colormapped_pixels
+/// runs batch_size frames (stored after each other in inputs) in a single
+/// invoke, returns the depth of each frame as a span into outputs. the frames
+/// are normalized one after the other, like consecutive single frames
+std::vector<std::span<float>> run_depth_estimation_batch(
+	TfLiteRuntime& tflite_runtime,
+	std::span<float> inputs,
+	std::span<float> outputs,
+	size_t batch_size,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
+);
+
+/// runs batch_size frames (stored after each other in inputs) in a single
+/// run, returns the depth of each frame as a span into outputs. the model
+/// needs a dynamic batch dimension
+std::vector<std::span<float>> run_depth_estimation_batch(
+	OnnxRuntime& onnx_runtime,
+	std::span<float> inputs,
+	std::span<float> outputs,
+	size_t batch_size,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
+);
+
+/// runs the depth estimation only if the motion gate detects a changed scene,
+/// otherwise the output is the (shifted) depth of the last inference. the
+/// input is interleaved rgb with values between 0 and 255
+DepthSource run_depth_estimation(
+	MotionGate& motion_gate,
+	TfLiteRuntime& tflite_runtime,
+	std::span<float> input,
+	size_t input_width,
+	size_t input_height,
+	std::span<float> output,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
+);
+
+/// runs the depth estimation only if the motion gate detects a changed scene,
+/// otherwise the output is the (shifted) depth of the last inference. the
+/// input is planar rgb with values between 0 and 1
+DepthSource run_depth_estimation(
+	MotionGate& motion_gate,
+	OnnxRuntime& onnx_runtime,
+	std::span<float> input_data,
+	size_t input_width,
+	size_t input_height,
+	std::span<float> output_data,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const DepthNormalization& normalization = {}
 );
\ No newline at end of file
@@ -1,22 +1,179 @@
 #include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <jni.h>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 #include "DepthEstimation.hpp"
+#include "cache/DepthCache.hpp"
+#include "export/DepthExport.hpp"
+#include "export/MeshExport.hpp"
+#include "onnx/OnnxNormalizationFolding.hpp"
+#include "onnx/OnnxPostprocessing.hpp"
 #include "onnx/OnnxRuntime.hpp"
+#include "processing/Colormaps.hpp"
+#include "processing/DepthRegions.hpp"
+#include "processing/GuidedUpsampling.hpp"
+#include "processing/LazyDepth.hpp"
+#include "processing/RobustNormalization.hpp"
+#include "processing/PointCloud.hpp"
+#include "reconstruction/TsdfVolume.hpp"
+#include "recording/DepthRecording.hpp"
+#include "recording/SessionRecording.hpp"
 #include "tflite/TfLiteRuntime.hpp"
 #include "utils/ImageUtils.hpp"
 #include "utils/Log.hpp"
 #include "utils/NativeJavaScopes.hpp"
 #include "utils/Profiling.hpp"
 
-// these 2 global variables are only used by a single thread from the kotlin
+// these global variables are only used by a single thread from the kotlin
 // side NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
 static std::unique_ptr<TfLiteRuntime> depth_estimation_tflite_runtime = nullptr;
 
 static std::unique_ptr<OnnxRuntime> depth_estimation_onnx_runtime = nullptr;
+
+/// shared by both runtimes, reset whenever a model is loaded
+static MotionGate depth_motion_gate;
+
+/// keeps the point and voxel buffers between the frames. the lock is held
+/// while the points are generated and copied out of the buffers
+static std::mutex point_cloud_generator_mutex;
+static PointCloudGenerator point_cloud_generator;
+
+/// recording is started and stopped from the ui thread, while the camera
+/// thread appends frames
+static std::mutex session_recorder_mutex;
+static std::shared_ptr<SessionRecorder> session_recorder = nullptr;
+
+/// compressed recording of the depth output, same threading as the session
+/// recorder
+static std::mutex depth_recorder_mutex;
+static std::shared_ptr<DepthRecordingWriter> depth_recorder = nullptr;
+
+/// opened from the ui thread, used by the depth thread
+static std::mutex depth_cache_mutex;
+static std::shared_ptr<DepthCache> depth_cache = nullptr;
+
+/// exports run on the io threads of the kotlin side, the pool is created on
+/// the first export
+static std::mutex export_thread_pool_mutex;
+static std::unique_ptr<ThreadPool> export_thread_pool = nullptr;
+
+/// created from the ui thread, integrated by the depth thread and meshed on
+/// demand
+static std::mutex tsdf_volume_mutex;
+static std::shared_ptr<TsdfVolume> tsdf_volume = nullptr;
+
+/// buffers of the depth upsampling, only used by the depth thread
+static GuidedDepthUpsampler depth_upsampler;
+
+/// summed area table of the bokeh effect, only used by the depth thread
+static DepthBokehRenderer depth_bokeh_renderer;
+
+/// rebuilt by the depth thread after every inference while enabled, queried
+/// from any thread
+static std::atomic_bool depth_region_index_enabled = false;
+static std::mutex depth_region_index_mutex;
+static DepthRegionIndex depth_region_index;
+
+/// output of the last lazy inference, a view into the output buffer of the
+/// runtime. the lock is held during lazy inferences, as they overwrite it
+static std::mutex lazy_depth_mutex;
+static LazyDepthFrame lazy_depth;
+
+/// robust normalization of the inference outputs, only used by the depth
+/// thread. the configuration of the ui thread is applied before the next
+/// inference, and the histogram is published after every inference
+static RobustDepthNormalizer robust_normalizer;
+static bool robust_normalizer_enabled = false;
+static std::mutex robust_normalization_mutex;
+static bool robust_normalization_enabled = false;
+static std::optional<RobustNormalizationOptions> robust_normalization_options;
+/// the options of the last configuration, kept for the depth cache keys
+static RobustNormalizationOptions configured_robust_normalization_options;
+static DepthHistogram published_depth_histogram;
+static RawDepthRange published_depth_bounds;
+static bool depth_histogram_published = false;
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
+/// appends the depth output to the depth recording, if one was started
+static void record_depth(std::span<const float> depth, size_t width, size_t height) {
+	std::shared_ptr<DepthRecordingWriter> recorder;
+	{
+		const std::scoped_lock lock(depth_recorder_mutex);
+		recorder = depth_recorder;
+	}
+	if (recorder == nullptr)
+		return;
+
+	const auto timestamp = std::chrono::steady_clock::now().time_since_epoch();
+	LOG_ON_EXCEPTION(recorder->write_frame(
+		depth, width, height,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp).count()
+	);)
+}
+
+/// threads of the data parallel stages after the inference (robust
+/// normalization, tsdf integration, depth upsampling)
+constexpr size_t DEPTH_THREAD_COUNT = 3;
+
+static ThreadPool& get_depth_thread_pool() {
+	// created on first use, the stages run on the depth thread
+	static ThreadPool thread_pool(DEPTH_THREAD_COUNT);
+	return thread_pool;
+}
+
+/// applies the configuration of the ui thread, returns the normalization of
+/// the next inference. only called by the depth thread
+static DepthNormalization get_depth_normalization() {
+	{
+		const std::scoped_lock lock(robust_normalization_mutex);
+		robust_normalizer_enabled = robust_normalization_enabled;
+		if (robust_normalization_options.has_value()) {
+			robust_normalizer.set_options(*robust_normalization_options);
+			robust_normalizer.reset();
+			robust_normalization_options.reset();
+		}
+	}
+	if (!robust_normalizer_enabled)
+		return {};
+	return {
+		.robust_normalizer = &robust_normalizer,
+		.thread_pool = &get_depth_thread_pool(),
+	};
+}
+
+/// copies the histogram of the last inference for the ui thread
+static void publish_depth_histogram() {
+	if (!robust_normalizer_enabled)
+		return;
+
+	const std::scoped_lock lock(robust_normalization_mutex);
+	published_depth_histogram = robust_normalizer.get_histogram();
+	published_depth_bounds = robust_normalizer.get_bounds();
+	depth_histogram_published = true;
+}
+
+/// the next inference or shutdown of the runtimes overwrites the buffer that
+/// the lazy depth points into
+static void invalidate_lazy_depth() {
+	const std::scoped_lock lock(lazy_depth_mutex);
+	lazy_depth = {};
+}
+
+/// indexes the depth output for region queries, if enabled
+static void index_depth(std::span<const float> depth, size_t width, size_t height) {
+	if (!depth_region_index_enabled)
+		return;
+
+	const std::scoped_lock lock(depth_region_index_mutex);
+	LOG_ON_EXCEPTION(depth_region_index.build(depth, width, height);)
+}
+
 // NOLINTBEGIN(readability-identifier-naming,
 // bugprone-easily-swappable-parameters)
 
@@ -35,6 +192,7 @@ Java_com_example_depthcamera_NativeLib_initDepthTfLiteRuntime(
 	);
 	const NativeStringScope model_token_string(env, model_token);
 
+	depth_motion_gate.reset();
 	LOG_ON_EXCEPTION(
 		depth_estimation_tflite_runtime = std::make_unique<TfLiteRuntime>(
 			model_data, gpu_delegate_serialization_dir_string,
@@ -48,14 +206,17 @@ Java_com_example_depthcamera_NativeLib_shutdownDepthTfLiteRuntime(
 	JNIEnv* /*env*/,
 	jobject /*thiz*/
 ) {
+	invalidate_lazy_depth();
 	depth_estimation_tflite_runtime.reset(nullptr);
 }
 
-extern "C" JNIEXPORT void JNICALL
+extern "C" JNIEXPORT jint JNICALL
 Java_com_example_depthcamera_NativeLib_runDepthTfLiteInference(
 	JNIEnv* env,
 	jobject /*thiz*/,
 	jfloatArray input,
+	jint input_width,
+	jint input_height,
 	jfloatArray output,
 	jfloat mean_r,
 	jfloat mean_g,
@@ -66,32 +227,88 @@ Java_com_example_depthcamera_NativeLib_runDepthTfLiteInference(
 ) {
 	if (depth_estimation_tflite_runtime == nullptr) {
 		LOG_ERROR("TfLiteRuntime not initialized!");
-		return;
+		return (jint)DepthSource::Fresh;
 	}
 
 	NativeFloatArrayScope input_array(env, input);
 	NativeFloatArrayScope output_array(env, output);
+	PROFILE_DEPTH_MEMORY(
+		"JNI inference buffers",
+		(input_array.size() + output_array.size()) * sizeof(float)
+	)
 
 	const std::array<float, 3> mean = {mean_r, mean_g, mean_b};
 	const std::array<float, 3> stddev = {stddev_r, stddev_g, stddev_b};
 
-	LOG_ON_EXCEPTION(run_depth_estimation(
-						 *depth_estimation_tflite_runtime, input_array,
-						 output_array, mean, stddev
-	);)
+	invalidate_lazy_depth();
+	std::optional<DepthSource> source;
+	LOG_ON_EXCEPTION(
+		source = run_depth_estimation(
+			depth_motion_gate, *depth_estimation_tflite_runtime, input_array,
+			(size_t)input_width, (size_t)input_height, output_array, mean,
+			stddev, get_depth_normalization()
+		);
+	)
+	// the output of a failed inference is stale or partially written, it
+	// must not end up in the histogram, the recording or the depth index
+	if (!source.has_value())
+		return (jint)DepthSource::Fresh;
+	publish_depth_histogram();
+	record_depth(output_array, (size_t)input_width, (size_t)input_height);
+	index_depth(output_array, (size_t)input_width, (size_t)input_height);
+	return (jint)*source;
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_depthcamera_NativeLib_initDepthOnnxRuntime(
 	JNIEnv* env,
 	jobject /*thiz*/,
-	jbyteArray model
+	jbyteArray model,
+	jstring model_name,
+	jstring model_cache_dir,
+	jstring model_token,
+	jfloat mean_r,
+	jfloat mean_g,
+	jfloat mean_b,
+	jfloat stddev_r,
+	jfloat stddev_g,
+	jfloat stddev_b,
+	jint display_colormap,
+	jint display_lut_size,
+	jint display_downscale
 ) {
 	NativeByteArrayScope model_data(env, model);
+	const NativeStringScope model_name_string(env, model_name);
+	const NativeStringScope model_cache_dir_string(env, model_cache_dir);
+	const NativeStringScope model_token_string(env, model_token);
 
+	const auto model_bytes = std::as_bytes((std::span<const jbyte>)model_data);
+	depth_motion_gate.reset();
 	LOG_ON_EXCEPTION(
+		// models whose normalization can't be folded run as they are, their
+		// input is normalized at run time by normalize_onnx_input
+		const auto folded_model = load_normalization_folded_model(
+			model_bytes, {mean_r, mean_g, mean_b},
+			{stddev_r, stddev_g, stddev_b},
+			std::string_view(model_cache_dir_string), model_token_string
+		);
+		auto session_model = model_bytes;
+		if (folded_model.has_value())
+			session_model = *folded_model;
+		// display models output colormapped pixels instead of depth
+		std::vector<std::byte> display_model;
+		if (display_colormap >= 0) {
+			display_model = append_depth_postprocessing(
+				session_model,
+				{.downscale_factor = (size_t)display_downscale,
+				 .colormap = (Colormap)display_colormap,
+				 .resolution = (ColormapResolution)display_lut_size}
+			);
+		}
 		depth_estimation_onnx_runtime = std::make_unique<OnnxRuntime>(
-			std::as_bytes((std::span<const jbyte>)model_data)
+			display_model.empty() ? session_model
+								  : std::span<const std::byte>(display_model),
+			model_name_string
 		);
 	)
 }
@@ -101,14 +318,17 @@ Java_com_example_depthcamera_NativeLib_shutdownDepthOnnxRuntime(
 	JNIEnv* /*env*/,
 	jobject /*thiz*/
 ) {
+	invalidate_lazy_depth();
 	depth_estimation_onnx_runtime.reset(nullptr);
 }
 
-extern "C" JNIEXPORT void JNICALL
+extern "C" JNIEXPORT jint JNICALL
 Java_com_example_depthcamera_NativeLib_runDepthOnnxInference(
 	JNIEnv* env,
 	jobject /*thiz*/,
 	jfloatArray input_data,
+	jint input_width,
+	jint input_height,
 	jfloatArray output_data,
 	jfloat mean_r,
 	jfloat mean_g,
@@ -119,19 +339,834 @@ Java_com_example_depthcamera_NativeLib_runDepthOnnxInference(
 ) {
 	if (depth_estimation_onnx_runtime == nullptr) {
 		LOG_ERROR("OnnxRuntime not initialized!");
-		return;
+		return (jint)DepthSource::Fresh;
 	}
 
 	NativeFloatArrayScope input_array(env, input_data);
 	NativeFloatArrayScope output_array(env, output_data);
+	PROFILE_DEPTH_MEMORY(
+		"JNI inference buffers",
+		(input_array.size() + output_array.size()) * sizeof(float)
+	)
 
 	const std::array<float, 3> mean = {mean_r, mean_g, mean_b};
 	const std::array<float, 3> stddev = {stddev_r, stddev_g, stddev_b};
 
-	LOG_ON_EXCEPTION(run_depth_estimation(
-						 *depth_estimation_onnx_runtime, input_array,
-						 output_array, mean, stddev
-	);)
+	invalidate_lazy_depth();
+	std::optional<DepthSource> source;
+	LOG_ON_EXCEPTION(
+		source = run_depth_estimation(
+			depth_motion_gate, *depth_estimation_onnx_runtime, input_array,
+			(size_t)input_width, (size_t)input_height, output_array, mean,
+			stddev, get_depth_normalization()
+		);
+	)
+	// the output of a failed inference is stale or partially written, it
+	// must not end up in the histogram, the recording or the depth index
+	if (!source.has_value())
+		return (jint)DepthSource::Fresh;
+	publish_depth_histogram();
+	record_depth(output_array, (size_t)input_width, (size_t)input_height);
+	index_depth(output_array, (size_t)input_width, (size_t)input_height);
+	return (jint)*source;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_runDepthOnnxColormapInference(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray input_data,
+	jintArray colormapped_pixels,
+	jfloat mean_r,
+	jfloat mean_g,
+	jfloat mean_b,
+	jfloat stddev_r,
+	jfloat stddev_g,
+	jfloat stddev_b
+) {
+	if (depth_estimation_onnx_runtime == nullptr) {
+		LOG_ERROR("OnnxRuntime not initialized!");
+		return JNI_FALSE;
+	}
+
+	NativeFloatArrayScope input_array(env, input_data);
+	NativeIntArrayScope pixel_array(env, colormapped_pixels);
+
+	LOG_ON_EXCEPTION(
+		run_depth_colormap_estimation(
+			*depth_estimation_onnx_runtime, input_array, pixel_array,
+			{mean_r, mean_g, mean_b}, {stddev_r, stddev_g, stddev_b}
+		);
+		return JNI_TRUE;
+	)
+	return JNI_FALSE;
+}
+
+/// runs the lazy inference of either runtime into the lazy depth
+template<typename Runtime>
+static jboolean run_lazy_inference(
+	JNIEnv* env,
+	Runtime& runtime,
+	jfloatArray input,
+	jint input_width,
+	jint input_height,
+	std::array<float, 3> mean,
+	std::array<float, 3> stddev
+) {
+	NativeFloatArrayScope input_array(env, input);
+
+	const std::scoped_lock lock(lazy_depth_mutex);
+	lazy_depth = {};
+	LOG_ON_EXCEPTION(
+		lazy_depth = run_lazy_depth_estimation(
+			runtime, input_array, (size_t)input_width, (size_t)input_height,
+			mean, stddev, get_depth_normalization()
+		);
+	)
+	publish_depth_histogram();
+	return lazy_depth.is_valid() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_runDepthTfLiteLazyInference(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray input,
+	jint input_width,
+	jint input_height,
+	jfloat mean_r,
+	jfloat mean_g,
+	jfloat mean_b,
+	jfloat stddev_r,
+	jfloat stddev_g,
+	jfloat stddev_b
+) {
+	if (depth_estimation_tflite_runtime == nullptr) {
+		LOG_ERROR("TfLiteRuntime not initialized!");
+		return JNI_FALSE;
+	}
+
+	return run_lazy_inference(
+		env, *depth_estimation_tflite_runtime, input, input_width,
+		input_height, {mean_r, mean_g, mean_b},
+		{stddev_r, stddev_g, stddev_b}
+	);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_runDepthOnnxLazyInference(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray input_data,
+	jint input_width,
+	jint input_height,
+	jfloat mean_r,
+	jfloat mean_g,
+	jfloat mean_b,
+	jfloat stddev_r,
+	jfloat stddev_g,
+	jfloat stddev_b
+) {
+	if (depth_estimation_onnx_runtime == nullptr) {
+		LOG_ERROR("OnnxRuntime not initialized!");
+		return JNI_FALSE;
+	}
+
+	return run_lazy_inference(
+		env, *depth_estimation_onnx_runtime, input_data, input_width,
+		input_height, {mean_r, mean_g, mean_b},
+		{stddev_r, stddev_g, stddev_b}
+	);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_sampleLazyDepth(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray points,
+	jfloatArray results
+) {
+	const NativeFloatArrayScope point_array(env, points);
+	NativeFloatArrayScope result_array(env, results);
+	const std::span<const float> point_values = point_array;
+	const std::span<float> result_values = result_array;
+
+	const size_t point_count = point_values.size() / 2;
+	if (result_values.size() < point_count) {
+		LOG_ERROR("sampleLazyDepth: results need a value per point");
+		return JNI_FALSE;
+	}
+
+	const std::scoped_lock lock(lazy_depth_mutex);
+	if (!lazy_depth.is_valid())
+		return JNI_FALSE;
+
+	for (size_t i = 0; i < point_count; i++) {
+		result_values[i] =
+			lazy_depth.sample(point_values[i * 2], point_values[i * 2 + 1]);
+	}
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_sampleLazyDepthRegions(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jintArray regions,
+	jfloatArray results
+) {
+	const NativeIntArrayScope region_array(env, regions);
+	NativeFloatArrayScope result_array(env, results);
+	const std::span<const jint> region_values = region_array;
+	const std::span<float> result_values = result_array;
+
+	const size_t region_count = region_values.size() / 4;
+	if (result_values.size() < region_count * 3) {
+		LOG_ERROR("sampleLazyDepthRegions: results need 3 values per region");
+		return JNI_FALSE;
+	}
+
+	const std::scoped_lock lock(lazy_depth_mutex);
+	if (!lazy_depth.is_valid())
+		return JNI_FALSE;
+
+	bool success = false;
+	LOG_ON_EXCEPTION(
+		for (size_t i = 0; i < region_count; i++) {
+			const auto* box = &region_values[i * 4];
+			const auto stats = lazy_depth.sample_region({
+				.x = (size_t)std::max(box[0], 0),
+				.y = (size_t)std::max(box[1], 0),
+				.width = (size_t)std::max(box[2], 0),
+				.height = (size_t)std::max(box[3], 0),
+			});
+			auto* result = &result_values[i * 3];
+			result[0] = stats.mean;
+			result[1] = stats.min;
+			result[2] = stats.max;
+		}
+		success = true;
+	)
+	return success ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_lazyDepth(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray output
+) {
+	NativeFloatArrayScope output_array(env, output);
+
+	const std::scoped_lock lock(lazy_depth_mutex);
+	if (!lazy_depth.is_valid())
+		return JNI_FALSE;
+
+	bool success = false;
+	LOG_ON_EXCEPTION(lazy_depth.normalize(output_array); success = true;)
+	return success ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_lazyDepthColormap(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jintArray colormapped_pixels
+) {
+	NativeIntArrayScope colormapped_pixel_array(env, colormapped_pixels);
+
+	const std::scoped_lock lock(lazy_depth_mutex);
+	if (!lazy_depth.is_valid())
+		return JNI_FALSE;
+
+	bool success = false;
+	LOG_ON_EXCEPTION(
+		lazy_depth.colormap(colormapped_pixel_array);
+		success = true;
+	)
+	return success ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_configureDepthMotionGate(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jboolean enabled,
+	jfloat block_change_threshold,
+	jfloat max_changed_block_fraction,
+	jboolean warp_cached_depth,
+	jint max_reused_frames
+) {
+	depth_motion_gate.set_options({
+		.enabled = enabled == JNI_TRUE,
+		.block_change_threshold = block_change_threshold,
+		.max_changed_block_fraction = max_changed_block_fraction,
+		.warp_cached_depth = warp_cached_depth == JNI_TRUE,
+		.max_reused_frames = (size_t)std::max(max_reused_frames, 0),
+	});
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_configureRobustNormalization(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jboolean enabled,
+	jfloat low_percentile,
+	jfloat high_percentile,
+	jfloat bounds_smoothing
+) {
+	const std::scoped_lock lock(robust_normalization_mutex);
+	robust_normalization_enabled = enabled == JNI_TRUE;
+	configured_robust_normalization_options = RobustNormalizationOptions{
+		.low_percentile = std::clamp(low_percentile, 0.0f, 1.0f),
+		.high_percentile = std::clamp(high_percentile, 0.0f, 1.0f),
+		.bounds_smoothing = std::clamp(bounds_smoothing, 0.0f, 1.0f),
+	};
+	robust_normalization_options = configured_robust_normalization_options;
+	depth_histogram_published = false;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_depthHistogram(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jintArray bins,
+	jfloatArray ranges
+) {
+	NativeIntArrayScope bin_array(env, bins);
+	NativeFloatArrayScope range_array(env, ranges);
+	const std::span<jint> bin_values = bin_array;
+	const std::span<float> range_values = range_array;
+
+	if (bin_values.size() != DepthHistogram::BIN_COUNT + 2 ||
+		range_values.size() != 6) {
+		LOG_ERROR(
+			"depthHistogram: bins need {} values and ranges 6",
+			DepthHistogram::BIN_COUNT + 2
+		);
+		return JNI_FALSE;
+	}
+
+	const std::scoped_lock lock(robust_normalization_mutex);
+	if (!depth_histogram_published)
+		return JNI_FALSE;
+
+	const auto& histogram = published_depth_histogram;
+	const auto to_jint = [](uint32_t count) {
+		return (jint)std::min<uint32_t>(count, INT32_MAX);
+	};
+	bin_values.front() = to_jint(histogram.underflow);
+	std::ranges::transform(
+		histogram.bins, bin_values.begin() + 1, to_jint
+	);
+	bin_values.back() = to_jint(histogram.overflow);
+
+	range_values[0] = histogram.bin_min;
+	range_values[1] = histogram.bin_max;
+	range_values[2] = histogram.min;
+	range_values[3] = histogram.max;
+	range_values[4] = published_depth_bounds.min;
+	range_values[5] = published_depth_bounds.max;
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_startDepthRecording(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jstring path
+) {
+	const NativeStringScope path_scope(env, path);
+	const std::string recording_path(std::string_view{path_scope});
+
+	LOG_ON_EXCEPTION(
+		auto recorder = std::make_shared<DepthRecordingWriter>(recording_path);
+		const std::scoped_lock lock(depth_recorder_mutex);
+		depth_recorder = std::move(recorder);
+		LOG_INFO("recording depth to {}", recording_path);
+	)
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_stopDepthRecording(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	std::shared_ptr<DepthRecordingWriter> recorder;
+	{
+		const std::scoped_lock lock(depth_recorder_mutex);
+		recorder = std::exchange(depth_recorder, nullptr);
+	}
+	if (recorder != nullptr)
+		LOG_INFO(
+			"recorded {} depth frames ({} bytes)", recorder->frame_count(),
+			recorder->written_bytes()
+		);
+	// the index is written once the depth thread released the recorder
+}
+
+static std::shared_ptr<DepthCache> get_depth_cache() {
+	const std::scoped_lock lock(depth_cache_mutex);
+	if (depth_cache == nullptr)
+		LOG_ERROR("DepthCache not opened!");
+	return depth_cache;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_openDepthCache(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jstring directory,
+	jlong max_bytes
+) {
+	const NativeStringScope directory_scope(env, directory);
+	const std::string cache_directory(std::string_view{directory_scope});
+
+	LOG_ON_EXCEPTION(
+		auto cache = std::make_shared<DepthCache>(
+			cache_directory, (size_t)std::max<jlong>(max_bytes, 0)
+		);
+		const std::scoped_lock lock(depth_cache_mutex);
+		depth_cache = std::move(cache);
+	)
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_depthcamera_NativeLib_depthCacheKey(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jobject bitmap,
+	jstring model_token,
+	jint input_width,
+	jint input_height,
+	jfloat mean_r,
+	jfloat mean_g,
+	jfloat mean_b,
+	jfloat stddev_r,
+	jfloat stddev_g,
+	jfloat stddev_b
+) {
+	const NativeStringScope model_token_scope(env, model_token);
+	DepthCacheParameters parameters{
+		.input_width = (size_t)input_width,
+		.input_height = (size_t)input_height,
+		.mean = {mean_r, mean_g, mean_b},
+		.stddev = {stddev_r, stddev_g, stddev_b},
+	};
+	{
+		// the normalization that the next inference applies
+		const std::scoped_lock lock(robust_normalization_mutex);
+		parameters.robust_normalization = robust_normalization_enabled;
+		const auto& options = configured_robust_normalization_options;
+		parameters.low_percentile = options.low_percentile;
+		parameters.high_percentile = options.high_percentile;
+		parameters.bounds_smoothing = options.bounds_smoothing;
+	}
+
+	// null tells the caller to skip the cache, a default key would be shared
+	// by every failed call
+	std::optional<DepthCacheKey> key;
+	LOG_ON_EXCEPTION(
+		const AndroidBitmapPixels locked_pixels(env, bitmap);
+		const auto image = locked_pixels.image();
+
+		// row padding is not part of the image content
+		const size_t row_bytes = image.width * 4;
+		std::span<const uint8_t> pixels = image.pixels;
+		std::vector<uint8_t> packed_pixels;
+		if (image.stride != row_bytes) {
+			packed_pixels.resize(row_bytes * image.height);
+			for (size_t y = 0; y < image.height; y++)
+				std::copy_n(
+					pixels.begin() + (ptrdiff_t)(y * image.stride), row_bytes,
+					packed_pixels.begin() + (ptrdiff_t)(y * row_bytes)
+				);
+			pixels = packed_pixels;
+		}
+
+		key = compute_depth_cache_key(
+			pixels, image.width, image.height, model_token_scope, parameters
+		);
+	)
+	if (!key.has_value())
+		return nullptr;
+
+	const std::array<jlong, 2> key_values = {
+		(jlong)key->high, (jlong)key->low
+	};
+	jlongArray key_array = env->NewLongArray(key_values.size());
+	env->SetLongArrayRegion(
+		key_array, 0, key_values.size(), key_values.data()
+	);
+	return key_array;
+}
+
+static DepthCacheKey depth_cache_key_from_java(JNIEnv* env, jlongArray key) {
+	std::array<jlong, 2> key_values{};
+	env->GetLongArrayRegion(key, 0, key_values.size(), key_values.data());
+	return DepthCacheKey{
+		.high = (uint64_t)key_values[0],
+		.low = (uint64_t)key_values[1],
+	};
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_depthCacheLoad(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jlongArray key,
+	jfloatArray depth,
+	jint width,
+	jint height
+) {
+	const auto cache = get_depth_cache();
+	if (cache == nullptr)
+		return JNI_FALSE;
+
+	const auto cache_key = depth_cache_key_from_java(env, key);
+	NativeFloatArrayScope depth_array(env, depth);
+
+	bool loaded = false;
+	LOG_ON_EXCEPTION(
+		loaded = cache->load(
+			cache_key, depth_array, (size_t)width, (size_t)height
+		);
+	)
+	return loaded ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_depthCacheStore(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jlongArray key,
+	jfloatArray depth,
+	jint width,
+	jint height
+) {
+	const auto cache = get_depth_cache();
+	if (cache == nullptr)
+		return;
+
+	const auto cache_key = depth_cache_key_from_java(env, key);
+	NativeFloatArrayScope depth_array(env, depth);
+
+	LOG_ON_EXCEPTION(
+		cache->store(cache_key, depth_array, (size_t)width, (size_t)height);
+	)
+}
+
+/// threads that filter and deflate the strips of exported pngs
+constexpr size_t EXPORT_THREAD_COUNT = 3;
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_exportDepthPng(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint width,
+	jint height,
+	jint fd
+) {
+	NativeFloatArrayScope depth_array(env, depth);
+
+	bool exported = false;
+	LOG_ON_EXCEPTION(
+		// the pool only runs one parallel_for at a time
+		const std::scoped_lock lock(export_thread_pool_mutex);
+		if (export_thread_pool == nullptr)
+			export_thread_pool =
+				std::make_unique<ThreadPool>(EXPORT_THREAD_COUNT);
+		write_depth_png(
+			fd, depth_array, (size_t)width, (size_t)height, *export_thread_pool
+		);
+		exported = true;
+	)
+	return exported ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_exportDepthPfm(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint width,
+	jint height,
+	jint fd
+) {
+	NativeFloatArrayScope depth_array(env, depth);
+
+	bool exported = false;
+	LOG_ON_EXCEPTION(
+		write_depth_pfm(fd, depth_array, (size_t)width, (size_t)height);
+		exported = true;
+	)
+	return exported ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_depthcamera_NativeLib_depthToPointCloud(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint width,
+	jint height,
+	jintArray colors,
+	jfloat fx,
+	jfloat fy,
+	jfloat cx,
+	jfloat cy,
+	jboolean inverse_depth,
+	jfloat scale,
+	jfloat shift,
+	jfloat max_depth,
+	jfloat voxel_size,
+	jfloatArray out_points
+) {
+	const NativeFloatArrayScope depth_array(env, depth);
+	const NativeIntArrayScope colors_array(env, colors);
+	const PointCloudOptions options{
+		.intrinsics = {.fx = fx, .fy = fy, .cx = cx, .cy = cy},
+		.encoding = inverse_depth == JNI_TRUE ? DepthEncoding::InverseDepth
+											  : DepthEncoding::Depth,
+		.scale = scale,
+		.shift = shift,
+		.max_depth = max_depth,
+		.voxel_size = voxel_size,
+	};
+
+	jint point_count = 0;
+	LOG_ON_EXCEPTION(
+		const std::scoped_lock lock(point_cloud_generator_mutex);
+		const auto points = point_cloud_generator.generate(
+			depth_array, (size_t)width, (size_t)height, colors_array, options
+		);
+		// the points are copied as they are, 4 floats each
+		const size_t max_points = (size_t)env->GetArrayLength(out_points) / 4;
+		point_count = (jint)std::min(points.size(), max_points);
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		env->SetFloatArrayRegion(
+			out_points, 0, point_count * 4,
+			reinterpret_cast<const jfloat*>(points.data())
+		);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	)
+	return point_count;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_createTsdfVolume(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jfloat voxel_size,
+	jfloat truncation_distance,
+	jint max_blocks
+) {
+	LOG_ON_EXCEPTION(
+		auto volume = std::make_shared<TsdfVolume>(TsdfVolumeOptions{
+			.voxel_size = voxel_size,
+			.truncation_distance = truncation_distance,
+			.max_blocks = (size_t)std::max(max_blocks, 1),
+		});
+		const std::scoped_lock lock(tsdf_volume_mutex);
+		tsdf_volume = std::move(volume);
+	)
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_releaseTsdfVolume(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	const std::scoped_lock lock(tsdf_volume_mutex);
+	tsdf_volume = nullptr;
+}
+
+static std::shared_ptr<TsdfVolume> get_tsdf_volume() {
+	const std::scoped_lock lock(tsdf_volume_mutex);
+	if (tsdf_volume == nullptr)
+		LOG_ERROR("TsdfVolume not created!");
+	return tsdf_volume;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_integrateTsdfFrame(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint width,
+	jint height,
+	jfloat fx,
+	jfloat fy,
+	jfloat cx,
+	jfloat cy,
+	jboolean inverse_depth,
+	jfloat scale,
+	jfloat shift,
+	jfloat max_depth,
+	jfloatArray camera_to_world
+) {
+	const auto volume = get_tsdf_volume();
+	if (volume == nullptr)
+		return;
+
+	const NativeFloatArrayScope depth_array(env, depth);
+	std::array<float, 16> pose_matrix{};
+	env->GetFloatArrayRegion(
+		camera_to_world, 0, pose_matrix.size(), pose_matrix.data()
+	);
+
+	LOG_ON_EXCEPTION(
+		volume->integrate(
+			TsdfFrame{
+				.depth = depth_array,
+				.width = (size_t)width,
+				.height = (size_t)height,
+				.intrinsics = {.fx = fx, .fy = fy, .cx = cx, .cy = cy},
+				.encoding = inverse_depth == JNI_TRUE
+								? DepthEncoding::InverseDepth
+								: DepthEncoding::Depth,
+				.scale = scale,
+				.shift = shift,
+				.max_depth = max_depth,
+				.pose = camera_pose_from_matrix(pose_matrix),
+			},
+			get_depth_thread_pool()
+		);
+	)
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_exportTsdfMesh(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint fd
+) {
+	const auto volume = get_tsdf_volume();
+	if (volume == nullptr)
+		return JNI_FALSE;
+
+	bool exported = false;
+	LOG_ON_EXCEPTION(
+		TsdfMesh mesh;
+		volume->extract_mesh(mesh);
+		write_mesh_ply(fd, mesh.vertices, mesh.triangles);
+		LOG_INFO(
+			"exported mesh with {} triangles from {} blocks",
+			mesh.triangles.size() / 3, volume->block_count()
+		);
+		exported = true;
+	)
+	return exported ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_upsampleDepth(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint depth_width,
+	jint depth_height,
+	jobject guide_bitmap,
+	jfloatArray output,
+	jint radius,
+	jfloat epsilon
+) {
+	const NativeFloatArrayScope depth_array(env, depth);
+	NativeFloatArrayScope output_array(env, output);
+
+	LOG_ON_EXCEPTION(
+		const AndroidBitmapPixels guide(env, guide_bitmap);
+		depth_upsampler.upsample(
+			depth_array, (size_t)depth_width, (size_t)depth_height,
+			guide.image(), output_array, get_depth_thread_pool(),
+			{.radius = (size_t)std::max(radius, 1), .epsilon = epsilon}
+		);
+	)
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_depthBokeh(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jobject image_bitmap,
+	jfloatArray depth,
+	jint depth_width,
+	jint depth_height,
+	jobject output_bitmap,
+	jfloat focus_depth,
+	jfloat focus_range,
+	jint max_radius
+) {
+	const NativeFloatArrayScope depth_array(env, depth);
+
+	LOG_ON_EXCEPTION(
+		const AndroidBitmapPixels image(env, image_bitmap);
+		const AndroidBitmapPixels output(env, output_bitmap);
+		depth_bokeh_renderer.render(
+			image.image(), depth_array, (size_t)depth_width,
+			(size_t)depth_height, output.image(), get_depth_thread_pool(),
+			{
+				.focus_depth = focus_depth,
+				.focus_range = focus_range,
+				.max_radius = (size_t)std::max(max_radius, 0),
+			}
+		);
+	)
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_configureDepthRegionIndex(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jboolean enabled
+) {
+	depth_region_index_enabled = enabled == JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_depthcamera_NativeLib_depthRegionQueries(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jintArray regions,
+	jfloat percentile,
+	jfloatArray results
+) {
+	const NativeIntArrayScope region_array(env, regions);
+	NativeFloatArrayScope result_array(env, results);
+	const std::span<const jint> region_values = region_array;
+	const std::span<float> result_values = result_array;
+
+	const size_t region_count = region_values.size() / 4;
+	if (result_values.size() < region_count * 4) {
+		LOG_ERROR("depthRegionQueries: results need 4 values per region");
+		return JNI_FALSE;
+	}
+
+	const std::scoped_lock lock(depth_region_index_mutex);
+	if (!depth_region_index.is_built())
+		return JNI_FALSE;
+
+	bool success = false;
+	LOG_ON_EXCEPTION(
+		for (size_t i = 0; i < region_count; i++) {
+			const auto* box = &region_values[i * 4];
+			const DepthRegion region{
+				.x = (size_t)std::max(box[0], 0),
+				.y = (size_t)std::max(box[1], 0),
+				.width = (size_t)std::max(box[2], 0),
+				.height = (size_t)std::max(box[3], 0),
+			};
+			const auto stats = depth_region_index.stats(region);
+			auto* result = &result_values[i * 4];
+			result[0] = stats.mean;
+			result[1] = stats.min;
+			result[2] = stats.max;
+			result[3] = depth_region_index.percentile(region, percentile);
+		}
+		success = true;
+	)
+	return success ? JNI_TRUE : JNI_FALSE;
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -143,6 +1178,11 @@ Java_com_example_depthcamera_NativeLib_depthColormap(
 ) {
 	NativeFloatArrayScope depth_value_array(env, depth_values);
 	NativeIntArrayScope colormapped_pixel_array(env, colormapped_pixels);
+	PROFILE_DEPTH_MEMORY(
+		"JNI colormap buffers",
+		depth_value_array.size() * sizeof(float) +
+			colormapped_pixel_array.size() * sizeof(jint)
+	)
 
 	if (depth_value_array.size() == colormapped_pixel_array.size()) {
 		LOG_ON_EXCEPTION(
@@ -157,6 +1197,46 @@ Java_com_example_depthcamera_NativeLib_depthColormap(
 	}
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_depthColormapBitmap(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint width,
+	jint height,
+	jobject bitmap,
+	jint colormap,
+	jint lut_size,
+	jfloat min_depth,
+	jfloat max_depth
+) {
+	if (colormap < 0 || colormap > (jint)Colormap::Grayscale) {
+		LOG_ERROR("unknown colormap {}", colormap);
+		return;
+	}
+	if (lut_size != (jint)ColormapResolution::Entries1024 &&
+		lut_size != (jint)ColormapResolution::Entries4096) {
+		LOG_ERROR("colormap lut size should be 1024 or 4096, not {}", lut_size);
+		return;
+	}
+
+	const NativeFloatArrayScope depth_array(env, depth);
+
+	LOG_ON_EXCEPTION(
+		const AndroidBitmapPixels pixels(env, bitmap);
+		colormap_depth(
+			depth_array, (size_t)std::max(width, 0),
+			(size_t)std::max(height, 0), pixels.image(),
+			{
+				.colormap = (Colormap)colormap,
+				.resolution = (ColormapResolution)lut_size,
+				.min_depth = min_depth,
+				.max_depth = max_depth,
+			}
+		);
+	)
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_depthcamera_NativeLib_bitmapToRgbChwFloatArray(
 	JNIEnv* env,
@@ -166,6 +1246,10 @@ Java_com_example_depthcamera_NativeLib_bitmapToRgbChwFloatArray(
 ) {
 
 	NativeFloatArrayScope out_float_array_scope(env, out_float_array);
+	PROFILE_CAMERA_MEMORY(
+		"JNI bitmap conversion buffer",
+		out_float_array_scope.size() * sizeof(float)
+	)
 
 	LOG_ON_EXCEPTION(
 		bitmap_to_rgb_chw_float_array(env, bitmap, out_float_array_scope);
@@ -181,6 +1265,10 @@ Java_com_example_depthcamera_NativeLib_bitmapToRgbHwc255FloatArray(
 ) {
 
 	NativeFloatArrayScope out_float_array_scope(env, out_float_array);
+	PROFILE_CAMERA_MEMORY(
+		"JNI bitmap conversion buffer",
+		out_float_array_scope.size() * sizeof(float)
+	)
 
 	LOG_ON_EXCEPTION(
 		bitmap_to_rgb_hwc_255_float_array(env, bitmap, out_float_array_scope);
@@ -192,25 +1280,92 @@ Java_com_example_depthcamera_NativeLib_imageBytesToArgbIntArray(
 	JNIEnv* env,
 	jobject /*thiz*/,
 	jbyteArray image_bytes,
+	jint width,
+	jint height,
+	jint rotation_degrees,
+	jlong timestamp_ns,
 	jintArray out_int_array
 ) {
 
 	NativeByteArrayScope image_byte_array(env, image_bytes);
 	NativeIntArrayScope out_int_array_scope(env, out_int_array);
+	PROFILE_CAMERA_MEMORY(
+		"JNI camera conversion buffers",
+		image_byte_array.size() + out_int_array_scope.size() * sizeof(jint)
+	)
+
+	std::shared_ptr<SessionRecorder> recorder;
+	{
+		const std::scoped_lock lock(session_recorder_mutex);
+		recorder = session_recorder;
+	}
+	if (recorder != nullptr) {
+		const std::span<const jbyte> recorded_bytes = image_byte_array;
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		LOG_ON_EXCEPTION(recorder->append_frame(RecordedFrame{
+			.timestamp_ns = timestamp_ns,
+			.width = (uint32_t)width,
+			.height = (uint32_t)height,
+			.rotation_degrees = (uint32_t)rotation_degrees,
+			.pixel_format = RecordedPixelFormat::Rgba8888,
+			.pixels = std::span<const uint8_t>(
+				reinterpret_cast<const uint8_t*>(recorded_bytes.data()),
+				recorded_bytes.size()
+			),
+		});)
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	}
 
 	LOG_ON_EXCEPTION(
 		image_bytes_to_argb_int_array(image_byte_array, out_int_array_scope);
 	)
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_startSessionRecording(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jstring path
+) {
+	const NativeStringScope path_scope(env, path);
+	const std::string recording_path(std::string_view{path_scope});
+
+	LOG_ON_EXCEPTION(
+		auto recorder = std::make_shared<SessionRecorder>(recording_path);
+		const std::scoped_lock lock(session_recorder_mutex);
+		session_recorder = std::move(recorder);
+		LOG_INFO("recording camera session to {}", recording_path);
+	)
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_depthcamera_NativeLib_stopSessionRecording(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	std::shared_ptr<SessionRecorder> recorder;
+	{
+		const std::scoped_lock lock(session_recorder_mutex);
+		recorder = std::exchange(session_recorder, nullptr);
+	}
+	if (recorder != nullptr)
+		LOG_INFO(
+			"recorded {} frames ({} bytes)", recorder->frame_count(),
+			recorder->recorded_bytes()
+		);
+	// the file is finalized once the camera thread released the recorder
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_depthcamera_NativeLib_newDepthFrame(
 	JNIEnv* /*env*/,
 	jobject /*this*/
 ) {
 	LOG_ON_EXCEPTION(
-		get_last_depth_profiling_frame_formatted() =
-			get_depth_profiling_frame().finish();
+		// only sampled frames are formatted, keep showing the last one
+		if (auto formatted = get_depth_profiling_frame().finish()) {
+			get_last_depth_profiling_frame_formatted() = std::move(*formatted);
+		}
 	)
 }
 extern "C" JNIEXPORT jstring JNICALL
@@ -228,8 +1383,10 @@ Java_com_example_depthcamera_NativeLib_newCameraFrame(
 	jobject /*this*/
 ) {
 	LOG_ON_EXCEPTION(
-		get_last_camera_profiling_frame_formatted() =
-			get_camera_profiling_frame().finish();
+		// only sampled frames are formatted, keep showing the last one
+		if (auto formatted = get_camera_profiling_frame().finish()) {
+			get_last_camera_profiling_frame_formatted() = std::move(*formatted);
+		}
 	)
 }
 extern "C" JNIEXPORT jstring JNICALL
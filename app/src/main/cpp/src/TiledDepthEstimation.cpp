@@ -0,0 +1,164 @@
+#include "TiledDepthEstimation.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+TiledDepthEstimator::TiledDepthEstimator(
+	TilingOptions options,
+	size_t runtime_count
+)
+	: options(options), thread_pool(runtime_count),
+	  worker_inputs(thread_pool.worker_count()),
+	  worker_outputs(thread_pool.worker_count()) {}
+
+void TiledDepthEstimator::run(
+	std::span<TfLiteRuntime* const> runtimes,
+	std::span<const float> input,
+	size_t width,
+	size_t height,
+	std::span<float> output,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+) {
+	run_tiled(
+		runtimes, input, ImageLayout::Hwc, width, height, output, mean, stddev
+	);
+}
+
+void TiledDepthEstimator::run(
+	std::span<OnnxRuntime* const> runtimes,
+	std::span<const float> input,
+	size_t width,
+	size_t height,
+	std::span<float> output,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+) {
+	run_tiled(
+		runtimes, input, ImageLayout::Chw, width, height, output, mean, stddev
+	);
+}
+
+template<typename Runtime>
+void TiledDepthEstimator::run_tiled(
+	std::span<Runtime* const> runtimes,
+	std::span<const float> input,
+	ImageLayout layout,
+	size_t width,
+	size_t height,
+	std::span<float> output,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (runtimes.size() < thread_pool.worker_count())
+		throw std::invalid_argument(std::format(
+			"{} runtime instances are needed, got {}",
+			thread_pool.worker_count(), runtimes.size()
+		));
+	if (input.size() != width * height * RGB_CHANNELS)
+		throw std::invalid_argument("input");
+	if (output.size() != width * height)
+		throw std::invalid_argument("output");
+
+	const auto tiles = compute_tile_grid(width, height, options);
+	const size_t tile_pixels = options.tile_width * options.tile_height;
+	const size_t batch_size = std::max<size_t>(options.tile_batch_size, 1);
+
+	// item 0 is the coarse depth of the whole downscaled image, which all
+	// tiles get aligned to, the others are the tiles
+	const size_t item_count = tiles.size() + 1;
+	const size_t batch_count = (item_count + batch_size - 1) / batch_size;
+	item_depths.resize(item_count * tile_pixels);
+	for (auto& worker_input : worker_inputs)
+		worker_input.resize(batch_size * tile_pixels * RGB_CHANNELS);
+	for (auto& worker_output : worker_outputs)
+		worker_output.resize(batch_size * tile_pixels);
+
+	{
+		PROFILE_DEPTH_SCOPE("Inference of tiles")
+
+		thread_pool.parallel_for(batch_count, [&](size_t batch, size_t worker) {
+			auto& batch_input = worker_inputs[worker];
+			auto& batch_output = worker_outputs[worker];
+			const size_t first_item = batch * batch_size;
+			const size_t batch_items =
+				std::min(batch_size, item_count - first_item);
+
+			for (size_t i = 0; i < batch_items; i++) {
+				auto item_input = std::span(batch_input)
+									  .subspan(
+										  i * tile_pixels * RGB_CHANNELS,
+										  tile_pixels * RGB_CHANNELS
+									  );
+				if (first_item + i == 0)
+					resample_bilinear(
+						input, width, height, item_input, options.tile_width,
+						options.tile_height, RGB_CHANNELS, layout
+					);
+				else
+					extract_tile(
+						input, width, height, layout, tiles[first_item + i - 1],
+						item_input
+					);
+			}
+			// the last batch is padded, so that the runtimes never have to
+			// reallocate their tensors for a different batch size
+			std::fill(
+				batch_input.begin() +
+					(ptrdiff_t)(batch_items * tile_pixels * RGB_CHANNELS),
+				batch_input.end(), 0.0f
+			);
+
+			Runtime& runtime = *runtimes[worker];
+			if (batch_size == 1)
+				run_depth_estimation(
+					runtime, batch_input, batch_output, mean, stddev
+				);
+			else
+				(void)run_depth_estimation_batch(
+					runtime, batch_input, batch_output, batch_size, mean, stddev
+				);
+
+			std::copy_n(
+				batch_output.begin(), batch_items * tile_pixels,
+				item_depths.begin() + (ptrdiff_t)(first_item * tile_pixels)
+			);
+		});
+	}
+
+	const auto coarse_depth = std::span(item_depths).first(tile_pixels);
+	const auto tile_depths = std::span(item_depths).subspan(tile_pixels);
+
+	PROFILE_DEPTH_SCOPE("Blending of tiles")
+
+	reference_depth.resize(width * height);
+	resample_bilinear(
+		coarse_depth, options.tile_width, options.tile_height, reference_depth,
+		width, height
+	);
+
+	tile_alignments.resize(tiles.size());
+	thread_pool.parallel_for(tiles.size(), [&](size_t tile, size_t /*worker*/) {
+		tile_alignments[tile] = fit_depth_alignment(
+			tile_depths.subspan(tile * tile_pixels, tile_pixels),
+			tiles[tile], reference_depth, width, options.alignment_stride
+		);
+	});
+
+	depth_sum.assign(width * height, 0.0f);
+	weight_sum.assign(width * height, 0.0f);
+	for (size_t tile = 0; tile < tiles.size(); tile++) {
+		accumulate_feathered_tile(
+			tile_depths.subspan(tile * tile_pixels, tile_pixels),
+			tiles[tile], tile_alignments[tile], options.overlap, width, height,
+			depth_sum, weight_sum
+		);
+	}
+	resolve_feathered_tiles(depth_sum, weight_sum, output);
+
+	min_max_scaling(output);
+}
\ No newline at end of file
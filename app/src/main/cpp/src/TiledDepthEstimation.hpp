@@ -0,0 +1,68 @@
+#pragma once
+
+#include "DepthEstimation.hpp"
+#include "processing/Tiling.hpp"
+#include "utils/ThreadPool.hpp"
+#include <span>
+#include <vector>
+
+/// depth estimation of images that are larger than the model input: the image
+/// is split into overlapping model sized tiles, and the tile depths are
+/// aligned to a coarse depth of the whole (downscaled) image and blended
+class TiledDepthEstimator {
+  public:
+	/// tiles run on one worker thread per runtime instance
+	TiledDepthEstimator(TilingOptions options, size_t runtime_count);
+
+	/// the input is interleaved rgb with values between 0 and 255, the output
+	/// has width * height relative depth values between 0 and 1
+	void run(
+		std::span<TfLiteRuntime* const> runtimes,
+		std::span<const float> input,
+		size_t width,
+		size_t height,
+		std::span<float> output,
+		std::array<float, RGB_CHANNELS> mean,
+		std::array<float, RGB_CHANNELS> stddev
+	);
+
+	/// the input is planar rgb with values between 0 and 1, the output has
+	/// width * height relative depth values between 0 and 1
+	void run(
+		std::span<OnnxRuntime* const> runtimes,
+		std::span<const float> input,
+		size_t width,
+		size_t height,
+		std::span<float> output,
+		std::array<float, RGB_CHANNELS> mean,
+		std::array<float, RGB_CHANNELS> stddev
+	);
+
+	[[nodiscard]] const TilingOptions& get_options() const { return options; }
+
+  private:
+	template<typename Runtime>
+	void run_tiled(
+		std::span<Runtime* const> runtimes,
+		std::span<const float> input,
+		ImageLayout layout,
+		size_t width,
+		size_t height,
+		std::span<float> output,
+		std::array<float, RGB_CHANNELS> mean,
+		std::array<float, RGB_CHANNELS> stddev
+	);
+
+	TilingOptions options;
+	ThreadPool thread_pool;
+
+	// reused between frames
+	std::vector<std::vector<float>> worker_inputs;
+	std::vector<std::vector<float>> worker_outputs;
+	/// coarse depth followed by the depth of every tile
+	std::vector<float> item_depths;
+	std::vector<float> reference_depth;
+	std::vector<DepthAlignment> tile_alignments;
+	std::vector<float> depth_sum;
+	std::vector<float> weight_sum;
+};
\ No newline at end of file
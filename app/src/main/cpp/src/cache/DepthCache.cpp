@@ -0,0 +1,356 @@
+#include "DepthCache.hpp"
+#include "utils/Log.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <vector>
+
+static_assert(sizeof(DepthCacheIndexHeader) % 8 == 0);
+static_assert(sizeof(DepthCacheIndexEntry) % 8 == 0);
+static_assert(sizeof(DepthCacheEntryHeader) % 2 == 0);
+
+constexpr uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t HASH_PRIME_3 = 0x165667B19E3779F9ULL;
+
+static uint64_t read_word(const uint8_t* bytes) {
+	uint64_t word = 0;
+	std::memcpy(&word, bytes, sizeof(word));
+	return word;
+}
+
+static uint64_t hash_round(uint64_t lane, uint64_t word) {
+	lane += word * HASH_PRIME_2;
+	lane = std::rotl(lane, 31);
+	return lane * HASH_PRIME_1;
+}
+
+static uint64_t avalanche(uint64_t hash) {
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+std::string DepthCacheKey::to_hex() const {
+	return std::format("{:016x}{:016x}", high, low);
+}
+
+DepthCacheKey hash_bytes(std::span<const uint8_t> bytes, uint64_t seed) {
+	PROFILE_DEPTH_FUNCTION()
+
+	std::array<uint64_t, 4> lanes = {
+		seed + HASH_PRIME_1 + HASH_PRIME_2, seed + HASH_PRIME_2, seed,
+		seed - HASH_PRIME_1
+	};
+
+	// 4 independent lanes keep the multipliers busy
+	size_t offset = 0;
+	for (; offset + 32 <= bytes.size(); offset += 32) {
+		for (size_t lane = 0; lane < lanes.size(); lane++)
+			lanes[lane] = hash_round(
+				lanes[lane], read_word(&bytes[offset + lane * 8])
+			);
+	}
+
+	uint64_t tail = HASH_PRIME_3 ^ bytes.size();
+	for (; offset + 8 <= bytes.size(); offset += 8)
+		tail = hash_round(tail, read_word(&bytes[offset]));
+	if (offset < bytes.size()) {
+		uint64_t last_word = 0;
+		std::memcpy(&last_word, &bytes[offset], bytes.size() - offset);
+		tail = hash_round(tail, last_word ^ (bytes.size() - offset));
+	}
+
+	return DepthCacheKey{
+		.high = avalanche(
+			(std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) +
+			 std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18)) ^
+			tail
+		),
+		.low = avalanche(
+			(lanes[0] ^ std::rotl(lanes[2], 23)) * HASH_PRIME_3 +
+			(lanes[1] ^ std::rotl(lanes[3], 41)) + tail * HASH_PRIME_1
+		),
+	};
+}
+
+DepthCacheKey compute_depth_cache_key(
+	std::span<const uint8_t> pixels,
+	size_t width,
+	size_t height,
+	std::string_view model_token,
+	const DepthCacheParameters& parameters
+) {
+	std::vector<uint8_t> description;
+	const auto append = [&](const auto& value) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		const auto* value_bytes = reinterpret_cast<const uint8_t*>(&value);
+		description.insert(
+			description.end(), value_bytes, value_bytes + sizeof(value)
+		);
+	};
+	append((uint64_t)width);
+	append((uint64_t)height);
+	append((uint64_t)parameters.input_width);
+	append((uint64_t)parameters.input_height);
+	append(parameters.mean);
+	append(parameters.stddev);
+	append((uint8_t)parameters.robust_normalization);
+	if (parameters.robust_normalization) {
+		append(parameters.low_percentile);
+		append(parameters.high_percentile);
+		append(parameters.bounds_smoothing);
+	}
+	description.insert(description.end(), model_token.begin(), model_token.end());
+
+	const auto description_key = hash_bytes(description);
+	const auto pixel_key = hash_bytes(pixels, description_key.high);
+	return DepthCacheKey{
+		.high = pixel_key.high,
+		.low = pixel_key.low ^ description_key.low,
+	};
+}
+
+DepthCache::DepthCache(
+	const std::filesystem::path& directory,
+	size_t max_bytes,
+	uint32_t max_entries
+)
+	: directory(directory), max_bytes(max_bytes) {
+	PROFILE_DEPTH_SCOPE("Open DepthCache")
+
+	std::filesystem::create_directories(directory);
+
+	const size_t index_size = sizeof(DepthCacheIndexHeader) +
+							  (size_t)max_entries * sizeof(DepthCacheIndexEntry);
+	index_file =
+		FileDescriptor((directory / "index").string(), O_RDWR | O_CREAT);
+	const bool index_size_matches = index_file.size() == index_size;
+	if (!index_size_matches)
+		index_file.truncate(index_size);
+	index_mapping = MappedRegion(index_file, 0, index_size, true);
+
+	if (!index_size_matches || header().magic != DEPTH_CACHE_INDEX_MAGIC ||
+		header().version != DEPTH_CACHE_VERSION ||
+		header().entry_capacity != max_entries) {
+		reset_index();
+		header().entry_capacity = max_entries;
+		return;
+	}
+
+	const auto index_entries = entries();
+	for (size_t slot = 0; slot < index_entries.size(); slot++) {
+		const auto& entry = index_entries[slot];
+		if (entry.last_used == 0)
+			continue;
+		slots[DepthCacheKey{.high = entry.key_high, .low = entry.key_low}] =
+			slot;
+		total_bytes += entry.file_size;
+	}
+	LOG_INFO(
+		"DepthCache: {} entries, {} bytes", slots.size(), total_bytes
+	);
+}
+
+DepthCacheIndexHeader& DepthCache::header() const {
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return *reinterpret_cast<DepthCacheIndexHeader*>(
+		index_mapping.bytes().data()
+	);
+}
+
+std::span<DepthCacheIndexEntry> DepthCache::entries() const {
+	const auto entry_bytes =
+		index_mapping.bytes().subspan(sizeof(DepthCacheIndexHeader));
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	return {
+		reinterpret_cast<DepthCacheIndexEntry*>(entry_bytes.data()),
+		entry_bytes.size() / sizeof(DepthCacheIndexEntry)
+	};
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+std::filesystem::path DepthCache::entry_path(const DepthCacheKey& key) const {
+	return directory / (key.to_hex() + ".depth");
+}
+
+void DepthCache::reset_index() {
+	// entries of an unreadable index can't be evicted anymore
+	for (const auto& file : std::filesystem::directory_iterator(directory)) {
+		if (file.path().extension() == ".depth" ||
+			file.path().extension() == ".tmp")
+			std::filesystem::remove(file.path());
+	}
+
+	const auto bytes = index_mapping.bytes();
+	std::ranges::fill(bytes, uint8_t{0});
+	header().magic = DEPTH_CACHE_INDEX_MAGIC;
+	header().version = DEPTH_CACHE_VERSION;
+	header().access_clock = 0;
+	slots.clear();
+	total_bytes = 0;
+}
+
+void DepthCache::remove_entry(size_t slot) {
+	auto& entry = entries()[slot];
+	const DepthCacheKey key{.high = entry.key_high, .low = entry.key_low};
+
+	std::error_code error;
+	std::filesystem::remove(entry_path(key), error);
+	total_bytes -= std::min<size_t>(entry.file_size, total_bytes);
+	slots.erase(key);
+	entry = DepthCacheIndexEntry{};
+}
+
+size_t DepthCache::evict_for(size_t new_size) {
+	const auto index_entries = entries();
+	while (true) {
+		size_t free_slot = index_entries.size();
+		size_t least_recent_slot = index_entries.size();
+		for (size_t slot = 0; slot < index_entries.size(); slot++) {
+			if (index_entries[slot].last_used == 0) {
+				free_slot = std::min(free_slot, slot);
+			} else if (least_recent_slot == index_entries.size() ||
+					   index_entries[slot].last_used <
+						   index_entries[least_recent_slot].last_used) {
+				least_recent_slot = slot;
+			}
+		}
+
+		const bool fits = total_bytes + new_size <= max_bytes;
+		if (fits && free_slot < index_entries.size())
+			return free_slot;
+		if (least_recent_slot == index_entries.size())
+			return free_slot;
+		remove_entry(least_recent_slot);
+	}
+}
+
+bool DepthCache::load(
+	const DepthCacheKey& key,
+	std::span<float> depth,
+	size_t width,
+	size_t height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+
+	const std::scoped_lock lock(mutex);
+
+	const auto slot = slots.find(key);
+	if (slot == slots.end())
+		return false;
+
+	FileDescriptor entry_file;
+	MappedRegion entry_mapping;
+	try {
+		entry_file = FileDescriptor(entry_path(key).string(), O_RDONLY);
+		entry_mapping =
+			MappedRegion(entry_file, 0, entry_file.size(), false);
+	} catch (const FileOperationException& exception) {
+		// deleted from outside, e.g. by clearing the app cache
+		LOG_ERROR("DepthCache: {}", exception.what());
+		remove_entry(slot->second);
+		return false;
+	}
+
+	const auto bytes = entry_mapping.bytes();
+	DepthCacheEntryHeader entry_header{};
+	if (bytes.size() != sizeof(entry_header) + depth.size() * sizeof(uint16_t))
+		return false;
+	std::memcpy(&entry_header, bytes.data(), sizeof(entry_header));
+	if (entry_header.magic != DEPTH_CACHE_ENTRY_MAGIC ||
+		entry_header.width != width || entry_header.height != height)
+		return false;
+
+	const uint8_t* values = bytes.data() + sizeof(entry_header);
+	for (size_t i = 0; i < depth.size(); i++) {
+		uint16_t value = 0;
+		std::memcpy(&value, values + i * sizeof(value), sizeof(value));
+		depth[i] = (float)value * (1.0f / 65535.0f);
+	}
+
+	entries()[slot->second].last_used = ++header().access_clock;
+	return true;
+}
+
+void DepthCache::store(
+	const DepthCacheKey& key,
+	std::span<const float> depth,
+	size_t width,
+	size_t height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+
+	const std::scoped_lock lock(mutex);
+
+	// content addressed, an existing entry has the same depth
+	if (const auto slot = slots.find(key); slot != slots.end()) {
+		entries()[slot->second].last_used = ++header().access_clock;
+		return;
+	}
+
+	const size_t file_size =
+		sizeof(DepthCacheEntryHeader) + depth.size() * sizeof(uint16_t);
+	if (file_size > max_bytes)
+		return;
+	const size_t slot = evict_for(file_size);
+	if (slot >= entries().size())
+		return;
+
+	// written to a temporary file first, so a killed process never leaves a
+	// truncated entry behind
+	const auto path = entry_path(key);
+	auto temporary_path = path;
+	temporary_path.replace_extension(".tmp");
+	{
+		const FileDescriptor entry_file(
+			temporary_path.string(), O_RDWR | O_CREAT | O_TRUNC
+		);
+		entry_file.truncate(file_size);
+		const MappedRegion entry_mapping(entry_file, 0, file_size, true);
+		const auto bytes = entry_mapping.bytes();
+
+		const DepthCacheEntryHeader entry_header{
+			.magic = DEPTH_CACHE_ENTRY_MAGIC,
+			.width = (uint32_t)width,
+			.height = (uint32_t)height,
+		};
+		std::memcpy(bytes.data(), &entry_header, sizeof(entry_header));
+		uint8_t* values = bytes.data() + sizeof(entry_header);
+		for (size_t i = 0; i < depth.size(); i++) {
+			const auto value = (uint16_t)std::lround(
+				std::clamp(depth[i], 0.0f, 1.0f) * 65535.0f
+			);
+			std::memcpy(values + i * sizeof(value), &value, sizeof(value));
+		}
+	}
+	std::filesystem::rename(temporary_path, path);
+
+	entries()[slot] = DepthCacheIndexEntry{
+		.key_high = key.high,
+		.key_low = key.low,
+		.last_used = ++header().access_clock,
+		.file_size = file_size,
+	};
+	slots[key] = slot;
+	total_bytes += file_size;
+}
+
+size_t DepthCache::size_bytes() const {
+	const std::scoped_lock lock(mutex);
+	return total_bytes;
+}
\ No newline at end of file
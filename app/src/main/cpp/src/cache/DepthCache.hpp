@@ -0,0 +1,144 @@
+#pragma once
+
+#include "processing/Preprocessing.hpp"
+#include "utils/MappedFile.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// 128 bit content hash of an image and everything that influences its depth
+struct DepthCacheKey {
+	uint64_t high = 0;
+	uint64_t low = 0;
+
+	bool operator==(const DepthCacheKey&) const = default;
+
+	[[nodiscard]] std::string to_hex() const;
+};
+
+struct DepthCacheKeyHash {
+	size_t operator()(const DepthCacheKey& key) const { return key.low; }
+};
+
+/// preprocessing that happens between the decoded image and the model, and
+/// the normalization of its output
+struct DepthCacheParameters {
+	size_t input_width = 0;
+	size_t input_height = 0;
+	std::array<float, RGB_CHANNELS> mean{};
+	std::array<float, RGB_CHANNELS> stddev{};
+	/// min_max_scaling if false
+	bool robust_normalization = false;
+	/// RobustNormalizationOptions, only part of the key with
+	/// robust_normalization
+	float low_percentile = 0.0f;
+	float high_percentile = 0.0f;
+	float bounds_smoothing = 0.0f;
+};
+
+/// non cryptographic 128 bit hash (4 lanes of multiply-rotate mixing, several
+/// GB/s), not meant to withstand deliberate collisions
+DepthCacheKey hash_bytes(std::span<const uint8_t> bytes, uint64_t seed = 0);
+
+/// key of a decoded image for a model, model_token should change whenever
+/// the model file changes
+DepthCacheKey compute_depth_cache_key(
+	std::span<const uint8_t> pixels,
+	size_t width,
+	size_t height,
+	std::string_view model_token,
+	const DepthCacheParameters& parameters
+);
+
+/// one slot of the memory mapped index, last_used == 0 marks free slots
+struct DepthCacheIndexEntry {
+	uint64_t key_high;
+	uint64_t key_low;
+	/// value of the access clock at the last load / store
+	uint64_t last_used;
+	uint64_t file_size;
+};
+
+struct DepthCacheIndexHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t entry_capacity;
+	uint64_t access_clock;
+	uint64_t reserved;
+};
+
+/// header of the entry files, followed by width * height uint16 values
+/// (relative depth 0 to 1 mapped to 0 to 65535)
+struct DepthCacheEntryHeader {
+	std::array<char, 8> magic;
+	uint32_t width;
+	uint32_t height;
+};
+
+constexpr std::array<char, 8> DEPTH_CACHE_INDEX_MAGIC = {'D', 'C', 'C', 'A',
+														 'C', 'H', 'E', 'I'};
+constexpr std::array<char, 8> DEPTH_CACHE_ENTRY_MAGIC = {'D', 'C', 'C', 'A',
+														 'C', 'H', 'E', 'D'};
+constexpr uint32_t DEPTH_CACHE_VERSION = 1;
+
+/// persistent cache of depth maps, so still images that are opened again
+/// don't have to run through the model. every depth map is a memory mapped
+/// file named after its key, a memory mapped index tracks their sizes and
+/// last use. the least recently used entries are evicted once the total size
+/// or the number of entries exceeds the limits
+class DepthCache {
+  public:
+	DepthCache(
+		const std::filesystem::path& directory,
+		size_t max_bytes,
+		uint32_t max_entries = 1024
+	);
+
+	DepthCache(const DepthCache&) = delete;
+	DepthCache(DepthCache&&) = delete;
+	void operator=(const DepthCache&) = delete;
+	void operator=(DepthCache&&) = delete;
+
+	/// thread safe, false if the key is not cached or was cached with another
+	/// size
+	bool load(
+		const DepthCacheKey& key,
+		std::span<float> depth,
+		size_t width,
+		size_t height
+	);
+
+	/// thread safe, depth values between 0 and 1
+	void store(
+		const DepthCacheKey& key,
+		std::span<const float> depth,
+		size_t width,
+		size_t height
+	);
+
+	[[nodiscard]] size_t size_bytes() const;
+
+  private:
+	[[nodiscard]] std::span<DepthCacheIndexEntry> entries() const;
+	[[nodiscard]] DepthCacheIndexHeader& header() const;
+	[[nodiscard]] std::filesystem::path entry_path(const DepthCacheKey& key
+	) const;
+	void reset_index();
+	void remove_entry(size_t slot);
+	/// makes room for an entry of new_size bytes, returns a free slot
+	size_t evict_for(size_t new_size);
+
+	mutable std::mutex mutex;
+	std::filesystem::path directory;
+	size_t max_bytes;
+	FileDescriptor index_file;
+	MappedRegion index_mapping;
+	/// key -> slot in the index
+	std::unordered_map<DepthCacheKey, size_t, DepthCacheKeyHash> slots;
+	size_t total_bytes = 0;
+};
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "DepthExport.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <zlib.h>
+
+constexpr std::array<uint8_t, 8> PNG_SIGNATURE = {0x89, 'P',  'N',  'G',
+												  '\r', '\n', 0x1a, '\n'};
+/// 16 bit grayscale pixels
+constexpr size_t PNG_BYTES_PER_PIXEL = 2;
+/// deflate window, the dictionary of a strip
+constexpr size_t DEFLATE_WINDOW_SIZE = 32 * 1024;
+
+class PngExportException : public std::runtime_error {
+  public:
+	explicit PngExportException(std::string_view message)
+		: std::runtime_error(std::format("png export failed: {}", message)) {}
+};
+
+static void append_u32_big_endian(std::vector<uint8_t>& output, uint32_t value) {
+	output.push_back((uint8_t)(value >> 24));
+	output.push_back((uint8_t)(value >> 16));
+	output.push_back((uint8_t)(value >> 8));
+	output.push_back((uint8_t)value);
+}
+
+static void append_chunk(
+	std::vector<uint8_t>& output,
+	std::string_view type,
+	std::span<const uint8_t> data
+) {
+	append_u32_big_endian(output, (uint32_t)data.size());
+	const size_t type_offset = output.size();
+	output.insert(output.end(), type.begin(), type.end());
+	output.insert(output.end(), data.begin(), data.end());
+	// the crc covers the type and the data
+	const auto crc = crc32(
+		0, &output[type_offset], (uInt)(output.size() - type_offset)
+	);
+	append_u32_big_endian(output, (uint32_t)crc);
+}
+
+static uint8_t paeth_predictor(uint8_t left, uint8_t above, uint8_t above_left) {
+	const int estimate = (int)left + (int)above - (int)above_left;
+	const int left_distance = std::abs(estimate - (int)left);
+	const int above_distance = std::abs(estimate - (int)above);
+	const int above_left_distance = std::abs(estimate - (int)above_left);
+	if (left_distance <= above_distance && left_distance <= above_left_distance)
+		return left;
+	if (above_distance <= above_left_distance)
+		return above;
+	return above_left;
+}
+
+/// writes the filtered row (without the filter type byte)
+static void filter_row(
+	PngFilter filter,
+	std::span<const uint8_t> row,
+	std::span<const uint8_t> previous_row,
+	std::span<uint8_t> filtered
+) {
+	for (size_t i = 0; i < row.size(); i++) {
+		const uint8_t left = i >= PNG_BYTES_PER_PIXEL
+								 ? row[i - PNG_BYTES_PER_PIXEL]
+								 : 0;
+		const uint8_t above = previous_row.empty() ? 0 : previous_row[i];
+		const uint8_t above_left =
+			previous_row.empty() || i < PNG_BYTES_PER_PIXEL
+				? 0
+				: previous_row[i - PNG_BYTES_PER_PIXEL];
+
+		uint8_t prediction = 0;
+		switch (filter) {
+		case PngFilter::Sub:
+			prediction = left;
+			break;
+		case PngFilter::Up:
+			prediction = above;
+			break;
+		case PngFilter::Average:
+			prediction = (uint8_t)(((int)left + (int)above) / 2);
+			break;
+		case PngFilter::Paeth:
+			prediction = paeth_predictor(left, above, above_left);
+			break;
+		default:
+			break;
+		}
+		filtered[i] = (uint8_t)(row[i] - prediction);
+	}
+}
+
+/// sum of the residuals as signed bytes, smaller usually deflates better
+static size_t filter_cost(std::span<const uint8_t> filtered) {
+	size_t cost = 0;
+	for (const uint8_t value : filtered)
+		cost += (size_t)std::abs((int)(int8_t)value);
+	return cost;
+}
+
+/// filter type byte + filtered row
+static void filter_png_row(
+	PngFilter filter,
+	std::span<const uint8_t> row,
+	std::span<const uint8_t> previous_row,
+	std::span<uint8_t> output,
+	std::vector<uint8_t>& candidate
+) {
+	const auto filtered = output.subspan(1);
+	if (filter != PngFilter::Adaptive) {
+		output[0] = (uint8_t)filter;
+		filter_row(filter, row, previous_row, filtered);
+		return;
+	}
+
+	candidate.resize(row.size());
+	size_t best_cost = SIZE_MAX;
+	for (const auto candidate_filter :
+		 {PngFilter::None, PngFilter::Sub, PngFilter::Up, PngFilter::Average,
+		  PngFilter::Paeth}) {
+		filter_row(candidate_filter, row, previous_row, candidate);
+		const size_t cost = filter_cost(candidate);
+		if (cost < best_cost) {
+			best_cost = cost;
+			output[0] = (uint8_t)candidate_filter;
+			std::ranges::copy(candidate, filtered.begin());
+		}
+	}
+}
+
+/// raw deflate of one strip, only the last strip ends the stream
+static std::vector<uint8_t> deflate_strip(
+	std::span<const uint8_t> strip,
+	std::span<const uint8_t> dictionary,
+	bool last_strip,
+	int compression_level
+) {
+	z_stream stream{};
+	if (deflateInit2(
+			&stream, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY
+		) != Z_OK)
+		throw PngExportException("deflateInit2");
+
+	std::vector<uint8_t> compressed(deflateBound(&stream, strip.size()) + 16);
+	int result = Z_OK;
+	if (!dictionary.empty())
+		result = deflateSetDictionary(
+			&stream, dictionary.data(), (uInt)dictionary.size()
+		);
+
+	if (result == Z_OK) {
+		stream.next_in = const_cast<Bytef*>(strip.data()); // NOLINT
+		stream.avail_in = (uInt)strip.size();
+		stream.next_out = compressed.data();
+		stream.avail_out = (uInt)compressed.size();
+		// a sync flush ends on a byte boundary without the final block bit, so
+		// the next strip can be appended
+		result = deflate(&stream, last_strip ? Z_FINISH : Z_SYNC_FLUSH);
+	}
+	const size_t compressed_size = compressed.size() - stream.avail_out;
+	deflateEnd(&stream);
+
+	if (result != (last_strip ? Z_STREAM_END : Z_OK) || stream.avail_in != 0)
+		throw PngExportException("deflate");
+	compressed.resize(compressed_size);
+	return compressed;
+}
+
+std::vector<uint8_t> encode_depth_png(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	ThreadPool& thread_pool,
+	const PngExportOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height || depth.empty())
+		throw std::invalid_argument("depth");
+
+	const size_t row_bytes = width * PNG_BYTES_PER_PIXEL;
+	const size_t filtered_row_bytes = row_bytes + 1;
+	const size_t strip_rows = std::max<size_t>(options.strip_rows, 1);
+	const size_t strip_count = (height + strip_rows - 1) / strip_rows;
+
+	// big endian samples, then filter byte + filtered row for every row
+	std::vector<uint8_t> samples(height * row_bytes);
+	std::vector<uint8_t> filtered(height * filtered_row_bytes);
+	std::vector<std::vector<uint8_t>> compressed_strips(strip_count);
+	std::vector<uLong> strip_checksums(strip_count);
+
+	thread_pool.parallel_for(strip_count, [&](size_t strip, size_t /*worker*/) {
+		const size_t first_row = strip * strip_rows;
+		const size_t end_row = std::min(first_row + strip_rows, height);
+		for (size_t y = first_row; y < end_row; y++) {
+			for (size_t x = 0; x < width; x++) {
+				const auto value = (uint16_t)std::lround(
+					std::clamp(depth[y * width + x], 0.0f, 1.0f) * 65535.0f
+				);
+				samples[y * row_bytes + x * 2] = (uint8_t)(value >> 8);
+				samples[y * row_bytes + x * 2 + 1] = (uint8_t)value;
+			}
+		}
+	});
+
+	// the filters of the first row of a strip need the last row of the
+	// previous strip, so filtering starts once all samples are converted
+	thread_pool.parallel_for(strip_count, [&](size_t strip, size_t /*worker*/) {
+		const size_t first_row = strip * strip_rows;
+		const size_t end_row = std::min(first_row + strip_rows, height);
+		std::vector<uint8_t> candidate;
+		for (size_t y = first_row; y < end_row; y++) {
+			filter_png_row(
+				options.filter,
+				std::span(samples).subspan(y * row_bytes, row_bytes),
+				y > 0 ? std::span<const uint8_t>(samples).subspan(
+							(y - 1) * row_bytes, row_bytes
+						)
+					  : std::span<const uint8_t>(),
+				std::span(filtered).subspan(
+					y * filtered_row_bytes, filtered_row_bytes
+				),
+				candidate
+			);
+		}
+	});
+
+	thread_pool.parallel_for(strip_count, [&](size_t strip, size_t /*worker*/) {
+		const size_t strip_begin = strip * strip_rows * filtered_row_bytes;
+		const size_t strip_end =
+			std::min((strip + 1) * strip_rows, height) * filtered_row_bytes;
+		const auto strip_bytes = std::span<const uint8_t>(filtered).subspan(
+			strip_begin, strip_end - strip_begin
+		);
+		// the preceding window keeps the ratio close to a serial deflate
+		const size_t dictionary_size =
+			std::min(strip_begin, DEFLATE_WINDOW_SIZE);
+		const auto dictionary = std::span<const uint8_t>(filtered).subspan(
+			strip_begin - dictionary_size, dictionary_size
+		);
+
+		compressed_strips[strip] = deflate_strip(
+			strip_bytes, dictionary, strip + 1 == strip_count,
+			options.compression_level
+		);
+		strip_checksums[strip] = adler32(
+			adler32(0, nullptr, 0), strip_bytes.data(), (uInt)strip_bytes.size()
+		);
+	});
+
+	uLong checksum = adler32(0, nullptr, 0);
+	for (size_t strip = 0; strip < strip_count; strip++) {
+		const size_t strip_size =
+			(std::min((strip + 1) * strip_rows, height) - strip * strip_rows) *
+			filtered_row_bytes;
+		checksum =
+			adler32_combine(checksum, strip_checksums[strip], (z_off_t)strip_size);
+	}
+
+	std::vector<uint8_t> png(PNG_SIGNATURE.begin(), PNG_SIGNATURE.end());
+
+	std::vector<uint8_t> header;
+	append_u32_big_endian(header, (uint32_t)width);
+	append_u32_big_endian(header, (uint32_t)height);
+	// 16 bit, grayscale, deflate, adaptive filtering, not interlaced
+	header.insert(header.end(), {16, 0, 0, 0, 0});
+	append_chunk(png, "IHDR", header);
+
+	// one IDAT per strip, together they form the zlib stream
+	for (size_t strip = 0; strip < strip_count; strip++) {
+		auto& data = compressed_strips[strip];
+		if (strip == 0) {
+			// zlib header: deflate with a 32 KiB window, default compression
+			data.insert(data.begin(), {0x78, 0x9c});
+		}
+		if (strip + 1 == strip_count)
+			append_u32_big_endian(data, (uint32_t)checksum);
+		append_chunk(png, "IDAT", data);
+	}
+	append_chunk(png, "IEND", {});
+	return png;
+}
+
+void write_depth_png(
+	int fd,
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	ThreadPool& thread_pool,
+	const PngExportOptions& options
+) {
+	write_all(fd, encode_depth_png(depth, width, height, thread_pool, options));
+}
+
+void write_depth_pfm(
+	int fd,
+	std::span<const float> depth,
+	size_t width,
+	size_t height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+
+	const float scale = std::endian::native == std::endian::little ? -1.0f : 1.0f;
+	const auto header = std::format("Pf\n{} {}\n{}\n", width, height, scale);
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	write_all(
+		fd, {reinterpret_cast<const uint8_t*>(header.data()), header.size()}
+	);
+	for (size_t row = 0; row < height; row++) {
+		const float* row_data = &depth[(height - 1 - row) * width];
+		write_all(
+			fd, {reinterpret_cast<const uint8_t*>(row_data),
+				 width * sizeof(float)}
+		);
+	}
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
\ No newline at end of file
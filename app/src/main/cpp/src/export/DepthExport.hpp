@@ -0,0 +1,55 @@
+#pragma once
+
+#include "utils/ThreadPool.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// png row filters, Adaptive picks the filter with the smallest sum of
+/// absolute residuals for every row (the libpng heuristic)
+enum class PngFilter : uint8_t {
+	None = 0,
+	Sub = 1,
+	Up = 2,
+	Average = 3,
+	Paeth = 4,
+	Adaptive = 255,
+};
+
+struct PngExportOptions {
+	PngFilter filter = PngFilter::Adaptive;
+	/// zlib level, 1 (fastest) to 9 (smallest)
+	int compression_level = 6;
+	/// rows that are filtered and deflated by one task
+	size_t strip_rows = 64;
+};
+
+/// encodes depth values between 0 and 1 as 16 bit grayscale png. the strips
+/// of rows are filtered and deflated in parallel on the thread pool (each
+/// primed with the preceding 32 KiB as dictionary) and stored as separate
+/// IDAT chunks that form a single zlib stream
+std::vector<uint8_t> encode_depth_png(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	ThreadPool& thread_pool,
+	const PngExportOptions& options = {}
+);
+
+/// encode_depth_png written to a file descriptor (which is not closed)
+void write_depth_png(
+	int fd,
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	ThreadPool& thread_pool,
+	const PngExportOptions& options = {}
+);
+
+/// raw 32 bit float pfm (bottom to top rows, little endian)
+void write_depth_pfm(
+	int fd,
+	std::span<const float> depth,
+	size_t width,
+	size_t height
+);
\ No newline at end of file
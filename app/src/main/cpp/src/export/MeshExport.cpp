@@ -0,0 +1,55 @@
+#include "MeshExport.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/Profiling.hpp"
+
+#include <bit>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void write_mesh_ply(
+	int fd,
+	std::span<const float> vertices,
+	std::span<const uint32_t> triangles
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	static_assert(std::endian::native == std::endian::little);
+	if (vertices.size() % 3 != 0 || triangles.size() % 3 != 0)
+		throw std::invalid_argument("vertices and triangles");
+
+	const auto header = std::format(
+		"ply\nformat binary_little_endian 1.0\nelement vertex {}\n"
+		"property float x\nproperty float y\nproperty float z\n"
+		"element face {}\nproperty list uchar uint vertex_indices\n"
+		"end_header\n",
+		vertices.size() / 3, triangles.size() / 3
+	);
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	write_all(
+		fd, {reinterpret_cast<const uint8_t*>(header.data()), header.size()}
+	);
+	write_all(
+		fd, {reinterpret_cast<const uint8_t*>(vertices.data()),
+			 vertices.size_bytes()}
+	);
+
+	// faces are a count byte followed by the indices, written in batches
+	constexpr size_t FACE_SIZE = 1 + 3 * sizeof(uint32_t);
+	constexpr size_t FACES_PER_BATCH = 4096;
+	std::vector<uint8_t> faces;
+	faces.reserve(FACES_PER_BATCH * FACE_SIZE);
+	for (size_t triangle = 0; triangle < triangles.size(); triangle += 3) {
+		faces.push_back(3);
+		const auto* indices =
+			reinterpret_cast<const uint8_t*>(&triangles[triangle]);
+		faces.insert(faces.end(), indices, indices + 3 * sizeof(uint32_t));
+		if (faces.size() >= FACES_PER_BATCH * FACE_SIZE) {
+			write_all(fd, faces);
+			faces.clear();
+		}
+	}
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	write_all(fd, faces);
+}
\ No newline at end of file
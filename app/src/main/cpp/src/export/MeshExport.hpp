@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+/// binary little endian ply of a triangle mesh (x, y, z per vertex, three
+/// indices per triangle), the file descriptor is not closed
+void write_mesh_ply(
+	int fd,
+	std::span<const float> vertices,
+	std::span<const uint32_t> triangles
+);
\ No newline at end of file
@@ -0,0 +1,373 @@
+#include "OnnxNormalizationFolding.hpp"
+#include "OnnxProtobuf.hpp"
+#include "OnnxUtils.hpp"
+#include "utils/Log.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+
+std::string format_folded_normalization(
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+) {
+	return std::format(
+		"mean={},{},{} stddev={},{},{}", mean[0], mean[1], mean[2], stddev[0],
+		stddev[1], stddev[2]
+	);
+}
+
+/// the parsed graph of a model, fields that are not edited stay encoded
+struct FoldingGraph {
+	std::vector<ProtobufField> fields;
+	std::vector<OnnxNode> nodes;
+	/// names of all tensors, for unique names of the new ones
+	std::vector<std::string> names;
+	std::string input_name;
+};
+
+static FoldingGraph parse_folding_graph(std::span<const std::byte> graph_data) {
+	FoldingGraph graph{.fields = parse_protobuf(graph_data)};
+	graph.names = collect_onnx_names(graph.fields);
+
+	std::vector<std::string_view> initializer_names;
+	for (const auto& field : graph.fields) {
+		if (field.number == GRAPH_NODE)
+			graph.nodes.push_back(parse_onnx_node(field));
+		else if (field.number == GRAPH_INITIALIZER)
+			initializer_names.push_back(parse_onnx_name(field, TENSOR_NAME));
+	}
+
+	// models of ir version 3 list their initializers as inputs too
+	std::vector<const ProtobufField*> inputs;
+	for (const auto& field : graph.fields) {
+		if (field.number == GRAPH_INPUT &&
+			std::ranges::find(
+				initializer_names, parse_onnx_name(field, VALUE_INFO_NAME)
+			) == initializer_names.end())
+			inputs.push_back(&field);
+	}
+	if (inputs.size() != 1)
+		throw OnnxInvalidInputCount(inputs.size());
+
+	const auto shape = parse_onnx_value_shape(*inputs[0]);
+	if (shape.size() != 4 || (shape[1] >= 0 && shape[1] != RGB_CHANNELS))
+		throw std::invalid_argument("input");
+	graph.input_name = parse_onnx_name(*inputs[0], VALUE_INFO_NAME);
+	return graph;
+}
+
+static size_t count_uses(const FoldingGraph& graph, std::string_view name) {
+	size_t uses = 0;
+	for (const auto& node : graph.nodes)
+		uses += std::ranges::count(node.inputs, name);
+	return uses;
+}
+
+static bool is_graph_input(const FoldingGraph& graph, std::string_view name) {
+	return std::ranges::any_of(graph.fields, [&](const ProtobufField& field) {
+		return field.number == GRAPH_INPUT &&
+			   parse_onnx_name(field, VALUE_INFO_NAME) == name;
+	});
+}
+
+/// the initializer with the name, nullopt if it is missing, not float or
+/// shared with other nodes
+static std::optional<OnnxFloatTensor>
+find_folding_initializer(const FoldingGraph& graph, std::string_view name) {
+	if (count_uses(graph, name) != 1 || is_graph_input(graph, name))
+		return std::nullopt;
+	for (const auto& field : graph.fields) {
+		if (field.number == GRAPH_INITIALIZER &&
+			parse_onnx_name(field, TENSOR_NAME) == name)
+			return parse_onnx_float_tensor(field);
+	}
+	return std::nullopt;
+}
+
+/// folds x * scale + offset of the input channels into the first conv:
+/// w' = w * scale[c], b' = b + sum of w * offset[c]. false if the graph
+/// doesn't start with a conv that can absorb it
+static bool fold_into_first_conv(
+	FoldingGraph& graph,
+	std::array<float, RGB_CHANNELS> scale,
+	std::array<float, RGB_CHANNELS> offset,
+	std::vector<OnnxFloatTensor>& initializers
+) {
+	if (count_uses(graph, graph.input_name) != 1)
+		return false;
+	const auto conv =
+		std::ranges::find_if(graph.nodes, [&](const OnnxNode& node) {
+			return std::ranges::count(node.inputs, graph.input_name) == 1;
+		});
+	if (conv->op_type != "Conv" || !conv->domain.empty() ||
+		conv->inputs.size() < 2 || conv->inputs[0] != graph.input_name)
+		return false;
+
+	const auto* group = conv->attribute("group");
+	if (group != nullptr && group->int_value != 1)
+		return false;
+	const auto* auto_pad = conv->attribute("auto_pad");
+	if (auto_pad != nullptr && auto_pad->string_value != "NOTSET" &&
+		auto_pad->string_value != "VALID")
+		return false;
+	const auto* pads = conv->attribute("pads");
+	if (pads != nullptr && std::ranges::any_of(pads->ints, [](int64_t pad) {
+			return pad != 0;
+		}))
+		return false;
+
+	auto weights = find_folding_initializer(graph, conv->inputs[1]);
+	if (!weights.has_value() || weights->dims.size() != 4 ||
+		weights->dims[1] != RGB_CHANNELS)
+		return false;
+	const auto output_channels = (size_t)weights->dims[0];
+	const size_t kernel_size =
+		weights->values.size() / output_channels / RGB_CHANNELS;
+
+	OnnxFloatTensor bias;
+	const bool has_bias = conv->inputs.size() > 2 && !conv->inputs[2].empty();
+	if (has_bias) {
+		auto existing_bias = find_folding_initializer(graph, conv->inputs[2]);
+		if (!existing_bias.has_value() ||
+			existing_bias->values.size() != output_channels)
+			return false;
+		bias = std::move(*existing_bias);
+	} else {
+		bias = {
+			.name = make_unique_onnx_name(
+				"folded_normalization_bias", graph.names
+			),
+			.dims = {(int64_t)output_channels},
+			.values = std::vector<float>(output_channels, 0.0f),
+		};
+		conv->inputs.resize(3);
+		conv->inputs[2] = bias.name;
+		conv->encoded = {};
+	}
+
+	for (size_t output = 0; output < output_channels; output++) {
+		double bias_offset = 0.0;
+		for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+			const size_t start =
+				(output * RGB_CHANNELS + channel) * kernel_size;
+			for (float& weight :
+				 std::span(weights->values).subspan(start, kernel_size)) {
+				bias_offset += (double)weight * offset[channel];
+				weight *= scale[channel];
+			}
+		}
+		bias.values[output] += (float)bias_offset;
+	}
+
+	initializers.push_back(std::move(*weights));
+	initializers.push_back(std::move(bias));
+	return true;
+}
+
+/// prepends x * scale + offset with [1, 3, 1, 1] constants that broadcast over
+/// the nchw input, the nodes that used the input use the result
+static std::vector<OnnxNode> prepend_normalization_nodes(
+	FoldingGraph& graph,
+	std::array<float, RGB_CHANNELS> scale,
+	std::array<float, RGB_CHANNELS> offset,
+	std::vector<OnnxFloatTensor>& initializers
+) {
+	const std::vector<int64_t> dims = {1, RGB_CHANNELS, 1, 1};
+	initializers.push_back({
+		.name =
+			make_unique_onnx_name("folded_normalization_scale", graph.names),
+		.dims = dims,
+		.values = {scale.begin(), scale.end()},
+	});
+	initializers.push_back({
+		.name =
+			make_unique_onnx_name("folded_normalization_offset", graph.names),
+		.dims = dims,
+		.values = {offset.begin(), offset.end()},
+	});
+	const auto scaled =
+		make_unique_onnx_name("folded_normalization_scaled", graph.names);
+	const auto normalized =
+		make_unique_onnx_name("folded_normalization_output", graph.names);
+
+	for (auto& node : graph.nodes) {
+		for (auto& input : node.inputs) {
+			if (input == graph.input_name) {
+				input = normalized;
+				node.encoded = {};
+			}
+		}
+	}
+
+	return {
+		{.inputs = {graph.input_name, initializers[0].name},
+		 .outputs = {scaled},
+		 .name = "folded_normalization_mul",
+		 .op_type = "Mul"},
+		{.inputs = {scaled, initializers[1].name},
+		 .outputs = {normalized},
+		 .name = "folded_normalization_add",
+		 .op_type = "Add"},
+	};
+}
+
+std::vector<std::byte> fold_input_normalization(
+	std::span<const std::byte> model_data,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto model_fields = parse_protobuf(model_data);
+	if (find_onnx_metadata(model_fields, FOLDED_NORMALIZATION_METADATA_KEY))
+		throw std::invalid_argument("model_data");
+	const auto graph_field =
+		std::ranges::find(model_fields, MODEL_GRAPH, &ProtobufField::number);
+	if (graph_field == model_fields.end())
+		throw std::invalid_argument("model_data");
+
+	std::array<float, RGB_CHANNELS> scale{};
+	std::array<float, RGB_CHANNELS> offset{};
+	for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+		if (stddev[channel] == 0.0f)
+			throw std::invalid_argument("stddev");
+		scale[channel] = 1.0f / stddev[channel];
+		offset[channel] = -mean[channel] / stddev[channel];
+	}
+
+	auto graph = parse_folding_graph(graph_field->bytes);
+	std::vector<OnnxFloatTensor> initializers;
+	std::vector<OnnxNode> prepended_nodes;
+	if (fold_into_first_conv(graph, scale, offset, initializers)) {
+		LOG_INFO("folded the input normalization into the first conv");
+	} else {
+		// broadcasting Mul and Add
+		if (parse_onnx_opset_version(model_fields) < 7)
+			throw std::invalid_argument("opset");
+		prepended_nodes =
+			prepend_normalization_nodes(graph, scale, offset, initializers);
+		LOG_INFO("prepended the input normalization to the graph");
+	}
+
+	// nodes are topologically sorted, the prepended ones go first. folded
+	// initializers replace the originals
+	ProtobufWriter graph_writer;
+	size_t node_index = 0;
+	for (const auto& field : graph.fields) {
+		if (field.number == GRAPH_NODE) {
+			if (node_index == 0) {
+				for (const auto& node : prepended_nodes)
+					node.write(graph_writer);
+			}
+			graph.nodes[node_index++].write(graph_writer);
+		} else if (field.number == GRAPH_INITIALIZER &&
+				   std::ranges::find(
+					   initializers, parse_onnx_name(field, TENSOR_NAME),
+					   &OnnxFloatTensor::name
+				   ) != initializers.end()) {
+			continue;
+		} else {
+			graph_writer.field(field);
+		}
+	}
+	for (const auto& initializer : initializers)
+		initializer.write(graph_writer);
+
+	ProtobufWriter model_writer;
+	for (const auto& field : model_fields) {
+		if (field.number == MODEL_GRAPH)
+			model_writer.message(MODEL_GRAPH, graph_writer);
+		else
+			model_writer.field(field);
+	}
+	write_onnx_metadata(
+		model_writer, FOLDED_NORMALIZATION_METADATA_KEY,
+		format_folded_normalization(mean, stddev)
+	);
+	return model_writer.release();
+}
+
+/// the cached model if it exists and was folded with the normalization
+static std::optional<std::vector<std::byte>> read_folded_model(
+	const std::filesystem::path& path,
+	std::string_view normalization
+) {
+	std::error_code error;
+	if (!std::filesystem::exists(path, error))
+		return std::nullopt;
+
+	const FileDescriptor file(path.string(), O_RDONLY);
+	const size_t size = file.size();
+	if (size == 0)
+		return std::nullopt;
+	const MappedRegion mapping(file, 0, size, false);
+	const auto bytes = std::as_bytes(mapping.bytes());
+	if (find_onnx_metadata(
+			parse_protobuf(bytes), FOLDED_NORMALIZATION_METADATA_KEY
+		) != normalization)
+		return std::nullopt;
+	return std::vector<std::byte>(bytes.begin(), bytes.end());
+}
+
+std::optional<std::vector<std::byte>> load_normalization_folded_model(
+	std::span<const std::byte> model_data,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const std::filesystem::path& cache_directory,
+	std::string_view model_token
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	std::string file_name(model_token);
+	std::ranges::replace(file_name, '/', '_');
+	const auto path = cache_directory / (file_name + ".folded.onnx");
+	const auto normalization = format_folded_normalization(mean, stddev);
+
+	try {
+		if (auto cached = read_folded_model(path, normalization)) {
+			LOG_INFO("loaded the folded model {}", path.string());
+			return cached;
+		}
+	} catch (const std::exception& exception) {
+		LOG_ERROR("failed to read {}: {}", path.string(), exception.what());
+	}
+
+	std::vector<std::byte> folded;
+	try {
+		folded = fold_input_normalization(model_data, mean, stddev);
+	} catch (const std::exception& exception) {
+		LOG_ERROR(
+			"can't fold the input normalization of {}: {}", model_token,
+			exception.what()
+		);
+		return std::nullopt;
+	}
+
+	// written to a temporary file first, so a killed process never leaves a
+	// truncated model behind
+	try {
+		std::filesystem::create_directories(cache_directory);
+		auto temporary_path = path;
+		temporary_path.replace_extension(".tmp");
+		{
+			const FileDescriptor file(
+				temporary_path.string(), O_WRONLY | O_CREAT | O_TRUNC
+			);
+			// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+			write_all(
+				file.get(),
+				{reinterpret_cast<const uint8_t*>(folded.data()), folded.size()}
+			);
+			// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+		std::filesystem::rename(temporary_path, path);
+	} catch (const std::exception& exception) {
+		LOG_ERROR("failed to cache {}: {}", path.string(), exception.what());
+	}
+	return folded;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// metadata_props key of models with a folded input normalization, the value
+/// lists the folded mean and stddev
+constexpr std::string_view FOLDED_NORMALIZATION_METADATA_KEY =
+	"depthcamera.folded_normalization";
+
+/// metadata value of a normalization
+std::string format_folded_normalization(
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+);
+
+/// rewrites the model so that it takes its nchw input before normalize_rgb,
+/// (value - mean) / stddev becomes part of the graph. the first Conv absorbs
+/// it into its weights and bias if it is the only consumer of the input and
+/// doesn't pad (the padding would be zero before instead of after the
+/// normalization), otherwise a Mul and an Add are prepended. the model is
+/// marked with FOLDED_NORMALIZATION_METADATA_KEY. throws
+/// std::invalid_argument if the model can't be folded
+std::vector<std::byte> fold_input_normalization(
+	std::span<const std::byte> model_data,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev
+);
+
+/// the folded model, read from cache_directory if an earlier run folded the
+/// model of model_token with the same normalization, otherwise folded and
+/// stored there. nullopt if the model can't be folded, it then has to be
+/// normalized at run time
+std::optional<std::vector<std::byte>> load_normalization_folded_model(
+	std::span<const std::byte> model_data,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	const std::filesystem::path& cache_directory,
+	std::string_view model_token
+);
\ No newline at end of file
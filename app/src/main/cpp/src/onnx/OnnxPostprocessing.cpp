@@ -0,0 +1,413 @@
+#include "OnnxPostprocessing.hpp"
+#include "OnnxProtobuf.hpp"
+#include "OnnxUtils.hpp"
+#include "processing/Postprocessing.hpp"
+#include "simd/SimdKernels.hpp"
+#include "utils/Log.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <onnxruntime_lite_custom_op.h>
+#include <ranges>
+#include <stdexcept>
+
+/// rows of a task on the intra op threads, large enough that a task outweighs
+/// its scheduling
+constexpr size_t POSTPROCESSING_ROWS_PER_TASK = 16;
+
+std::string
+format_depth_postprocessing(const DepthPostprocessingOptions& options) {
+	return std::format(
+		"downscale={} colormap={} lut_size={}", options.downscale_factor,
+		(int)options.colormap, (int)options.resolution
+	);
+}
+
+/// a depth tensor of shape [..., height, width], the leading dimensions
+/// count the frames
+struct DepthTensorShape {
+	size_t frames = 1;
+	size_t height = 0;
+	size_t width = 0;
+
+	explicit DepthTensorShape(const std::vector<int64_t>& shape) {
+		if (shape.size() < 2 ||
+			std::ranges::any_of(shape, [](int64_t dim) { return dim < 0; }))
+			throw std::invalid_argument("shape");
+		for (size_t i = 0; i + 2 < shape.size(); i++)
+			frames *= (size_t)shape[i];
+		height = (size_t)shape[shape.size() - 2];
+		width = (size_t)shape.back();
+	}
+
+	[[nodiscard]] size_t rows() const { return frames * height; }
+	[[nodiscard]] size_t frame_size() const { return height * width; }
+};
+
+/// runs task(index) for every index on the intra op threads of the session
+/// (serially if it has none)
+template <typename Task>
+static void
+parallel_for(OrtKernelContext* context, size_t count, const Task& task) {
+	Ort::KernelContext(context).ParallelFor(
+		[](void* user_data, size_t index) {
+			(*static_cast<const Task*>(user_data))(index);
+		},
+		count, 0, const_cast<Task*>(&task) // NOLINT(*-const-cast)
+	);
+}
+
+/// runs task(begin_row, end_row) for blocks of rows
+template <typename Task>
+static void
+parallel_for_rows(OrtKernelContext* context, size_t rows, const Task& task) {
+	const size_t block_count =
+		(rows + POSTPROCESSING_ROWS_PER_TASK - 1) /
+		POSTPROCESSING_ROWS_PER_TASK;
+	parallel_for(context, block_count, [&](size_t block) {
+		const size_t begin = block * POSTPROCESSING_ROWS_PER_TASK;
+		task(begin, std::min(begin + POSTPROCESSING_ROWS_PER_TASK, rows));
+	});
+}
+
+/// onnxruntime expects kernels to report errors as status instead of
+/// throwing through its c api
+template <typename Function>
+static Ort::Status run_kernel(const char* name, const Function& function) {
+	try {
+		PROFILE_DEPTH_SCOPE(name)
+		function();
+		return Ort::Status{nullptr};
+	} catch (const std::exception& exception) {
+		LOG_ERROR("{} failed: {}", name, exception.what());
+		return Ort::Status{exception};
+	}
+}
+
+struct DepthDownscaleKernel {
+	size_t factor;
+
+	DepthDownscaleKernel(const OrtApi* /*api*/, const OrtKernelInfo* info)
+		: factor(
+			  (size_t)Ort::ConstKernelInfo{info}.GetAttribute<int64_t>("factor")
+		  ) {
+		if (factor == 0)
+			throw std::invalid_argument("factor");
+	}
+
+	Ort::Status Compute(
+		OrtKernelContext* context,
+		const Ort::Custom::Tensor<float>& depth,
+		Ort::Custom::Tensor<float>& downscaled
+	) {
+		return run_kernel("DepthDownscale", [&] {
+			const DepthTensorShape shape(depth.Shape());
+			auto output_shape = depth.Shape();
+			output_shape[output_shape.size() - 2] /= (int64_t)factor;
+			output_shape.back() /= (int64_t)factor;
+			const DepthTensorShape downscaled_shape(output_shape);
+
+			const float* input = depth.Data();
+			float* output = downscaled.Allocate(output_shape);
+			const size_t width = downscaled_shape.width;
+			const float block_scale = 1.0f / (float)(factor * factor);
+			parallel_for_rows(
+				context, downscaled_shape.rows(),
+				[&](size_t begin, size_t end) {
+					for (size_t row = begin; row < end; row++) {
+						const size_t frame = row / downscaled_shape.height;
+						const size_t y = row % downscaled_shape.height;
+						const float* source = input +
+											  frame * shape.frame_size() +
+											  y * factor * shape.width;
+						const std::span<float> target(
+							output + row * width, width
+						);
+						std::ranges::fill(target, 0.0f);
+						// summed row by row, so the inner loop runs over
+						// contiguous memory
+						for (size_t dy = 0; dy < factor; dy++) {
+							const float* source_row = source + dy * shape.width;
+							for (size_t x = 0; x < width; x++) {
+								for (size_t dx = 0; dx < factor; dx++)
+									target[x] += source_row[x * factor + dx];
+							}
+						}
+						for (float& value : target)
+							value *= block_scale;
+					}
+				}
+			);
+		});
+	}
+};
+
+struct DepthRangeNormalizeKernel {
+	DepthRangeNormalizeKernel(
+		const OrtApi* /*api*/,
+		const OrtKernelInfo* /*info*/
+	) {}
+
+	Ort::Status Compute(
+		OrtKernelContext* context,
+		const Ort::Custom::Tensor<float>& depth,
+		Ort::Custom::Tensor<float>& normalized
+	) {
+		return run_kernel("DepthRangeNormalize", [&] {
+			const DepthTensorShape shape(depth.Shape());
+			const float* input = depth.Data();
+			float* output = normalized.Allocate(depth.Shape());
+			if (shape.frame_size() == 0)
+				return;
+
+			// the range of every block of rows first, reduced per frame
+			// afterwards, blocks end at frame boundaries
+			const size_t blocks_per_frame =
+				(shape.height + POSTPROCESSING_ROWS_PER_TASK - 1) /
+				POSTPROCESSING_ROWS_PER_TASK;
+			std::vector<RawDepthRange> block_ranges(
+				shape.frames * blocks_per_frame
+			);
+			parallel_for(context, block_ranges.size(), [&](size_t block) {
+				const size_t frame = block / blocks_per_frame;
+				const size_t y =
+					block % blocks_per_frame * POSTPROCESSING_ROWS_PER_TASK;
+				const size_t rows =
+					std::min(POSTPROCESSING_ROWS_PER_TASK, shape.height - y);
+				block_ranges[block] = raw_depth_range(
+					{input + frame * shape.frame_size() + y * shape.width,
+					 rows * shape.width}
+				);
+			});
+
+			std::vector<RawDepthRange> frame_ranges(shape.frames);
+			for (size_t frame = 0; frame < shape.frames; frame++) {
+				auto& range = frame_ranges[frame];
+				range = block_ranges[frame * blocks_per_frame];
+				for (const auto& block_range :
+					 std::span(block_ranges)
+						 .subspan(frame * blocks_per_frame, blocks_per_frame)) {
+					range.min = std::min(range.min, block_range.min);
+					range.max = std::max(range.max, block_range.max);
+				}
+			}
+
+			// copied and rescaled per row, the second pass reads from cache
+			parallel_for_rows(
+				context, shape.rows(),
+				[&](size_t begin, size_t end) {
+					for (size_t row = begin; row < end; row++) {
+						const auto [min, max] =
+							frame_ranges[row / shape.height];
+						const float diff = max - min;
+						const std::span<float> values(
+							output + row * shape.width, shape.width
+						);
+						if (diff > 0.0f) {
+							std::ranges::copy_n(
+								input + row * shape.width, shape.width,
+								values.begin()
+							);
+							simd_kernels().scale_offset(
+								values, 1.0f / diff, -min / diff
+							);
+						} else {
+							std::ranges::fill(values, 0.5f);
+						}
+					}
+				}
+			);
+		});
+	}
+};
+
+struct DepthColormapArgbKernel {
+	ColormapOptions options;
+
+	DepthColormapArgbKernel(const OrtApi* /*api*/, const OrtKernelInfo* info) {
+		const Ort::ConstKernelInfo kernel_info{info};
+		const auto colormap = kernel_info.GetAttribute<int64_t>("colormap");
+		if (colormap < 0 || colormap > (int64_t)Colormap::Grayscale)
+			throw std::invalid_argument("colormap");
+		const auto lut_size = kernel_info.GetAttribute<int64_t>("lut_size");
+		if (lut_size != (int64_t)ColormapResolution::Entries1024 &&
+			lut_size != (int64_t)ColormapResolution::Entries4096)
+			throw std::invalid_argument("lut_size");
+		options.colormap = (Colormap)colormap;
+		options.resolution = (ColormapResolution)lut_size;
+	}
+
+	Ort::Status Compute(
+		OrtKernelContext* context,
+		const Ort::Custom::Tensor<float>& depth,
+		Ort::Custom::Tensor<int32_t>& pixels
+	) {
+		return run_kernel("DepthColormapArgb", [&] {
+			const DepthTensorShape shape(depth.Shape());
+			const float* input = depth.Data();
+			int32_t* output = pixels.Allocate(depth.Shape());
+			parallel_for_rows(
+				context, shape.rows(),
+				[&](size_t begin, size_t end) {
+					const size_t size = (end - begin) * shape.width;
+					colormap_depth_argb(
+						{input + begin * shape.width, size},
+						{output + begin * shape.width, size}, options
+					);
+				}
+			);
+		});
+	}
+};
+
+/// the ops and their domain, which sessions reference until they are
+/// destroyed
+struct DepthPostprocessingOps {
+	std::unique_ptr<OrtCustomOp> downscale{
+		Ort::Custom::CreateLiteCustomOp<DepthDownscaleKernel>(
+			"DepthDownscale", "CPUExecutionProvider"
+		)
+	};
+	std::unique_ptr<OrtCustomOp> range_normalize{
+		Ort::Custom::CreateLiteCustomOp<DepthRangeNormalizeKernel>(
+			"DepthRangeNormalize", "CPUExecutionProvider"
+		)
+	};
+	std::unique_ptr<OrtCustomOp> colormap_argb{
+		Ort::Custom::CreateLiteCustomOp<DepthColormapArgbKernel>(
+			"DepthColormapArgb", "CPUExecutionProvider"
+		)
+	};
+	Ort::CustomOpDomain domain{DEPTH_POSTPROCESSING_DOMAIN.data()};
+
+	DepthPostprocessingOps() {
+		domain.Add(downscale.get());
+		domain.Add(range_normalize.get());
+		domain.Add(colormap_argb.get());
+	}
+};
+
+void add_depth_postprocessing_ops(Ort::SessionOptions& session_options) {
+	static DepthPostprocessingOps ops;
+	session_options.Add(ops.domain);
+}
+
+std::vector<std::byte> append_depth_postprocessing(
+	std::span<const std::byte> model_data,
+	const DepthPostprocessingOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (options.downscale_factor == 0)
+		throw std::invalid_argument("downscale_factor");
+	const auto model_fields = parse_protobuf(model_data);
+	if (find_onnx_metadata(model_fields, DEPTH_POSTPROCESSING_METADATA_KEY))
+		throw std::invalid_argument("model_data");
+	const auto graph_field =
+		std::ranges::find(model_fields, MODEL_GRAPH, &ProtobufField::number);
+	if (graph_field == model_fields.end())
+		throw std::invalid_argument("model_data");
+
+	const auto graph_fields = parse_protobuf(graph_field->bytes);
+	std::vector<const ProtobufField*> outputs;
+	for (const auto& field : graph_fields) {
+		if (field.number == GRAPH_OUTPUT)
+			outputs.push_back(&field);
+	}
+	if (outputs.size() != 1)
+		throw OnnxInvalidOutputCount(outputs.size());
+	const std::string depth_name(parse_onnx_name(*outputs[0], VALUE_INFO_NAME));
+	auto dims = parse_onnx_value_shape(*outputs[0]);
+	if (dims.size() < 2)
+		throw std::invalid_argument("output");
+
+	auto names = collect_onnx_names(graph_fields);
+	std::vector<OnnxNode> nodes;
+	std::string depth = depth_name;
+	if (options.downscale_factor > 1) {
+		auto downscaled = make_unique_onnx_name("depth_downscaled", names);
+		nodes.push_back(
+			{.inputs = {depth},
+			 .outputs = {downscaled},
+			 .name = "depth_downscale",
+			 .op_type = "DepthDownscale",
+			 .domain = std::string(DEPTH_POSTPROCESSING_DOMAIN),
+			 .attributes = {
+				 {.name = "factor",
+				  .type = OnnxAttributeType::Int,
+				  .int_value = (int64_t)options.downscale_factor}
+			 }}
+		);
+		depth = std::move(downscaled);
+		for (auto& dim : std::span(dims).last(2)) {
+			if (dim >= 0)
+				dim /= (int64_t)options.downscale_factor;
+		}
+	}
+	auto normalized = make_unique_onnx_name("depth_normalized", names);
+	auto pixels = make_unique_onnx_name("depth_argb", names);
+	nodes.push_back(
+		{.inputs = {depth},
+		 .outputs = {normalized},
+		 .name = "depth_range_normalize",
+		 .op_type = "DepthRangeNormalize",
+		 .domain = std::string(DEPTH_POSTPROCESSING_DOMAIN)}
+	);
+	nodes.push_back(
+		{.inputs = {normalized},
+		 .outputs = {pixels},
+		 .name = "depth_colormap_argb",
+		 .op_type = "DepthColormapArgb",
+		 .domain = std::string(DEPTH_POSTPROCESSING_DOMAIN),
+		 .attributes = {
+			 {.name = "colormap",
+			  .type = OnnxAttributeType::Int,
+			  .int_value = (int64_t)options.colormap},
+			 {.name = "lut_size",
+			  .type = OnnxAttributeType::Int,
+			  .int_value = (int64_t)options.resolution},
+		 }}
+	);
+
+	// the depth output becomes an internal value, the nodes go after the last
+	// existing one to keep the topological order
+	const ProtobufField* last_node = nullptr;
+	for (const auto& field : graph_fields) {
+		if (field.number == GRAPH_NODE)
+			last_node = &field;
+	}
+	ProtobufWriter graph_writer;
+	for (const auto& field : graph_fields) {
+		if (field.number == GRAPH_OUTPUT) {
+			write_onnx_value_info(
+				graph_writer, GRAPH_OUTPUT, pixels, ONNX_INT32, dims
+			);
+			continue;
+		}
+		graph_writer.field(field);
+		if (&field == last_node) {
+			for (const auto& node : nodes)
+				node.write(graph_writer);
+		}
+	}
+
+	ProtobufWriter model_writer;
+	for (const auto& field : model_fields) {
+		if (field.number == MODEL_GRAPH)
+			model_writer.message(MODEL_GRAPH, graph_writer);
+		else
+			model_writer.field(field);
+	}
+	write_onnx_opset_import(model_writer, DEPTH_POSTPROCESSING_DOMAIN, 1);
+	write_onnx_metadata(
+		model_writer, DEPTH_POSTPROCESSING_METADATA_KEY,
+		format_depth_postprocessing(options)
+	);
+	LOG_INFO(
+		"appended the postprocessing ({}) to the output {}",
+		format_depth_postprocessing(options), depth_name
+	);
+	return model_writer.release();
+}
\ No newline at end of file
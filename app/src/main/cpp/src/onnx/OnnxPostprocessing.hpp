@@ -0,0 +1,48 @@
+#pragma once
+
+#include "processing/Colormaps.hpp"
+#include <cstddef>
+#include <onnxruntime_cxx_api.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// domain of the custom postprocessing ops
+constexpr std::string_view DEPTH_POSTPROCESSING_DOMAIN =
+	"com.example.depthcamera";
+
+/// metadata_props key of models with appended postprocessing, the value
+/// lists the options
+constexpr std::string_view DEPTH_POSTPROCESSING_METADATA_KEY =
+	"depthcamera.postprocessing";
+
+struct DepthPostprocessingOptions {
+	/// averages blocks of factor x factor depth pixels, 1 keeps the
+	/// resolution
+	size_t downscale_factor = 1;
+	Colormap colormap = Colormap::Inferno;
+	ColormapResolution resolution = ColormapResolution::Entries1024;
+};
+
+/// metadata value of the options
+std::string
+format_depth_postprocessing(const DepthPostprocessingOptions& options);
+
+/// registers the ops of DEPTH_POSTPROCESSING_DOMAIN for the cpu provider,
+/// they split their work over the intra op threads of onnxruntime:
+/// - DepthDownscale (factor): box filter of the last two dimensions
+/// - DepthRangeNormalize: min_max_scaling of every frame (the dimensions
+///   before the last two)
+/// - DepthColormapArgb (colormap, lut_size): colormap_depth_argb into int32
+void add_depth_postprocessing_ops(Ort::SessionOptions& session_options);
+
+/// appends the ops to the single output of the model, which then outputs the
+/// colormapped relative depth as argb ints (as Bitmap.setPixels expects
+/// them) in the shape of the (downscaled) depth. the model is marked with
+/// DEPTH_POSTPROCESSING_METADATA_KEY, throws std::invalid_argument if it
+/// already is
+std::vector<std::byte> append_depth_postprocessing(
+	std::span<const std::byte> model_data,
+	const DepthPostprocessingOptions& options
+);
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include "OnnxProtobuf.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+// onnx stores raw tensor data and fixed32 values in little endian
+static_assert(std::endian::native == std::endian::little);
+
+static uint64_t read_varint(std::span<const std::byte> data, size_t& offset) {
+	uint64_t value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		if (offset >= data.size())
+			throw std::invalid_argument("varint");
+		const auto byte = (uint8_t)data[offset++];
+		value |= (uint64_t)(byte & 0x7fU) << shift;
+		if ((byte & 0x80U) == 0)
+			return value;
+	}
+	throw std::invalid_argument("varint");
+}
+
+std::string_view ProtobufField::string() const {
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+std::vector<ProtobufField> parse_protobuf(std::span<const std::byte> message) {
+	std::vector<ProtobufField> fields;
+	size_t offset = 0;
+	while (offset < message.size()) {
+		const size_t start = offset;
+		const uint64_t tag = read_varint(message, offset);
+		ProtobufField field{
+			.number = (uint32_t)(tag >> 3),
+			.type = (WireType)(tag & 7U),
+		};
+		switch (field.type) {
+		case WireType::Varint:
+			field.value = read_varint(message, offset);
+			break;
+		case WireType::Fixed64:
+		case WireType::Fixed32: {
+			const size_t size = field.type == WireType::Fixed64 ? 8 : 4;
+			if (message.size() - offset < size)
+				throw std::invalid_argument("message");
+			std::memcpy(&field.value, &message[offset], size);
+			offset += size;
+			break;
+		}
+		case WireType::Bytes: {
+			const uint64_t size = read_varint(message, offset);
+			if (message.size() - offset < size)
+				throw std::invalid_argument("message");
+			field.bytes = message.subspan(offset, size);
+			offset += size;
+			break;
+		}
+		default:
+			// groups are not used by onnx.proto
+			throw std::invalid_argument("wire type");
+		}
+		field.encoded = message.subspan(start, offset - start);
+		fields.push_back(field);
+	}
+	return fields;
+}
+
+void append_varints(const ProtobufField& field, std::vector<int64_t>& values) {
+	if (field.type == WireType::Varint) {
+		values.push_back((int64_t)field.value);
+		return;
+	}
+	if (field.type != WireType::Bytes)
+		throw std::invalid_argument("field");
+	size_t offset = 0;
+	while (offset < field.bytes.size())
+		values.push_back((int64_t)read_varint(field.bytes, offset));
+}
+
+void append_floats(const ProtobufField& field, std::vector<float>& values) {
+	if (field.type == WireType::Fixed32) {
+		values.push_back(std::bit_cast<float>((uint32_t)field.value));
+		return;
+	}
+	if (field.type != WireType::Bytes || field.bytes.size() % sizeof(float))
+		throw std::invalid_argument("field");
+	const size_t start = values.size();
+	values.resize(start + field.bytes.size() / sizeof(float));
+	std::memcpy(&values[start], field.bytes.data(), field.bytes.size());
+}
+
+void ProtobufWriter::raw_varint(uint64_t value) {
+	while (value >= 0x80U) {
+		buffer.push_back((std::byte)((value & 0x7fU) | 0x80U));
+		value >>= 7;
+	}
+	buffer.push_back((std::byte)value);
+}
+
+void ProtobufWriter::tag(uint32_t number, WireType type) {
+	raw_varint(((uint64_t)number << 3) | (uint64_t)type);
+}
+
+void ProtobufWriter::varint(uint32_t number, uint64_t value) {
+	tag(number, WireType::Varint);
+	raw_varint(value);
+}
+
+void ProtobufWriter::fixed32(uint32_t number, uint32_t value) {
+	tag(number, WireType::Fixed32);
+	const auto bytes = std::bit_cast<std::array<std::byte, 4>>(value);
+	buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+void ProtobufWriter::bytes(uint32_t number, std::span<const std::byte> value) {
+	tag(number, WireType::Bytes);
+	raw_varint(value.size());
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+void ProtobufWriter::string(uint32_t number, std::string_view value) {
+	bytes(number, std::as_bytes(std::span(value)));
+}
+
+void ProtobufWriter::message(uint32_t number, const ProtobufWriter& message) {
+	bytes(number, message.data());
+}
+
+void ProtobufWriter::packed_varints(
+	uint32_t number,
+	std::span<const int64_t> values
+) {
+	ProtobufWriter packed;
+	for (const int64_t value : values)
+		packed.raw_varint((uint64_t)value);
+	bytes(number, packed.data());
+}
+
+void ProtobufWriter::packed_floats(
+	uint32_t number,
+	std::span<const float> values
+) {
+	bytes(number, std::as_bytes(values));
+}
+
+void ProtobufWriter::field(const ProtobufField& field) {
+	buffer.insert(buffer.end(), field.encoded.begin(), field.encoded.end());
+}
+
+void OnnxAttribute::write(ProtobufWriter& writer) const {
+	if (!encoded.empty()) {
+		writer.field({.encoded = encoded});
+		return;
+	}
+
+	ProtobufWriter attribute;
+	attribute.string(ATTRIBUTE_NAME, name);
+	attribute.varint(ATTRIBUTE_TYPE, (uint64_t)type);
+	switch (type) {
+	case OnnxAttributeType::Float:
+		attribute.fixed32(
+			ATTRIBUTE_FLOAT, std::bit_cast<uint32_t>(float_value)
+		);
+		break;
+	case OnnxAttributeType::Int:
+		attribute.varint(ATTRIBUTE_INT, (uint64_t)int_value);
+		break;
+	case OnnxAttributeType::String:
+		attribute.string(ATTRIBUTE_STRING, string_value);
+		break;
+	case OnnxAttributeType::Floats:
+		attribute.packed_floats(ATTRIBUTE_FLOATS, floats);
+		break;
+	case OnnxAttributeType::Ints:
+		attribute.packed_varints(ATTRIBUTE_INTS, ints);
+		break;
+	}
+	writer.message(NODE_ATTRIBUTE, attribute);
+}
+
+static OnnxAttribute parse_onnx_attribute(const ProtobufField& field) {
+	OnnxAttribute attribute{.encoded = field.encoded};
+	for (const auto& attribute_field : parse_protobuf(field.bytes)) {
+		switch (attribute_field.number) {
+		case ATTRIBUTE_NAME:
+			attribute.name = attribute_field.string();
+			break;
+		case ATTRIBUTE_TYPE:
+			attribute.type = (OnnxAttributeType)attribute_field.value;
+			break;
+		case ATTRIBUTE_FLOAT:
+			attribute.float_value =
+				std::bit_cast<float>((uint32_t)attribute_field.value);
+			break;
+		case ATTRIBUTE_INT:
+			attribute.int_value = (int64_t)attribute_field.value;
+			break;
+		case ATTRIBUTE_STRING:
+			attribute.string_value = attribute_field.string();
+			break;
+		case ATTRIBUTE_FLOATS:
+			append_floats(attribute_field, attribute.floats);
+			break;
+		case ATTRIBUTE_INTS:
+			append_varints(attribute_field, attribute.ints);
+			break;
+		default:
+			break;
+		}
+	}
+	return attribute;
+}
+
+const OnnxAttribute* OnnxNode::attribute(std::string_view name) const {
+	const auto found =
+		std::ranges::find(attributes, name, &OnnxAttribute::name);
+	return found == attributes.end() ? nullptr : &*found;
+}
+
+void OnnxNode::write(ProtobufWriter& writer) const {
+	if (!encoded.empty()) {
+		writer.field({.encoded = encoded});
+		return;
+	}
+
+	ProtobufWriter node;
+	for (const auto& input : inputs)
+		node.string(NODE_INPUT, input);
+	for (const auto& output : outputs)
+		node.string(NODE_OUTPUT, output);
+	if (!name.empty())
+		node.string(NODE_NAME, name);
+	node.string(NODE_OP_TYPE, op_type);
+	for (const auto& attribute : attributes)
+		attribute.write(node);
+	if (!domain.empty())
+		node.string(NODE_DOMAIN, domain);
+	writer.message(GRAPH_NODE, node);
+}
+
+OnnxNode parse_onnx_node(const ProtobufField& field) {
+	OnnxNode node{.encoded = field.encoded};
+	for (const auto& node_field : parse_protobuf(field.bytes)) {
+		switch (node_field.number) {
+		case NODE_INPUT:
+			node.inputs.emplace_back(node_field.string());
+			break;
+		case NODE_OUTPUT:
+			node.outputs.emplace_back(node_field.string());
+			break;
+		case NODE_NAME:
+			node.name = node_field.string();
+			break;
+		case NODE_OP_TYPE:
+			node.op_type = node_field.string();
+			break;
+		case NODE_ATTRIBUTE:
+			node.attributes.push_back(parse_onnx_attribute(node_field));
+			break;
+		case NODE_DOMAIN:
+			node.domain = node_field.string();
+			break;
+		default:
+			// doc strings and metadata are dropped when the node changes
+			break;
+		}
+	}
+	// "ai.onnx" is an alias of the default domain
+	if (node.domain == "ai.onnx")
+		node.domain.clear();
+	return node;
+}
+
+void OnnxFloatTensor::write(ProtobufWriter& writer) const {
+	ProtobufWriter tensor;
+	tensor.packed_varints(TENSOR_DIMS, dims);
+	tensor.varint(TENSOR_DATA_TYPE, ONNX_FLOAT);
+	tensor.string(TENSOR_NAME, name);
+	tensor.bytes(TENSOR_RAW_DATA, std::as_bytes(std::span(values)));
+	writer.message(GRAPH_INITIALIZER, tensor);
+}
+
+std::optional<OnnxFloatTensor>
+parse_onnx_float_tensor(const ProtobufField& field) {
+	OnnxFloatTensor tensor;
+	int64_t data_type = 0;
+	std::optional<ProtobufField> raw_data;
+	for (const auto& tensor_field : parse_protobuf(field.bytes)) {
+		switch (tensor_field.number) {
+		case TENSOR_DIMS:
+			append_varints(tensor_field, tensor.dims);
+			break;
+		case TENSOR_DATA_TYPE:
+			data_type = (int64_t)tensor_field.value;
+			break;
+		case TENSOR_FLOAT_DATA:
+			append_floats(tensor_field, tensor.values);
+			break;
+		case TENSOR_NAME:
+			tensor.name = tensor_field.string();
+			break;
+		case TENSOR_RAW_DATA:
+			raw_data = tensor_field;
+			break;
+		case TENSOR_DATA_LOCATION:
+			// 1 is EXTERNAL
+			if (tensor_field.value != 0)
+				return std::nullopt;
+			break;
+		default:
+			break;
+		}
+	}
+	if (data_type != ONNX_FLOAT)
+		return std::nullopt;
+	// little endian floats, read like packed float_data
+	if (raw_data.has_value())
+		append_floats(*raw_data, tensor.values);
+
+	size_t element_count = 1;
+	for (const int64_t dim : tensor.dims)
+		element_count *= (size_t)std::max<int64_t>(dim, 0);
+	if (tensor.values.size() != element_count)
+		return std::nullopt;
+	return tensor;
+}
+
+std::string_view parse_onnx_name(const ProtobufField& field, uint32_t number) {
+	for (const auto& name_field : parse_protobuf(field.bytes)) {
+		if (name_field.number == number && name_field.type == WireType::Bytes)
+			return name_field.string();
+	}
+	return {};
+}
+
+/// the first Bytes field with the number, empty if missing
+static std::span<const std::byte>
+find_submessage(std::span<const std::byte> message, uint32_t number) {
+	for (const auto& field : parse_protobuf(message)) {
+		if (field.number == number && field.type == WireType::Bytes)
+			return field.bytes;
+	}
+	return {};
+}
+
+std::vector<int64_t> parse_onnx_value_shape(const ProtobufField& field) {
+	const auto type = find_submessage(field.bytes, VALUE_INFO_TYPE);
+	const auto tensor_type = find_submessage(type, TYPE_TENSOR_TYPE);
+	const auto shape = find_submessage(tensor_type, TENSOR_TYPE_SHAPE);
+
+	std::vector<int64_t> dims;
+	for (const auto& dim_field : parse_protobuf(shape)) {
+		if (dim_field.number != SHAPE_DIM)
+			continue;
+		int64_t dim = -1;
+		for (const auto& value_field : parse_protobuf(dim_field.bytes)) {
+			if (value_field.number == DIMENSION_VALUE &&
+				value_field.type == WireType::Varint)
+				dim = (int64_t)value_field.value;
+		}
+		dims.push_back(dim);
+	}
+	return dims;
+}
+
+void write_onnx_value_info(
+	ProtobufWriter& graph,
+	uint32_t number,
+	std::string_view name,
+	int32_t element_type,
+	std::span<const int64_t> dims
+) {
+	ProtobufWriter shape;
+	for (const int64_t dim : dims) {
+		// dynamic dimensions are written without a value
+		ProtobufWriter dimension;
+		if (dim >= 0)
+			dimension.varint(DIMENSION_VALUE, (uint64_t)dim);
+		shape.message(SHAPE_DIM, dimension);
+	}
+	ProtobufWriter tensor_type;
+	tensor_type.varint(TENSOR_TYPE_ELEMENT_TYPE, (uint64_t)element_type);
+	tensor_type.message(TENSOR_TYPE_SHAPE, shape);
+	ProtobufWriter type;
+	type.message(TYPE_TENSOR_TYPE, tensor_type);
+
+	ProtobufWriter value_info;
+	value_info.string(VALUE_INFO_NAME, name);
+	value_info.message(VALUE_INFO_TYPE, type);
+	graph.message(number, value_info);
+}
+
+std::vector<std::string>
+collect_onnx_names(std::span<const ProtobufField> graph_fields) {
+	std::vector<std::string> names;
+	for (const auto& field : graph_fields) {
+		if (field.number == GRAPH_NODE) {
+			for (const auto& node_field : parse_protobuf(field.bytes)) {
+				if (node_field.number == NODE_OUTPUT)
+					names.emplace_back(node_field.string());
+			}
+		} else if (field.number == GRAPH_INITIALIZER) {
+			names.emplace_back(parse_onnx_name(field, TENSOR_NAME));
+		} else if (field.number == GRAPH_INPUT) {
+			names.emplace_back(parse_onnx_name(field, VALUE_INFO_NAME));
+		}
+	}
+	return names;
+}
+
+int64_t parse_onnx_opset_version(std::span<const ProtobufField> model_fields) {
+	for (const auto& field : model_fields) {
+		if (field.number != MODEL_OPSET_IMPORT)
+			continue;
+		std::string_view domain;
+		int64_t version = 0;
+		for (const auto& opset_field : parse_protobuf(field.bytes)) {
+			if (opset_field.number == OPSET_DOMAIN)
+				domain = opset_field.string();
+			else if (opset_field.number == OPSET_VERSION)
+				version = (int64_t)opset_field.value;
+		}
+		if (domain.empty() || domain == "ai.onnx")
+			return version;
+	}
+	return 0;
+}
+
+std::optional<std::string_view> find_onnx_metadata(
+	std::span<const ProtobufField> model_fields,
+	std::string_view key
+) {
+	for (const auto& field : model_fields) {
+		if (field.number != MODEL_METADATA_PROPS)
+			continue;
+		std::string_view entry_key;
+		std::string_view entry_value;
+		for (const auto& entry_field : parse_protobuf(field.bytes)) {
+			if (entry_field.number == STRING_ENTRY_KEY)
+				entry_key = entry_field.string();
+			else if (entry_field.number == STRING_ENTRY_VALUE)
+				entry_value = entry_field.string();
+		}
+		if (entry_key == key)
+			return entry_value;
+	}
+	return std::nullopt;
+}
+
+void write_onnx_opset_import(
+	ProtobufWriter& model,
+	std::string_view domain,
+	int64_t version
+) {
+	ProtobufWriter opset;
+	opset.string(OPSET_DOMAIN, domain);
+	opset.varint(OPSET_VERSION, (uint64_t)version);
+	model.message(MODEL_OPSET_IMPORT, opset);
+}
+
+void write_onnx_metadata(
+	ProtobufWriter& model,
+	std::string_view key,
+	std::string_view value
+) {
+	ProtobufWriter entry;
+	entry.string(STRING_ENTRY_KEY, key);
+	entry.string(STRING_ENTRY_VALUE, value);
+	model.message(MODEL_METADATA_PROPS, entry);
+}
+
+std::string
+make_unique_onnx_name(std::string_view base, std::vector<std::string>& names) {
+	std::string name(base);
+	for (size_t suffix = 1; std::ranges::find(names, name) != names.end();
+		 suffix++)
+		name = std::string(base) + "_" + std::to_string(suffix);
+	names.push_back(name);
+	return name;
+}
\ No newline at end of file
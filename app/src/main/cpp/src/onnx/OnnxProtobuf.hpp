@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// protobuf wire types used by onnx.proto
+enum class WireType : uint8_t {
+	Varint = 0,
+	Fixed64 = 1,
+	Bytes = 2,
+	Fixed32 = 5,
+};
+
+/// a single field of a serialized protobuf message
+struct ProtobufField {
+	uint32_t number = 0;
+	WireType type = WireType::Varint;
+	/// varint or fixed value
+	uint64_t value = 0;
+	/// payload of Bytes fields (strings, submessages, packed values)
+	std::span<const std::byte> bytes;
+	/// the whole field with its tag, copied as it is when unchanged
+	std::span<const std::byte> encoded;
+
+	[[nodiscard]] std::string_view string() const;
+};
+
+/// the fields of a message in their serialized order, throws
+/// std::invalid_argument on malformed messages
+std::vector<ProtobufField> parse_protobuf(std::span<const std::byte> message);
+
+/// values of a repeated varint field, packed or not
+void append_varints(const ProtobufField& field, std::vector<int64_t>& values);
+
+/// values of a repeated float field, packed or not
+void append_floats(const ProtobufField& field, std::vector<float>& values);
+
+/// serializes a message field by field
+class ProtobufWriter {
+  public:
+	void varint(uint32_t number, uint64_t value);
+	void fixed32(uint32_t number, uint32_t value);
+	void bytes(uint32_t number, std::span<const std::byte> value);
+	void string(uint32_t number, std::string_view value);
+	void message(uint32_t number, const ProtobufWriter& message);
+	void packed_varints(uint32_t number, std::span<const int64_t> values);
+	void packed_floats(uint32_t number, std::span<const float> values);
+	/// copies a parsed field as it is
+	void field(const ProtobufField& field);
+
+	[[nodiscard]] std::span<const std::byte> data() const { return buffer; }
+	std::vector<std::byte> release() { return std::move(buffer); }
+
+  private:
+	void tag(uint32_t number, WireType type);
+	void raw_varint(uint64_t value);
+
+	std::vector<std::byte> buffer;
+};
+
+// field numbers of onnx.proto (ir version 10)
+constexpr uint32_t MODEL_GRAPH = 7;
+constexpr uint32_t MODEL_OPSET_IMPORT = 8;
+constexpr uint32_t MODEL_METADATA_PROPS = 14;
+constexpr uint32_t OPSET_DOMAIN = 1;
+constexpr uint32_t OPSET_VERSION = 2;
+constexpr uint32_t STRING_ENTRY_KEY = 1;
+constexpr uint32_t STRING_ENTRY_VALUE = 2;
+constexpr uint32_t GRAPH_NODE = 1;
+constexpr uint32_t GRAPH_INITIALIZER = 5;
+constexpr uint32_t GRAPH_INPUT = 11;
+constexpr uint32_t GRAPH_OUTPUT = 12;
+constexpr uint32_t NODE_INPUT = 1;
+constexpr uint32_t NODE_OUTPUT = 2;
+constexpr uint32_t NODE_NAME = 3;
+constexpr uint32_t NODE_OP_TYPE = 4;
+constexpr uint32_t NODE_ATTRIBUTE = 5;
+constexpr uint32_t NODE_DOMAIN = 7;
+constexpr uint32_t ATTRIBUTE_NAME = 1;
+constexpr uint32_t ATTRIBUTE_FLOAT = 2;
+constexpr uint32_t ATTRIBUTE_INT = 3;
+constexpr uint32_t ATTRIBUTE_STRING = 4;
+constexpr uint32_t ATTRIBUTE_FLOATS = 7;
+constexpr uint32_t ATTRIBUTE_INTS = 8;
+constexpr uint32_t ATTRIBUTE_TYPE = 20;
+constexpr uint32_t TENSOR_DIMS = 1;
+constexpr uint32_t TENSOR_DATA_TYPE = 2;
+constexpr uint32_t TENSOR_FLOAT_DATA = 4;
+constexpr uint32_t TENSOR_NAME = 8;
+constexpr uint32_t TENSOR_RAW_DATA = 9;
+constexpr uint32_t TENSOR_DATA_LOCATION = 14;
+constexpr uint32_t VALUE_INFO_NAME = 1;
+constexpr uint32_t VALUE_INFO_TYPE = 2;
+constexpr uint32_t TYPE_TENSOR_TYPE = 1;
+constexpr uint32_t TENSOR_TYPE_ELEMENT_TYPE = 1;
+constexpr uint32_t TENSOR_TYPE_SHAPE = 2;
+constexpr uint32_t SHAPE_DIM = 1;
+constexpr uint32_t DIMENSION_VALUE = 1;
+
+/// AttributeProto.AttributeType
+enum class OnnxAttributeType : int32_t {
+	Float = 1,
+	Int = 2,
+	String = 3,
+	Floats = 6,
+	Ints = 7,
+};
+
+/// TensorProto.DataType
+constexpr int32_t ONNX_FLOAT = 1;
+constexpr int32_t ONNX_INT32 = 6;
+
+struct OnnxAttribute {
+	std::string name;
+	OnnxAttributeType type = OnnxAttributeType::Int;
+	float float_value = 0.0f;
+	int64_t int_value = 0;
+	std::string string_value;
+	std::vector<float> floats;
+	std::vector<int64_t> ints;
+	/// set for parsed attributes, which are written back unchanged (they can
+	/// be of types not decoded here, like tensors or graphs)
+	std::span<const std::byte> encoded;
+
+	void write(ProtobufWriter& writer) const;
+};
+
+struct OnnxNode {
+	std::vector<std::string> inputs;
+	std::vector<std::string> outputs;
+	std::string name;
+	std::string op_type;
+	/// empty for the default onnx domain
+	std::string domain;
+	std::vector<OnnxAttribute> attributes;
+	/// set for parsed nodes, cleared when the node is changed
+	std::span<const std::byte> encoded;
+
+	[[nodiscard]] const OnnxAttribute* attribute(std::string_view name) const;
+	void write(ProtobufWriter& writer) const;
+};
+
+OnnxNode parse_onnx_node(const ProtobufField& field);
+
+/// float tensor with its values, used for initializers
+struct OnnxFloatTensor {
+	std::string name;
+	std::vector<int64_t> dims;
+	std::vector<float> values;
+
+	void write(ProtobufWriter& writer) const;
+};
+
+/// nullopt for tensors that are not float or that store their data
+/// externally
+std::optional<OnnxFloatTensor>
+parse_onnx_float_tensor(const ProtobufField& field);
+
+/// name of a TensorProto or ValueInfoProto
+std::string_view parse_onnx_name(const ProtobufField& field, uint32_t number);
+
+/// dimensions of a ValueInfoProto of a tensor, -1 for dynamic dimensions
+std::vector<int64_t> parse_onnx_value_shape(const ProtobufField& field);
+
+/// writes a ValueInfoProto of a tensor, -1 for dynamic dimensions
+void write_onnx_value_info(
+	ProtobufWriter& graph,
+	uint32_t number,
+	std::string_view name,
+	int32_t element_type,
+	std::span<const int64_t> dims
+);
+
+/// names of the node outputs, initializers and inputs of a graph
+std::vector<std::string>
+collect_onnx_names(std::span<const ProtobufField> graph_fields);
+
+/// version of the default domain in the opset imports of a model, 0 if
+/// missing
+int64_t parse_onnx_opset_version(std::span<const ProtobufField> model_fields);
+
+/// value of a metadata_props entry of a model
+std::optional<std::string_view> find_onnx_metadata(
+	std::span<const ProtobufField> model_fields,
+	std::string_view key
+);
+
+void write_onnx_opset_import(
+	ProtobufWriter& model,
+	std::string_view domain,
+	int64_t version
+);
+
+void write_onnx_metadata(
+	ProtobufWriter& model,
+	std::string_view key,
+	std::string_view value
+);
+
+/// base, or base with a numbered suffix if a name of the graph already uses
+/// it. the result is added to names
+std::string
+make_unique_onnx_name(std::string_view base, std::vector<std::string>& names);
\ No newline at end of file
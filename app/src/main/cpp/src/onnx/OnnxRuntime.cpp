@@ -1,4 +1,6 @@
 #include "OnnxRuntime.hpp"
+#include "OnnxNormalizationFolding.hpp"
+#include "OnnxPostprocessing.hpp"
 #include "onnxruntime_c_api.h"
 #include "onnxruntime_cxx_api.h"
 #include "utils/Exceptions.hpp"
@@ -6,7 +8,10 @@
 #include "utils/Profiling.hpp"
 
 #include <cpu_provider_factory.h>
+#include <optional>
+#ifdef __ANDROID__
 #include <nnapi_provider_factory.h>
+#endif
 
 static void onnx_logging_callback(
 	void* /*param*/,
@@ -33,16 +38,26 @@ static void onnx_logging_callback(
 	}
 }
 
-OnnxRuntime::OnnxRuntime(std::span<const std::byte> model_data) {
+OnnxRuntime::OnnxRuntime(
+	std::span<const std::byte> model_data,
+	std::string_view model_name,
+	OnnxRuntimeOptions options
+)
+	: model_name(model_name) {
 	PROFILE_DEPTH_SCOPE("Init OnnxRuntime")
 
+	const ResidentMemoryDelta session_delta;
+
 	env = Ort::Env(
 		ORT_LOGGING_LEVEL_WARNING, "Default", onnx_logging_callback, nullptr
 	);
 
 	auto session_options = Ort::SessionOptions();
-	session_options.SetInterOpNumThreads(4);
+	session_options.SetInterOpNumThreads(options.inter_op_thread_count);
 	session_options.SetGraphOptimizationLevel(ORT_ENABLE_ALL);
+	// needed by models with append_depth_postprocessing, their ops run on the
+	// intra op threads
+	add_depth_postprocessing_ops(session_options);
 
 	throw_on_onnx_status(
 		Ort::Status(OrtSessionOptionsAppendExecutionProvider_CPU(
@@ -50,46 +65,89 @@ OnnxRuntime::OnnxRuntime(std::span<const std::byte> model_data) {
 		))
 	);
 
-	// TODO: test out what impact NNAPI_FLAG_USE_FP16 has
-	const uint32_t nnapi_flags =
-		NNAPI_FLAG_USE_FP16; // | NNAPI_FLAG_CPU_DISABLED;
-
-	throw_on_onnx_status(
-		Ort::Status(OrtSessionOptionsAppendExecutionProvider_Nnapi(
-			session_options, nnapi_flags
-		))
-	);
+#ifdef __ANDROID__
+	if (options.use_nnapi) {
+		// the accuracy cost of NNAPI_FLAG_USE_FP16 can be measured with the
+		// DepthEvaluation tool
+		uint32_t nnapi_flags = 0; // | NNAPI_FLAG_CPU_DISABLED;
+		if (options.use_fp16)
+			nnapi_flags |= NNAPI_FLAG_USE_FP16;
+
+		throw_on_onnx_status(
+			Ort::Status(OrtSessionOptionsAppendExecutionProvider_Nnapi(
+				session_options, nnapi_flags
+			))
+		);
+	}
+#endif
 
 	session = Ort::Session(
 		env, model_data.data(), model_data.size_bytes(), session_options
 	);
 
+	session_memory = TrackedMemory(
+		get_depth_profiling_frame().memory(),
+		std::format("OnnxRuntime ({}): session", model_name),
+		session_delta.finish()
+	);
+
 	const auto input_names = session.GetInputNames();
 	if (input_names.size() != 1)
 		throw OnnxInvalidInputCount(input_names.size());
 	input_name = input_names[0];
 
+	// the shape info is a view into the type info, which has to outlive it
+	const auto input_type_info = session.GetInputTypeInfo(0);
 	const auto input_type_and_shape_info =
-		session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo();
+		input_type_info.GetTensorTypeAndShapeInfo();
 	input_shape = input_type_and_shape_info.GetShape();
 	input_type = input_type_and_shape_info.GetElementType();
 
+	const Ort::AllocatorWithDefaultOptions allocator;
+	folded_normalization =
+		session.GetModelMetadata().LookupCustomMetadataMapAllocated(
+			FOLDED_NORMALIZATION_METADATA_KEY.data(), allocator
+		) != nullptr;
+	depth_postprocessing =
+		session.GetModelMetadata().LookupCustomMetadataMapAllocated(
+			DEPTH_POSTPROCESSING_METADATA_KEY.data(), allocator
+		) != nullptr;
+
 	const auto output_names = session.GetOutputNames();
 	if (output_names.size() != 1)
 		throw OnnxInvalidOutputCount(output_names.size());
 	output_name = output_names[0];
 
+	const auto output_type_info = session.GetOutputTypeInfo(0);
 	const auto output_type_and_shape_info =
-		session.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo();
+		output_type_info.GetTensorTypeAndShapeInfo();
 	output_shape = output_type_and_shape_info.GetShape();
 	output_type = output_type_and_shape_info.GetElementType();
 
 	memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU);
 }
 
+std::span<const int64_t> OnnxRuntime::get_batch_shape(
+	const std::vector<int64_t>& model_shape,
+	std::vector<int64_t>& batch_shape,
+	size_t batch_size
+) const {
+	if (model_shape.empty())
+		return model_shape;
+
+	// dynamic dimensions are -1
+	if (model_shape[0] > 0 && (size_t)model_shape[0] != batch_size)
+		throw OnnxFixedBatchSize(model_shape[0], batch_size);
+
+	batch_shape = model_shape;
+	batch_shape[0] = (int64_t)batch_size;
+	return batch_shape;
+}
+
 void OnnxRuntime::run_inference_raw(
 	std::span<std::byte> input_data,
-	std::span<std::byte> output_data
+	std::span<std::byte> output_data,
+	size_t batch_size
 ) {
 	PROFILE_DEPTH_SCOPE("Run Inference")
 
@@ -99,13 +157,18 @@ void OnnxRuntime::run_inference_raw(
 	{
 		PROFILE_DEPTH_SCOPE("Preparing Inference")
 
+		const auto batch_input =
+			get_batch_shape(input_shape, batch_input_shape, batch_size);
+		const auto batch_output =
+			get_batch_shape(output_shape, batch_output_shape, batch_size);
+
 		input_tensor = Ort::Value::CreateTensor(
 			memory_info, input_data.data(), input_data.size_bytes(),
-			input_shape.data(), input_shape.size(), input_type
+			batch_input.data(), batch_input.size(), input_type
 		);
 		output_tensor = Ort::Value::CreateTensor(
 			memory_info, output_data.data(), output_data.size_bytes(),
-			output_shape.data(), output_shape.size(), output_type
+			batch_output.data(), batch_output.size(), output_type
 		);
 	}
 
@@ -116,9 +179,28 @@ void OnnxRuntime::run_inference_raw(
 		const char* output_names{output_name.data()};
 		const Ort::RunOptions run_options;
 
+#if DEPTH_CAMERA_PROFILING_MODE != PROFILING_MODE_OFF
+		// the arena only grows during the first run, later runs don't read
+		// the resident memory
+		std::optional<ResidentMemoryDelta> arena_delta;
+		if (!arena_memory_measured)
+			arena_delta.emplace();
+#endif
+
 		session.Run(
 			run_options, &input_names, &input_tensor, 1, &output_names,
 			&output_tensor, 1
 		);
+
+#if DEPTH_CAMERA_PROFILING_MODE != PROFILING_MODE_OFF
+		if (arena_delta.has_value()) {
+			arena_memory = TrackedMemory(
+				get_depth_profiling_frame().memory(),
+				std::format("OnnxRuntime ({}): arena", model_name),
+				arena_delta->finish()
+			);
+			arena_memory_measured = true;
+		}
+#endif
 	}
 }
\ No newline at end of file
@@ -1,13 +1,28 @@
 #pragma once
 
 #include "OnnxUtils.hpp"
+#include "utils/MemoryProfiling.hpp"
 #include <cassert>
 #include <onnxruntime_cxx_api.h>
 #include <span>
+#include <string_view>
+
+struct OnnxRuntimeOptions {
+	/// only available on android, the cpu provider is always appended as
+	/// fallback
+	bool use_nnapi = true;
+	/// NNAPI_FLAG_USE_FP16: lets nnapi compute in fp16
+	bool use_fp16 = true;
+	int inter_op_thread_count = 4;
+};
 
 class OnnxRuntime {
   public:
-	explicit OnnxRuntime(std::span<const std::byte> model_data);
+	explicit OnnxRuntime(
+		std::span<const std::byte> model_data,
+		std::string_view model_name,
+		OnnxRuntimeOptions options = {}
+	);
 
 	OnnxRuntime(OnnxRuntime&&) = delete;
 	OnnxRuntime(const OnnxRuntime&) = delete;
@@ -15,8 +30,32 @@ class OnnxRuntime {
 	void operator=(const OnnxRuntime&) = delete;
 	~OnnxRuntime() = default;
 
+	/// the model takes its input before normalize_rgb, see
+	/// fold_input_normalization
+	[[nodiscard]] bool has_folded_normalization() const {
+		return folded_normalization;
+	}
+
+	/// the model outputs colormapped argb ints instead of depth, see
+	/// append_depth_postprocessing
+	[[nodiscard]] bool has_depth_postprocessing() const {
+		return depth_postprocessing;
+	}
+
 	template<typename I, typename O>
 	void run_inference(std::span<I> input_data, std::span<O> output_data) {
+		run_batch_inference(input_data, output_data, 1);
+	}
+
+	/// runs batch_size inputs (stored after each other) in a single run, the
+	/// model needs a dynamic batch dimension for batch sizes other than its
+	/// fixed one
+	template<typename I, typename O>
+	void run_batch_inference(
+		std::span<I> input_data,
+		std::span<O> output_data,
+		size_t batch_size
+	) {
 		if (input_type != Ort::TypeToTensorType<I>::type)
 			throw std::invalid_argument("input_type");
 		if (output_type != Ort::TypeToTensorType<O>::type)
@@ -24,16 +63,42 @@ class OnnxRuntime {
 
 		return run_inference_raw(
 			std::as_writable_bytes(input_data),
-			std::as_writable_bytes(output_data)
+			std::as_writable_bytes(output_data), batch_size
+		);
+	}
+
+	/// runs a single input, onnxruntime writes the output directly into a
+	/// buffer of the runtime that stays valid until the next run
+	template<typename I>
+	std::span<const float>
+	run_inference_in_place(std::span<I> input_data, size_t output_size) {
+		if (input_type != Ort::TypeToTensorType<I>::type)
+			throw std::invalid_argument("input_type");
+		if (output_type != Ort::TypeToTensorType<float>::type)
+			throw std::invalid_argument("output_type");
+
+		output_buffer.resize(output_size);
+		run_inference_raw(
+			std::as_writable_bytes(input_data),
+			std::as_writable_bytes(std::span(output_buffer)), 1
 		);
+		return output_buffer;
 	}
 
   private:
 	void run_inference_raw(
 		std::span<std::byte> input_data,
-		std::span<std::byte> output_data
+		std::span<std::byte> output_data,
+		size_t batch_size
 	);
 
+	/// shape with the batch dimension (the first one) set to batch_size
+	std::span<const int64_t> get_batch_shape(
+		const std::vector<int64_t>& model_shape,
+		std::vector<int64_t>& batch_shape,
+		size_t batch_size
+	) const;
+
 	Ort::Env env = nullptr;
 	Ort::Session session{nullptr};
 	Ort::MemoryInfo memory_info{nullptr};
@@ -42,7 +107,26 @@ class OnnxRuntime {
 	std::vector<int64_t> input_shape;
 	ONNXTensorElementDataType input_type;
 
+	bool folded_normalization = false;
+	bool depth_postprocessing = false;
+
 	std::string output_name;
 	std::vector<int64_t> output_shape;
 	ONNXTensorElementDataType output_type;
+
+	/// shapes of the current run, kept so that runs don't allocate
+	std::vector<int64_t> batch_input_shape;
+	std::vector<int64_t> batch_output_shape;
+
+	/// output of run_inference_in_place
+	std::vector<float> output_buffer;
+
+	std::string model_name;
+	/// resident memory growth while creating the session (parsed and
+	/// optimized model)
+	TrackedMemory session_memory;
+	/// resident memory growth during the first inference, when the arena
+	/// allocator reserves its chunks
+	TrackedMemory arena_memory;
+	bool arena_memory_measured = false;
 };
\ No newline at end of file
@@ -54,6 +54,20 @@ class OnnxInvalidOutputCount : public std::runtime_error {
 	size_t actual_count;
 };
 
+class OnnxFixedBatchSize : public std::runtime_error {
+  public:
+	explicit OnnxFixedBatchSize(int64_t model_batch_size, size_t batch_size)
+		: model_batch_size(model_batch_size),
+		  std::runtime_error(
+			  std::format(
+				  "model has a fixed batch size of {}, can't run a batch of {}",
+				  model_batch_size, batch_size
+			  )
+		  ) {}
+
+	int64_t model_batch_size;
+};
+
 std::string_view format_ort_error_code(OrtErrorCode error_code) {
 	switch (error_code) {
 	case ORT_OK:
@@ -0,0 +1,552 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include <array>
+#include <cstddef>
+
+/// entries of the source tables, the lookup tables of the colormaps are
+/// interpolated from them
+constexpr size_t COLORMAP_TABLE_SIZE = 256;
+constexpr size_t INFERNO_COLOR_COUNT = COLORMAP_TABLE_SIZE;
+
+/**
+ * Inferno Colormap: index is depth (0..255)
+ * value based on:
+ * https://github.com/kennethmoreland-com/kennethmoreland-com.github.io/blob/master/color-advice/inferno/inferno-table-byte-0256.csv
+ */
+constexpr std::array<int, INFERNO_COLOR_COUNT> INFERNO_COLORS = {
+	color_rgb(0, 0, 4),		  color_rgb(1, 0, 5),
+	color_rgb(1, 1, 6),		  color_rgb(1, 1, 8),
+	color_rgb(2, 1, 10),	  color_rgb(2, 2, 12),
+	color_rgb(2, 2, 14),	  color_rgb(3, 2, 16),
+	color_rgb(4, 3, 18),	  color_rgb(4, 3, 20),
+	color_rgb(5, 4, 23),	  color_rgb(6, 4, 25),
+	color_rgb(7, 5, 27),	  color_rgb(8, 5, 29),
+	color_rgb(9, 6, 31),	  color_rgb(10, 7, 34),
+	color_rgb(11, 7, 36),	  color_rgb(12, 8, 38),
+	color_rgb(13, 8, 41),	  color_rgb(14, 9, 43),
+	color_rgb(16, 9, 45),	  color_rgb(17, 10, 48),
+	color_rgb(18, 10, 50),	  color_rgb(20, 11, 52),
+	color_rgb(21, 11, 55),	  color_rgb(22, 11, 57),
+	color_rgb(24, 12, 60),	  color_rgb(25, 12, 62),
+	color_rgb(27, 12, 65),	  color_rgb(28, 12, 67),
+	color_rgb(30, 12, 69),	  color_rgb(31, 12, 72),
+	color_rgb(33, 12, 74),	  color_rgb(35, 12, 76),
+	color_rgb(36, 12, 79),	  color_rgb(38, 12, 81),
+	color_rgb(40, 11, 83),	  color_rgb(41, 11, 85),
+	color_rgb(43, 11, 87),	  color_rgb(45, 11, 89),
+	color_rgb(47, 10, 91),	  color_rgb(49, 10, 92),
+	color_rgb(50, 10, 94),	  color_rgb(52, 10, 95),
+	color_rgb(54, 9, 97),	  color_rgb(56, 9, 98),
+	color_rgb(57, 9, 99),	  color_rgb(59, 9, 100),
+	color_rgb(61, 9, 101),	  color_rgb(62, 9, 102),
+	color_rgb(64, 10, 103),	  color_rgb(66, 10, 104),
+	color_rgb(68, 10, 104),	  color_rgb(69, 10, 105),
+	color_rgb(71, 11, 106),	  color_rgb(73, 11, 106),
+	color_rgb(74, 12, 107),	  color_rgb(76, 12, 107),
+	color_rgb(77, 13, 108),	  color_rgb(79, 13, 108),
+	color_rgb(81, 14, 108),	  color_rgb(82, 14, 109),
+	color_rgb(84, 15, 109),	  color_rgb(85, 15, 109),
+	color_rgb(87, 16, 110),	  color_rgb(89, 16, 110),
+	color_rgb(90, 17, 110),	  color_rgb(92, 18, 110),
+	color_rgb(93, 18, 110),	  color_rgb(95, 19, 110),
+	color_rgb(97, 19, 110),	  color_rgb(98, 20, 110),
+	color_rgb(100, 21, 110),  color_rgb(101, 21, 110),
+	color_rgb(103, 22, 110),  color_rgb(105, 22, 110),
+	color_rgb(106, 23, 110),  color_rgb(108, 24, 110),
+	color_rgb(109, 24, 110),  color_rgb(111, 25, 110),
+	color_rgb(113, 25, 110),  color_rgb(114, 26, 110),
+	color_rgb(116, 26, 110),  color_rgb(117, 27, 110),
+	color_rgb(119, 28, 109),  color_rgb(120, 28, 109),
+	color_rgb(122, 29, 109),  color_rgb(124, 29, 109),
+	color_rgb(125, 30, 109),  color_rgb(127, 30, 108),
+	color_rgb(128, 31, 108),  color_rgb(130, 32, 108),
+	color_rgb(132, 32, 107),  color_rgb(133, 33, 107),
+	color_rgb(135, 33, 107),  color_rgb(136, 34, 106),
+	color_rgb(138, 34, 106),  color_rgb(140, 35, 105),
+	color_rgb(141, 35, 105),  color_rgb(143, 36, 105),
+	color_rgb(144, 37, 104),  color_rgb(146, 37, 104),
+	color_rgb(147, 38, 103),  color_rgb(149, 38, 103),
+	color_rgb(151, 39, 102),  color_rgb(152, 39, 102),
+	color_rgb(154, 40, 101),  color_rgb(155, 41, 100),
+	color_rgb(157, 41, 100),  color_rgb(159, 42, 99),
+	color_rgb(160, 42, 99),	  color_rgb(162, 43, 98),
+	color_rgb(163, 44, 97),	  color_rgb(165, 44, 96),
+	color_rgb(166, 45, 96),	  color_rgb(168, 46, 95),
+	color_rgb(169, 46, 94),	  color_rgb(171, 47, 94),
+	color_rgb(173, 48, 93),	  color_rgb(174, 48, 92),
+	color_rgb(176, 49, 91),	  color_rgb(177, 50, 90),
+	color_rgb(179, 50, 90),	  color_rgb(180, 51, 89),
+	color_rgb(182, 52, 88),	  color_rgb(183, 53, 87),
+	color_rgb(185, 53, 86),	  color_rgb(186, 54, 85),
+	color_rgb(188, 55, 84),	  color_rgb(189, 56, 83),
+	color_rgb(191, 57, 82),	  color_rgb(192, 58, 81),
+	color_rgb(193, 58, 80),	  color_rgb(195, 59, 79),
+	color_rgb(196, 60, 78),	  color_rgb(198, 61, 77),
+	color_rgb(199, 62, 76),	  color_rgb(200, 63, 75),
+	color_rgb(202, 64, 74),	  color_rgb(203, 65, 73),
+	color_rgb(204, 66, 72),	  color_rgb(206, 67, 71),
+	color_rgb(207, 68, 70),	  color_rgb(208, 69, 69),
+	color_rgb(210, 70, 68),	  color_rgb(211, 71, 67),
+	color_rgb(212, 72, 66),	  color_rgb(213, 74, 65),
+	color_rgb(215, 75, 63),	  color_rgb(216, 76, 62),
+	color_rgb(217, 77, 61),	  color_rgb(218, 78, 60),
+	color_rgb(219, 80, 59),	  color_rgb(221, 81, 58),
+	color_rgb(222, 82, 56),	  color_rgb(223, 83, 55),
+	color_rgb(224, 85, 54),	  color_rgb(225, 86, 53),
+	color_rgb(226, 87, 52),	  color_rgb(227, 89, 51),
+	color_rgb(228, 90, 49),	  color_rgb(229, 92, 48),
+	color_rgb(230, 93, 47),	  color_rgb(231, 94, 46),
+	color_rgb(232, 96, 45),	  color_rgb(233, 97, 43),
+	color_rgb(234, 99, 42),	  color_rgb(235, 100, 41),
+	color_rgb(235, 102, 40),  color_rgb(236, 103, 38),
+	color_rgb(237, 105, 37),  color_rgb(238, 106, 36),
+	color_rgb(239, 108, 35),  color_rgb(239, 110, 33),
+	color_rgb(240, 111, 32),  color_rgb(241, 113, 31),
+	color_rgb(241, 115, 29),  color_rgb(242, 116, 28),
+	color_rgb(243, 118, 27),  color_rgb(243, 120, 25),
+	color_rgb(244, 121, 24),  color_rgb(245, 123, 23),
+	color_rgb(245, 125, 21),  color_rgb(246, 126, 20),
+	color_rgb(246, 128, 19),  color_rgb(247, 130, 18),
+	color_rgb(247, 132, 16),  color_rgb(248, 133, 15),
+	color_rgb(248, 135, 14),  color_rgb(248, 137, 12),
+	color_rgb(249, 139, 11),  color_rgb(249, 140, 10),
+	color_rgb(249, 142, 9),	  color_rgb(250, 144, 8),
+	color_rgb(250, 146, 7),	  color_rgb(250, 148, 7),
+	color_rgb(251, 150, 6),	  color_rgb(251, 151, 6),
+	color_rgb(251, 153, 6),	  color_rgb(251, 155, 6),
+	color_rgb(251, 157, 7),	  color_rgb(252, 159, 7),
+	color_rgb(252, 161, 8),	  color_rgb(252, 163, 9),
+	color_rgb(252, 165, 10),  color_rgb(252, 166, 12),
+	color_rgb(252, 168, 13),  color_rgb(252, 170, 15),
+	color_rgb(252, 172, 17),  color_rgb(252, 174, 18),
+	color_rgb(252, 176, 20),  color_rgb(252, 178, 22),
+	color_rgb(252, 180, 24),  color_rgb(251, 182, 26),
+	color_rgb(251, 184, 29),  color_rgb(251, 186, 31),
+	color_rgb(251, 188, 33),  color_rgb(251, 190, 35),
+	color_rgb(250, 192, 38),  color_rgb(250, 194, 40),
+	color_rgb(250, 196, 42),  color_rgb(250, 198, 45),
+	color_rgb(249, 199, 47),  color_rgb(249, 201, 50),
+	color_rgb(249, 203, 53),  color_rgb(248, 205, 55),
+	color_rgb(248, 207, 58),  color_rgb(247, 209, 61),
+	color_rgb(247, 211, 64),  color_rgb(246, 213, 67),
+	color_rgb(246, 215, 70),  color_rgb(245, 217, 73),
+	color_rgb(245, 219, 76),  color_rgb(244, 221, 79),
+	color_rgb(244, 223, 83),  color_rgb(244, 225, 86),
+	color_rgb(243, 227, 90),  color_rgb(243, 229, 93),
+	color_rgb(242, 230, 97),  color_rgb(242, 232, 101),
+	color_rgb(242, 234, 105), color_rgb(241, 236, 109),
+	color_rgb(241, 237, 113), color_rgb(241, 239, 117),
+	color_rgb(241, 241, 121), color_rgb(242, 242, 125),
+	color_rgb(242, 244, 130), color_rgb(243, 245, 134),
+	color_rgb(243, 246, 138), color_rgb(244, 248, 142),
+	color_rgb(245, 249, 146), color_rgb(246, 250, 150),
+	color_rgb(248, 251, 154), color_rgb(249, 252, 157),
+	color_rgb(250, 253, 161), color_rgb(252, 255, 164)
+};
+
+/**
+ * Magma Colormap: index is depth (0..255)
+ * values of matplotlib (_cm_listed.py), rounded to bytes
+ */
+constexpr std::array<int, COLORMAP_TABLE_SIZE> MAGMA_COLORS = {
+	color_rgb(0, 0, 4),		  color_rgb(1, 0, 5),
+	color_rgb(1, 1, 6),		  color_rgb(1, 1, 8),
+	color_rgb(2, 1, 9),		  color_rgb(2, 2, 11),
+	color_rgb(2, 2, 13),	  color_rgb(3, 3, 15),
+	color_rgb(3, 3, 18),	  color_rgb(4, 4, 20),
+	color_rgb(5, 4, 22),	  color_rgb(6, 5, 24),
+	color_rgb(6, 5, 26),	  color_rgb(7, 6, 28),
+	color_rgb(8, 7, 30),	  color_rgb(9, 7, 32),
+	color_rgb(10, 8, 34),	  color_rgb(11, 9, 36),
+	color_rgb(12, 9, 38),	  color_rgb(13, 10, 41),
+	color_rgb(14, 11, 43),	  color_rgb(16, 11, 45),
+	color_rgb(17, 12, 47),	  color_rgb(18, 13, 49),
+	color_rgb(19, 13, 52),	  color_rgb(20, 14, 54),
+	color_rgb(21, 14, 56),	  color_rgb(22, 15, 59),
+	color_rgb(24, 15, 61),	  color_rgb(25, 16, 63),
+	color_rgb(26, 16, 66),	  color_rgb(28, 16, 68),
+	color_rgb(29, 17, 71),	  color_rgb(30, 17, 73),
+	color_rgb(32, 17, 75),	  color_rgb(33, 17, 78),
+	color_rgb(34, 17, 80),	  color_rgb(36, 18, 83),
+	color_rgb(37, 18, 85),	  color_rgb(39, 18, 88),
+	color_rgb(41, 17, 90),	  color_rgb(42, 17, 92),
+	color_rgb(44, 17, 95),	  color_rgb(45, 17, 97),
+	color_rgb(47, 17, 99),	  color_rgb(49, 17, 101),
+	color_rgb(51, 16, 103),	  color_rgb(52, 16, 105),
+	color_rgb(54, 16, 107),	  color_rgb(56, 16, 108),
+	color_rgb(57, 15, 110),	  color_rgb(59, 15, 112),
+	color_rgb(61, 15, 113),	  color_rgb(63, 15, 114),
+	color_rgb(64, 15, 116),	  color_rgb(66, 15, 117),
+	color_rgb(68, 15, 118),	  color_rgb(69, 16, 119),
+	color_rgb(71, 16, 120),	  color_rgb(73, 16, 120),
+	color_rgb(74, 16, 121),	  color_rgb(76, 17, 122),
+	color_rgb(78, 17, 123),	  color_rgb(79, 18, 123),
+	color_rgb(81, 18, 124),	  color_rgb(82, 19, 124),
+	color_rgb(84, 19, 125),	  color_rgb(86, 20, 125),
+	color_rgb(87, 21, 126),	  color_rgb(89, 21, 126),
+	color_rgb(90, 22, 126),	  color_rgb(92, 22, 127),
+	color_rgb(93, 23, 127),	  color_rgb(95, 24, 127),
+	color_rgb(96, 24, 128),	  color_rgb(98, 25, 128),
+	color_rgb(100, 26, 128),  color_rgb(101, 26, 128),
+	color_rgb(103, 27, 128),  color_rgb(104, 28, 129),
+	color_rgb(106, 28, 129),  color_rgb(107, 29, 129),
+	color_rgb(109, 29, 129),  color_rgb(110, 30, 129),
+	color_rgb(112, 31, 129),  color_rgb(114, 31, 129),
+	color_rgb(115, 32, 129),  color_rgb(117, 33, 129),
+	color_rgb(118, 33, 129),  color_rgb(120, 34, 129),
+	color_rgb(121, 34, 130),  color_rgb(123, 35, 130),
+	color_rgb(124, 35, 130),  color_rgb(126, 36, 130),
+	color_rgb(128, 37, 130),  color_rgb(129, 37, 129),
+	color_rgb(131, 38, 129),  color_rgb(132, 38, 129),
+	color_rgb(134, 39, 129),  color_rgb(136, 39, 129),
+	color_rgb(137, 40, 129),  color_rgb(139, 41, 129),
+	color_rgb(140, 41, 129),  color_rgb(142, 42, 129),
+	color_rgb(144, 42, 129),  color_rgb(145, 43, 129),
+	color_rgb(147, 43, 128),  color_rgb(148, 44, 128),
+	color_rgb(150, 44, 128),  color_rgb(152, 45, 128),
+	color_rgb(153, 45, 128),  color_rgb(155, 46, 127),
+	color_rgb(156, 46, 127),  color_rgb(158, 47, 127),
+	color_rgb(160, 47, 127),  color_rgb(161, 48, 126),
+	color_rgb(163, 48, 126),  color_rgb(165, 49, 126),
+	color_rgb(166, 49, 125),  color_rgb(168, 50, 125),
+	color_rgb(170, 51, 125),  color_rgb(171, 51, 124),
+	color_rgb(173, 52, 124),  color_rgb(174, 52, 123),
+	color_rgb(176, 53, 123),  color_rgb(178, 53, 123),
+	color_rgb(179, 54, 122),  color_rgb(181, 54, 122),
+	color_rgb(183, 55, 121),  color_rgb(184, 55, 121),
+	color_rgb(186, 56, 120),  color_rgb(188, 57, 120),
+	color_rgb(189, 57, 119),  color_rgb(191, 58, 119),
+	color_rgb(192, 58, 118),  color_rgb(194, 59, 117),
+	color_rgb(196, 60, 117),  color_rgb(197, 60, 116),
+	color_rgb(199, 61, 115),  color_rgb(200, 62, 115),
+	color_rgb(202, 62, 114),  color_rgb(204, 63, 113),
+	color_rgb(205, 64, 113),  color_rgb(207, 64, 112),
+	color_rgb(208, 65, 111),  color_rgb(210, 66, 111),
+	color_rgb(211, 67, 110),  color_rgb(213, 68, 109),
+	color_rgb(214, 69, 108),  color_rgb(216, 69, 108),
+	color_rgb(217, 70, 107),  color_rgb(219, 71, 106),
+	color_rgb(220, 72, 105),  color_rgb(222, 73, 104),
+	color_rgb(223, 74, 104),  color_rgb(224, 76, 103),
+	color_rgb(226, 77, 102),  color_rgb(227, 78, 101),
+	color_rgb(228, 79, 100),  color_rgb(229, 80, 100),
+	color_rgb(231, 82, 99),	  color_rgb(232, 83, 98),
+	color_rgb(233, 84, 98),	  color_rgb(234, 86, 97),
+	color_rgb(235, 87, 96),	  color_rgb(236, 88, 96),
+	color_rgb(237, 90, 95),	  color_rgb(238, 91, 94),
+	color_rgb(239, 93, 94),	  color_rgb(240, 95, 94),
+	color_rgb(241, 96, 93),	  color_rgb(242, 98, 93),
+	color_rgb(242, 100, 92),  color_rgb(243, 101, 92),
+	color_rgb(244, 103, 92),  color_rgb(244, 105, 92),
+	color_rgb(245, 107, 92),  color_rgb(246, 108, 92),
+	color_rgb(246, 110, 92),  color_rgb(247, 112, 92),
+	color_rgb(247, 114, 92),  color_rgb(248, 116, 92),
+	color_rgb(248, 118, 92),  color_rgb(249, 120, 93),
+	color_rgb(249, 121, 93),  color_rgb(249, 123, 93),
+	color_rgb(250, 125, 94),  color_rgb(250, 127, 94),
+	color_rgb(250, 129, 95),  color_rgb(251, 131, 95),
+	color_rgb(251, 133, 96),  color_rgb(251, 135, 97),
+	color_rgb(252, 137, 97),  color_rgb(252, 138, 98),
+	color_rgb(252, 140, 99),  color_rgb(252, 142, 100),
+	color_rgb(252, 144, 101), color_rgb(253, 146, 102),
+	color_rgb(253, 148, 103), color_rgb(253, 150, 104),
+	color_rgb(253, 152, 105), color_rgb(253, 154, 106),
+	color_rgb(253, 155, 107), color_rgb(254, 157, 108),
+	color_rgb(254, 159, 109), color_rgb(254, 161, 110),
+	color_rgb(254, 163, 111), color_rgb(254, 165, 113),
+	color_rgb(254, 167, 114), color_rgb(254, 169, 115),
+	color_rgb(254, 170, 116), color_rgb(254, 172, 118),
+	color_rgb(254, 174, 119), color_rgb(254, 176, 120),
+	color_rgb(254, 178, 122), color_rgb(254, 180, 123),
+	color_rgb(254, 182, 124), color_rgb(254, 183, 126),
+	color_rgb(254, 185, 127), color_rgb(254, 187, 129),
+	color_rgb(254, 189, 130), color_rgb(254, 191, 132),
+	color_rgb(254, 193, 133), color_rgb(254, 194, 135),
+	color_rgb(254, 196, 136), color_rgb(254, 198, 138),
+	color_rgb(254, 200, 140), color_rgb(254, 202, 141),
+	color_rgb(254, 204, 143), color_rgb(254, 205, 144),
+	color_rgb(254, 207, 146), color_rgb(254, 209, 148),
+	color_rgb(254, 211, 149), color_rgb(254, 213, 151),
+	color_rgb(254, 215, 153), color_rgb(254, 216, 154),
+	color_rgb(253, 218, 156), color_rgb(253, 220, 158),
+	color_rgb(253, 222, 160), color_rgb(253, 224, 161),
+	color_rgb(253, 226, 163), color_rgb(253, 227, 165),
+	color_rgb(253, 229, 167), color_rgb(253, 231, 169),
+	color_rgb(253, 233, 170), color_rgb(253, 235, 172),
+	color_rgb(252, 236, 174), color_rgb(252, 238, 176),
+	color_rgb(252, 240, 178), color_rgb(252, 242, 180),
+	color_rgb(252, 244, 182), color_rgb(252, 246, 184),
+	color_rgb(252, 247, 185), color_rgb(252, 249, 187),
+	color_rgb(252, 251, 189), color_rgb(252, 253, 191)
+};
+
+/**
+ * Viridis Colormap: index is depth (0..255)
+ * values of matplotlib (_cm_listed.py), rounded to bytes
+ */
+constexpr std::array<int, COLORMAP_TABLE_SIZE> VIRIDIS_COLORS = {
+	color_rgb(68, 1, 84),	  color_rgb(68, 2, 86),
+	color_rgb(69, 4, 87),	  color_rgb(69, 5, 89),
+	color_rgb(70, 7, 90),	  color_rgb(70, 8, 92),
+	color_rgb(70, 10, 93),	  color_rgb(70, 11, 94),
+	color_rgb(71, 13, 96),	  color_rgb(71, 14, 97),
+	color_rgb(71, 16, 99),	  color_rgb(71, 17, 100),
+	color_rgb(71, 19, 101),	  color_rgb(72, 20, 103),
+	color_rgb(72, 22, 104),	  color_rgb(72, 23, 105),
+	color_rgb(72, 24, 106),	  color_rgb(72, 26, 108),
+	color_rgb(72, 27, 109),	  color_rgb(72, 28, 110),
+	color_rgb(72, 29, 111),	  color_rgb(72, 31, 112),
+	color_rgb(72, 32, 113),	  color_rgb(72, 33, 115),
+	color_rgb(72, 35, 116),	  color_rgb(72, 36, 117),
+	color_rgb(72, 37, 118),	  color_rgb(72, 38, 119),
+	color_rgb(72, 40, 120),	  color_rgb(72, 41, 121),
+	color_rgb(71, 42, 122),	  color_rgb(71, 44, 122),
+	color_rgb(71, 45, 123),	  color_rgb(71, 46, 124),
+	color_rgb(71, 47, 125),	  color_rgb(70, 48, 126),
+	color_rgb(70, 50, 126),	  color_rgb(70, 51, 127),
+	color_rgb(70, 52, 128),	  color_rgb(69, 53, 129),
+	color_rgb(69, 55, 129),	  color_rgb(69, 56, 130),
+	color_rgb(68, 57, 131),	  color_rgb(68, 58, 131),
+	color_rgb(68, 59, 132),	  color_rgb(67, 61, 132),
+	color_rgb(67, 62, 133),	  color_rgb(66, 63, 133),
+	color_rgb(66, 64, 134),	  color_rgb(66, 65, 134),
+	color_rgb(65, 66, 135),	  color_rgb(65, 68, 135),
+	color_rgb(64, 69, 136),	  color_rgb(64, 70, 136),
+	color_rgb(63, 71, 136),	  color_rgb(63, 72, 137),
+	color_rgb(62, 73, 137),	  color_rgb(62, 74, 137),
+	color_rgb(62, 76, 138),	  color_rgb(61, 77, 138),
+	color_rgb(61, 78, 138),	  color_rgb(60, 79, 138),
+	color_rgb(60, 80, 139),	  color_rgb(59, 81, 139),
+	color_rgb(59, 82, 139),	  color_rgb(58, 83, 139),
+	color_rgb(58, 84, 140),	  color_rgb(57, 85, 140),
+	color_rgb(57, 86, 140),	  color_rgb(56, 88, 140),
+	color_rgb(56, 89, 140),	  color_rgb(55, 90, 140),
+	color_rgb(55, 91, 141),	  color_rgb(54, 92, 141),
+	color_rgb(54, 93, 141),	  color_rgb(53, 94, 141),
+	color_rgb(53, 95, 141),	  color_rgb(52, 96, 141),
+	color_rgb(52, 97, 141),	  color_rgb(51, 98, 141),
+	color_rgb(51, 99, 141),	  color_rgb(50, 100, 142),
+	color_rgb(50, 101, 142),  color_rgb(49, 102, 142),
+	color_rgb(49, 103, 142),  color_rgb(49, 104, 142),
+	color_rgb(48, 105, 142),  color_rgb(48, 106, 142),
+	color_rgb(47, 107, 142),  color_rgb(47, 108, 142),
+	color_rgb(46, 109, 142),  color_rgb(46, 110, 142),
+	color_rgb(46, 111, 142),  color_rgb(45, 112, 142),
+	color_rgb(45, 113, 142),  color_rgb(44, 113, 142),
+	color_rgb(44, 114, 142),  color_rgb(44, 115, 142),
+	color_rgb(43, 116, 142),  color_rgb(43, 117, 142),
+	color_rgb(42, 118, 142),  color_rgb(42, 119, 142),
+	color_rgb(42, 120, 142),  color_rgb(41, 121, 142),
+	color_rgb(41, 122, 142),  color_rgb(41, 123, 142),
+	color_rgb(40, 124, 142),  color_rgb(40, 125, 142),
+	color_rgb(39, 126, 142),  color_rgb(39, 127, 142),
+	color_rgb(39, 128, 142),  color_rgb(38, 129, 142),
+	color_rgb(38, 130, 142),  color_rgb(38, 130, 142),
+	color_rgb(37, 131, 142),  color_rgb(37, 132, 142),
+	color_rgb(37, 133, 142),  color_rgb(36, 134, 142),
+	color_rgb(36, 135, 142),  color_rgb(35, 136, 142),
+	color_rgb(35, 137, 142),  color_rgb(35, 138, 141),
+	color_rgb(34, 139, 141),  color_rgb(34, 140, 141),
+	color_rgb(34, 141, 141),  color_rgb(33, 142, 141),
+	color_rgb(33, 143, 141),  color_rgb(33, 144, 141),
+	color_rgb(33, 145, 140),  color_rgb(32, 146, 140),
+	color_rgb(32, 146, 140),  color_rgb(32, 147, 140),
+	color_rgb(31, 148, 140),  color_rgb(31, 149, 139),
+	color_rgb(31, 150, 139),  color_rgb(31, 151, 139),
+	color_rgb(31, 152, 139),  color_rgb(31, 153, 138),
+	color_rgb(31, 154, 138),  color_rgb(30, 155, 138),
+	color_rgb(30, 156, 137),  color_rgb(30, 157, 137),
+	color_rgb(31, 158, 137),  color_rgb(31, 159, 136),
+	color_rgb(31, 160, 136),  color_rgb(31, 161, 136),
+	color_rgb(31, 161, 135),  color_rgb(31, 162, 135),
+	color_rgb(32, 163, 134),  color_rgb(32, 164, 134),
+	color_rgb(33, 165, 133),  color_rgb(33, 166, 133),
+	color_rgb(34, 167, 133),  color_rgb(34, 168, 132),
+	color_rgb(35, 169, 131),  color_rgb(36, 170, 131),
+	color_rgb(37, 171, 130),  color_rgb(37, 172, 130),
+	color_rgb(38, 173, 129),  color_rgb(39, 173, 129),
+	color_rgb(40, 174, 128),  color_rgb(41, 175, 127),
+	color_rgb(42, 176, 127),  color_rgb(44, 177, 126),
+	color_rgb(45, 178, 125),  color_rgb(46, 179, 124),
+	color_rgb(47, 180, 124),  color_rgb(49, 181, 123),
+	color_rgb(50, 182, 122),  color_rgb(52, 182, 121),
+	color_rgb(53, 183, 121),  color_rgb(55, 184, 120),
+	color_rgb(56, 185, 119),  color_rgb(58, 186, 118),
+	color_rgb(59, 187, 117),  color_rgb(61, 188, 116),
+	color_rgb(63, 188, 115),  color_rgb(64, 189, 114),
+	color_rgb(66, 190, 113),  color_rgb(68, 191, 112),
+	color_rgb(70, 192, 111),  color_rgb(72, 193, 110),
+	color_rgb(74, 193, 109),  color_rgb(76, 194, 108),
+	color_rgb(78, 195, 107),  color_rgb(80, 196, 106),
+	color_rgb(82, 197, 105),  color_rgb(84, 197, 104),
+	color_rgb(86, 198, 103),  color_rgb(88, 199, 101),
+	color_rgb(90, 200, 100),  color_rgb(92, 200, 99),
+	color_rgb(94, 201, 98),	  color_rgb(96, 202, 96),
+	color_rgb(99, 203, 95),	  color_rgb(101, 203, 94),
+	color_rgb(103, 204, 92),  color_rgb(105, 205, 91),
+	color_rgb(108, 205, 90),  color_rgb(110, 206, 88),
+	color_rgb(112, 207, 87),  color_rgb(115, 208, 86),
+	color_rgb(117, 208, 84),  color_rgb(119, 209, 83),
+	color_rgb(122, 209, 81),  color_rgb(124, 210, 80),
+	color_rgb(127, 211, 78),  color_rgb(129, 211, 77),
+	color_rgb(132, 212, 75),  color_rgb(134, 213, 73),
+	color_rgb(137, 213, 72),  color_rgb(139, 214, 70),
+	color_rgb(142, 214, 69),  color_rgb(144, 215, 67),
+	color_rgb(147, 215, 65),  color_rgb(149, 216, 64),
+	color_rgb(152, 216, 62),  color_rgb(155, 217, 60),
+	color_rgb(157, 217, 59),  color_rgb(160, 218, 57),
+	color_rgb(162, 218, 55),  color_rgb(165, 219, 54),
+	color_rgb(168, 219, 52),  color_rgb(170, 220, 50),
+	color_rgb(173, 220, 48),  color_rgb(176, 221, 47),
+	color_rgb(178, 221, 45),  color_rgb(181, 222, 43),
+	color_rgb(184, 222, 41),  color_rgb(186, 222, 40),
+	color_rgb(189, 223, 38),  color_rgb(192, 223, 37),
+	color_rgb(194, 223, 35),  color_rgb(197, 224, 33),
+	color_rgb(200, 224, 32),  color_rgb(202, 225, 31),
+	color_rgb(205, 225, 29),  color_rgb(208, 225, 28),
+	color_rgb(210, 226, 27),  color_rgb(213, 226, 26),
+	color_rgb(216, 226, 25),  color_rgb(218, 227, 25),
+	color_rgb(221, 227, 24),  color_rgb(223, 227, 24),
+	color_rgb(226, 228, 24),  color_rgb(229, 228, 25),
+	color_rgb(231, 228, 25),  color_rgb(234, 229, 26),
+	color_rgb(236, 229, 27),  color_rgb(239, 229, 28),
+	color_rgb(241, 229, 29),  color_rgb(244, 230, 30),
+	color_rgb(246, 230, 32),  color_rgb(248, 230, 33),
+	color_rgb(251, 231, 35),  color_rgb(253, 231, 37)
+};
+
+/**
+ * Turbo Colormap: index is depth (0..255)
+ * values of matplotlib (_cm_listed.py), rounded to bytes. Copyright 2019
+ * Google LLC, Apache-2.0
+ */
+constexpr std::array<int, COLORMAP_TABLE_SIZE> TURBO_COLORS = {
+	color_rgb(48, 18, 59),	  color_rgb(50, 21, 67),
+	color_rgb(51, 24, 74),	  color_rgb(52, 27, 81),
+	color_rgb(53, 30, 88),	  color_rgb(54, 33, 95),
+	color_rgb(55, 36, 102),	  color_rgb(56, 39, 109),
+	color_rgb(57, 42, 115),	  color_rgb(58, 45, 121),
+	color_rgb(59, 47, 128),	  color_rgb(60, 50, 134),
+	color_rgb(61, 53, 139),	  color_rgb(62, 56, 145),
+	color_rgb(63, 59, 151),	  color_rgb(63, 62, 156),
+	color_rgb(64, 64, 162),	  color_rgb(65, 67, 167),
+	color_rgb(65, 70, 172),	  color_rgb(66, 73, 177),
+	color_rgb(66, 75, 181),	  color_rgb(67, 78, 186),
+	color_rgb(68, 81, 191),	  color_rgb(68, 84, 195),
+	color_rgb(68, 86, 199),	  color_rgb(69, 89, 203),
+	color_rgb(69, 92, 207),	  color_rgb(69, 94, 211),
+	color_rgb(70, 97, 214),	  color_rgb(70, 100, 218),
+	color_rgb(70, 102, 221),  color_rgb(70, 105, 224),
+	color_rgb(70, 107, 227),  color_rgb(71, 110, 230),
+	color_rgb(71, 113, 233),  color_rgb(71, 115, 235),
+	color_rgb(71, 118, 238),  color_rgb(71, 120, 240),
+	color_rgb(71, 123, 242),  color_rgb(70, 125, 244),
+	color_rgb(70, 128, 246),  color_rgb(70, 130, 248),
+	color_rgb(70, 133, 250),  color_rgb(70, 135, 251),
+	color_rgb(69, 138, 252),  color_rgb(69, 140, 253),
+	color_rgb(68, 143, 254),  color_rgb(67, 145, 254),
+	color_rgb(66, 148, 255),  color_rgb(65, 150, 255),
+	color_rgb(64, 153, 255),  color_rgb(62, 155, 254),
+	color_rgb(61, 158, 254),  color_rgb(59, 160, 253),
+	color_rgb(58, 163, 252),  color_rgb(56, 165, 251),
+	color_rgb(55, 168, 250),  color_rgb(53, 171, 248),
+	color_rgb(51, 173, 247),  color_rgb(49, 175, 245),
+	color_rgb(47, 178, 244),  color_rgb(46, 180, 242),
+	color_rgb(44, 183, 240),  color_rgb(42, 185, 238),
+	color_rgb(40, 188, 235),  color_rgb(39, 190, 233),
+	color_rgb(37, 192, 231),  color_rgb(35, 195, 228),
+	color_rgb(34, 197, 226),  color_rgb(32, 199, 223),
+	color_rgb(31, 201, 221),  color_rgb(30, 203, 218),
+	color_rgb(28, 205, 216),  color_rgb(27, 208, 213),
+	color_rgb(26, 210, 210),  color_rgb(26, 212, 208),
+	color_rgb(25, 213, 205),  color_rgb(24, 215, 202),
+	color_rgb(24, 217, 200),  color_rgb(24, 219, 197),
+	color_rgb(24, 221, 194),  color_rgb(24, 222, 192),
+	color_rgb(24, 224, 189),  color_rgb(25, 226, 187),
+	color_rgb(25, 227, 185),  color_rgb(26, 228, 182),
+	color_rgb(28, 230, 180),  color_rgb(29, 231, 178),
+	color_rgb(31, 233, 175),  color_rgb(32, 234, 172),
+	color_rgb(34, 235, 170),  color_rgb(37, 236, 167),
+	color_rgb(39, 238, 164),  color_rgb(42, 239, 161),
+	color_rgb(44, 240, 158),  color_rgb(47, 241, 155),
+	color_rgb(50, 242, 152),  color_rgb(53, 243, 148),
+	color_rgb(56, 244, 145),  color_rgb(60, 245, 142),
+	color_rgb(63, 246, 138),  color_rgb(67, 247, 135),
+	color_rgb(70, 248, 132),  color_rgb(74, 248, 128),
+	color_rgb(78, 249, 125),  color_rgb(82, 250, 122),
+	color_rgb(85, 250, 118),  color_rgb(89, 251, 115),
+	color_rgb(93, 252, 111),  color_rgb(97, 252, 108),
+	color_rgb(101, 253, 105), color_rgb(105, 253, 102),
+	color_rgb(109, 254, 98),  color_rgb(113, 254, 95),
+	color_rgb(117, 254, 92),  color_rgb(121, 254, 89),
+	color_rgb(125, 255, 86),  color_rgb(128, 255, 83),
+	color_rgb(132, 255, 81),  color_rgb(136, 255, 78),
+	color_rgb(139, 255, 75),  color_rgb(143, 255, 73),
+	color_rgb(146, 255, 71),  color_rgb(150, 254, 68),
+	color_rgb(153, 254, 66),  color_rgb(156, 254, 64),
+	color_rgb(159, 253, 63),  color_rgb(161, 253, 61),
+	color_rgb(164, 252, 60),  color_rgb(167, 252, 58),
+	color_rgb(169, 251, 57),  color_rgb(172, 251, 56),
+	color_rgb(175, 250, 55),  color_rgb(177, 249, 54),
+	color_rgb(180, 248, 54),  color_rgb(183, 247, 53),
+	color_rgb(185, 246, 53),  color_rgb(188, 245, 52),
+	color_rgb(190, 244, 52),  color_rgb(193, 243, 52),
+	color_rgb(195, 241, 52),  color_rgb(198, 240, 52),
+	color_rgb(200, 239, 52),  color_rgb(203, 237, 52),
+	color_rgb(205, 236, 52),  color_rgb(208, 234, 52),
+	color_rgb(210, 233, 53),  color_rgb(212, 231, 53),
+	color_rgb(215, 229, 53),  color_rgb(217, 228, 54),
+	color_rgb(219, 226, 54),  color_rgb(221, 224, 55),
+	color_rgb(223, 223, 55),  color_rgb(225, 221, 55),
+	color_rgb(227, 219, 56),  color_rgb(229, 217, 56),
+	color_rgb(231, 215, 57),  color_rgb(233, 213, 57),
+	color_rgb(235, 211, 57),  color_rgb(236, 209, 58),
+	color_rgb(238, 207, 58),  color_rgb(239, 205, 58),
+	color_rgb(241, 203, 58),  color_rgb(242, 201, 58),
+	color_rgb(244, 199, 58),  color_rgb(245, 197, 58),
+	color_rgb(246, 195, 58),  color_rgb(247, 193, 58),
+	color_rgb(248, 190, 57),  color_rgb(249, 188, 57),
+	color_rgb(250, 186, 57),  color_rgb(251, 184, 56),
+	color_rgb(251, 182, 55),  color_rgb(252, 179, 54),
+	color_rgb(252, 177, 54),  color_rgb(253, 174, 53),
+	color_rgb(253, 172, 52),  color_rgb(254, 169, 51),
+	color_rgb(254, 167, 50),  color_rgb(254, 164, 49),
+	color_rgb(254, 161, 48),  color_rgb(254, 158, 47),
+	color_rgb(254, 155, 45),  color_rgb(254, 153, 44),
+	color_rgb(254, 150, 43),  color_rgb(254, 147, 42),
+	color_rgb(254, 144, 41),  color_rgb(253, 141, 39),
+	color_rgb(253, 138, 38),  color_rgb(252, 135, 37),
+	color_rgb(252, 132, 35),  color_rgb(251, 129, 34),
+	color_rgb(251, 126, 33),  color_rgb(250, 123, 31),
+	color_rgb(249, 120, 30),  color_rgb(249, 117, 29),
+	color_rgb(248, 114, 28),  color_rgb(247, 111, 26),
+	color_rgb(246, 108, 25),  color_rgb(245, 105, 24),
+	color_rgb(244, 102, 23),  color_rgb(243, 99, 21),
+	color_rgb(242, 96, 20),	  color_rgb(241, 93, 19),
+	color_rgb(240, 91, 18),	  color_rgb(239, 88, 17),
+	color_rgb(237, 85, 16),	  color_rgb(236, 83, 15),
+	color_rgb(235, 80, 14),	  color_rgb(234, 78, 13),
+	color_rgb(232, 75, 12),	  color_rgb(231, 73, 12),
+	color_rgb(229, 71, 11),	  color_rgb(228, 69, 10),
+	color_rgb(226, 67, 10),	  color_rgb(225, 65, 9),
+	color_rgb(223, 63, 8),	  color_rgb(221, 61, 8),
+	color_rgb(220, 59, 7),	  color_rgb(218, 57, 7),
+	color_rgb(216, 55, 6),	  color_rgb(214, 53, 6),
+	color_rgb(212, 51, 5),	  color_rgb(210, 49, 5),
+	color_rgb(208, 47, 5),	  color_rgb(206, 45, 4),
+	color_rgb(204, 43, 4),	  color_rgb(202, 42, 4),
+	color_rgb(200, 40, 3),	  color_rgb(197, 38, 3),
+	color_rgb(195, 37, 3),	  color_rgb(193, 35, 2),
+	color_rgb(190, 33, 2),	  color_rgb(188, 32, 2),
+	color_rgb(185, 30, 2),	  color_rgb(183, 29, 2),
+	color_rgb(180, 27, 1),	  color_rgb(178, 26, 1),
+	color_rgb(175, 24, 1),	  color_rgb(172, 23, 1),
+	color_rgb(169, 22, 1),	  color_rgb(167, 20, 1),
+	color_rgb(164, 19, 1),	  color_rgb(161, 18, 1),
+	color_rgb(158, 16, 1),	  color_rgb(155, 15, 1),
+	color_rgb(152, 14, 1),	  color_rgb(149, 13, 1),
+	color_rgb(146, 11, 1),	  color_rgb(142, 10, 1),
+	color_rgb(139, 9, 2),	  color_rgb(136, 8, 2),
+	color_rgb(133, 7, 2),	  color_rgb(129, 6, 2),
+	color_rgb(126, 5, 2),	  color_rgb(122, 4, 3)
+};
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "Colormaps.hpp"
+
+#include "processing/ColormapTables.hpp"
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+/// r, g, b and opaque alpha in android bitmap byte order
+constexpr uint32_t rgba_pixel(uint32_t r, uint32_t g, uint32_t b) {
+	return r | (g << 8) | (b << 16) | (0xFFU << 24);
+}
+
+/// linear interpolation of the source table at size entries (kept cheap, the
+/// compilers limit the operations of a constant evaluation)
+template<size_t SIZE>
+constexpr std::array<uint32_t, SIZE>
+make_colormap_lut(const std::array<int, COLORMAP_TABLE_SIZE>& table) {
+	std::array<uint32_t, SIZE> lut{};
+	for (size_t i = 0; i < SIZE; i++) {
+		// position in the table in 1 / (SIZE - 1) steps, exact in integers
+		const size_t scaled = i * (COLORMAP_TABLE_SIZE - 1);
+		const size_t index = scaled / (SIZE - 1);
+		const auto weight = (uint32_t)(scaled % (SIZE - 1));
+		const auto from = (uint32_t)table[index];
+		const auto to = (uint32_t)table[std::min(index + 1, COLORMAP_TABLE_SIZE - 1)];
+
+		uint32_t pixel = 0xFFU << 24;
+		// argb source channels, red and blue swap into the rgba byte order
+		for (uint32_t shift = 0; shift < 24; shift += 8) {
+			const uint32_t channel =
+				(((from >> shift) & 0xFFU) * ((uint32_t)SIZE - 1 - weight) +
+				 ((to >> shift) & 0xFFU) * weight + ((uint32_t)SIZE - 1) / 2) /
+				((uint32_t)SIZE - 1);
+			pixel |= channel << (16 - shift);
+		}
+		lut[i] = pixel;
+	}
+	return lut;
+}
+
+template<size_t SIZE> constexpr std::array<uint32_t, SIZE> make_grayscale_lut() {
+	std::array<uint32_t, SIZE> lut{};
+	for (size_t i = 0; i < SIZE; i++) {
+		const auto gray = (uint32_t)((i * 255 + (SIZE - 1) / 2) / (SIZE - 1));
+		lut[i] = rgba_pixel(gray, gray, gray);
+	}
+	return lut;
+}
+
+template<size_t SIZE> struct ColormapLuts {
+	static constexpr auto INFERNO = make_colormap_lut<SIZE>(INFERNO_COLORS);
+	static constexpr auto MAGMA = make_colormap_lut<SIZE>(MAGMA_COLORS);
+	static constexpr auto VIRIDIS = make_colormap_lut<SIZE>(VIRIDIS_COLORS);
+	static constexpr auto TURBO = make_colormap_lut<SIZE>(TURBO_COLORS);
+	static constexpr auto GRAYSCALE = make_grayscale_lut<SIZE>();
+
+	static std::span<const uint32_t> get(Colormap colormap) {
+		switch (colormap) {
+		case Colormap::Inferno:
+			return INFERNO;
+		case Colormap::Magma:
+			return MAGMA;
+		case Colormap::Viridis:
+			return VIRIDIS;
+		case Colormap::Turbo:
+			return TURBO;
+		case Colormap::Grayscale:
+			return GRAYSCALE;
+		}
+		throw std::invalid_argument("colormap");
+	}
+};
+
+std::span<const uint32_t>
+colormap_lut(Colormap colormap, ColormapResolution resolution) {
+	switch (resolution) {
+	case ColormapResolution::Entries1024:
+		return ColormapLuts<1024>::get(colormap);
+	case ColormapResolution::Entries4096:
+		return ColormapLuts<4096>::get(colormap);
+	}
+	throw std::invalid_argument("resolution");
+}
+
+/// pixels per block of lut indices
+constexpr size_t COLORMAP_BLOCK_SIZE = 64;
+
+/// maps depth to lut positions, index = depth * scale + offset
+struct LutMapping {
+	float scale;
+	float offset;
+	float max_index;
+};
+
+static LutMapping
+lut_mapping(const ColormapOptions& options, size_t lut_size) {
+	const auto max_index = (float)(lut_size - 1);
+	const float range = options.max_depth - options.min_depth;
+	if (!(range > 0.0f))
+		return {.scale = 0.0f, .offset = max_index / 2.0f, .max_index = max_index};
+
+	const float scale = max_index / range;
+	// + 0.5f rounds the truncating conversion to the nearest entry
+	return {
+		.scale = scale,
+		.offset = 0.5f - options.min_depth * scale,
+		.max_index = max_index + 0.5f,
+	};
+}
+
+/// lut indices of a block of depth values, no branches or table accesses so
+/// the compiler vectorizes it
+static void lut_indices(
+	const float* depth,
+	size_t count,
+	const LutMapping& mapping,
+	uint32_t* indices
+) {
+	for (size_t i = 0; i < count; i++) {
+		float position = depth[i] * mapping.scale + mapping.offset;
+		// also maps nan to the first entry
+		position = position > 0.0f ? position : 0.0f;
+		position = position < mapping.max_index ? position : mapping.max_index;
+		indices[i] = (uint32_t)position;
+	}
+}
+
+void colormap_depth(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	const MutableRgbaImageView& output,
+	const ColormapOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+	if (depth.empty())
+		return;
+	if (output.width != width || output.height != height ||
+		output.stride < width * 4 ||
+		output.pixels.size() < (height - 1) * output.stride + width * 4)
+		throw std::invalid_argument("output");
+
+	const auto lut = colormap_lut(options.colormap, options.resolution);
+	const auto mapping = lut_mapping(options, lut.size());
+
+	std::array<uint32_t, COLORMAP_BLOCK_SIZE> indices{};
+	std::array<uint32_t, COLORMAP_BLOCK_SIZE> colors{};
+	for (size_t y = 0; y < height; y++) {
+		const float* depth_row = &depth[y * width];
+		uint8_t* output_row = &output.pixels[y * output.stride];
+		for (size_t x = 0; x < width; x += COLORMAP_BLOCK_SIZE) {
+			const size_t count = std::min(COLORMAP_BLOCK_SIZE, width - x);
+			lut_indices(&depth_row[x], count, mapping, indices.data());
+			for (size_t i = 0; i < count; i++)
+				colors[i] = lut[indices[i]];
+			// bitmap rows are not necessarily aligned to 4 bytes
+			std::memcpy(&output_row[x * 4], colors.data(), count * 4);
+		}
+	}
+}
+
+void colormap_depth_argb(
+	std::span<const float> depth,
+	std::span<int> colormapped_pixels,
+	const ColormapOptions& options
+) {
+	if (depth.size() != colormapped_pixels.size())
+		throw std::invalid_argument("colormapped_pixels");
+
+	const auto lut = colormap_lut(options.colormap, options.resolution);
+	const auto mapping = lut_mapping(options, lut.size());
+
+	std::array<uint32_t, COLORMAP_BLOCK_SIZE> indices{};
+	for (size_t begin = 0; begin < depth.size();
+		 begin += COLORMAP_BLOCK_SIZE) {
+		const size_t count = std::min(COLORMAP_BLOCK_SIZE, depth.size() - begin);
+		lut_indices(&depth[begin], count, mapping, indices.data());
+		for (size_t i = 0; i < count; i++) {
+			// the lut is 0xAABBGGRR, argb swaps red and blue
+			const uint32_t color = lut[indices[i]];
+			colormapped_pixels[begin + i] =
+				(int)((color & 0xFF00FF00U) | ((color & 0xFFU) << 16) |
+					  ((color >> 16) & 0xFFU));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include <cstdint>
+#include <span>
+
+enum class Colormap : uint8_t { Inferno, Magma, Viridis, Turbo, Grayscale };
+
+/// entries of the lookup table, more entries give smoother gradients (the
+/// 256 entry source tables are interpolated)
+enum class ColormapResolution : uint16_t { Entries1024 = 1024, Entries4096 = 4096 };
+
+struct ColormapOptions {
+	Colormap colormap = Colormap::Inferno;
+	ColormapResolution resolution = ColormapResolution::Entries1024;
+	/// depth that maps to the first and the last color, values outside are
+	/// clamped. if both are equal, every value maps to the middle color
+	float min_depth = 0.0f;
+	float max_depth = 1.0f;
+};
+
+/// colors of the lookup table in android bitmap byte order (r, g, b, a, so
+/// 0xAABBGGRR as little endian uint32), generated at compile time
+std::span<const uint32_t> colormap_lut(Colormap colormap, ColormapResolution resolution);
+
+/// writes the colors straight into the rows of the output (e.g. locked
+/// android bitmap pixels or a plain buffer on host builds), which has to be
+/// width * height. the lut indices of a block of pixels are computed in a
+/// vectorizable loop (one multiply add and a rounding conversion per pixel)
+void colormap_depth(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	const MutableRgbaImageView& output,
+	const ColormapOptions& options = {}
+);
+
+/// argb ints, e.g. for Bitmap.setPixels
+void colormap_depth_argb(
+	std::span<const float> depth,
+	std::span<int> colormapped_pixels,
+	const ColormapOptions& options = {}
+);
\ No newline at end of file
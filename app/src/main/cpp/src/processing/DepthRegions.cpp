@@ -0,0 +1,267 @@
+#include "DepthRegions.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+void DepthRegionIndex::build(
+	std::span<const float> depth,
+	size_t depth_width,
+	size_t depth_height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != depth_width * depth_height || depth.empty())
+		throw std::invalid_argument("depth");
+
+	if (depth_width != width || depth_height != height) {
+		width = depth_width;
+		height = depth_height;
+		level_count_x = (size_t)std::bit_width(width);
+		level_count_y = (size_t)std::bit_width(height);
+
+		rip_offsets.resize(level_count_x * level_count_y);
+		size_t rip_map_size = 0;
+		for (size_t level_x = 0; level_x < level_count_x; level_x++) {
+			for (size_t level_y = 0; level_y < level_count_y; level_y++) {
+				rip_offsets[level_x * level_count_y + level_y] = rip_map_size;
+				rip_map_size += (width >> level_x) * (height >> level_y);
+			}
+		}
+		rip_map.resize(rip_map_size);
+		integral.resize((width + 1) * (height + 1));
+
+		cells_x = (width + HISTOGRAM_CELL_SIZE - 1) / HISTOGRAM_CELL_SIZE;
+		cells_y = (height + HISTOGRAM_CELL_SIZE - 1) / HISTOGRAM_CELL_SIZE;
+		histograms.resize((cells_x + 1) * (cells_y + 1) * HISTOGRAM_BIN_COUNT);
+	}
+
+	// integral image, the base level of the rip map and the value range in a
+	// single pass over the depth
+	const size_t integral_width = width + 1;
+	std::fill_n(integral.begin(), integral_width, 0.0);
+	auto* base_level = &rip_map[rip_offsets[0]];
+	// range of the finite values, the bins of the histograms cover it
+	float min = std::numeric_limits<float>::infinity();
+	float max = -std::numeric_limits<float>::infinity();
+	for (size_t y = 0; y < height; y++) {
+		const float* row = &depth[y * width];
+		const double* integral_above = &integral[y * integral_width];
+		double* integral_row = &integral[(y + 1) * integral_width];
+		integral_row[0] = 0.0;
+		double row_sum = 0.0;
+		for (size_t x = 0; x < width; x++) {
+			const float value = row[x];
+			row_sum += value;
+			integral_row[x + 1] = integral_above[x + 1] + row_sum;
+			base_level[y * width + x] = MinMax{.min = value, .max = value};
+			if (std::isfinite(value)) {
+				min = std::min(min, value);
+				max = std::max(max, value);
+			}
+		}
+	}
+	if (min > max) {
+		min = 0.0f;
+		max = 0.0f;
+	}
+	depth_min = min;
+	depth_max = max;
+
+	// every level halves its neighbour with the next smaller x (or y) level
+	for (size_t level_y = 0; level_y < level_count_y; level_y++) {
+		for (size_t level_x = 0; level_x < level_count_x; level_x++) {
+			if (level_x == 0 && level_y == 0)
+				continue;
+			const size_t level_width = width >> level_x;
+			const size_t level_height = height >> level_y;
+			auto* level = &rip_map[rip_offsets[level_x * level_count_y + level_y]];
+
+			const bool halve_x = level_x > 0;
+			const MinMax* source = halve_x ? rip_level(level_x - 1, level_y)
+										   : rip_level(level_x, level_y - 1);
+			const size_t source_width = halve_x ? width >> (level_x - 1)
+												: level_width;
+			const size_t second_offset = halve_x ? 1 : source_width;
+			for (size_t y = 0; y < level_height; y++) {
+				for (size_t x = 0; x < level_width; x++) {
+					const size_t first = halve_x ? y * source_width + 2 * x
+												 : 2 * y * source_width + x;
+					const auto& a = source[first];
+					const auto& b = source[first + second_offset];
+					level[y * level_width + x] = MinMax{
+						.min = std::min(a.min, b.min),
+						.max = std::max(a.max, b.max),
+					};
+				}
+			}
+		}
+	}
+
+	// pixel counts of every bin per cell, then integrated per bin
+	std::ranges::fill(histograms, 0U);
+	const size_t histogram_width = cells_x + 1;
+	const float bin_scale =
+		max > min ? (float)HISTOGRAM_BIN_COUNT / (max - min) : 0.0f;
+	for (size_t y = 0; y < height; y++) {
+		const size_t cell_row = y / HISTOGRAM_CELL_SIZE + 1;
+		for (size_t x = 0; x < width; x++) {
+			// casting nan or an infinity to a bin is undefined, they are left
+			// out of the histograms
+			const float value = depth[y * width + x];
+			if (!std::isfinite(value))
+				continue;
+			const auto bin = std::min(
+				(size_t)((value - min) * bin_scale), HISTOGRAM_BIN_COUNT - 1
+			);
+			const size_t cell = cell_row * histogram_width +
+								x / HISTOGRAM_CELL_SIZE + 1;
+			histograms[cell * HISTOGRAM_BIN_COUNT + bin]++;
+		}
+	}
+	for (size_t cell_y = 1; cell_y <= cells_y; cell_y++) {
+		std::array<uint32_t, HISTOGRAM_BIN_COUNT> row_sums{};
+		for (size_t cell_x = 1; cell_x <= cells_x; cell_x++) {
+			uint32_t* bins = &histograms
+				[(cell_y * histogram_width + cell_x) * HISTOGRAM_BIN_COUNT];
+			const uint32_t* bins_above = bins - histogram_width * HISTOGRAM_BIN_COUNT;
+			for (size_t bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+				row_sums[bin] += bins[bin];
+				bins[bin] = bins_above[bin] + row_sums[bin];
+			}
+		}
+	}
+}
+
+DepthRegion DepthRegionIndex::clip(const DepthRegion& region) const {
+	if (!is_built())
+		throw std::logic_error("DepthRegionIndex not built");
+	if (region.x >= width || region.y >= height || region.width == 0 ||
+		region.height == 0)
+		throw std::invalid_argument("region");
+	return DepthRegion{
+		.x = region.x,
+		.y = region.y,
+		.width = std::min(region.width, width - region.x),
+		.height = std::min(region.height, height - region.y),
+	};
+}
+
+/// one block of a power of two interval decomposition
+struct DyadicInterval {
+	size_t level;
+	size_t index;
+};
+
+/// at most two blocks per level
+using DyadicIntervals = std::array<DyadicInterval, 2 * 64>;
+
+/// splits [begin, end) into the largest aligned power of two blocks, returns
+/// the number of blocks
+static size_t
+dyadic_intervals(size_t begin, size_t end, DyadicIntervals& intervals) {
+	size_t count = 0;
+	while (begin < end) {
+		// aligned to begin and not past end
+		auto level = (size_t)std::bit_width(end - begin) - 1;
+		if (begin != 0)
+			level = std::min(level, (size_t)std::countr_zero(begin));
+		intervals[count++] = {.level = level, .index = begin >> level};
+		begin += (size_t)1 << level;
+	}
+	return count;
+}
+
+DepthRegionIndex::MinMax DepthRegionIndex::min_max(const DepthRegion& region
+) const {
+	DyadicIntervals intervals_x{};
+	DyadicIntervals intervals_y{};
+	const size_t count_x =
+		dyadic_intervals(region.x, region.x + region.width, intervals_x);
+	const size_t count_y =
+		dyadic_intervals(region.y, region.y + region.height, intervals_y);
+
+	MinMax result{.min = depth_max, .max = depth_min};
+	for (size_t i = 0; i < count_y; i++) {
+		const auto& interval_y = intervals_y[i];
+		for (size_t j = 0; j < count_x; j++) {
+			const auto& interval_x = intervals_x[j];
+			const auto& block = rip_level(
+				interval_x.level, interval_y.level
+			)[interval_y.index * (width >> interval_x.level) + interval_x.index];
+			result.min = std::min(result.min, block.min);
+			result.max = std::max(result.max, block.max);
+		}
+	}
+	return result;
+}
+
+DepthRegionStats DepthRegionIndex::stats(const DepthRegion& region) const {
+	const auto clipped = clip(region);
+	const size_t integral_width = width + 1;
+	const size_t left = clipped.x;
+	const size_t right = clipped.x + clipped.width;
+	const size_t top = clipped.y * integral_width;
+	const size_t bottom = (clipped.y + clipped.height) * integral_width;
+	const double sum = integral[bottom + right] - integral[bottom + left] -
+					   integral[top + right] + integral[top + left];
+
+	const auto range = min_max(clipped);
+	return DepthRegionStats{
+		.mean = (float)(sum / (double)(clipped.width * clipped.height)),
+		.min = range.min,
+		.max = range.max,
+	};
+}
+
+float DepthRegionIndex::percentile(const DepthRegion& region, float percentile)
+	const {
+	const auto clipped = clip(region);
+
+	// all cells that overlap the region
+	const size_t histogram_width = cells_x + 1;
+	const size_t left = clipped.x / HISTOGRAM_CELL_SIZE;
+	const size_t right =
+		(clipped.x + clipped.width + HISTOGRAM_CELL_SIZE - 1) /
+		HISTOGRAM_CELL_SIZE;
+	const size_t top = clipped.y / HISTOGRAM_CELL_SIZE * histogram_width;
+	const size_t bottom =
+		(clipped.y + clipped.height + HISTOGRAM_CELL_SIZE - 1) /
+		HISTOGRAM_CELL_SIZE * histogram_width;
+	const uint32_t* top_left = &histograms[(top + left) * HISTOGRAM_BIN_COUNT];
+	const uint32_t* top_right = &histograms[(top + right) * HISTOGRAM_BIN_COUNT];
+	const uint32_t* bottom_left =
+		&histograms[(bottom + left) * HISTOGRAM_BIN_COUNT];
+	const uint32_t* bottom_right =
+		&histograms[(bottom + right) * HISTOGRAM_BIN_COUNT];
+
+	std::array<uint32_t, HISTOGRAM_BIN_COUNT> counts{};
+	uint32_t total = 0;
+	for (size_t bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+		counts[bin] = bottom_right[bin] - bottom_left[bin] - top_right[bin] +
+					  top_left[bin];
+		total += counts[bin];
+	}
+
+	// interpolated within the bin that contains the percentile
+	const float target = std::clamp(percentile, 0.0f, 1.0f) * (float)total;
+	const float bin_width = (depth_max - depth_min) / HISTOGRAM_BIN_COUNT;
+	float value = depth_max;
+	float cumulative = 0.0f;
+	for (size_t bin = 0; bin < HISTOGRAM_BIN_COUNT; bin++) {
+		const auto count = (float)counts[bin];
+		if (count > 0.0f && cumulative + count >= target) {
+			value = depth_min +
+					((float)bin + (target - cumulative) / count) * bin_width;
+			break;
+		}
+		cumulative += count;
+	}
+
+	const auto range = min_max(clipped);
+	return std::clamp(value, range.min, range.max);
+}
\ No newline at end of file
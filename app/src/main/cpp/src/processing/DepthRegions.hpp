@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// rectangle in depth pixels, clipped to the depth map by the queries
+struct DepthRegion {
+	size_t x = 0;
+	size_t y = 0;
+	size_t width = 0;
+	size_t height = 0;
+};
+
+struct DepthRegionStats {
+	float mean = 0.0f;
+	float min = 0.0f;
+	float max = 0.0f;
+};
+
+/// answers statistics of arbitrary rectangles of a depth map without
+/// scanning them:
+/// - mean from an integral image, O(1)
+/// - min / max from a rip map (min / max pyramids downsampled separately in
+///   x and y), the rectangle is split into O(log width * log height)
+///   power of two blocks
+/// - approximate percentiles from integral histograms over cells of
+///   HISTOGRAM_CELL_SIZE pixels, interpolated within the bins and clamped to
+///   the exact min / max
+///
+/// buffers are reused when the size doesn't change
+class DepthRegionIndex {
+  public:
+	static constexpr size_t HISTOGRAM_CELL_SIZE = 4;
+	static constexpr size_t HISTOGRAM_BIN_COUNT = 32;
+
+	void build(std::span<const float> depth, size_t width, size_t height);
+
+	[[nodiscard]] bool is_built() const { return width > 0; }
+
+	/// throws std::invalid_argument for regions outside of the depth map
+	[[nodiscard]] DepthRegionStats stats(const DepthRegion& region) const;
+
+	/// percentile between 0.0f and 1.0f, accurate to about a histogram bin
+	[[nodiscard]] float
+	percentile(const DepthRegion& region, float percentile) const;
+
+  private:
+	struct MinMax {
+		float min;
+		float max;
+	};
+
+	[[nodiscard]] DepthRegion clip(const DepthRegion& region) const;
+	[[nodiscard]] MinMax min_max(const DepthRegion& region) const;
+	[[nodiscard]] const MinMax*
+	rip_level(size_t level_x, size_t level_y) const {
+		return &rip_map[rip_offsets[level_x * level_count_y + level_y]];
+	}
+
+	size_t width = 0;
+	size_t height = 0;
+	float depth_min = 0.0f;
+	float depth_max = 0.0f;
+
+	/// (width + 1) * (height + 1), first row and column are 0
+	std::vector<double> integral;
+
+	/// level (x, y) has width >> x times height >> y blocks of 2^x * 2^y
+	/// pixels (partial blocks at the borders are left out)
+	std::vector<MinMax> rip_map;
+	std::vector<size_t> rip_offsets;
+	size_t level_count_x = 0;
+	size_t level_count_y = 0;
+
+	/// (cells_x + 1) * (cells_y + 1) * HISTOGRAM_BIN_COUNT pixel counts, an
+	/// integral image per bin (interleaved)
+	std::vector<uint32_t> histograms;
+	size_t cells_x = 0;
+	size_t cells_y = 0;
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "GuidedUpsampling.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+/// rows of the depth resolution passes that one task processes
+constexpr size_t ROWS_PER_TASK = 16;
+/// columns of the vertical box filter pass that one task processes, the
+/// running sums of a tile stay in registers / l1
+constexpr size_t COLUMNS_PER_TASK = 64;
+
+/// bt.601 luma of 8 bit rgb, scaled to 0 to 1
+constexpr float LUMA_RED = 0.299f / 255.0f;
+constexpr float LUMA_GREEN = 0.587f / 255.0f;
+constexpr float LUMA_BLUE = 0.114f / 255.0f;
+
+static float rgba_luma(const uint8_t* pixel) {
+	return LUMA_RED * (float)pixel[0] + LUMA_GREEN * (float)pixel[1] +
+		   LUMA_BLUE * (float)pixel[2];
+}
+
+static size_t task_count(size_t count, size_t per_task) {
+	return (count + per_task - 1) / per_task;
+}
+
+void GuidedDepthUpsampler::box_filter(
+	std::span<const float> input,
+	std::span<float> output,
+	ThreadPool& thread_pool
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto window_count = [this](size_t position, size_t size) {
+		const size_t first = position >= radius ? position - radius : 0;
+		const size_t last = std::min(position + radius, size - 1);
+		return (float)(last - first + 1);
+	};
+
+	// horizontal running sums, divided by the window width
+	thread_pool.parallel_for(
+		task_count(height, ROWS_PER_TASK),
+		[&](size_t task, size_t /*worker*/) {
+			const size_t end_row = std::min((task + 1) * ROWS_PER_TASK, height);
+			for (size_t y = task * ROWS_PER_TASK; y < end_row; y++) {
+				const float* row = &input[y * width];
+				float* sums = &row_sums[y * width];
+				float sum = 0.0f;
+				for (size_t x = 0; x <= std::min(radius, width - 1); x++)
+					sum += row[x];
+				for (size_t x = 0; x < width; x++) {
+					sums[x] = sum / window_count(x, width);
+					if (x + radius + 1 < width)
+						sum += row[x + radius + 1];
+					if (x >= radius)
+						sum -= row[x - radius];
+				}
+			}
+		}
+	);
+
+	// vertical running sums over a tile of columns, divided by the window
+	// height
+	thread_pool.parallel_for(
+		task_count(width, COLUMNS_PER_TASK),
+		[&](size_t task, size_t /*worker*/) {
+			const size_t first_column = task * COLUMNS_PER_TASK;
+			const size_t columns =
+				std::min(first_column + COLUMNS_PER_TASK, width) - first_column;
+			std::array<float, COLUMNS_PER_TASK> sums{};
+			for (size_t y = 0; y <= std::min(radius, height - 1); y++) {
+				for (size_t x = 0; x < columns; x++)
+					sums[x] += row_sums[y * width + first_column + x];
+			}
+			for (size_t y = 0; y < height; y++) {
+				const float inverse_count = 1.0f / window_count(y, height);
+				for (size_t x = 0; x < columns; x++)
+					output[y * width + first_column + x] =
+						sums[x] * inverse_count;
+				if (y + radius + 1 < height) {
+					const float* added =
+						&row_sums[(y + radius + 1) * width + first_column];
+					for (size_t x = 0; x < columns; x++)
+						sums[x] += added[x];
+				}
+				if (y >= radius) {
+					const float* removed =
+						&row_sums[(y - radius) * width + first_column];
+					for (size_t x = 0; x < columns; x++)
+						sums[x] -= removed[x];
+				}
+			}
+		}
+	);
+}
+
+void GuidedDepthUpsampler::upsample(
+	std::span<const float> depth,
+	size_t depth_width,
+	size_t depth_height,
+	const RgbaImageView& guide,
+	std::span<float> output,
+	ThreadPool& thread_pool,
+	const GuidedUpsamplingOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != depth_width * depth_height || depth.empty())
+		throw std::invalid_argument("depth");
+	if (guide.width == 0 || guide.height == 0 ||
+		guide.stride < guide.width * 4 ||
+		guide.pixels.size() <
+			guide.stride * (guide.height - 1) + guide.width * 4)
+		throw std::invalid_argument("guide");
+	if (output.size() != guide.width * guide.height)
+		throw std::invalid_argument("output");
+
+	width = depth_width;
+	height = depth_height;
+	radius = options.radius;
+	const size_t count = width * height;
+	for (auto* buffer :
+		 {&guide_luma, &luma_depth, &luma_squared, &mean_luma, &mean_depth,
+		  &mean_luma_depth, &mean_luma_squared, &coefficient_a, &coefficient_b,
+		  &smoothed_a, &smoothed_b, &row_sums})
+		buffer->resize(count);
+
+	// area average of the guide luma over the footprint of every depth pixel
+	thread_pool.parallel_for(
+		task_count(height, ROWS_PER_TASK),
+		[&](size_t task, size_t /*worker*/) {
+			const size_t end_row = std::min((task + 1) * ROWS_PER_TASK, height);
+			for (size_t y = task * ROWS_PER_TASK; y < end_row; y++) {
+				const size_t first_guide_row = y * guide.height / height;
+				// at least one pixel, in case the guide is smaller
+				const size_t end_guide_row = std::max(
+					(y + 1) * guide.height / height, first_guide_row + 1
+				);
+				for (size_t x = 0; x < width; x++) {
+					const size_t first_guide_column = x * guide.width / width;
+					const size_t end_guide_column = std::max(
+						(x + 1) * guide.width / width, first_guide_column + 1
+					);
+					float sum = 0.0f;
+					for (size_t guide_y = first_guide_row;
+						 guide_y < end_guide_row; guide_y++) {
+						const uint8_t* row = &guide.pixels[guide_y * guide.stride];
+						for (size_t guide_x = first_guide_column;
+							 guide_x < end_guide_column; guide_x++)
+							sum += rgba_luma(&row[guide_x * 4]);
+					}
+					const float luma =
+						sum / (float)((end_guide_row - first_guide_row) *
+									  (end_guide_column - first_guide_column));
+					const size_t index = y * width + x;
+					guide_luma[index] = luma;
+					luma_depth[index] = luma * depth[index];
+					luma_squared[index] = luma * luma;
+				}
+			}
+		}
+	);
+
+	box_filter(guide_luma, mean_luma, thread_pool);
+	box_filter(depth, mean_depth, thread_pool);
+	box_filter(luma_depth, mean_luma_depth, thread_pool);
+	box_filter(luma_squared, mean_luma_squared, thread_pool);
+
+	for (size_t i = 0; i < count; i++) {
+		const float variance = mean_luma_squared[i] - mean_luma[i] * mean_luma[i];
+		const float covariance =
+			mean_luma_depth[i] - mean_luma[i] * mean_depth[i];
+		coefficient_a[i] = covariance / (variance + options.epsilon);
+		coefficient_b[i] = mean_depth[i] - coefficient_a[i] * mean_luma[i];
+	}
+
+	box_filter(coefficient_a, smoothed_a, thread_pool);
+	box_filter(coefficient_b, smoothed_b, thread_pool);
+
+	// pixel centers of the output mapped to depth coordinates
+	const float scale_x = (float)width / (float)guide.width;
+	const float scale_y = (float)height / (float)guide.height;
+	column_indices.resize(guide.width);
+	column_weights.resize(guide.width);
+	for (size_t x = 0; x < guide.width; x++) {
+		const float position = std::clamp(
+			((float)x + 0.5f) * scale_x - 0.5f, 0.0f, (float)(width - 1)
+		);
+		column_indices[x] = (uint32_t)position;
+		column_weights[x] = position - (float)column_indices[x];
+	}
+
+	worker_rows.resize(thread_pool.worker_count());
+	const size_t tile_rows = std::max<size_t>(options.tile_rows, 1);
+	thread_pool.parallel_for(
+		task_count(guide.height, tile_rows),
+		[&](size_t task, size_t worker) {
+			// a and b interpolated to the output row, with the last column
+			// repeated so that x + 1 is always valid
+			auto& rows = worker_rows[worker];
+			rows.resize(2 * (width + 1));
+			float* row_a = rows.data();
+			float* row_b = rows.data() + width + 1;
+
+			const size_t end_row = std::min((task + 1) * tile_rows, guide.height);
+			for (size_t y = task * tile_rows; y < end_row; y++) {
+				const float position = std::clamp(
+					((float)y + 0.5f) * scale_y - 0.5f, 0.0f,
+					(float)(height - 1)
+				);
+				const auto first_row = (size_t)position;
+				const size_t second_row = std::min(first_row + 1, height - 1);
+				const float weight = position - (float)first_row;
+				for (size_t x = 0; x < width; x++) {
+					const float a0 = smoothed_a[first_row * width + x];
+					const float a1 = smoothed_a[second_row * width + x];
+					const float b0 = smoothed_b[first_row * width + x];
+					const float b1 = smoothed_b[second_row * width + x];
+					row_a[x] = a0 + (a1 - a0) * weight;
+					row_b[x] = b0 + (b1 - b0) * weight;
+				}
+				row_a[width] = row_a[width - 1];
+				row_b[width] = row_b[width - 1];
+
+				const uint8_t* guide_row = &guide.pixels[y * guide.stride];
+				float* output_row = &output[y * guide.width];
+				for (size_t x = 0; x < guide.width; x++) {
+					const uint32_t column = column_indices[x];
+					const float column_weight = column_weights[x];
+					const float a = row_a[column] +
+									(row_a[column + 1] - row_a[column]) *
+										column_weight;
+					const float b = row_b[column] +
+									(row_b[column + 1] - row_b[column]) *
+										column_weight;
+					output_row[x] = std::clamp(
+						a * rgba_luma(&guide_row[x * 4]) + b, 0.0f, 1.0f
+					);
+				}
+			}
+		}
+	);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include "utils/ThreadPool.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct GuidedUpsamplingOptions {
+	/// radius of the box filters in depth pixels
+	size_t radius = 4;
+	/// regularization of the local linear model, larger values smooth across
+	/// weaker guide edges
+	float epsilon = 1e-4f;
+	/// output rows per task
+	size_t tile_rows = 32;
+};
+
+/// upsamples depth to the resolution of the camera image with the fast guided
+/// filter (He and Sun): the local linear model depth = a * luma + b is fitted
+/// at depth resolution against the downsampled luma, and the smoothed
+/// coefficients are bilinearly upsampled and applied to the full resolution
+/// luma, so depth edges follow the edges of the image. the box filters use
+/// running sums, the cost doesn't depend on the radius. buffers are reused
+/// between calls
+class GuidedDepthUpsampler {
+  public:
+	/// output has guide.width * guide.height values, the depth covers the
+	/// whole guide image (stretched, as the model input)
+	void upsample(
+		std::span<const float> depth,
+		size_t depth_width,
+		size_t depth_height,
+		const RgbaImageView& guide,
+		std::span<float> output,
+		ThreadPool& thread_pool,
+		const GuidedUpsamplingOptions& options = {}
+	);
+
+  private:
+	/// mean over the (2 * radius + 1)^2 window, clipped at the borders
+	void box_filter(
+		std::span<const float> input,
+		std::span<float> output,
+		ThreadPool& thread_pool
+	);
+
+	size_t width = 0;
+	size_t height = 0;
+	size_t radius = 0;
+
+	std::vector<float> guide_luma;
+	std::vector<float> luma_depth;
+	std::vector<float> luma_squared;
+	std::vector<float> mean_luma;
+	std::vector<float> mean_depth;
+	std::vector<float> mean_luma_depth;
+	std::vector<float> mean_luma_squared;
+	std::vector<float> coefficient_a;
+	std::vector<float> coefficient_b;
+	std::vector<float> smoothed_a;
+	std::vector<float> smoothed_b;
+	/// horizontal pass of the box filter
+	std::vector<float> row_sums;
+	/// smoothed_a and smoothed_b interpolated to the output row, per worker
+	std::vector<std::vector<float>> worker_rows;
+
+	/// bilinear sample positions of the output columns
+	std::vector<uint32_t> column_indices;
+	std::vector<float> column_weights;
+};
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "LazyDepth.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+LazyDepthFrame::LazyDepthFrame(
+	std::span<const float> raw,
+	size_t width,
+	size_t height
+)
+	: LazyDepthFrame(raw, width, height, raw_depth_range(raw)) {}
+
+LazyDepthFrame::LazyDepthFrame(
+	std::span<const float> raw,
+	size_t width,
+	size_t height,
+	const RawDepthRange& range
+)
+	: raw(raw), width(width), height(height), range(range) {
+	if (raw.size() != width * height || raw.empty())
+		throw std::invalid_argument("raw");
+}
+
+float LazyDepthFrame::sample(float x, float y) const {
+	if (!is_valid())
+		throw std::logic_error("LazyDepthFrame is empty");
+
+	// pixel centers are at (i + 0.5) / size
+	const float pixel_x =
+		std::clamp(x * (float)width - 0.5f, 0.0f, (float)(width - 1));
+	const float pixel_y =
+		std::clamp(y * (float)height - 0.5f, 0.0f, (float)(height - 1));
+	const auto x0 = (size_t)pixel_x;
+	const auto y0 = (size_t)pixel_y;
+	const size_t x1 = std::min(x0 + 1, width - 1);
+	const size_t y1 = std::min(y0 + 1, height - 1);
+	const float weight_x = pixel_x - (float)x0;
+	const float weight_y = pixel_y - (float)y0;
+
+	const float top = raw[y0 * width + x0] +
+					  (raw[y0 * width + x1] - raw[y0 * width + x0]) * weight_x;
+	const float bottom =
+		raw[y1 * width + x0] +
+		(raw[y1 * width + x1] - raw[y1 * width + x0]) * weight_x;
+	// the normalization is linear, interpolating the raw values is the same
+	return range.normalize(top + (bottom - top) * weight_y);
+}
+
+DepthRegionStats LazyDepthFrame::sample_region(const DepthRegion& region
+) const {
+	if (!is_valid())
+		throw std::logic_error("LazyDepthFrame is empty");
+	if (region.x >= width || region.y >= height || region.width == 0 ||
+		region.height == 0)
+		throw std::invalid_argument("region");
+
+	const size_t right = std::min(region.x + region.width, width);
+	const size_t bottom = std::min(region.y + region.height, height);
+	double sum = 0.0;
+	float min = raw[region.y * width + region.x];
+	float max = min;
+	for (size_t y = region.y; y < bottom; y++) {
+		for (size_t x = region.x; x < right; x++) {
+			const float value = raw[y * width + x];
+			sum += value;
+			min = std::min(min, value);
+			max = std::max(max, value);
+		}
+	}
+
+	const auto count = (double)((right - region.x) * (bottom - region.y));
+	return DepthRegionStats{
+		.mean = range.normalize((float)(sum / count)),
+		.min = range.normalize(min),
+		.max = range.normalize(max),
+	};
+}
+
+void LazyDepthFrame::normalize(std::span<float> output) const {
+	if (output.size() != raw.size())
+		throw std::invalid_argument("output");
+
+	std::ranges::transform(raw, output.begin(), [this](float value) {
+		return range.normalize(value);
+	});
+}
+
+void LazyDepthFrame::colormap(
+	std::span<int> colormapped_pixels,
+	ColormapOptions colormap_options
+) const {
+	if (colormapped_pixels.size() != raw.size())
+		throw std::invalid_argument("colormapped_pixels");
+
+	colormap_options.min_depth = range.min;
+	colormap_options.max_depth = range.max;
+	colormap_depth_argb(raw, colormapped_pixels, colormap_options);
+}
\ No newline at end of file
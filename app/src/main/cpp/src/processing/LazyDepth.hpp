@@ -0,0 +1,54 @@
+#pragma once
+
+#include "processing/Colormaps.hpp"
+#include "processing/DepthRegions.hpp"
+#include "processing/Postprocessing.hpp"
+#include <span>
+
+/// raw depth output of a model that is only normalized where it is read: the
+/// frame keeps a view into the output buffer of the runtime and only reduces
+/// its range up front, so consumers that need a few points (anchors, focus
+/// points) don't pay the full normalization and colormap passes
+class LazyDepthFrame {
+  public:
+	LazyDepthFrame() = default;
+	/// raw has to outlive the frame (until the next inference of the runtime)
+	LazyDepthFrame(std::span<const float> raw, size_t width, size_t height);
+	/// normalized with the given range instead of the range of the frame
+	LazyDepthFrame(
+		std::span<const float> raw,
+		size_t width,
+		size_t height,
+		const RawDepthRange& range
+	);
+
+	[[nodiscard]] bool is_valid() const { return !raw.empty(); }
+	[[nodiscard]] size_t get_width() const { return width; }
+	[[nodiscard]] size_t get_height() const { return height; }
+	[[nodiscard]] const RawDepthRange& get_range() const { return range; }
+
+	/// relative depth between 0.0f and 1.0f, bilinearly interpolated at image
+	/// coordinates between 0.0f and 1.0f (clamped to the image)
+	[[nodiscard]] float sample(float x, float y) const;
+
+	/// relative depth statistics of a rectangle in depth pixels, throws
+	/// std::invalid_argument for regions outside of the depth map
+	[[nodiscard]] DepthRegionStats sample_region(const DepthRegion& region
+	) const;
+
+	/// the whole frame as relative depth
+	void normalize(std::span<float> output) const;
+
+	/// the whole frame as argb colors, normalized in the same pass (the depth
+	/// range of the options is replaced by the range of the frame)
+	void colormap(
+		std::span<int> colormapped_pixels,
+		ColormapOptions colormap_options = {}
+	) const;
+
+  private:
+	std::span<const float> raw;
+	size_t width = 0;
+	size_t height = 0;
+	RawDepthRange range;
+};
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "MotionGate.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+MotionGate::MotionGate(MotionGateOptions options) : options(options) {}
+
+void MotionGate::set_options(MotionGateOptions new_options) {
+	options = new_options;
+	reset();
+}
+
+void MotionGate::reset() {
+	reference_luma.clear();
+	cached_depth.clear();
+	reused_frame_count = 0;
+}
+
+MotionGateDecision MotionGate::evaluate(
+	std::span<const float> rgb,
+	size_t width,
+	size_t height,
+	ImageLayout layout,
+	float max_value
+) {
+	if (!options.enabled)
+		return {};
+
+	PROFILE_DEPTH_FUNCTION()
+
+	if (rgb.size() != width * height * RGB_CHANNELS)
+		throw std::invalid_argument("rgb");
+
+	compute_luma(rgb, width, height, layout, max_value);
+
+	if (reference_luma.empty() || width != reference_input_width ||
+		height != reference_input_height ||
+		reused_frame_count >= options.max_reused_frames)
+		return {};
+
+	if (changed_block_fraction(0, 0) <= options.max_changed_block_fraction) {
+		reused_frame_count++;
+		return {.source = DepthSource::Reused};
+	}
+
+	// the depth can only be shifted if it has the resolution of the input
+	if (options.warp_cached_depth && cached_depth.size() == width * height) {
+		const auto [shift_x, shift_y] = estimate_global_motion();
+		if ((shift_x != 0 || shift_y != 0) &&
+			changed_block_fraction(shift_x, shift_y) <=
+				options.max_changed_block_fraction) {
+			reused_frame_count++;
+			const auto factor = (int)options.downsample_factor;
+			return {
+				.source = DepthSource::Warped,
+				.shift_x = shift_x * factor,
+				.shift_y = shift_y * factor,
+			};
+		}
+	}
+
+	return {};
+}
+
+void MotionGate::update_reference(std::span<const float> depth) {
+	if (!options.enabled)
+		return;
+
+	reference_luma.assign(luma.begin(), luma.end());
+	reference_input_width = input_width;
+	reference_input_height = input_height;
+	cached_depth.assign(depth.begin(), depth.end());
+	reused_frame_count = 0;
+}
+
+void MotionGate::write_cached_depth(
+	const MotionGateDecision& decision,
+	std::span<float> output
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (output.size() != cached_depth.size())
+		throw std::invalid_argument("output");
+
+	if (decision.source != DepthSource::Warped) {
+		std::ranges::copy(cached_depth, output.begin());
+		return;
+	}
+
+	// content moved by the shift, pixels that moved into the image from
+	// outside are clamped to the border
+	const auto width = (int)input_width;
+	const auto height = (int)input_height;
+	for (int y = 0; y < height; y++) {
+		const int source_y = std::clamp(y - decision.shift_y, 0, height - 1);
+		for (int x = 0; x < width; x++) {
+			const int source_x = std::clamp(x - decision.shift_x, 0, width - 1);
+			output[(size_t)(y * width + x)] =
+				cached_depth[(size_t)(source_y * width + source_x)];
+		}
+	}
+}
+
+void MotionGate::compute_luma(
+	std::span<const float> rgb,
+	size_t width,
+	size_t height,
+	ImageLayout layout,
+	float max_value
+) {
+	const size_t factor = std::max<size_t>(options.downsample_factor, 1);
+	input_width = width;
+	input_height = height;
+	luma_width = std::max<size_t>(width / factor, 1);
+	luma_height = std::max<size_t>(height / factor, 1);
+	luma.assign(luma_width * luma_height, 0.0f);
+
+	const size_t plane_size = width * height;
+	const auto pixel_luma = [&](size_t x, size_t y) {
+		const size_t pixel = y * width + x;
+		if (layout == ImageLayout::Hwc) {
+			const auto* values = &rgb[pixel * RGB_CHANNELS];
+			return 0.299f * values[0] + 0.587f * values[1] +
+				   0.114f * values[2];
+		}
+		return 0.299f * rgb[pixel] + 0.587f * rgb[plane_size + pixel] +
+			   0.114f * rgb[2 * plane_size + pixel];
+	};
+
+	// box filter of factor x factor pixels, the remaining border pixels are
+	// ignored
+	const size_t box_width = std::min(factor, width);
+	const size_t box_height = std::min(factor, height);
+	const float scale = 1.0f / ((float)(box_width * box_height) * max_value);
+	for (size_t luma_y = 0; luma_y < luma_height; luma_y++) {
+		for (size_t luma_x = 0; luma_x < luma_width; luma_x++) {
+			float sum = 0.0f;
+			for (size_t y = 0; y < box_height; y++) {
+				for (size_t x = 0; x < box_width; x++) {
+					sum += pixel_luma(
+						luma_x * box_width + x, luma_y * box_height + y
+					);
+				}
+			}
+			luma[luma_y * luma_width + luma_x] = sum * scale;
+		}
+	}
+}
+
+float MotionGate::changed_block_fraction(int shift_x, int shift_y) const {
+	const size_t block_size = std::max<size_t>(options.block_size, 1);
+	const size_t blocks_x = (luma_width + block_size - 1) / block_size;
+	const size_t blocks_y = (luma_height + block_size - 1) / block_size;
+	const auto width = (int)luma_width;
+	const auto height = (int)luma_height;
+
+	size_t changed_blocks = 0;
+	for (size_t block_y = 0; block_y < blocks_y; block_y++) {
+		for (size_t block_x = 0; block_x < blocks_x; block_x++) {
+			float sum = 0.0f;
+			float square_sum = 0.0f;
+			float reference_sum = 0.0f;
+			float reference_square_sum = 0.0f;
+
+			const size_t end_y =
+				std::min((block_y + 1) * block_size, luma_height);
+			const size_t end_x =
+				std::min((block_x + 1) * block_size, luma_width);
+			for (size_t y = block_y * block_size; y < end_y; y++) {
+				const int reference_y =
+					std::clamp((int)y - shift_y, 0, height - 1);
+				for (size_t x = block_x * block_size; x < end_x; x++) {
+					const int reference_x =
+						std::clamp((int)x - shift_x, 0, width - 1);
+					const float value = luma[y * luma_width + x];
+					const float reference_value =
+						reference_luma[(size_t)(reference_y * width + reference_x)];
+					sum += value;
+					square_sum += value * value;
+					reference_sum += reference_value;
+					reference_square_sum += reference_value * reference_value;
+				}
+			}
+
+			const auto count =
+				(float)((end_y - block_y * block_size) *
+						(end_x - block_x * block_size));
+			const float mean = sum / count;
+			const float reference_mean = reference_sum / count;
+			const float stddev =
+				std::sqrt(std::max(square_sum / count - mean * mean, 0.0f));
+			const float reference_stddev = std::sqrt(std::max(
+				reference_square_sum / count - reference_mean * reference_mean,
+				0.0f
+			));
+
+			if (std::abs(mean - reference_mean) >
+					options.block_change_threshold ||
+				std::abs(stddev - reference_stddev) >
+					options.block_change_threshold)
+				changed_blocks++;
+		}
+	}
+	return (float)changed_blocks / (float)(blocks_x * blocks_y);
+}
+
+std::pair<int, int> MotionGate::estimate_global_motion() const {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto width = (int)luma_width;
+	const auto height = (int)luma_height;
+	const int radius = std::min({options.max_motion_shift, width - 1, height - 1});
+
+	std::pair<int, int> best_shift = {0, 0};
+	float best_difference = std::numeric_limits<float>::max();
+	for (int shift_y = -radius; shift_y <= radius; shift_y++) {
+		for (int shift_x = -radius; shift_x <= radius; shift_x++) {
+			// only the region that is visible in both frames
+			float difference = 0.0f;
+			for (int y = std::max(shift_y, 0);
+				 y < height + std::min(shift_y, 0); y++) {
+				for (int x = std::max(shift_x, 0);
+					 x < width + std::min(shift_x, 0); x++) {
+					difference += std::abs(
+						luma[(size_t)(y * width + x)] -
+						reference_luma[(size_t)(
+							(y - shift_y) * width + (x - shift_x)
+						)]
+					);
+				}
+			}
+			const auto overlap = (float)((width - std::abs(shift_x)) *
+										 (height - std::abs(shift_y)));
+			difference /= overlap;
+
+			if (difference < best_difference) {
+				best_difference = difference;
+				best_shift = {shift_x, shift_y};
+			}
+		}
+	}
+	return best_shift;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "processing/Preprocessing.hpp"
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+/// where the depth of a frame came from
+enum class DepthSource : uint8_t {
+	/// the model was invoked for this frame
+	Fresh = 0,
+	/// the scene didn't change, the depth of the last inference was reused
+	Reused = 1,
+	/// the camera moved, the depth of the last inference was shifted by the
+	/// estimated global motion
+	Warped = 2,
+	/// the image was seen before, the depth was loaded from the DepthCache
+	Cached = 3,
+};
+
+struct MotionGateOptions {
+	/// off by default, every frame runs the model unless the app opts in
+	bool enabled = false;
+	/// frames are compared on a luma image that is downsampled by this factor
+	size_t downsample_factor = 4;
+	/// side length of the compared blocks, in downsampled pixels
+	size_t block_size = 8;
+	/// a block changed if its mean or standard deviation of luma (0 to 1)
+	/// differs by more than this
+	float block_change_threshold = 0.03f;
+	/// the inference is skipped if at most this fraction of blocks changed
+	float max_changed_block_fraction = 0.02f;
+	/// reuse the depth for translating cameras, shifted by the estimated
+	/// global motion
+	bool warp_cached_depth = true;
+	/// search radius of the global motion estimation, in downsampled pixels
+	int max_motion_shift = 4;
+	/// forces an inference after this many consecutive reused frames
+	size_t max_reused_frames = 30;
+};
+
+struct MotionGateDecision {
+	DepthSource source = DepthSource::Fresh;
+	/// global motion in input pixels (only for DepthSource::Warped)
+	int shift_x = 0;
+	int shift_y = 0;
+};
+
+/// detects whether the camera image changed enough since the last inference
+/// to be worth running the model again, by comparing block statistics of
+/// downsampled luma images
+class MotionGate {
+  public:
+	explicit MotionGate(MotionGateOptions options = {});
+
+	/// compares the model input (before normalization, values between 0 and
+	/// max_value) to the input of the last inference
+	MotionGateDecision evaluate(
+		std::span<const float> rgb,
+		size_t width,
+		size_t height,
+		ImageLayout layout,
+		float max_value
+	);
+
+	/// stores the frame of the last evaluate() call and its inferred depth as
+	/// reference for the next frames
+	void update_reference(std::span<const float> depth);
+
+	/// writes the cached depth of the last inference, shifted by the global
+	/// motion of the decision
+	void write_cached_depth(
+		const MotionGateDecision& decision,
+		std::span<float> output
+	) const;
+
+	/// forgets the reference frame, the next frame is always inferred
+	void reset();
+
+	void set_options(MotionGateOptions new_options);
+
+  private:
+	void compute_luma(
+		std::span<const float> rgb,
+		size_t width,
+		size_t height,
+		ImageLayout layout,
+		float max_value
+	);
+
+	/// fraction of blocks whose statistics changed, comparing the current
+	/// frame with the reference moved by (shift_x, shift_y)
+	[[nodiscard]] float changed_block_fraction(int shift_x, int shift_y) const;
+
+	/// translation with the smallest mean absolute luma difference
+	[[nodiscard]] std::pair<int, int> estimate_global_motion() const;
+
+	MotionGateOptions options;
+
+	size_t input_width = 0;
+	size_t input_height = 0;
+	size_t luma_width = 0;
+	size_t luma_height = 0;
+	std::vector<float> luma;
+
+	std::vector<float> reference_luma;
+	size_t reference_input_width = 0;
+	size_t reference_input_height = 0;
+	std::vector<float> cached_depth;
+	size_t reused_frame_count = 0;
+};
\ No newline at end of file
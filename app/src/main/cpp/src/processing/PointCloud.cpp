@@ -0,0 +1,227 @@
+#include "PointCloud.hpp"
+
+#include "utils/ImageUtils.hpp"
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+CameraIntrinsics intrinsics_from_field_of_view(
+	size_t width,
+	size_t height,
+	float horizontal_fov_radians
+) {
+	const float focal_length =
+		(float)width / (2.0f * std::tan(horizontal_fov_radians / 2.0f));
+	return CameraIntrinsics{
+		.fx = focal_length,
+		.fy = focal_length,
+		.cx = ((float)width - 1.0f) / 2.0f,
+		.cy = ((float)height - 1.0f) / 2.0f,
+	};
+}
+
+CameraIntrinsics scale_intrinsics(
+	const CameraIntrinsics& intrinsics,
+	size_t from_width,
+	size_t from_height,
+	size_t to_width,
+	size_t to_height
+) {
+	const float scale_x = (float)to_width / (float)from_width;
+	const float scale_y = (float)to_height / (float)from_height;
+	// pixel centers are at integer coordinates, so the principal point is
+	// scaled around -0.5
+	return CameraIntrinsics{
+		.fx = intrinsics.fx * scale_x,
+		.fy = intrinsics.fy * scale_y,
+		.cx = (intrinsics.cx + 0.5f) * scale_x - 0.5f,
+		.cy = (intrinsics.cy + 0.5f) * scale_y - 0.5f,
+	};
+}
+
+std::span<const PointXYZRGB> PointCloudGenerator::generate(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	std::span<const int> colors,
+	const PointCloudOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+	if (!colors.empty() && colors.size() != depth.size())
+		throw std::invalid_argument("colors");
+
+	back_project(depth, width, height, colors, options);
+	if (options.voxel_size <= 0.0f)
+		return points;
+
+	downsample(options.voxel_size, !colors.empty());
+	return downsampled_points;
+}
+
+void PointCloudGenerator::back_project(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	std::span<const int> colors,
+	const PointCloudOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto& intrinsics = options.intrinsics;
+	column_rays.resize(width);
+	for (size_t x = 0; x < width; x++)
+		column_rays[x] = ((float)x - intrinsics.cx) / intrinsics.fx;
+	row_x.resize(width);
+	row_y.resize(width);
+	row_z.resize(width);
+
+	// every pixel is a point at most, the buffer only grows
+	points.reserve(width * height);
+	points.clear();
+
+	const bool inverse = options.encoding == DepthEncoding::InverseDepth;
+	for (size_t y = 0; y < height; y++) {
+		const float row_ray = ((float)y - intrinsics.cy) / intrinsics.fy;
+		const float* row_depth = &depth[y * width];
+		float* xs = row_x.data();
+		float* ys = row_y.data();
+		float* zs = row_z.data();
+		const float* rays = column_rays.data();
+
+		// no branches and no stores that depend on the value, so the compiler
+		// vectorizes the loop. a zero inverse depth gives inf, which is
+		// dropped with the negative and nan values below
+		if (inverse) {
+			for (size_t x = 0; x < width; x++) {
+				const float z =
+					1.0f / (options.scale * row_depth[x] + options.shift);
+				xs[x] = rays[x] * z;
+				ys[x] = row_ray * z;
+				zs[x] = z;
+			}
+		} else {
+			for (size_t x = 0; x < width; x++) {
+				const float z = options.scale * row_depth[x] + options.shift;
+				xs[x] = rays[x] * z;
+				ys[x] = row_ray * z;
+				zs[x] = z;
+			}
+		}
+
+		for (size_t x = 0; x < width; x++) {
+			const float z = zs[x];
+			// written so that nan fails the check
+			if (!(z > options.min_depth && z <= options.max_depth))
+				continue;
+			points.push_back(PointXYZRGB{
+				.x = xs[x],
+				.y = ys[x],
+				.z = z,
+				.color = colors.empty() ? 0 : colors[y * width + x],
+			});
+		}
+	}
+}
+
+/// voxel coordinates wrap at 2^21, far beyond the depth range of a camera
+constexpr uint64_t VOXEL_COORDINATE_MASK = (1ULL << 21) - 1;
+
+static uint64_t voxel_key(float x, float y, float z, float inverse_voxel_size) {
+	const auto coordinate = [inverse_voxel_size](float value) {
+		// floor without the libm call (no sse4.1 / armv8 rounding instructions
+		// by default), the points are finite
+		const float scaled = value * inverse_voxel_size;
+		auto index = (int64_t)scaled;
+		index -= (float)index > scaled ? 1 : 0;
+		return (uint64_t)index & VOXEL_COORDINATE_MASK;
+	};
+	return (coordinate(x) << 42) | (coordinate(y) << 21) | coordinate(z);
+}
+
+/// fibonacci hashing, the upper bits are well mixed
+static size_t voxel_slot(uint64_t key, int slot_shift) {
+	return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> slot_shift);
+}
+
+void PointCloudGenerator::grow_voxels(size_t capacity) {
+	std::vector<Voxel> previous_voxels(capacity, Voxel{});
+	std::swap(voxels, previous_voxels);
+	const size_t slot_mask = voxels.size() - 1;
+	const int slot_shift = 64 - std::countr_zero(voxels.size());
+
+	for (uint32_t& used_slot : used_voxels) {
+		const auto& voxel = previous_voxels[used_slot];
+		size_t slot = voxel_slot(voxel.key, slot_shift);
+		while (voxels[slot].count != 0)
+			slot = (slot + 1) & slot_mask;
+		voxels[slot] = voxel;
+		used_slot = (uint32_t)slot;
+	}
+}
+
+void PointCloudGenerator::downsample(float voxel_size, bool has_colors) {
+	PROFILE_DEPTH_FUNCTION()
+
+	// the table only grows (at most half full) and is cleared slot by slot,
+	// so frames with similar voxel counts don't allocate
+	if (voxels.empty())
+		grow_voxels(MIN_VOXEL_CAPACITY);
+
+	const float inverse_voxel_size = 1.0f / voxel_size;
+	used_voxels.clear();
+	// neighbouring pixels mostly fall into the same voxel
+	uint64_t previous_key = UINT64_MAX;
+	size_t previous_slot = 0;
+	for (const auto& point : points) {
+		const uint64_t key =
+			voxel_key(point.x, point.y, point.z, inverse_voxel_size);
+		size_t slot = previous_slot;
+		if (key != previous_key) {
+			if (used_voxels.size() * 2 >= voxels.size())
+				grow_voxels(voxels.size() * 2);
+			const size_t slot_mask = voxels.size() - 1;
+			slot = voxel_slot(key, 64 - std::countr_zero(voxels.size()));
+			while (voxels[slot].count != 0 && voxels[slot].key != key)
+				slot = (slot + 1) & slot_mask;
+			previous_key = key;
+			previous_slot = slot;
+		}
+
+		auto& voxel = voxels[slot];
+		if (voxel.count == 0) {
+			voxel = Voxel{.key = key};
+			used_voxels.push_back((uint32_t)slot);
+		}
+		voxel.x += point.x;
+		voxel.y += point.y;
+		voxel.z += point.z;
+		voxel.r += (uint32_t)red_channel_from_argb_color(point.color);
+		voxel.g += (uint32_t)green_channel_from_argb_color(point.color);
+		voxel.b += (uint32_t)blue_channel_from_argb_color(point.color);
+		voxel.count++;
+	}
+
+	downsampled_points.clear();
+	downsampled_points.reserve(used_voxels.size());
+	for (const uint32_t slot : used_voxels) {
+		auto& voxel = voxels[slot];
+		const float inverse_count = 1.0f / (float)voxel.count;
+		downsampled_points.push_back(PointXYZRGB{
+			.x = voxel.x * inverse_count,
+			.y = voxel.y * inverse_count,
+			.z = voxel.z * inverse_count,
+			.color = has_colors ? color_rgb(
+									  (int)(voxel.r / voxel.count),
+									  (int)(voxel.g / voxel.count),
+									  (int)(voxel.b / voxel.count)
+								  )
+								: 0,
+		});
+		voxel.count = 0;
+	}
+}
\ No newline at end of file
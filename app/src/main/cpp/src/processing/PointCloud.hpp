@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// pinhole camera intrinsics in pixels of the depth map
+struct CameraIntrinsics {
+	float fx = 1.0f;
+	float fy = 1.0f;
+	float cx = 0.0f;
+	float cy = 0.0f;
+};
+
+/// intrinsics of a centered pinhole camera with square pixels
+CameraIntrinsics intrinsics_from_field_of_view(
+	size_t width,
+	size_t height,
+	float horizontal_fov_radians
+);
+
+/// intrinsics of the camera image (e.g. LENS_INTRINSIC_CALIBRATION) scaled to
+/// the resolution of the depth map
+CameraIntrinsics scale_intrinsics(
+	const CameraIntrinsics& intrinsics,
+	size_t from_width,
+	size_t from_height,
+	size_t to_width,
+	size_t to_height
+);
+
+/// what the values of the depth map are, before scale and shift
+enum class DepthEncoding : uint8_t {
+	/// values grow with the distance
+	Depth,
+	/// values shrink with the distance (disparity), the output of the relative
+	/// depth models
+	InverseDepth,
+};
+
+struct PointCloudOptions {
+	CameraIntrinsics intrinsics;
+	DepthEncoding encoding = DepthEncoding::InverseDepth;
+	/// metric depth = scale * value + shift, for inverse depth the metric
+	/// depth is 1 / (scale * value + shift)
+	float scale = 1.0f;
+	float shift = 0.0f;
+	/// points outside of the range are dropped
+	float min_depth = 0.0f;
+	float max_depth = 100.0f;
+	/// edge length of the voxels points are averaged in, 0 disables the
+	/// downsampling
+	float voxel_size = 0.0f;
+};
+
+/// 16 bytes, so a point cloud can be uploaded as a vertex buffer as is
+struct PointXYZRGB {
+	float x;
+	float y;
+	float z;
+	/// argb, 0 without colors
+	int32_t color;
+};
+static_assert(sizeof(PointXYZRGB) == 4 * sizeof(float));
+
+/// back-projects depth maps into camera space points (x right, y down, z
+/// forward). all buffers are reused between frames, so a generator should be
+/// kept for a stream of depth maps
+class PointCloudGenerator {
+  public:
+	/// colors are argb pixels of the depth map size, or empty. the points are
+	/// valid until the next call
+	std::span<const PointXYZRGB> generate(
+		std::span<const float> depth,
+		size_t width,
+		size_t height,
+		std::span<const int> colors,
+		const PointCloudOptions& options
+	);
+
+  private:
+	void back_project(
+		std::span<const float> depth,
+		size_t width,
+		size_t height,
+		std::span<const int> colors,
+		const PointCloudOptions& options
+	);
+	void downsample(float voxel_size, bool has_colors);
+	/// rehashes the voxels of the current frame into a larger table
+	void grow_voxels(size_t capacity);
+
+	/// (x - cx) / fx of every column
+	std::vector<float> column_rays;
+	/// x, y, z of a row, computed branch free so the loop vectorizes
+	std::vector<float> row_x;
+	std::vector<float> row_y;
+	std::vector<float> row_z;
+	std::vector<PointXYZRGB> points;
+
+	struct Voxel {
+		uint64_t key = 0;
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		/// sums of the color channels
+		uint32_t r = 0;
+		uint32_t g = 0;
+		uint32_t b = 0;
+		uint32_t count = 0;
+	};
+	static constexpr size_t MIN_VOXEL_CAPACITY = 4096;
+	/// open addressing hash table of the voxels (power of two size), count == 0
+	/// marks free slots
+	std::vector<Voxel> voxels;
+	/// slots used by the current frame, in insertion order
+	std::vector<uint32_t> used_voxels;
+	std::vector<PointXYZRGB> downsampled_points;
+};
\ No newline at end of file
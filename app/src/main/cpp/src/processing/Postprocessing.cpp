@@ -0,0 +1,228 @@
+#include "Postprocessing.hpp"
+
+#include "processing/ColormapTables.hpp"
+#include "processing/Colormaps.hpp"
+#include "simd/SimdKernels.hpp"
+#include "utils/ImageUtils.hpp"
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+RawDepthRange raw_depth_range(std::span<const float> values) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (values.empty())
+		return {};
+
+	const auto [min, max] = simd_kernels().min_max(values);
+	return {.min = min, .max = max};
+}
+
+void min_max_scaling(std::span<float> values) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (values.empty())
+		return;
+
+	const auto [min, max] = raw_depth_range(values);
+
+	const float diff = max - min;
+
+	if (diff > 0.0f) {
+		simd_kernels().scale_offset(values, 1.0f / diff, -min / diff);
+	} else {
+		for (float& value : values) {
+			value = 0.5f;
+		}
+	}
+}
+
+void depth_colormap(
+	std::span<const float> depth_values,
+	std::span<int> colormapped_pixels
+) {
+	if (depth_values.size() != colormapped_pixels.size())
+		throw std::invalid_argument("depth_values and colormapped_pixels");
+
+	colormap_depth_argb(depth_values, colormapped_pixels);
+}
+
+int inferno_depth_colormap(float relative_depth) {
+	relative_depth = std::clamp(relative_depth, 0.0f, 1.0f);
+	auto index = (size_t)(relative_depth * (INFERNO_COLOR_COUNT - 1));
+	return INFERNO_COLORS[index];
+}
+
+/// rows / columns of the summed area table passes that one task processes
+constexpr size_t BOKEH_ROWS_PER_TASK = 16;
+constexpr size_t BOKEH_COLUMNS_PER_TASK = 64;
+
+void DepthBokehRenderer::render(
+	const RgbaImageView& image,
+	std::span<const float> depth,
+	size_t depth_width,
+	size_t depth_height,
+	const MutableRgbaImageView& output,
+	ThreadPool& thread_pool,
+	const BokehOptions& options
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != depth_width * depth_height || depth.empty())
+		throw std::invalid_argument("depth");
+	const size_t width = image.width;
+	const size_t height = image.height;
+	if (width == 0 || height == 0 || image.stride < width * 4 ||
+		image.pixels.size() < image.stride * (height - 1) + width * 4)
+		throw std::invalid_argument("image");
+	if (output.width != width || output.height != height ||
+		output.stride < width * 4 ||
+		output.pixels.size() < output.stride * (height - 1) + width * 4)
+		throw std::invalid_argument("output");
+
+	const size_t table_width = width + 1;
+	summed_area_table.resize(table_width * (height + 1));
+	std::fill_n(summed_area_table.begin(), table_width, PixelSum{});
+
+	// prefix sums of every row
+	thread_pool.parallel_for(
+		(height + BOKEH_ROWS_PER_TASK - 1) / BOKEH_ROWS_PER_TASK,
+		[&](size_t task, size_t /*worker*/) {
+			const size_t end_row =
+				std::min((task + 1) * BOKEH_ROWS_PER_TASK, height);
+			for (size_t y = task * BOKEH_ROWS_PER_TASK; y < end_row; y++) {
+				const uint8_t* row = &image.pixels[y * image.stride];
+				PixelSum* sums = &summed_area_table[(y + 1) * table_width];
+				PixelSum sum{};
+				sums[0] = sum;
+				for (size_t x = 0; x < width; x++) {
+					for (size_t channel = 0; channel < 3; channel++)
+						sum.channels[channel] += row[x * 4 + channel];
+					sums[x + 1] = sum;
+				}
+			}
+		}
+	);
+
+	// accumulated down the columns, a tile of columns per task
+	thread_pool.parallel_for(
+		(table_width + BOKEH_COLUMNS_PER_TASK - 1) / BOKEH_COLUMNS_PER_TASK,
+		[&](size_t task, size_t /*worker*/) {
+			const size_t first_column = task * BOKEH_COLUMNS_PER_TASK;
+			const size_t end_column =
+				std::min(first_column + BOKEH_COLUMNS_PER_TASK, table_width);
+			for (size_t y = 2; y <= height; y++) {
+				PixelSum* sums = &summed_area_table[y * table_width];
+				const PixelSum* above = sums - table_width;
+				for (size_t x = first_column; x < end_column; x++) {
+					for (size_t channel = 0; channel < 4; channel++)
+						sums[x].channels[channel] += above[x].channels[channel];
+				}
+			}
+		}
+	);
+
+	// pixel centers of the output mapped to depth coordinates
+	const float scale_x = (float)depth_width / (float)width;
+	const float scale_y = (float)depth_height / (float)height;
+	column_indices.resize(width);
+	column_weights.resize(width);
+	for (size_t x = 0; x < width; x++) {
+		const float position = std::clamp(
+			((float)x + 0.5f) * scale_x - 0.5f, 0.0f, (float)(depth_width - 1)
+		);
+		column_indices[x] = (uint32_t)position;
+		column_weights[x] = position - (float)column_indices[x];
+	}
+
+	// the radius reaches max_radius at the depth furthest from the focus
+	const float max_distance =
+		std::max(options.focus_depth, 1.0f - options.focus_depth) -
+		options.focus_range;
+	const float radius_scale =
+		(float)options.max_radius / std::max(max_distance, 1e-3f);
+
+	worker_radii.resize(thread_pool.worker_count());
+	const size_t tile_rows = std::max<size_t>(options.tile_rows, 1);
+	thread_pool.parallel_for(
+		(height + tile_rows - 1) / tile_rows,
+		[&](size_t task, size_t worker) {
+			auto& radii = worker_radii[worker];
+			radii.resize(width);
+
+			const size_t end_row = std::min((task + 1) * tile_rows, height);
+			for (size_t y = task * tile_rows; y < end_row; y++) {
+				const float position = std::clamp(
+					((float)y + 0.5f) * scale_y - 0.5f, 0.0f,
+					(float)(depth_height - 1)
+				);
+				const auto first_row = (size_t)position;
+				const size_t second_row =
+					std::min(first_row + 1, depth_height - 1);
+				const float row_weight = position - (float)first_row;
+				const float* depth_row_0 = &depth[first_row * depth_width];
+				const float* depth_row_1 = &depth[second_row * depth_width];
+
+				for (size_t x = 0; x < width; x++) {
+					const size_t column = column_indices[x];
+					const size_t next_column =
+						std::min<size_t>(column + 1, depth_width - 1);
+					const float top =
+						depth_row_0[column] +
+						(depth_row_0[next_column] - depth_row_0[column]) *
+							column_weights[x];
+					const float bottom =
+						depth_row_1[column] +
+						(depth_row_1[next_column] - depth_row_1[column]) *
+							column_weights[x];
+					const float pixel_depth = top + (bottom - top) * row_weight;
+					const float distance =
+						std::abs(pixel_depth - options.focus_depth) -
+						options.focus_range;
+					radii[x] = (uint16_t)std::clamp(
+						distance * radius_scale + 0.5f, 0.0f,
+						(float)options.max_radius
+					);
+				}
+
+				const uint8_t* input_row = &image.pixels[y * image.stride];
+				uint8_t* output_row = &output.pixels[y * output.stride];
+				for (size_t x = 0; x < width; x++) {
+					const size_t radius = radii[x];
+					if (radius == 0) {
+						output_row[x * 4] = input_row[x * 4];
+						output_row[x * 4 + 1] = input_row[x * 4 + 1];
+						output_row[x * 4 + 2] = input_row[x * 4 + 2];
+						output_row[x * 4 + 3] = 255;
+						continue;
+					}
+
+					const size_t left = x >= radius ? x - radius : 0;
+					const size_t right = std::min(x + radius, width - 1) + 1;
+					const size_t top = y >= radius ? y - radius : 0;
+					const size_t bottom = std::min(y + radius, height - 1) + 1;
+					const auto& top_left =
+						summed_area_table[top * table_width + left];
+					const auto& top_right =
+						summed_area_table[top * table_width + right];
+					const auto& bottom_left =
+						summed_area_table[bottom * table_width + left];
+					const auto& bottom_right =
+						summed_area_table[bottom * table_width + right];
+					const float inverse_count =
+						1.0f / (float)((right - left) * (bottom - top));
+					for (size_t channel = 0; channel < 3; channel++) {
+						const uint32_t sum = bottom_right.channels[channel] -
+											 bottom_left.channels[channel] -
+											 top_right.channels[channel] +
+											 top_left.channels[channel];
+						output_row[x * 4 + channel] =
+							(uint8_t)((float)sum * inverse_count + 0.5f);
+					}
+					output_row[x * 4 + 3] = 255;
+				}
+			}
+		}
+	);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include "utils/ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// value range of a raw model output, maps it to [0, 1] like min_max_scaling
+/// (values outside of the range are clipped)
+struct RawDepthRange {
+	float min = 0.0f;
+	float max = 0.0f;
+
+	[[nodiscard]] float normalize(float value) const {
+		const float diff = max - min;
+		return diff > 0.0f ? std::clamp((value - min) / diff, 0.0f, 1.0f)
+						   : 0.5f;
+	}
+};
+
+/// the range reduction of min_max_scaling, without rescaling the values
+RawDepthRange raw_depth_range(std::span<const float> values);
+
+/// rescales values from [min, max] to [0, 1]
+void min_max_scaling(std::span<float> values);
+
+/// computes the int representation of the inferno colormap of the depth at each
+/// pixel (1024 entry lookup table, see colormap_depth_argb for the others)
+void depth_colormap(
+	std::span<const float> depth_values,
+	std::span<int> colormapped_pixels
+);
+
+/// argb color of the inferno colormap for a relative depth between 0.0f and
+/// 1.0f (values outside are clamped)
+int inferno_depth_colormap(float relative_depth);
+
+struct BokehOptions {
+	/// relative depth (0.0f to 1.0f) that stays sharp
+	float focus_depth = 1.0f;
+	/// depth distance around the focus depth that stays sharp
+	float focus_range = 0.1f;
+	/// blur radius in pixels at the largest depth distance from the focus
+	size_t max_radius = 24;
+	/// output rows per task
+	size_t tile_rows = 32;
+};
+
+/// synthetic depth of field: every pixel becomes the mean of a box around it
+/// whose radius grows with the depth distance from the focus. the boxes are
+/// read from a summed area table of the image, so the cost doesn't depend on
+/// the radius. the table is reused between frames
+class DepthBokehRenderer {
+  public:
+	/// depth covers the whole image (stretched, as the model input), output
+	/// has the size of the image and is written opaque
+	void render(
+		const RgbaImageView& image,
+		std::span<const float> depth,
+		size_t depth_width,
+		size_t depth_height,
+		const MutableRgbaImageView& output,
+		ThreadPool& thread_pool,
+		const BokehOptions& options = {}
+	);
+
+  private:
+	/// sums of r, g and b (the fourth lane pads to 16 bytes, so the four
+	/// lanes are added and subtracted as one vector)
+	struct alignas(16) PixelSum {
+		std::array<uint32_t, 4> channels;
+	};
+
+	/// (width + 1) * (height + 1) entries, the first row and column are 0.
+	/// uint32 sums wrap for large images, but the box sums are differences
+	/// of them and stay exact
+	std::vector<PixelSum> summed_area_table;
+	/// blur radius of every output pixel of a row, per worker
+	std::vector<std::vector<uint16_t>> worker_radii;
+	std::vector<uint32_t> column_indices;
+	std::vector<float> column_weights;
+};
\ No newline at end of file
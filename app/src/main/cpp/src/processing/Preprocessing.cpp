@@ -0,0 +1,100 @@
+#include "Preprocessing.hpp"
+
+#include "simd/SimdKernels.hpp"
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+void normalize_rgb(
+	std::span<float> values,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	ImageLayout layout
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (values.size() % RGB_CHANNELS != 0)
+		throw std::invalid_argument("values");
+
+	// (value - mean) / stddev as value * scale + offset
+	std::array<float, RGB_CHANNELS> scale{};
+	std::array<float, RGB_CHANNELS> offset{};
+	for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+		scale[channel] = 1.0f / stddev[channel];
+		offset[channel] = -mean[channel] / stddev[channel];
+	}
+
+	const auto& kernels = simd_kernels();
+	if (layout == ImageLayout::Hwc) {
+		kernels.scale_offset_rgb(values, scale, offset);
+		return;
+	}
+	const size_t plane_size = values.size() / RGB_CHANNELS;
+	for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+		kernels.scale_offset(
+			values.subspan(channel * plane_size, plane_size), scale[channel],
+			offset[channel]
+		);
+	}
+}
+
+void resample_bilinear(
+	std::span<const float> source,
+	size_t source_width,
+	size_t source_height,
+	std::span<float> destination,
+	size_t destination_width,
+	size_t destination_height,
+	size_t channels,
+	ImageLayout layout
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (source.size() != source_width * source_height * channels)
+		throw std::invalid_argument("source");
+	if (destination.size() != destination_width * destination_height * channels)
+		throw std::invalid_argument("destination");
+
+	const size_t source_plane = source_width * source_height;
+	const size_t destination_plane = destination_width * destination_height;
+	const auto source_index = [&](size_t x, size_t y, size_t channel) {
+		return layout == ImageLayout::Hwc
+				   ? (y * source_width + x) * channels + channel
+				   : channel * source_plane + y * source_width + x;
+	};
+	const auto destination_index = [&](size_t x, size_t y, size_t channel) {
+		return layout == ImageLayout::Hwc
+				   ? (y * destination_width + x) * channels + channel
+				   : channel * destination_plane + y * destination_width + x;
+	};
+
+	const float scale_x = (float)source_width / (float)destination_width;
+	const float scale_y = (float)source_height / (float)destination_height;
+
+	for (size_t y = 0; y < destination_height; y++) {
+		const float source_y =
+			std::max(((float)y + 0.5f) * scale_y - 0.5f, 0.0f);
+		const auto y0 = std::min((size_t)source_y, source_height - 1);
+		const auto y1 = std::min(y0 + 1, source_height - 1);
+		const float weight_y = source_y - (float)y0;
+
+		for (size_t x = 0; x < destination_width; x++) {
+			const float source_x =
+				std::max(((float)x + 0.5f) * scale_x - 0.5f, 0.0f);
+			const auto x0 = std::min((size_t)source_x, source_width - 1);
+			const auto x1 = std::min(x0 + 1, source_width - 1);
+			const float weight_x = source_x - (float)x0;
+
+			for (size_t channel = 0; channel < channels; channel++) {
+				const float top =
+					source[source_index(x0, y0, channel)] * (1.0f - weight_x) +
+					source[source_index(x1, y0, channel)] * weight_x;
+				const float bottom =
+					source[source_index(x0, y1, channel)] * (1.0f - weight_x) +
+					source[source_index(x1, y1, channel)] * weight_x;
+				destination[destination_index(x, y, channel)] =
+					top * (1.0f - weight_y) + bottom * weight_y;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "utils/ImageUtils.hpp"
+#include <array>
+#include <span>
+
+/// normalizes rgb input values (3 floats for r, g and b) based on their mean
+/// and standard deviation values, Chw values are a single image
+void normalize_rgb(
+	std::span<float> values,
+	std::array<float, RGB_CHANNELS> mean,
+	std::array<float, RGB_CHANNELS> stddev,
+	ImageLayout layout = ImageLayout::Hwc
+);
+
+/// bilinear resampling (pixel centers aligned) of an image with the given
+/// number of interleaved (Hwc) or planar (Chw) channels
+void resample_bilinear(
+	std::span<const float> source,
+	size_t source_width,
+	size_t source_height,
+	std::span<float> destination,
+	size_t destination_width,
+	size_t destination_height,
+	size_t channels = 1,
+	ImageLayout layout = ImageLayout::Chw
+);
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "RobustNormalization.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+uint64_t DepthHistogram::count() const {
+	uint64_t total = (uint64_t)underflow + overflow;
+	for (const auto bin : bins)
+		total += bin;
+	return total;
+}
+
+float DepthHistogram::percentile(float fraction) const {
+	const uint64_t total = count();
+	if (total == 0)
+		return min;
+
+	const double target = std::clamp(fraction, 0.0f, 1.0f) * (double)total;
+
+	// walks the segments (underflow, bins, overflow) up to the one that
+	// contains the target and interpolates linearly within it
+	double cumulative = 0.0;
+	const auto contains_target = [&](uint32_t count) {
+		if (count == 0 || cumulative + count < target) {
+			cumulative += count;
+			return false;
+		}
+		return true;
+	};
+	const auto interpolate = [&](uint32_t count, float begin, float end) {
+		const auto weight = (float)((target - cumulative) / count);
+		return begin + (end - begin) * weight;
+	};
+
+	if (contains_target(underflow))
+		return interpolate(underflow, min, bin_min);
+	const float bin_width = (bin_max - bin_min) / BIN_COUNT;
+	for (size_t bin = 0; bin < BIN_COUNT; bin++) {
+		const float begin = bin_min + (float)bin * bin_width;
+		if (contains_target(bins[bin]))
+			return std::clamp(
+				interpolate(bins[bin], begin, begin + bin_width), min, max
+			);
+	}
+	if (contains_target(overflow))
+		return interpolate(overflow, bin_max, max);
+	return max;
+}
+
+RobustDepthNormalizer::RobustDepthNormalizer(
+	const RobustNormalizationOptions& options
+)
+	: options(options) {}
+
+void RobustDepthNormalizer::set_options(
+	const RobustNormalizationOptions& new_options
+) {
+	options = new_options;
+}
+
+void RobustDepthNormalizer::reset() {
+	histogram = {};
+	bounds = {};
+	bin_range = {};
+	has_bounds = false;
+}
+
+void RobustDepthNormalizer::build_histogram(
+	std::span<const float> depth,
+	RawDepthRange bin_range,
+	ThreadPool& thread_pool
+) {
+	const float bin_min = bin_range.min;
+	const float bin_max = bin_range.max;
+	const float bin_scale = bin_max > bin_min ? (float)DepthHistogram::BIN_COUNT /
+													(bin_max - bin_min)
+											  : 0.0f;
+
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+	worker_histograms.resize(thread_pool.worker_count());
+	for (auto& worker_histogram : worker_histograms) {
+		worker_histogram = {};
+		worker_histogram.min = infinity;
+		worker_histogram.max = -infinity;
+	}
+
+	const size_t tile_count =
+		(depth.size() + options.tile_size - 1) / options.tile_size;
+	thread_pool.parallel_for(tile_count, [&](size_t tile, size_t worker) {
+		auto& partial = worker_histograms[worker];
+		const size_t begin = tile * options.tile_size;
+		const size_t end = std::min(begin + options.tile_size, depth.size());
+		float min = partial.min;
+		float max = partial.max;
+		for (size_t i = begin; i < end; i++) {
+			const float value = depth[i];
+			// nan fails both bounds checks, and casting it (or an infinity)
+			// to a bin is undefined. they are left out of the histogram
+			if (!std::isfinite(value))
+				continue;
+			min = std::min(min, value);
+			max = std::max(max, value);
+			if (value < bin_min) {
+				partial.underflow++;
+			} else if (value > bin_max) {
+				partial.overflow++;
+			} else {
+				const auto bin = std::min(
+					(size_t)((value - bin_min) * bin_scale),
+					DepthHistogram::BIN_COUNT - 1
+				);
+				partial.bins[bin]++;
+			}
+		}
+		partial.min = min;
+		partial.max = max;
+	});
+
+	histogram = {};
+	histogram.bin_min = bin_min;
+	histogram.bin_max = bin_max;
+	histogram.min = infinity;
+	histogram.max = -infinity;
+	for (const auto& partial : worker_histograms) {
+		histogram.min = std::min(histogram.min, partial.min);
+		histogram.max = std::max(histogram.max, partial.max);
+		histogram.underflow += partial.underflow;
+		histogram.overflow += partial.overflow;
+		for (size_t bin = 0; bin < DepthHistogram::BIN_COUNT; bin++)
+			histogram.bins[bin] += partial.bins[bin];
+	}
+	// no finite value in the frame
+	if (histogram.min > histogram.max) {
+		histogram.min = 0.0f;
+		histogram.max = 0.0f;
+	}
+}
+
+RawDepthRange RobustDepthNormalizer::next_bin_range() const {
+	const float low = histogram.percentile(options.low_percentile);
+	const float high = histogram.percentile(options.high_percentile);
+	const float margin = (high - low) * BIN_RANGE_MARGIN;
+	return {
+		.min = std::max(low - margin, histogram.min),
+		.max = std::min(high + margin, histogram.max),
+	};
+}
+
+const RawDepthRange& RobustDepthNormalizer::update(
+	std::span<const float> depth,
+	ThreadPool& thread_pool
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.empty())
+		throw std::invalid_argument("depth");
+	if (options.tile_size == 0)
+		throw std::invalid_argument("tile_size");
+
+	if (!has_bounds) {
+		// the range of the frame is too coarse for the bins if it has
+		// outliers, the bins are refined around its percentiles
+		build_histogram(depth, raw_depth_range(depth), thread_pool);
+		bin_range = next_bin_range();
+	}
+	build_histogram(depth, bin_range, thread_pool);
+	bin_range = next_bin_range();
+
+	const float low = histogram.percentile(options.low_percentile);
+	const float high =
+		std::max(histogram.percentile(options.high_percentile), low);
+	if (has_bounds) {
+		const float weight = std::clamp(options.bounds_smoothing, 0.0f, 1.0f);
+		bounds.min += (low - bounds.min) * weight;
+		bounds.max += (high - bounds.max) * weight;
+	} else {
+		bounds = {.min = low, .max = high};
+		has_bounds = true;
+	}
+	return bounds;
+}
+
+void RobustDepthNormalizer::normalize(
+	std::span<const float> depth,
+	std::span<float> output,
+	ThreadPool& thread_pool
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (output.size() != depth.size())
+		throw std::invalid_argument("output");
+	if (options.tile_size == 0)
+		throw std::invalid_argument("tile_size");
+
+	const size_t tile_count =
+		(depth.size() + options.tile_size - 1) / options.tile_size;
+	thread_pool.parallel_for(tile_count, [&](size_t tile, size_t /*worker*/) {
+		const size_t begin = tile * options.tile_size;
+		const size_t end = std::min(begin + options.tile_size, depth.size());
+		for (size_t i = begin; i < end; i++)
+			output[i] = bounds.normalize(depth[i]);
+	});
+}
+
+void RobustDepthNormalizer::colormap(
+	std::span<const float> depth,
+	std::span<int> colormapped_pixels,
+	ThreadPool& thread_pool,
+	ColormapOptions colormap_options
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (colormapped_pixels.size() != depth.size())
+		throw std::invalid_argument("colormapped_pixels");
+	if (options.tile_size == 0)
+		throw std::invalid_argument("tile_size");
+
+	colormap_options.min_depth = bounds.min;
+	colormap_options.max_depth = bounds.max;
+	const size_t tile_count =
+		(depth.size() + options.tile_size - 1) / options.tile_size;
+	thread_pool.parallel_for(tile_count, [&](size_t tile, size_t /*worker*/) {
+		const size_t begin = tile * options.tile_size;
+		const size_t count = std::min(options.tile_size, depth.size() - begin);
+		colormap_depth_argb(
+			depth.subspan(begin, count),
+			colormapped_pixels.subspan(begin, count), colormap_options
+		);
+	});
+}
\ No newline at end of file
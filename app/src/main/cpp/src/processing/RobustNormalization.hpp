@@ -0,0 +1,111 @@
+#pragma once
+
+#include "processing/Colormaps.hpp"
+#include "processing/Postprocessing.hpp"
+#include "utils/ThreadPool.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// fixed bin histogram of a depth frame. the bins cover the percentile bounds
+/// of the previous frame (with a margin), values outside of them are only
+/// counted (underflow and overflow). so the histogram is built in a single
+/// pass without knowing the range of the frame up front, and outliers don't
+/// widen the bins
+struct DepthHistogram {
+	static constexpr size_t BIN_COUNT = 256;
+
+	float bin_min = 0.0f;
+	float bin_max = 0.0f;
+	/// exact range of the frame
+	float min = 0.0f;
+	float max = 0.0f;
+	std::array<uint32_t, BIN_COUNT> bins{};
+	/// values below bin_min (between min and bin_min)
+	uint32_t underflow = 0;
+	/// values above bin_max (between bin_max and max)
+	uint32_t overflow = 0;
+
+	[[nodiscard]] uint64_t count() const;
+
+	/// value below which the given fraction (0.0f to 1.0f) of the frame lies,
+	/// interpolated within the bins. underflow and overflow are treated as
+	/// bins from min to bin_min and from bin_max to max
+	[[nodiscard]] float percentile(float fraction) const;
+};
+
+struct RobustNormalizationOptions {
+	/// the percentiles that map to 0.0f and 1.0f, values outside are clipped
+	float low_percentile = 0.01f;
+	float high_percentile = 0.99f;
+	/// weight of the bounds of a new frame against the smoothed bounds of
+	/// the previous frames, 1.0f disables the temporal smoothing
+	float bounds_smoothing = 1.0f;
+	/// values per task
+	size_t tile_size = 16384;
+};
+
+/// alternative to min_max_scaling that a few outlier pixels can't compress:
+/// the bounds are percentiles of a histogram that is built in one parallel
+/// pass, the normalization (and colormap lookup) is a second fused pass
+class RobustDepthNormalizer {
+  public:
+	explicit RobustDepthNormalizer(const RobustNormalizationOptions& options = {}
+	);
+
+	/// builds the histogram of the frame and updates the bounds. the first
+	/// frame (and the first after reset) needs two extra passes: its range,
+	/// and a histogram over it for the bin range
+	const RawDepthRange&
+	update(std::span<const float> depth, ThreadPool& thread_pool);
+
+	/// maps the bounds to 0.0f and 1.0f, clipped. output can be depth
+	void normalize(
+		std::span<const float> depth,
+		std::span<float> output,
+		ThreadPool& thread_pool
+	) const;
+
+	/// argb colors of the depth between the bounds, normalized in the lookup
+	/// of the colors (the depth range of the options is replaced)
+	void colormap(
+		std::span<const float> depth,
+		std::span<int> colormapped_pixels,
+		ThreadPool& thread_pool,
+		ColormapOptions colormap_options = {}
+	) const;
+
+	/// forgets the bounds and the bin range, e.g. when the model changes
+	void reset();
+
+	void set_options(const RobustNormalizationOptions& new_options);
+	[[nodiscard]] const RobustNormalizationOptions& get_options() const {
+		return options;
+	}
+	[[nodiscard]] const DepthHistogram& get_histogram() const {
+		return histogram;
+	}
+	[[nodiscard]] const RawDepthRange& get_bounds() const { return bounds; }
+
+  private:
+	/// margin around the percentile bounds that the bins of the next frame
+	/// cover, relative to the distance between the bounds
+	static constexpr float BIN_RANGE_MARGIN = 0.25f;
+
+	void build_histogram(
+		std::span<const float> depth,
+		RawDepthRange bin_range,
+		ThreadPool& thread_pool
+	);
+	/// the percentile bounds of the histogram with the margin
+	[[nodiscard]] RawDepthRange next_bin_range() const;
+
+	RobustNormalizationOptions options;
+	DepthHistogram histogram;
+	RawDepthRange bounds;
+	RawDepthRange bin_range;
+	bool has_bounds = false;
+	/// partial histograms, per worker
+	std::vector<DepthHistogram> worker_histograms;
+};
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "Tiling.hpp"
+
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/// evenly spaced tile starts along one axis
+static std::vector<size_t>
+compute_tile_starts(size_t length, size_t tile_length, size_t overlap) {
+	if (length < tile_length)
+		throw std::invalid_argument(
+			"images have to be at least as large as the tiles"
+		);
+	if (overlap >= tile_length)
+		throw std::invalid_argument("overlap has to be smaller than the tiles");
+
+	if (length == tile_length)
+		return {0};
+
+	const size_t stride = tile_length - overlap;
+	const size_t count = (length - overlap + stride - 1) / stride;
+	std::vector<size_t> starts(count);
+	for (size_t i = 0; i < count; i++)
+		starts[i] = (size_t)std::lround(
+			(double)i * (double)(length - tile_length) / (double)(count - 1)
+		);
+	return starts;
+}
+
+std::vector<TileRegion> compute_tile_grid(
+	size_t width,
+	size_t height,
+	const TilingOptions& options
+) {
+	const auto starts_x =
+		compute_tile_starts(width, options.tile_width, options.overlap);
+	const auto starts_y =
+		compute_tile_starts(height, options.tile_height, options.overlap);
+
+	std::vector<TileRegion> tiles;
+	tiles.reserve(starts_x.size() * starts_y.size());
+	for (const size_t y : starts_y) {
+		for (const size_t x : starts_x) {
+			tiles.push_back({
+				.x = x,
+				.y = y,
+				.width = options.tile_width,
+				.height = options.tile_height,
+			});
+		}
+	}
+	return tiles;
+}
+
+void extract_tile(
+	std::span<const float> rgb,
+	size_t width,
+	size_t height,
+	ImageLayout layout,
+	const TileRegion& tile,
+	std::span<float> tile_rgb
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (rgb.size() != width * height * RGB_CHANNELS)
+		throw std::invalid_argument("rgb");
+	if (tile_rgb.size() != tile.width * tile.height * RGB_CHANNELS)
+		throw std::invalid_argument("tile_rgb");
+
+	if (layout == ImageLayout::Hwc) {
+		for (size_t y = 0; y < tile.height; y++) {
+			const auto row = rgb.subspan(
+				((tile.y + y) * width + tile.x) * RGB_CHANNELS,
+				tile.width * RGB_CHANNELS
+			);
+			std::ranges::copy(
+				row, tile_rgb.begin() + (ptrdiff_t)(y * tile.width * RGB_CHANNELS)
+			);
+		}
+		return;
+	}
+
+	for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+		for (size_t y = 0; y < tile.height; y++) {
+			const auto row = rgb.subspan(
+				channel * width * height + (tile.y + y) * width + tile.x,
+				tile.width
+			);
+			std::ranges::copy(
+				row,
+				tile_rgb.begin() +
+					(ptrdiff_t)(channel * tile.width * tile.height +
+								y * tile.width)
+			);
+		}
+	}
+}
+
+DepthAlignment fit_depth_alignment(
+	std::span<const float> tile_depth,
+	const TileRegion& tile,
+	std::span<const float> reference_depth,
+	size_t width,
+	size_t stride
+) {
+	stride = std::max<size_t>(stride, 1);
+
+	double sum_t = 0.0;
+	double sum_r = 0.0;
+	double sum_tt = 0.0;
+	double sum_tr = 0.0;
+	size_t count = 0;
+	for (size_t y = 0; y < tile.height; y += stride) {
+		for (size_t x = 0; x < tile.width; x += stride) {
+			const double value = tile_depth[y * tile.width + x];
+			const double reference =
+				reference_depth[(tile.y + y) * width + tile.x + x];
+			sum_t += value;
+			sum_r += reference;
+			sum_tt += value * value;
+			sum_tr += value * reference;
+			count++;
+		}
+	}
+
+	const auto n = (double)count;
+	const double determinant = n * sum_tt - sum_t * sum_t;
+	// flat tiles (for example a wall) only get shifted
+	const double scale =
+		determinant > 1e-9 ? (n * sum_tr - sum_t * sum_r) / determinant : 0.0;
+	const double shift = (sum_r - scale * sum_t) / n;
+	return {.scale = (float)scale, .shift = (float)shift};
+}
+
+/// weight of a pixel along one axis, ramps up from the tile border over the
+/// overlap unless the border is also the image border
+static float feather_weight(
+	size_t position,
+	size_t tile_start,
+	size_t tile_length,
+	size_t image_length,
+	size_t overlap
+) {
+	if (overlap == 0)
+		return 1.0f;
+
+	float weight = 1.0f;
+	const auto ramp = [&](size_t distance) {
+		return std::min(((float)distance + 0.5f) / (float)overlap, 1.0f);
+	};
+	if (tile_start > 0)
+		weight = std::min(weight, ramp(position));
+	if (tile_start + tile_length < image_length)
+		weight = std::min(weight, ramp(tile_length - 1 - position));
+	return weight;
+}
+
+void accumulate_feathered_tile(
+	std::span<const float> tile_depth,
+	const TileRegion& tile,
+	DepthAlignment alignment,
+	size_t overlap,
+	size_t width,
+	size_t height,
+	std::span<float> depth_sum,
+	std::span<float> weight_sum
+) {
+	std::vector<float> weights_x(tile.width);
+	for (size_t x = 0; x < tile.width; x++)
+		weights_x[x] = feather_weight(x, tile.x, tile.width, width, overlap);
+
+	for (size_t y = 0; y < tile.height; y++) {
+		const float weight_y =
+			feather_weight(y, tile.y, tile.height, height, overlap);
+		const size_t row = (tile.y + y) * width + tile.x;
+		for (size_t x = 0; x < tile.width; x++) {
+			const float weight = weights_x[x] * weight_y;
+			const float aligned =
+				alignment.scale * tile_depth[y * tile.width + x] +
+				alignment.shift;
+			depth_sum[row + x] += weight * aligned;
+			weight_sum[row + x] += weight;
+		}
+	}
+}
+
+void resolve_feathered_tiles(
+	std::span<const float> depth_sum,
+	std::span<const float> weight_sum,
+	std::span<float> depth
+) {
+	for (size_t i = 0; i < depth.size(); i++)
+		depth[i] = weight_sum[i] > 0.0f ? depth_sum[i] / weight_sum[i] : 0.0f;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "processing/Preprocessing.hpp"
+#include <span>
+#include <vector>
+
+struct TilingOptions {
+	/// model input size, every tile has exactly this size
+	size_t tile_width = 256;
+	size_t tile_height = 256;
+	/// minimum overlap of neighboring tiles in pixels, the blending ramp spans
+	/// the overlap
+	size_t overlap = 32;
+	/// tiles per invoke, onnx models need a dynamic batch dimension for more
+	/// than 1
+	size_t tile_batch_size = 1;
+	/// only every n-th pixel (in both directions) is used to fit the
+	/// scale/shift alignment of a tile
+	size_t alignment_stride = 4;
+};
+
+struct TileRegion {
+	size_t x = 0;
+	size_t y = 0;
+	size_t width = 0;
+	size_t height = 0;
+};
+
+/// scale and shift that map the relative depth of a tile onto the depth of
+/// the whole image
+struct DepthAlignment {
+	float scale = 1.0f;
+	float shift = 0.0f;
+};
+
+/// tiles of the tile size that cover the whole image, neighbors overlap by at
+/// least options.overlap and the last tile of each row / column ends at the
+/// image border
+std::vector<TileRegion> compute_tile_grid(
+	size_t width,
+	size_t height,
+	const TilingOptions& options
+);
+
+/// copies the tile out of an rgb image, keeping its layout
+void extract_tile(
+	std::span<const float> rgb,
+	size_t width,
+	size_t height,
+	ImageLayout layout,
+	const TileRegion& tile,
+	std::span<float> tile_rgb
+);
+
+/// least squares fit of scale * tile_depth + shift = reference_depth, where
+/// reference_depth covers the whole image
+DepthAlignment fit_depth_alignment(
+	std::span<const float> tile_depth,
+	const TileRegion& tile,
+	std::span<const float> reference_depth,
+	size_t width,
+	size_t stride
+);
+
+/// adds the aligned tile depth to the accumulation buffers, weighted by a
+/// linear ramp over the overlap at tile borders inside the image
+void accumulate_feathered_tile(
+	std::span<const float> tile_depth,
+	const TileRegion& tile,
+	DepthAlignment alignment,
+	size_t overlap,
+	size_t width,
+	size_t height,
+	std::span<float> depth_sum,
+	std::span<float> weight_sum
+);
+
+/// divides the accumulated depth by the accumulated weights
+void resolve_feathered_tiles(
+	std::span<const float> depth_sum,
+	std::span<const float> weight_sum,
+	std::span<float> depth
+);
\ No newline at end of file
@@ -0,0 +1,521 @@
+#include "TsdfVolume.hpp"
+
+#include "utils/Log.hpp"
+#include "utils/Profiling.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+CameraPose camera_pose_from_matrix(std::span<const float, 16> matrix) {
+	// column major: element (row, column) is at column * 4 + row
+	CameraPose pose;
+	for (size_t row = 0; row < 3; row++) {
+		for (size_t column = 0; column < 3; column++)
+			pose.rotation[row * 3 + column] = matrix[column * 4 + row];
+		pose.translation[row] = matrix[12 + row];
+	}
+	return pose;
+}
+
+/// block and voxel coordinates are packed with 21 bits each
+constexpr int COORDINATE_BITS = 21;
+constexpr uint64_t COORDINATE_MASK = (1ULL << COORDINATE_BITS) - 1;
+constexpr uint64_t FREE_BLOCK_KEY = UINT64_MAX;
+
+static uint64_t pack_coordinates(int64_t x, int64_t y, int64_t z) {
+	return (((uint64_t)x & COORDINATE_MASK) << (2 * COORDINATE_BITS)) |
+		   (((uint64_t)y & COORDINATE_MASK) << COORDINATE_BITS) |
+		   ((uint64_t)z & COORDINATE_MASK);
+}
+
+static std::array<int64_t, 3> unpack_coordinates(uint64_t key) {
+	const auto coordinate = [](uint64_t bits) {
+		// sign extension of the 21 bit value
+		constexpr int SHIFT = 64 - COORDINATE_BITS;
+		return (int64_t)((bits & COORDINATE_MASK) << SHIFT) >> SHIFT;
+	};
+	return {
+		coordinate(key >> (2 * COORDINATE_BITS)),
+		coordinate(key >> COORDINATE_BITS), coordinate(key)
+	};
+}
+
+/// fibonacci hashing, the upper bits are well mixed
+static size_t block_slot(uint64_t key, int slot_shift) {
+	return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> slot_shift);
+}
+
+static int64_t floor_to_int(float value) {
+	auto index = (int64_t)value;
+	index -= (float)index > value ? 1 : 0;
+	return index;
+}
+
+constexpr float TSDF_SCALE = 32767.0f;
+
+TsdfVolume::TsdfVolume(const TsdfVolumeOptions& options)
+	: options(options) {
+	if (options.voxel_size <= 0.0f || options.truncation_distance <= 0.0f)
+		throw std::invalid_argument("voxel_size and truncation_distance");
+	if (options.max_blocks == 0 ||
+		options.max_blocks > (size_t)std::numeric_limits<int32_t>::max())
+		throw std::invalid_argument("max_blocks");
+
+	blocks = std::make_unique_for_overwrite<VoxelBlock[]>(options.max_blocks);
+	slots.resize(std::bit_ceil(options.max_blocks * 2));
+	reset();
+}
+
+void TsdfVolume::reset() {
+	const std::scoped_lock lock(mutex);
+
+	block_keys.assign(options.max_blocks, FREE_BLOCK_KEY);
+	block_frames.assign(options.max_blocks, 0);
+	free_blocks.resize(options.max_blocks);
+	// the lowest indices are handed out first
+	for (size_t i = 0; i < options.max_blocks; i++)
+		free_blocks[i] = (int32_t)(options.max_blocks - 1 - i);
+	std::ranges::fill(slots, BlockSlot{.key = FREE_BLOCK_KEY, .block = -1});
+}
+
+size_t TsdfVolume::block_count() const {
+	const std::scoped_lock lock(mutex);
+	return options.max_blocks - free_blocks.size();
+}
+
+int32_t TsdfVolume::find_block(uint64_t key) const {
+	const size_t slot_mask = slots.size() - 1;
+	const int slot_shift = 64 - std::countr_zero(slots.size());
+	for (size_t slot = block_slot(key, slot_shift);; slot = (slot + 1) & slot_mask) {
+		if (slots[slot].block < 0)
+			return -1;
+		if (slots[slot].key == key)
+			return slots[slot].block;
+	}
+}
+
+int32_t TsdfVolume::allocate_block(uint64_t key) {
+	if (free_blocks.empty())
+		recycle_blocks();
+	if (free_blocks.empty())
+		return -1;
+
+	const int32_t block = free_blocks.back();
+	free_blocks.pop_back();
+	block_keys[block] = key;
+	block_frames[block] = 0;
+	std::ranges::fill(blocks[block].voxels, Voxel{.tsdf = 0, .weight = 0});
+
+	// the table is at most half full, so there is always a free slot
+	const size_t slot_mask = slots.size() - 1;
+	size_t slot = block_slot(key, 64 - std::countr_zero(slots.size()));
+	while (slots[slot].block >= 0)
+		slot = (slot + 1) & slot_mask;
+	slots[slot] = BlockSlot{.key = key, .block = block};
+	return block;
+}
+
+void TsdfVolume::remove_block(int32_t block) {
+	const size_t slot_mask = slots.size() - 1;
+	const int slot_shift = 64 - std::countr_zero(slots.size());
+	const uint64_t key = block_keys[block];
+
+	size_t hole = block_slot(key, slot_shift);
+	while (slots[hole].block != block)
+		hole = (hole + 1) & slot_mask;
+
+	// backward shift deletion: entries after the hole move into it if their
+	// home slot is not between the hole and their position, so linear
+	// probing never needs tombstones
+	for (size_t next = (hole + 1) & slot_mask; slots[next].block >= 0;
+		 next = (next + 1) & slot_mask) {
+		const size_t home = block_slot(slots[next].key, slot_shift);
+		if (((next - home) & slot_mask) >= ((next - hole) & slot_mask)) {
+			slots[hole] = slots[next];
+			hole = next;
+		}
+	}
+	slots[hole] = BlockSlot{.key = FREE_BLOCK_KEY, .block = -1};
+
+	block_keys[block] = FREE_BLOCK_KEY;
+	free_blocks.push_back(block);
+}
+
+void TsdfVolume::recycle_blocks() {
+	PROFILE_DEPTH_FUNCTION()
+
+	// blocks of the current frame stay, they are integrated next
+	std::vector<std::pair<uint64_t, int32_t>> candidates;
+	for (size_t block = 0; block < options.max_blocks; block++) {
+		if (block_keys[block] != FREE_BLOCK_KEY &&
+			block_frames[block] != frame_index)
+			candidates.emplace_back(block_frames[block], (int32_t)block);
+	}
+	if (candidates.empty()) {
+		LOG_ERROR("TsdfVolume: all {} blocks are in view", options.max_blocks);
+		return;
+	}
+
+	// an eighth at once, so the scan above is not repeated for every block
+	const size_t recycled_count =
+		std::min(candidates.size(), std::max<size_t>(options.max_blocks / 8, 1));
+	std::ranges::nth_element(
+		candidates, candidates.begin() + (ptrdiff_t)(recycled_count - 1)
+	);
+	for (size_t i = 0; i < recycled_count; i++)
+		remove_block(candidates[i].second);
+}
+
+void TsdfVolume::allocate_frame_blocks(const TsdfFrame& frame) {
+	PROFILE_DEPTH_FUNCTION()
+
+	metric_depth.resize(frame.depth.size());
+	for (size_t i = 0; i < frame.depth.size(); i++) {
+		const float value = frame.scale * frame.depth[i] + frame.shift;
+		const float depth =
+			frame.encoding == DepthEncoding::InverseDepth ? 1.0f / value : value;
+		// 0 marks invalid depth, nan fails the check
+		metric_depth[i] =
+			depth > frame.min_depth && depth <= frame.max_depth ? depth : 0.0f;
+	}
+
+	frame_index++;
+	frame_blocks.clear();
+
+	const auto& intrinsics = frame.intrinsics;
+	const auto& rotation = frame.pose.rotation;
+	const auto& translation = frame.pose.translation;
+	const float block_extent = options.voxel_size * (float)BLOCK_SIZE;
+	const float inverse_block_extent = 1.0f / block_extent;
+	// samples along the ray through the truncation band, close enough that no
+	// block is skipped
+	const float band_step =
+		std::min(options.truncation_distance, block_extent / 2.0f);
+	const auto band_samples =
+		(size_t)std::ceil(2.0f * options.truncation_distance / band_step) + 1;
+	const size_t stride = std::max<size_t>(options.allocation_stride, 1);
+
+	uint64_t previous_key = FREE_BLOCK_KEY;
+	bool pool_exhausted = false;
+	for (size_t y = 0; y < frame.height; y += stride) {
+		const float ray_y = ((float)y - intrinsics.cy) / intrinsics.fy;
+		for (size_t x = 0; x < frame.width; x += stride) {
+			const float depth = metric_depth[y * frame.width + x];
+			if (depth <= 0.0f)
+				continue;
+			const float ray_x = ((float)x - intrinsics.cx) / intrinsics.fx;
+
+			for (size_t sample = 0; sample < band_samples; sample++) {
+				const float z = std::max(
+					depth - options.truncation_distance +
+						(float)sample * band_step,
+					0.0f
+				);
+				const std::array<float, 3> camera = {ray_x * z, ray_y * z, z};
+				std::array<int64_t, 3> block_coordinates{};
+				for (size_t axis = 0; axis < 3; axis++) {
+					const float world = rotation[axis * 3] * camera[0] +
+										rotation[axis * 3 + 1] * camera[1] +
+										rotation[axis * 3 + 2] * camera[2] +
+										translation[axis];
+					block_coordinates[axis] =
+						floor_to_int(world * inverse_block_extent);
+				}
+
+				const uint64_t key = pack_coordinates(
+					block_coordinates[0], block_coordinates[1],
+					block_coordinates[2]
+				);
+				// consecutive samples and pixels mostly hit the same block
+				if (key == previous_key)
+					continue;
+				previous_key = key;
+
+				int32_t block = find_block(key);
+				if (block < 0 && !pool_exhausted) {
+					block = allocate_block(key);
+					pool_exhausted = block < 0;
+				}
+				if (block < 0 || block_frames[block] == frame_index)
+					continue;
+				block_frames[block] = frame_index;
+				frame_blocks.push_back(block);
+			}
+		}
+	}
+}
+
+void TsdfVolume::integrate_block(int32_t block, const TsdfFrame& frame) {
+	const auto& intrinsics = frame.intrinsics;
+	const auto& rotation = frame.pose.rotation;
+	const auto& translation = frame.pose.translation;
+	const float voxel_size = options.voxel_size;
+	const float truncation = options.truncation_distance;
+	const float inverse_truncation = 1.0f / truncation;
+	const auto width = (float)frame.width;
+	const auto height = (float)frame.height;
+
+	const auto block_coordinates = unpack_coordinates(block_keys[block]);
+	// camera = rotation^T * (world - translation), stepping one voxel along a
+	// world axis adds a row of the rotation
+	std::array<float, 3> origin{};
+	for (size_t axis = 0; axis < 3; axis++) {
+		origin[axis] =
+			((float)(block_coordinates[axis] * BLOCK_SIZE) + 0.5f) * voxel_size -
+			translation[axis];
+	}
+	std::array<float, 3> camera_origin{};
+	for (size_t axis = 0; axis < 3; axis++) {
+		camera_origin[axis] = rotation[axis] * origin[0] +
+							  rotation[3 + axis] * origin[1] +
+							  rotation[6 + axis] * origin[2];
+	}
+
+	auto& voxels = blocks[block].voxels;
+	size_t voxel_index = 0;
+	for (int z = 0; z < BLOCK_SIZE; z++) {
+		for (int y = 0; y < BLOCK_SIZE; y++) {
+			for (int x = 0; x < BLOCK_SIZE; x++, voxel_index++) {
+				std::array<float, 3> camera{};
+				for (size_t axis = 0; axis < 3; axis++) {
+					camera[axis] =
+						camera_origin[axis] +
+						voxel_size * ((float)x * rotation[axis] +
+									  (float)y * rotation[3 + axis] +
+									  (float)z * rotation[6 + axis]);
+				}
+				if (camera[2] <= 0.0f)
+					continue;
+
+				const float u =
+					intrinsics.fx * camera[0] / camera[2] + intrinsics.cx + 0.5f;
+				const float v =
+					intrinsics.fy * camera[1] / camera[2] + intrinsics.cy + 0.5f;
+				if (!(u >= 0.0f && u < width && v >= 0.0f && v < height))
+					continue;
+
+				const float depth =
+					metric_depth[(size_t)v * frame.width + (size_t)u];
+				if (depth <= 0.0f)
+					continue;
+				// projective distance along the optical axis
+				const float distance = depth - camera[2];
+				if (distance < -truncation)
+					continue;
+
+				auto& voxel = voxels[voxel_index];
+				const float tsdf = std::min(distance * inverse_truncation, 1.0f);
+				const auto weight = (float)voxel.weight;
+				const float fused =
+					((float)voxel.tsdf / TSDF_SCALE * weight + tsdf) /
+					(weight + 1.0f);
+				voxel.tsdf = (int16_t)std::lround(fused * TSDF_SCALE);
+				voxel.weight = (uint16_t)std::min<uint32_t>(
+					voxel.weight + 1U, options.max_weight
+				);
+			}
+		}
+	}
+}
+
+void TsdfVolume::integrate(const TsdfFrame& frame, ThreadPool& thread_pool) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (frame.depth.size() != frame.width * frame.height)
+		throw std::invalid_argument("depth");
+
+	const std::scoped_lock lock(mutex);
+	allocate_frame_blocks(frame);
+
+	// blocks don't share voxels, so they are updated without locking
+	thread_pool.parallel_for(
+		frame_blocks.size(),
+		[&](size_t index, size_t /*worker*/) {
+			integrate_block(frame_blocks[index], frame);
+		}
+	);
+}
+
+const TsdfVolume::Voxel*
+TsdfVolume::find_voxel(int64_t x, int64_t y, int64_t z) const {
+	const auto block_coordinate = [](int64_t coordinate) {
+		// floor division
+		return coordinate >= 0 ? coordinate / BLOCK_SIZE
+							   : (coordinate - BLOCK_SIZE + 1) / BLOCK_SIZE;
+	};
+	const int64_t block_x = block_coordinate(x);
+	const int64_t block_y = block_coordinate(y);
+	const int64_t block_z = block_coordinate(z);
+	const int32_t block =
+		find_block(pack_coordinates(block_x, block_y, block_z));
+	if (block < 0)
+		return nullptr;
+
+	const int64_t local_x = x - block_x * BLOCK_SIZE;
+	const int64_t local_y = y - block_y * BLOCK_SIZE;
+	const int64_t local_z = z - block_z * BLOCK_SIZE;
+	const auto& voxel = blocks[block].voxels[(size_t)(
+		(local_z * BLOCK_SIZE + local_y) * BLOCK_SIZE + local_x
+	)];
+	return voxel.weight > 0 ? &voxel : nullptr;
+}
+
+/// corner offsets of a voxel cell, bit 0 is x, bit 1 is y and bit 2 is z
+constexpr size_t CELL_CORNER_COUNT = 8;
+
+/// corner pairs of the 12 edges of a cell
+constexpr std::array<std::array<uint8_t, 2>, 12> CELL_EDGES = {{
+	{0, 1},
+	{2, 3},
+	{4, 5},
+	{6, 7},
+	{0, 2},
+	{1, 3},
+	{4, 6},
+	{5, 7},
+	{0, 4},
+	{1, 5},
+	{2, 6},
+	{3, 7},
+}};
+
+void TsdfVolume::extract_mesh(TsdfMesh& mesh) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	const std::scoped_lock lock(mutex);
+	mesh.vertices.clear();
+	mesh.triangles.clear();
+
+	std::vector<uint64_t> used_keys;
+	for (size_t block = 0; block < options.max_blocks; block++) {
+		if (block_keys[block] != FREE_BLOCK_KEY)
+			used_keys.push_back(block_keys[block]);
+	}
+
+	const auto for_each_voxel = [&](const auto& function) {
+		for (const uint64_t key : used_keys) {
+			const auto block_coordinates = unpack_coordinates(key);
+			for (int z = 0; z < BLOCK_SIZE; z++) {
+				for (int y = 0; y < BLOCK_SIZE; y++) {
+					for (int x = 0; x < BLOCK_SIZE; x++) {
+						function(
+							block_coordinates[0] * BLOCK_SIZE + x,
+							block_coordinates[1] * BLOCK_SIZE + y,
+							block_coordinates[2] * BLOCK_SIZE + z
+						);
+					}
+				}
+			}
+		}
+	};
+
+	// one vertex per cell (the cube between 8 voxel centers) with a sign
+	// change, placed at the mean of the interpolated edge crossings
+	std::unordered_map<uint64_t, uint32_t> cell_vertices;
+	for_each_voxel([&](int64_t x, int64_t y, int64_t z) {
+		std::array<float, CELL_CORNER_COUNT> corners{};
+		size_t negative_count = 0;
+		for (size_t corner = 0; corner < CELL_CORNER_COUNT; corner++) {
+			const auto* voxel = find_voxel(
+				x + (int64_t)(corner & 1), y + (int64_t)((corner >> 1) & 1),
+				z + (int64_t)((corner >> 2) & 1)
+			);
+			if (voxel == nullptr)
+				return;
+			corners[corner] = (float)voxel->tsdf;
+			negative_count += voxel->tsdf < 0 ? 1 : 0;
+		}
+		if (negative_count == 0 || negative_count == CELL_CORNER_COUNT)
+			return;
+
+		std::array<float, 3> offset{};
+		size_t crossing_count = 0;
+		for (const auto& edge : CELL_EDGES) {
+			const float first = corners[edge[0]];
+			const float second = corners[edge[1]];
+			if ((first < 0) == (second < 0))
+				continue;
+			const float t = first / (first - second);
+			for (size_t axis = 0; axis < 3; axis++) {
+				const auto first_position = (float)((edge[0] >> axis) & 1);
+				const auto second_position = (float)((edge[1] >> axis) & 1);
+				offset[axis] +=
+					first_position + t * (second_position - first_position);
+			}
+			crossing_count++;
+		}
+
+		const std::array<int64_t, 3> cell = {x, y, z};
+		cell_vertices.emplace(
+			pack_coordinates(x, y, z),
+			(uint32_t)(mesh.vertices.size() / 3)
+		);
+		for (size_t axis = 0; axis < 3; axis++) {
+			mesh.vertices.push_back(
+				((float)cell[axis] + 0.5f +
+				 offset[axis] / (float)crossing_count) *
+				options.voxel_size
+			);
+		}
+	});
+
+	// every voxel edge with a sign change is shared by 4 cells, their
+	// vertices form a quad
+	for_each_voxel([&](int64_t x, int64_t y, int64_t z) {
+		const auto* voxel = find_voxel(x, y, z);
+		if (voxel == nullptr)
+			return;
+		const std::array<int64_t, 3> position = {x, y, z};
+
+		for (size_t axis = 0; axis < 3; axis++) {
+			auto neighbour_position = position;
+			neighbour_position[axis]++;
+			const auto* neighbour = find_voxel(
+				neighbour_position[0], neighbour_position[1],
+				neighbour_position[2]
+			);
+			if (neighbour == nullptr ||
+				(voxel->tsdf < 0) == (neighbour->tsdf < 0))
+				continue;
+
+			// the other two axes in cyclic order, so that the quad is counter
+			// clockwise seen from +axis
+			const size_t u_axis = (axis + 1) % 3;
+			const size_t v_axis = (axis + 2) % 3;
+			constexpr std::array<std::array<int64_t, 2>, 4> QUAD_OFFSETS = {{
+				{-1, -1},
+				{0, -1},
+				{0, 0},
+				{-1, 0},
+			}};
+			std::array<uint32_t, 4> quad{};
+			bool complete = true;
+			for (size_t i = 0; i < quad.size(); i++) {
+				auto cell = position;
+				cell[u_axis] += QUAD_OFFSETS[i][0];
+				cell[v_axis] += QUAD_OFFSETS[i][1];
+				const auto vertex = cell_vertices.find(
+					pack_coordinates(cell[0], cell[1], cell[2])
+				);
+				if (vertex == cell_vertices.end()) {
+					complete = false;
+					break;
+				}
+				quad[i] = vertex->second;
+			}
+			if (!complete)
+				continue;
+
+			// the free space (positive tsdf) is in front of the triangles
+			if (voxel->tsdf >= 0)
+				std::ranges::reverse(quad);
+			mesh.triangles.insert(
+				mesh.triangles.end(),
+				{quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]}
+			);
+		}
+	});
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "processing/PointCloud.hpp"
+#include "utils/ThreadPool.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+/// rigid camera pose, world = rotation * camera + translation
+struct CameraPose {
+	/// row major 3x3
+	std::array<float, 9> rotation = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+	std::array<float, 3> translation = {0, 0, 0};
+};
+
+/// pose from a column major 4x4 camera to world matrix (android.opengl.Matrix
+/// layout)
+CameraPose camera_pose_from_matrix(std::span<const float, 16> matrix);
+
+struct TsdfVolumeOptions {
+	/// edge length of a voxel in meters
+	float voxel_size = 0.01f;
+	/// distance behind / in front of the surface that is integrated, usually
+	/// a few voxels
+	float truncation_distance = 0.04f;
+	/// upper bound of the memory, 2 KiB per block of 8x8x8 voxels. once all
+	/// blocks are used, the blocks that were not observed for the longest
+	/// time are recycled
+	size_t max_blocks = 16384;
+	/// the weight of a voxel saturates, so the volume keeps adapting to changes
+	uint16_t max_weight = 64;
+	/// every n-th pixel in both directions allocates blocks
+	size_t allocation_stride = 2;
+};
+
+struct TsdfFrame {
+	std::span<const float> depth;
+	size_t width = 0;
+	size_t height = 0;
+	CameraIntrinsics intrinsics;
+	DepthEncoding encoding = DepthEncoding::InverseDepth;
+	/// to metric depth, as in PointCloudOptions
+	float scale = 1.0f;
+	float shift = 0.0f;
+	float min_depth = 0.0f;
+	float max_depth = 5.0f;
+	CameraPose pose;
+};
+
+/// triangle mesh of the zero crossing of the tsdf
+struct TsdfMesh {
+	/// x, y, z of every vertex in world coordinates
+	std::vector<float> vertices;
+	/// three vertex indices per triangle, counter clockwise seen from the
+	/// free space in front of the surface
+	std::vector<uint32_t> triangles;
+};
+
+/// truncated signed distance fusion of depth frames into a sparse volume.
+/// only blocks of 8x8x8 voxels near observed surfaces exist: they come from
+/// a fixed pool (bounded memory) and are found through an open addressing
+/// hash table of their block coordinates. a frame only integrates the blocks
+/// that its depth allocated, so the cost follows the visible surface and not
+/// the size of the scene
+class TsdfVolume {
+  public:
+	explicit TsdfVolume(const TsdfVolumeOptions& options);
+
+	TsdfVolume(const TsdfVolume&) = delete;
+	TsdfVolume(TsdfVolume&&) = delete;
+	void operator=(const TsdfVolume&) = delete;
+	void operator=(TsdfVolume&&) = delete;
+
+	/// thread safe, the voxel updates of the blocks run on the thread pool
+	void integrate(const TsdfFrame& frame, ThreadPool& thread_pool);
+
+	/// thread safe, surface nets over all blocks (one vertex per voxel cell
+	/// that contains the surface, one quad per crossed voxel edge)
+	void extract_mesh(TsdfMesh& mesh) const;
+
+	/// thread safe, removes all blocks
+	void reset();
+
+	[[nodiscard]] size_t block_count() const;
+	[[nodiscard]] const TsdfVolumeOptions& get_options() const {
+		return options;
+	}
+
+	static constexpr int BLOCK_SIZE = 8;
+	static constexpr size_t BLOCK_VOXEL_COUNT =
+		(size_t)BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE;
+
+	struct Voxel {
+		/// signed distance / truncation distance, scaled to int16
+		int16_t tsdf;
+		/// 0 for voxels that were never observed
+		uint16_t weight;
+	};
+
+	/// voxels in x, then y, then z order
+	struct VoxelBlock {
+		std::array<Voxel, BLOCK_VOXEL_COUNT> voxels;
+	};
+
+  private:
+	struct BlockSlot {
+		uint64_t key;
+		/// index into the pool, -1 for free slots
+		int32_t block;
+	};
+
+	[[nodiscard]] int32_t find_block(uint64_t key) const;
+	/// -1 if the pool is exhausted by blocks of the current frame
+	int32_t allocate_block(uint64_t key);
+	void remove_block(int32_t block);
+	/// frees the least recently observed blocks
+	void recycle_blocks();
+	void allocate_frame_blocks(const TsdfFrame& frame);
+	void integrate_block(int32_t block, const TsdfFrame& frame);
+	[[nodiscard]] const Voxel*
+	find_voxel(int64_t x, int64_t y, int64_t z) const;
+
+	mutable std::mutex mutex;
+	TsdfVolumeOptions options;
+
+	/// the pool is not zeroed, blocks are cleared when they are allocated
+	std::unique_ptr<VoxelBlock[]> blocks;
+	/// block coordinates (packed) and last observed frame of every pool entry
+	std::vector<uint64_t> block_keys;
+	std::vector<uint64_t> block_frames;
+	std::vector<int32_t> free_blocks;
+	std::vector<BlockSlot> slots;
+	uint64_t frame_index = 0;
+
+	/// per frame scratch
+	std::vector<float> metric_depth;
+	std::vector<int32_t> frame_blocks;
+};
\ No newline at end of file
@@ -0,0 +1,435 @@
+#include "DepthRecording.hpp"
+#include "utils/Log.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <unistd.h>
+
+static_assert(sizeof(DepthRecordingFileHeader) % 8 == 0);
+static_assert(sizeof(DepthRecordingFrameHeader) % 8 == 0);
+
+/// residuals with a quotient of at least this many bits are stored raw
+constexpr uint32_t RICE_ESCAPE_LENGTH = 16;
+constexpr uint32_t RICE_PARAMETER_BITS = 4;
+constexpr uint32_t MAX_RICE_PARAMETER = 15;
+
+DepthRange
+quantize_depth(std::span<const float> depth, std::span<uint16_t> quantized) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (quantized.size() != depth.size())
+		throw std::invalid_argument("quantized");
+	if (depth.empty())
+		return {};
+
+	const auto [min, max] = std::ranges::minmax(depth);
+	if (!(max > min)) {
+		std::ranges::fill(quantized, uint16_t{0});
+		return {.min = min, .max = min};
+	}
+
+	const float scale = 65535.0f / (max - min);
+	for (size_t i = 0; i < depth.size(); i++)
+		quantized[i] = (uint16_t)((depth[i] - min) * scale + 0.5f);
+	return {.min = min, .max = max};
+}
+
+void dequantize_depth(
+	std::span<const uint16_t> quantized,
+	DepthRange range,
+	std::span<float> depth
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (quantized.size() != depth.size())
+		throw std::invalid_argument("depth");
+
+	const float scale = (range.max - range.min) / 65535.0f;
+	for (size_t i = 0; i < depth.size(); i++)
+		depth[i] = range.min + (float)quantized[i] * scale;
+}
+
+/// least significant bit first
+class BitWriter {
+  public:
+	explicit BitWriter(std::vector<uint8_t>& output) : output(output) {}
+
+	/// count <= 32
+	void write(uint64_t bits, uint32_t count) {
+		buffer |= bits << pending;
+		pending += count;
+		if (pending >= 32) {
+			const auto word = (uint32_t)buffer;
+			const size_t position = output.size();
+			output.resize(position + 4);
+			std::memcpy(&output[position], &word, 4);
+			buffer >>= 32;
+			pending -= 32;
+		}
+	}
+
+	void flush() {
+		for (; pending > 0; pending -= std::min(pending, 8U)) {
+			output.push_back((uint8_t)buffer);
+			buffer >>= 8;
+		}
+	}
+
+  private:
+	std::vector<uint8_t>& output;
+	uint64_t buffer = 0;
+	uint32_t pending = 0;
+};
+
+class BitReader {
+  public:
+	explicit BitReader(std::span<const uint8_t> input) : input(input) {}
+
+	/// at least 56 bits are available afterwards, bits past the end are 0
+	void refill() {
+		while (available <= 56) {
+			const uint64_t byte = position < input.size() ? input[position] : 0;
+			buffer |= byte << available;
+			available += 8;
+			position++;
+		}
+	}
+
+	[[nodiscard]] uint64_t peek() const { return buffer; }
+
+	/// count <= 56, after refill
+	uint32_t read(uint32_t count) {
+		const auto value = (uint32_t)(buffer & ((1ULL << count) - 1));
+		buffer >>= count;
+		available -= count;
+		return value;
+	}
+
+	/// more bits were read than the input contains
+	[[nodiscard]] bool overrun() const {
+		return (position * 8 - available) > input.size() * 8;
+	}
+
+  private:
+	std::span<const uint8_t> input;
+	size_t position = 0;
+	uint64_t buffer = 0;
+	uint32_t available = 0;
+};
+
+static uint16_t zigzag(uint16_t value, uint16_t prediction) {
+	const auto residual = (int16_t)(uint16_t)(value - prediction);
+	return (uint16_t)(((uint16_t)residual << 1) ^ (uint16_t)(residual >> 15));
+}
+
+static uint16_t unzigzag(uint32_t encoded, uint16_t prediction) {
+	const auto residual = (uint16_t)((encoded >> 1) ^ (0U - (encoded & 1)));
+	return (uint16_t)(prediction + residual);
+}
+
+/// left neighbour plus the horizontal gradient of the row above, so smooth
+/// slopes leave residuals close to 0. wraps around like the residuals
+static uint16_t predict_depth(
+	std::span<const uint16_t> quantized,
+	size_t width,
+	size_t x,
+	size_t y
+) {
+	const size_t index = y * width + x;
+	if (y == 0)
+		return x > 0 ? quantized[index - 1] : 0;
+	if (x == 0)
+		return quantized[index - width];
+	return (uint16_t)(quantized[index - 1] + quantized[index - width] -
+					  quantized[index - width - 1]);
+}
+
+void encode_depth_rows(
+	std::span<const uint16_t> quantized,
+	size_t width,
+	size_t height,
+	std::vector<uint8_t>& encoded
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (quantized.size() != width * height)
+		throw std::invalid_argument("quantized");
+
+	// smooth depth needs ~4 bits per value
+	encoded.reserve(encoded.size() + quantized.size() / 2);
+	BitWriter writer(encoded);
+	std::vector<uint16_t> residuals(width);
+
+	for (size_t y = 0; y < height; y++) {
+		const auto row = quantized.subspan(y * width, width);
+		uint64_t residual_sum = 0;
+		for (size_t x = 0; x < width; x++) {
+			residuals[x] =
+				zigzag(row[x], predict_depth(quantized, width, x, y));
+			residual_sum += residuals[x];
+		}
+
+		// the rice parameter is close to log2 of the mean residual
+		const uint64_t mean = residual_sum / std::max<size_t>(width, 1);
+		const auto parameter = std::min<uint32_t>(
+			mean > 0 ? (uint32_t)std::bit_width(mean) - 1 : 0,
+			MAX_RICE_PARAMETER
+		);
+		writer.write(parameter, RICE_PARAMETER_BITS);
+
+		for (const uint16_t residual : residuals) {
+			const uint32_t quotient = residual >> parameter;
+			if (quotient < RICE_ESCAPE_LENGTH) {
+				// unary quotient (ones terminated by a zero) + remainder
+				writer.write((1ULL << quotient) - 1, quotient + 1);
+				writer.write(residual & ((1U << parameter) - 1), parameter);
+			} else {
+				writer.write((1ULL << RICE_ESCAPE_LENGTH) - 1, RICE_ESCAPE_LENGTH);
+				writer.write(residual, 16);
+			}
+		}
+	}
+	writer.flush();
+}
+
+void decode_depth_rows(
+	std::span<const uint8_t> encoded,
+	size_t width,
+	size_t height,
+	std::span<uint16_t> quantized
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (quantized.size() != width * height)
+		throw std::invalid_argument("quantized");
+
+	BitReader reader(encoded);
+	for (size_t y = 0; y < height; y++) {
+		const auto row = quantized.subspan(y * width, width);
+		reader.refill();
+		const uint32_t parameter = reader.read(RICE_PARAMETER_BITS);
+
+		for (size_t x = 0; x < width; x++) {
+			reader.refill();
+			const auto quotient = std::min<uint32_t>(
+				(uint32_t)std::countr_one(reader.peek()), RICE_ESCAPE_LENGTH
+			);
+			uint32_t residual = 0;
+			if (quotient < RICE_ESCAPE_LENGTH) {
+				reader.read(quotient + 1);
+				residual = (quotient << parameter) | reader.read(parameter);
+			} else {
+				reader.read(RICE_ESCAPE_LENGTH);
+				residual = reader.read(16);
+			}
+
+			row[x] = unzigzag(residual, predict_depth(quantized, width, x, y));
+		}
+	}
+
+	if (reader.overrun())
+		throw DepthRecordingException("encoded depth is truncated");
+}
+
+DepthRecordingWriter::DepthRecordingWriter(const std::string& path)
+	: file(path, O_WRONLY | O_CREAT | O_TRUNC) {
+	const DepthRecordingFileHeader header{
+		.magic = DEPTH_RECORDING_MAGIC,
+		.version = DEPTH_RECORDING_VERSION,
+		.reserved = 0,
+	};
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	write_bytes({reinterpret_cast<const uint8_t*>(&header), sizeof(header)});
+}
+
+DepthRecordingWriter::~DepthRecordingWriter() noexcept {
+	const std::scoped_lock lock(mutex);
+	LOG_ON_EXCEPTION(
+		const DepthRecordingFooter footer{
+			.index_offset = file_offset,
+			.frame_count = index.size(),
+			.magic = DEPTH_RECORDING_INDEX_MAGIC,
+		};
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		write_bytes(
+			{reinterpret_cast<const uint8_t*>(index.data()),
+			 index.size() * sizeof(DepthRecordingIndexEntry)}
+		);
+		write_bytes({reinterpret_cast<const uint8_t*>(&footer), sizeof(footer)});
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	)
+}
+
+void DepthRecordingWriter::write_bytes(std::span<const uint8_t> bytes) {
+	while (!bytes.empty()) {
+		const ssize_t written = write(file.get(), bytes.data(), bytes.size());
+		if (written < 0)
+			throw FileOperationException("write", file.path());
+		bytes = bytes.subspan((size_t)written);
+		file_offset += (size_t)written;
+	}
+}
+
+void DepthRecordingWriter::write_frame(
+	std::span<const float> depth,
+	size_t width,
+	size_t height,
+	int64_t timestamp_ns
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+
+	const std::scoped_lock lock(mutex);
+
+	quantized.resize(depth.size());
+	const auto range = quantize_depth(depth, quantized);
+	encoded.clear();
+	encode_depth_rows(quantized, width, height, encoded);
+	const size_t encoded_size = encoded.size();
+	encoded.resize(align_up(encoded_size, 8), 0);
+
+	const DepthRecordingFrameHeader header{
+		.magic = DEPTH_RECORDING_FRAME_MAGIC,
+		.width = (uint32_t)width,
+		.height = (uint32_t)height,
+		.reserved = 0,
+		.timestamp_ns = timestamp_ns,
+		.range_min = range.min,
+		.range_max = range.max,
+		.encoded_size = encoded_size,
+	};
+	const DepthRecordingIndexEntry index_entry{
+		.offset = file_offset,
+		.timestamp_ns = timestamp_ns,
+	};
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	write_bytes({reinterpret_cast<const uint8_t*>(&header), sizeof(header)});
+	write_bytes(encoded);
+	index.push_back(index_entry);
+}
+
+size_t DepthRecordingWriter::frame_count() const {
+	const std::scoped_lock lock(mutex);
+	return index.size();
+}
+
+size_t DepthRecordingWriter::written_bytes() const {
+	const std::scoped_lock lock(mutex);
+	return file_offset;
+}
+
+DepthRecordingReader::DepthRecordingReader(const std::string& path)
+	: file(path, O_RDONLY) {
+	const size_t file_size = file.size();
+	if (file_size < sizeof(DepthRecordingFileHeader))
+		throw DepthRecordingException(
+			std::format("{} is not a depth recording", path)
+		);
+	mapping = MappedRegion(file, 0, file_size, false);
+	const auto bytes = mapping.bytes();
+
+	DepthRecordingFileHeader header{};
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	if (header.magic != DEPTH_RECORDING_MAGIC)
+		throw DepthRecordingException(
+			std::format("{} is not a depth recording", path)
+		);
+	if (header.version != DEPTH_RECORDING_VERSION)
+		throw DepthRecordingException(std::format(
+			"{} has version {}, expected {}", path, header.version,
+			DEPTH_RECORDING_VERSION
+		));
+
+	DepthRecordingFooter footer{};
+	if (file_size >= sizeof(header) + sizeof(footer))
+		std::memcpy(
+			&footer, bytes.data() + file_size - sizeof(footer), sizeof(footer)
+		);
+	const size_t index_size =
+		footer.frame_count * sizeof(DepthRecordingIndexEntry);
+	if (footer.magic == DEPTH_RECORDING_INDEX_MAGIC &&
+		footer.index_offset + index_size + sizeof(footer) == file_size) {
+		index.resize(footer.frame_count);
+		std::memcpy(
+			index.data(), bytes.data() + footer.index_offset, index_size
+		);
+	} else {
+		LOG_INFO("{} has no index, scanning the frames", path);
+		scan_frames();
+	}
+}
+
+void DepthRecordingReader::scan_frames() {
+	const auto bytes = mapping.bytes();
+	size_t offset = sizeof(DepthRecordingFileHeader);
+	while (offset + sizeof(DepthRecordingFrameHeader) <= bytes.size()) {
+		DepthRecordingFrameHeader header{};
+		std::memcpy(&header, bytes.data() + offset, sizeof(header));
+		if (header.magic != DEPTH_RECORDING_FRAME_MAGIC ||
+			offset + sizeof(header) + header.encoded_size > bytes.size())
+			break;
+
+		index.push_back({.offset = offset, .timestamp_ns = header.timestamp_ns}
+		);
+		offset += sizeof(header) + align_up(header.encoded_size, 8);
+	}
+}
+
+DepthRecordingFrameHeader DepthRecordingReader::frame_header(size_t frame
+) const {
+	const auto bytes = mapping.bytes();
+	const size_t offset = index.at(frame).offset;
+	DepthRecordingFrameHeader header{};
+	if (offset + sizeof(header) > bytes.size())
+		throw DepthRecordingException(std::format("frame {} is truncated", frame)
+		);
+	std::memcpy(&header, bytes.data() + offset, sizeof(header));
+	if (header.magic != DEPTH_RECORDING_FRAME_MAGIC ||
+		offset + sizeof(header) + header.encoded_size > bytes.size())
+		throw DepthRecordingException(std::format("frame {} is corrupt", frame)
+		);
+	return header;
+}
+
+DepthRecordingFrameInfo DepthRecordingReader::frame_info(size_t frame) const {
+	const auto header = frame_header(frame);
+	return {
+		.width = header.width,
+		.height = header.height,
+		.timestamp_ns = header.timestamp_ns,
+		.range = {.min = header.range_min, .max = header.range_max},
+	};
+}
+
+void DepthRecordingReader::read_frame(size_t frame, std::span<float> depth) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto header = frame_header(frame);
+	if (depth.size() != (size_t)header.width * header.height)
+		throw std::invalid_argument("depth");
+
+	quantized.resize(depth.size());
+	decode_depth_rows(
+		mapping.bytes().subspan(
+			index[frame].offset + sizeof(header), header.encoded_size
+		),
+		header.width, header.height, quantized
+	);
+	dequantize_depth(
+		quantized, {.min = header.range_min, .max = header.range_max}, depth
+	);
+}
+
+size_t DepthRecordingReader::find_frame(int64_t timestamp_ns) const {
+	const auto next = std::ranges::upper_bound(
+		index, timestamp_ns, {}, &DepthRecordingIndexEntry::timestamp_ns
+	);
+	return next == index.begin() ? 0 : (size_t)(next - index.begin()) - 1;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "utils/MappedFile.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// value range of a quantized depth frame, uint16 0 maps to min and 65535 to
+/// max
+struct DepthRange {
+	float min = 0.0f;
+	float max = 1.0f;
+};
+
+/// quantizes depth to uint16 over the value range of the frame
+DepthRange
+quantize_depth(std::span<const float> depth, std::span<uint16_t> quantized);
+
+void dequantize_depth(
+	std::span<const uint16_t> quantized,
+	DepthRange range,
+	std::span<float> depth
+);
+
+/// lossless compression of quantized depth: every value is predicted from its
+/// left neighbour and the row above (delta of the row deltas), the zigzag
+/// encoded residuals are rice coded with a parameter chosen per row. appends
+/// to encoded
+void encode_depth_rows(
+	std::span<const uint16_t> quantized,
+	size_t width,
+	size_t height,
+	std::vector<uint8_t>& encoded
+);
+
+/// inverse of encode_depth_rows, throws DepthRecordingException for
+/// truncated input
+void decode_depth_rows(
+	std::span<const uint8_t> encoded,
+	size_t width,
+	size_t height,
+	std::span<uint16_t> quantized
+);
+
+class DepthRecordingException : public std::runtime_error {
+  public:
+	using std::runtime_error::runtime_error;
+};
+
+/// file layout of depth recordings:
+/// - DepthRecordingFileHeader
+/// - frames: a DepthRecordingFrameHeader followed by the encoded rows, padded
+///   to 8 bytes
+/// - index: a DepthRecordingIndexEntry for every frame, followed by the
+///   DepthRecordingFooter
+///
+/// all values are little endian. recordings without footer (the writer was
+/// killed) are indexed by scanning the frames
+struct DepthRecordingFileHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t reserved;
+};
+
+struct DepthRecordingFrameHeader {
+	std::array<char, 4> magic;
+	uint32_t width;
+	uint32_t height;
+	uint32_t reserved;
+	int64_t timestamp_ns;
+	float range_min;
+	float range_max;
+	uint64_t encoded_size;
+};
+
+struct DepthRecordingIndexEntry {
+	uint64_t offset;
+	int64_t timestamp_ns;
+};
+
+struct DepthRecordingFooter {
+	uint64_t index_offset;
+	uint64_t frame_count;
+	std::array<char, 8> magic;
+};
+
+constexpr std::array<char, 8> DEPTH_RECORDING_MAGIC = {'D', 'C', 'D', 'E',
+													   'P', 'T', 'H', '1'};
+constexpr std::array<char, 4> DEPTH_RECORDING_FRAME_MAGIC = {'D', 'F', 'R', 'M'};
+constexpr std::array<char, 8> DEPTH_RECORDING_INDEX_MAGIC = {'D', 'C', 'D', 'I',
+															 'N', 'D', 'E', 'X'};
+constexpr uint32_t DEPTH_RECORDING_VERSION = 1;
+
+/// appends compressed depth frames to a file, the index is written on
+/// destruction
+class DepthRecordingWriter {
+  public:
+	explicit DepthRecordingWriter(const std::string& path);
+	~DepthRecordingWriter() noexcept;
+
+	DepthRecordingWriter(const DepthRecordingWriter&) = delete;
+	DepthRecordingWriter(DepthRecordingWriter&&) = delete;
+	void operator=(const DepthRecordingWriter&) = delete;
+	void operator=(DepthRecordingWriter&&) = delete;
+
+	/// thread safe
+	void write_frame(
+		std::span<const float> depth,
+		size_t width,
+		size_t height,
+		int64_t timestamp_ns
+	);
+
+	[[nodiscard]] size_t frame_count() const;
+	[[nodiscard]] size_t written_bytes() const;
+
+  private:
+	void write_bytes(std::span<const uint8_t> bytes);
+
+	mutable std::mutex mutex;
+	FileDescriptor file;
+	size_t file_offset = 0;
+	std::vector<DepthRecordingIndexEntry> index;
+	std::vector<uint16_t> quantized;
+	std::vector<uint8_t> encoded;
+};
+
+struct DepthRecordingFrameInfo {
+	size_t width = 0;
+	size_t height = 0;
+	int64_t timestamp_ns = 0;
+	DepthRange range;
+};
+
+/// random access to the frames of a memory mapped depth recording
+class DepthRecordingReader {
+  public:
+	explicit DepthRecordingReader(const std::string& path);
+
+	[[nodiscard]] size_t frame_count() const { return index.size(); }
+
+	[[nodiscard]] DepthRecordingFrameInfo frame_info(size_t frame) const;
+
+	/// depth has to have the size of the frame (frame_info)
+	void read_frame(size_t frame, std::span<float> depth);
+
+	/// the last frame with a timestamp at or before timestamp_ns (or the
+	/// first frame)
+	[[nodiscard]] size_t find_frame(int64_t timestamp_ns) const;
+
+  private:
+	[[nodiscard]] DepthRecordingFrameHeader frame_header(size_t frame) const;
+	void scan_frames();
+
+	FileDescriptor file;
+	MappedRegion mapping;
+	std::vector<DepthRecordingIndexEntry> index;
+	std::vector<uint16_t> quantized;
+};
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "SessionRecording.hpp"
+#include "utils/Log.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <unistd.h>
+
+static_assert(sizeof(SessionFileHeader) <= MAPPING_ALIGNMENT);
+static_assert(sizeof(SessionChunkHeader) % 8 == 0);
+static_assert(sizeof(SessionFrameHeader) % 8 == 0);
+
+SessionRecorder::SessionRecorder(const std::string& path, size_t chunk_size)
+	: file(path, O_RDWR | O_CREAT | O_TRUNC),
+	  default_chunk_size(align_up(chunk_size, MAPPING_ALIGNMENT)) {
+	const SessionFileHeader header{
+		.magic = SESSION_FILE_MAGIC,
+		.version = SESSION_FILE_VERSION,
+		.reserved = 0,
+	};
+	if (pwrite(file.get(), &header, sizeof(header), 0) != sizeof(header))
+		throw FileOperationException("write", path);
+	file.truncate(MAPPING_ALIGNMENT);
+}
+
+SessionRecorder::~SessionRecorder() noexcept {
+	if (!chunk.is_mapped())
+		return;
+
+	const size_t recorded_size = chunk_offset + chunk_header().used_size;
+	chunk = MappedRegion();
+	LOG_ON_EXCEPTION(file.truncate(recorded_size);)
+}
+
+SessionChunkHeader& SessionRecorder::chunk_header() const {
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return *reinterpret_cast<SessionChunkHeader*>(chunk.bytes().data());
+}
+
+void SessionRecorder::start_chunk(size_t minimum_size) {
+	PROFILE_CAMERA_FUNCTION()
+
+	const size_t offset = chunk.is_mapped()
+							  ? chunk_offset + chunk_header().chunk_size
+							  : MAPPING_ALIGNMENT;
+	const size_t size = align_up(
+		std::max(default_chunk_size, minimum_size), MAPPING_ALIGNMENT
+	);
+
+	chunk = MappedRegion();
+	file.truncate(offset + size);
+	chunk = MappedRegion(file, offset, size, true);
+	chunk_offset = offset;
+
+	chunk_header() = SessionChunkHeader{
+		.magic = SESSION_CHUNK_MAGIC,
+		.chunk_size = size,
+		.used_size = sizeof(SessionChunkHeader),
+		.frame_count = 0,
+	};
+}
+
+void SessionRecorder::append_frame(const RecordedFrame& frame) {
+	PROFILE_CAMERA_FUNCTION()
+
+	if (frame.pixels.size() != (size_t)frame.width * frame.height * 4)
+		throw std::invalid_argument("frame.pixels");
+
+	const std::scoped_lock lock(mutex);
+
+	const size_t frame_size =
+		sizeof(SessionFrameHeader) + align_up(frame.pixels.size(), 8);
+	if (!chunk.is_mapped() ||
+		chunk_header().used_size + frame_size > chunk_header().chunk_size)
+		start_chunk(sizeof(SessionChunkHeader) + frame_size);
+
+	auto& header = chunk_header();
+	uint8_t* frame_start = chunk.bytes().data() + header.used_size;
+
+	const SessionFrameHeader frame_header{
+		.timestamp_ns = frame.timestamp_ns,
+		.width = frame.width,
+		.height = frame.height,
+		.rotation_degrees = frame.rotation_degrees,
+		.pixel_format = (uint32_t)frame.pixel_format,
+		.pixel_size = frame.pixels.size(),
+	};
+	std::memcpy(frame_start, &frame_header, sizeof(frame_header));
+	std::memcpy(
+		frame_start + sizeof(frame_header), frame.pixels.data(),
+		frame.pixels.size()
+	);
+
+	// the frame only becomes visible to readers once it is complete
+	header.used_size += frame_size;
+	header.frame_count++;
+	total_frames++;
+}
+
+size_t SessionRecorder::frame_count() const {
+	const std::scoped_lock lock(mutex);
+	return total_frames;
+}
+
+size_t SessionRecorder::recorded_bytes() const {
+	const std::scoped_lock lock(mutex);
+	return chunk.is_mapped() ? chunk_offset + chunk_header().used_size
+							 : MAPPING_ALIGNMENT;
+}
+
+SessionRecording::SessionRecording(const std::string& path)
+	: file(path, O_RDONLY) {
+	const size_t file_size = file.size();
+	if (file_size < sizeof(SessionFileHeader))
+		throw SessionRecordingException(
+			std::format("{} is not a session recording", path)
+		);
+	mapping = MappedRegion(file, 0, file_size, false);
+	const auto bytes = mapping.bytes();
+
+	SessionFileHeader file_header{};
+	std::memcpy(&file_header, bytes.data(), sizeof(file_header));
+	if (file_header.magic != SESSION_FILE_MAGIC)
+		throw SessionRecordingException(
+			std::format("{} is not a session recording", path)
+		);
+	if (file_header.version != SESSION_FILE_VERSION)
+		throw SessionRecordingException(std::format(
+			"{} has version {}, expected {}", path, file_header.version,
+			SESSION_FILE_VERSION
+		));
+
+	size_t chunk_offset = MAPPING_ALIGNMENT;
+	while (chunk_offset + sizeof(SessionChunkHeader) <= file_size) {
+		SessionChunkHeader chunk{};
+		std::memcpy(&chunk, bytes.data() + chunk_offset, sizeof(chunk));
+		if (chunk.magic != SESSION_CHUNK_MAGIC || chunk.chunk_size == 0) {
+			// the recorder was killed while starting this chunk
+			LOG_ERROR(
+				"{}: invalid chunk at offset {}, ignoring the rest", path,
+				chunk_offset
+			);
+			break;
+		}
+
+		const size_t chunk_end =
+			chunk_offset + std::min(chunk.used_size, file_size - chunk_offset);
+		size_t frame_offset = chunk_offset + sizeof(SessionChunkHeader);
+		for (size_t i = 0; i < chunk.frame_count; i++) {
+			SessionFrameHeader header{};
+			if (frame_offset + sizeof(header) > chunk_end)
+				break;
+			std::memcpy(&header, bytes.data() + frame_offset, sizeof(header));
+			const size_t pixel_offset = frame_offset + sizeof(header);
+			if (pixel_offset + header.pixel_size > chunk_end)
+				break;
+
+			recorded_frames.push_back(RecordedFrame{
+				.timestamp_ns = header.timestamp_ns,
+				.width = header.width,
+				.height = header.height,
+				.rotation_degrees = header.rotation_degrees,
+				.pixel_format = (RecordedPixelFormat)header.pixel_format,
+				.pixels = bytes.subspan(pixel_offset, header.pixel_size),
+			});
+			frame_offset = pixel_offset + align_up(header.pixel_size, 8);
+		}
+
+		chunk_offset += chunk.chunk_size;
+	}
+}
+
+void rotate_pixels(
+	std::span<const uint8_t> pixels,
+	size_t width,
+	size_t height,
+	uint32_t rotation_degrees,
+	std::span<uint8_t> rotated
+) {
+	if (pixels.size() != width * height * 4 || rotated.size() != pixels.size())
+		throw std::invalid_argument("rotated");
+
+	const bool swaps_axes = rotation_degrees % 180 == 90;
+	const size_t rotated_width = swaps_axes ? height : width;
+
+	for (size_t y = 0; y < height; y++) {
+		for (size_t x = 0; x < width; x++) {
+			size_t rotated_x = x;
+			size_t rotated_y = y;
+			switch (rotation_degrees % 360) {
+			case 90:
+				rotated_x = height - 1 - y;
+				rotated_y = x;
+				break;
+			case 180:
+				rotated_x = width - 1 - x;
+				rotated_y = height - 1 - y;
+				break;
+			case 270:
+				rotated_x = y;
+				rotated_y = width - 1 - x;
+				break;
+			default:
+				break;
+			}
+			std::memcpy(
+				&rotated[(rotated_y * rotated_width + rotated_x) * 4],
+				&pixels[(y * width + x) * 4], 4
+			);
+		}
+	}
+}
\ No newline at end of file
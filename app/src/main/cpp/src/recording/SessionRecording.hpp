@@ -0,0 +1,134 @@
+#pragma once
+
+#include "utils/MappedFile.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// pixel layout of the recorded frames
+enum class RecordedPixelFormat : uint32_t {
+	/// the bytes of camera images (PixelFormat.RGBA_8888), before
+	/// image_bytes_to_argb_int_array
+	Rgba8888 = 0,
+};
+
+struct RecordedFrame {
+	/// capture time of the camera image (Image.getTimestamp)
+	int64_t timestamp_ns = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	/// clockwise rotation that makes the frame upright
+	uint32_t rotation_degrees = 0;
+	RecordedPixelFormat pixel_format = RecordedPixelFormat::Rgba8888;
+	std::span<const uint8_t> pixels;
+};
+
+/// file layout of session recordings:
+/// - SessionFileHeader, padded to MAPPING_ALIGNMENT
+/// - chunks of SessionChunkHeader followed by frames, every chunk starts at a
+///   multiple of MAPPING_ALIGNMENT so it can be mapped on its own
+/// - frames are a SessionFrameHeader followed by the pixels, padded to 8
+///   bytes
+///
+/// all values are little endian. a chunk only counts the frames that were
+/// completely written, so recordings of killed processes stay readable
+struct SessionFileHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t reserved;
+};
+
+struct SessionChunkHeader {
+	std::array<char, 8> magic;
+	/// distance to the next chunk
+	uint64_t chunk_size;
+	/// bytes of this chunk that contain complete frames, including the header
+	uint64_t used_size;
+	uint64_t frame_count;
+};
+
+struct SessionFrameHeader {
+	int64_t timestamp_ns;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rotation_degrees;
+	uint32_t pixel_format;
+	uint64_t pixel_size;
+};
+
+constexpr std::array<char, 8> SESSION_FILE_MAGIC = {'D', 'C', 'S', 'E',
+													'S', 'S', 'I', 'O'};
+constexpr std::array<char, 8> SESSION_CHUNK_MAGIC = {'D', 'C', 'C', 'H',
+													 'U', 'N', 'K', '0'};
+constexpr uint32_t SESSION_FILE_VERSION = 1;
+/// new chunks are mapped with at least this size
+constexpr size_t SESSION_CHUNK_SIZE = 32 * 1024 * 1024;
+
+class SessionRecordingException : public std::runtime_error {
+  public:
+	using std::runtime_error::runtime_error;
+};
+
+/// appends camera frames to a memory mapped, chunked session recording. only
+/// the current chunk is mapped, the file grows one chunk at a time
+class SessionRecorder {
+  public:
+	explicit SessionRecorder(
+		const std::string& path,
+		size_t chunk_size = SESSION_CHUNK_SIZE
+	);
+	/// truncates the file to the recorded frames
+	~SessionRecorder() noexcept;
+
+	SessionRecorder(const SessionRecorder&) = delete;
+	SessionRecorder(SessionRecorder&&) = delete;
+	void operator=(const SessionRecorder&) = delete;
+	void operator=(SessionRecorder&&) = delete;
+
+	/// thread safe, frames should be appended in capture order
+	void append_frame(const RecordedFrame& frame);
+
+	[[nodiscard]] size_t frame_count() const;
+	[[nodiscard]] size_t recorded_bytes() const;
+
+  private:
+	void start_chunk(size_t minimum_size);
+	[[nodiscard]] SessionChunkHeader& chunk_header() const;
+
+	mutable std::mutex mutex;
+	FileDescriptor file;
+	size_t default_chunk_size;
+	MappedRegion chunk;
+	size_t chunk_offset = 0;
+	size_t total_frames = 0;
+};
+
+/// read only mapping of a whole session recording
+class SessionRecording {
+  public:
+	explicit SessionRecording(const std::string& path);
+
+	[[nodiscard]] std::span<const RecordedFrame> frames() const {
+		return recorded_frames;
+	}
+
+  private:
+	FileDescriptor file;
+	MappedRegion mapping;
+	/// the pixels point into the mapping
+	std::vector<RecordedFrame> recorded_frames;
+};
+
+/// rotates tightly packed 4 byte pixels clockwise by 0, 90, 180 or 270 degrees,
+/// like the rotation that is applied after the camera conversion
+void rotate_pixels(
+	std::span<const uint8_t> pixels,
+	size_t width,
+	size_t height,
+	uint32_t rotation_degrees,
+	std::span<uint8_t> rotated
+);
\ No newline at end of file
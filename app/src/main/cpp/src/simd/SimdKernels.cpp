@@ -0,0 +1,91 @@
+#include "SimdKernels.hpp"
+
+#include "utils/Log.hpp"
+
+static void
+scalar_scale_offset(std::span<float> values, float scale, float offset) {
+	for (float& value : values)
+		value = value * scale + offset;
+}
+
+static void scalar_scale_offset_rgb(
+	std::span<float> values,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	for (size_t i = 0; i + 3 <= values.size(); i += 3) {
+		values[i] = values[i] * scale[0] + offset[0];
+		values[i + 1] = values[i + 1] * scale[1] + offset[1];
+		values[i + 2] = values[i + 2] * scale[2] + offset[2];
+	}
+}
+
+static FloatRange scalar_min_max(std::span<const float> values) {
+	FloatRange range{.min = values[0], .max = values[0]};
+	for (const float value : values) {
+		range.min = value < range.min ? value : range.min;
+		range.max = value > range.max ? value : range.max;
+	}
+	return range;
+}
+
+static void scalar_rgba_to_rgb(
+	std::span<const uint8_t> pixels,
+	std::span<float> rgb,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	const size_t pixel_count = rgb.size() / 3;
+	for (size_t i = 0; i < pixel_count; i++) {
+		rgb[3 * i] = (float)pixels[4 * i] * scale[0] + offset[0];
+		rgb[3 * i + 1] = (float)pixels[4 * i + 1] * scale[1] + offset[1];
+		rgb[3 * i + 2] = (float)pixels[4 * i + 2] * scale[2] + offset[2];
+	}
+}
+
+static void scalar_dequantize_uint8(
+	std::span<const uint8_t> quantized_values,
+	std::span<float> real_values,
+	float scale,
+	int32_t zero_point
+) {
+	for (size_t i = 0; i < real_values.size(); i++)
+		real_values[i] =
+			scale * (float)((int32_t)quantized_values[i] - zero_point);
+}
+
+const SimdKernels SCALAR_KERNELS = {
+	.name = "scalar",
+	.scale_offset = scalar_scale_offset,
+	.scale_offset_rgb = scalar_scale_offset_rgb,
+	.min_max = scalar_min_max,
+	.rgba_to_rgb = scalar_rgba_to_rgb,
+	.dequantize_uint8 = scalar_dequantize_uint8,
+};
+
+std::vector<const SimdKernels*> supported_simd_kernels() {
+	std::vector<const SimdKernels*> kernels = {&SCALAR_KERNELS};
+#ifdef SIMD_KERNELS_NEON
+	// part of arm64 and of the armeabi-v7a abi of the ndk
+	kernels.push_back(&NEON_KERNELS);
+#endif
+#ifdef SIMD_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1"))
+		kernels.push_back(&SSE4_KERNELS);
+	if (__builtin_cpu_supports("avx2"))
+		kernels.push_back(&AVX2_KERNELS);
+#endif
+	return kernels;
+}
+
+static const SimdKernels& select_simd_kernels() {
+	const auto& kernels = *supported_simd_kernels().back();
+	LOG_INFO("using {} kernels", kernels.name);
+	return kernels;
+}
+
+const SimdKernels& simd_kernels() {
+	static const SimdKernels& kernels = select_simd_kernels();
+	return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define SIMD_KERNELS_NEON
+#elif defined(__x86_64__) || defined(__i386__)
+#define SIMD_KERNELS_X86
+#endif
+
+struct FloatRange {
+	float min = 0.0f;
+	float max = 0.0f;
+};
+
+/// the per pixel kernels of the pre- and postprocessing, implemented once
+/// for every instruction set. the scalar set is the reference of the others,
+/// which agree with it up to float rounding (a few ulp, the vector kernels
+/// don't fuse multiply-adds). results with NaN values are unspecified
+struct SimdKernels {
+	/// "scalar", "neon", "sse4.1" or "avx2"
+	std::string_view name;
+
+	/// values = values * scale + offset
+	void (*scale_offset)(std::span<float> values, float scale, float offset);
+
+	/// interleaved rgb values (size divisible by 3), every channel with its
+	/// own scale and offset
+	void (*scale_offset_rgb)(
+		std::span<float> values,
+		const std::array<float, 3>& scale,
+		const std::array<float, 3>& offset
+	);
+
+	/// values must not be empty
+	FloatRange (*min_max)(std::span<const float> values);
+
+	/// rgba bytes (4 per pixel) to interleaved rgb floats (3 per pixel),
+	/// byte * scale + offset
+	void (*rgba_to_rgb)(
+		std::span<const uint8_t> pixels,
+		std::span<float> rgb,
+		const std::array<float, 3>& scale,
+		const std::array<float, 3>& offset
+	);
+
+	/// real value = scale * (quantized value - zero point)
+	void (*dequantize_uint8)(
+		std::span<const uint8_t> quantized_values,
+		std::span<float> real_values,
+		float scale,
+		int32_t zero_point
+	);
+};
+
+extern const SimdKernels SCALAR_KERNELS;
+#ifdef SIMD_KERNELS_NEON
+extern const SimdKernels NEON_KERNELS;
+#endif
+#ifdef SIMD_KERNELS_X86
+extern const SimdKernels SSE4_KERNELS;
+extern const SimdKernels AVX2_KERNELS;
+#endif
+
+/// the kernel sets that the cpu can run, from the scalar reference to the
+/// widest instruction set
+std::vector<const SimdKernels*> supported_simd_kernels();
+
+/// the widest supported kernel set, detected once on first use
+const SimdKernels& simd_kernels();
\ No newline at end of file
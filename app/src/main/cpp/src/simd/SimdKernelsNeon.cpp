@@ -0,0 +1,208 @@
+#include "SimdKernels.hpp"
+
+#ifdef SIMD_KERNELS_NEON
+#include <arm_neon.h>
+
+/// the 16 bytes as 4 vectors of 4 floats
+struct Float32x4x4 {
+	float32x4_t values_0;
+	float32x4_t values_1;
+	float32x4_t values_2;
+	float32x4_t values_3;
+};
+
+static Float32x4x4 widen_to_float(uint8x16_t bytes) {
+	const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+	const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+	return {
+		vcvtq_f32_u32(vmovl_u16(vget_low_u16(low))),
+		vcvtq_f32_u32(vmovl_u16(vget_high_u16(low))),
+		vcvtq_f32_u32(vmovl_u16(vget_low_u16(high))),
+		vcvtq_f32_u32(vmovl_u16(vget_high_u16(high))),
+	};
+}
+
+static float horizontal_min(float32x4_t values) {
+#ifdef __aarch64__
+	return vminvq_f32(values);
+#else
+	const float32x2_t pair =
+		vpmin_f32(vget_low_f32(values), vget_high_f32(values));
+	return vget_lane_f32(vpmin_f32(pair, pair), 0);
+#endif
+}
+
+static float horizontal_max(float32x4_t values) {
+#ifdef __aarch64__
+	return vmaxvq_f32(values);
+#else
+	const float32x2_t pair =
+		vpmax_f32(vget_low_f32(values), vget_high_f32(values));
+	return vget_lane_f32(vpmax_f32(pair, pair), 0);
+#endif
+}
+
+/// value * scale + offset, as separate instructions like the scalar kernels
+static float32x4_t
+scale_offset_vector(float32x4_t value, float32x4_t scale, float32x4_t offset) {
+	return vaddq_f32(vmulq_f32(value, scale), offset);
+}
+
+static void
+neon_scale_offset(std::span<float> values, float scale, float offset) {
+	float* data = values.data();
+	const size_t size = values.size();
+	const float32x4_t scales = vdupq_n_f32(scale);
+	const float32x4_t offsets = vdupq_n_f32(offset);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		vst1q_f32(
+			data + i, scale_offset_vector(vld1q_f32(data + i), scales, offsets)
+		);
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale + offset;
+}
+
+static void neon_scale_offset_rgb(
+	std::span<float> values,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	float* data = values.data();
+	const size_t size = values.size() - values.size() % 3;
+	size_t i = 0;
+	// deinterleaved into r, g and b vectors of 4 pixels
+	for (; i + 12 <= size; i += 12) {
+		float32x4x3_t rgb = vld3q_f32(data + i);
+		for (size_t channel = 0; channel < 3; channel++) {
+			rgb.val[channel] = scale_offset_vector(
+				rgb.val[channel], vdupq_n_f32(scale[channel]),
+				vdupq_n_f32(offset[channel])
+			);
+		}
+		vst3q_f32(data + i, rgb);
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale[i % 3] + offset[i % 3];
+}
+
+static FloatRange neon_min_max(std::span<const float> values) {
+	const float* data = values.data();
+	const size_t size = values.size();
+	float32x4_t min = vdupq_n_f32(data[0]);
+	float32x4_t max = min;
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const float32x4_t value = vld1q_f32(data + i);
+		min = vminq_f32(min, value);
+		max = vmaxq_f32(max, value);
+	}
+	FloatRange range{.min = horizontal_min(min), .max = horizontal_max(max)};
+	for (; i < size; i++) {
+		range.min = data[i] < range.min ? data[i] : range.min;
+		range.max = data[i] > range.max ? data[i] : range.max;
+	}
+	return range;
+}
+
+static void neon_rgba_to_rgb(
+	std::span<const uint8_t> pixels,
+	std::span<float> rgb,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	const uint8_t* source = pixels.data();
+	float* destination = rgb.data();
+	const size_t pixel_count = rgb.size() / 3;
+	size_t i = 0;
+	// 16 pixels deinterleaved into r, g, b and a bytes, stored interleaved
+	// again 4 pixels at a time
+	for (; i + 16 <= pixel_count; i += 16) {
+		const uint8x16x4_t rgba = vld4q_u8(source + 4 * i);
+		std::array<Float32x4x4, 3> channels{};
+		for (size_t channel = 0; channel < 3; channel++) {
+			const float32x4_t channel_scale = vdupq_n_f32(scale[channel]);
+			const float32x4_t channel_offset = vdupq_n_f32(offset[channel]);
+			auto& values = channels[channel];
+			values = widen_to_float(rgba.val[channel]);
+			values.values_0 = scale_offset_vector(
+				values.values_0, channel_scale, channel_offset
+			);
+			values.values_1 = scale_offset_vector(
+				values.values_1, channel_scale, channel_offset
+			);
+			values.values_2 = scale_offset_vector(
+				values.values_2, channel_scale, channel_offset
+			);
+			values.values_3 = scale_offset_vector(
+				values.values_3, channel_scale, channel_offset
+			);
+		}
+		float* out = destination + 3 * i;
+		vst3q_f32(
+			out, {{channels[0].values_0, channels[1].values_0,
+				   channels[2].values_0}}
+		);
+		vst3q_f32(
+			out + 12, {{channels[0].values_1, channels[1].values_1,
+						channels[2].values_1}}
+		);
+		vst3q_f32(
+			out + 24, {{channels[0].values_2, channels[1].values_2,
+						channels[2].values_2}}
+		);
+		vst3q_f32(
+			out + 36, {{channels[0].values_3, channels[1].values_3,
+						channels[2].values_3}}
+		);
+	}
+	for (; i < pixel_count; i++) {
+		for (size_t channel = 0; channel < 3; channel++) {
+			destination[3 * i + channel] =
+				(float)source[4 * i + channel] * scale[channel] +
+				offset[channel];
+		}
+	}
+}
+
+static void neon_dequantize_uint8(
+	std::span<const uint8_t> quantized_values,
+	std::span<float> real_values,
+	float scale,
+	int32_t zero_point
+) {
+	const uint8_t* source = quantized_values.data();
+	float* destination = real_values.data();
+	const size_t size = real_values.size();
+	const int32x4_t zero_points = vdupq_n_s32(zero_point);
+	const float32x4_t scales = vdupq_n_f32(scale);
+	const auto dequantize = [&](uint16x4_t values) {
+		const int32x4_t shifted = vsubq_s32(
+			vreinterpretq_s32_u32(vmovl_u16(values)), zero_points
+		);
+		return vmulq_f32(scales, vcvtq_f32_s32(shifted));
+	};
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const uint8x16_t bytes = vld1q_u8(source + i);
+		const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+		const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+		vst1q_f32(destination + i, dequantize(vget_low_u16(low)));
+		vst1q_f32(destination + i + 4, dequantize(vget_high_u16(low)));
+		vst1q_f32(destination + i + 8, dequantize(vget_low_u16(high)));
+		vst1q_f32(destination + i + 12, dequantize(vget_high_u16(high)));
+	}
+	for (; i < size; i++)
+		destination[i] = scale * (float)((int32_t)source[i] - zero_point);
+}
+
+const SimdKernels NEON_KERNELS = {
+	.name = "neon",
+	.scale_offset = neon_scale_offset,
+	.scale_offset_rgb = neon_scale_offset_rgb,
+	.min_max = neon_min_max,
+	.rgba_to_rgb = neon_rgba_to_rgb,
+	.dequantize_uint8 = neon_dequantize_uint8,
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "SimdKernels.hpp"
+
+#ifdef SIMD_KERNELS_X86
+#include <cstring>
+#include <immintrin.h>
+
+// the functions are compiled for their instruction set with target
+// attributes, the rest of the library keeps the baseline of the abi
+#define SSE4_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/// 8 bytes into the low half of a vector
+static __m128i load_low_64(const uint8_t* bytes) {
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes));
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+SSE4_TARGET static void
+sse4_scale_offset(std::span<float> values, float scale, float offset) {
+	float* data = values.data();
+	const size_t size = values.size();
+	const __m128 scales = _mm_set1_ps(scale);
+	const __m128 offsets = _mm_set1_ps(offset);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128 value = _mm_loadu_ps(data + i);
+		_mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(value, scales), offsets));
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale + offset;
+}
+
+SSE4_TARGET static void sse4_scale_offset_rgb(
+	std::span<float> values,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	float* data = values.data();
+	const size_t size = values.size() - values.size() % 3;
+	// 4 pixels are 3 vectors, the channel pattern rotates between them
+	const __m128 scale_0 = _mm_setr_ps(scale[0], scale[1], scale[2], scale[0]);
+	const __m128 scale_1 = _mm_setr_ps(scale[1], scale[2], scale[0], scale[1]);
+	const __m128 scale_2 = _mm_setr_ps(scale[2], scale[0], scale[1], scale[2]);
+	const __m128 offset_0 =
+		_mm_setr_ps(offset[0], offset[1], offset[2], offset[0]);
+	const __m128 offset_1 =
+		_mm_setr_ps(offset[1], offset[2], offset[0], offset[1]);
+	const __m128 offset_2 =
+		_mm_setr_ps(offset[2], offset[0], offset[1], offset[2]);
+	size_t i = 0;
+	for (; i + 12 <= size; i += 12) {
+		const __m128 value_0 = _mm_loadu_ps(data + i);
+		const __m128 value_1 = _mm_loadu_ps(data + i + 4);
+		const __m128 value_2 = _mm_loadu_ps(data + i + 8);
+		_mm_storeu_ps(
+			data + i, _mm_add_ps(_mm_mul_ps(value_0, scale_0), offset_0)
+		);
+		_mm_storeu_ps(
+			data + i + 4, _mm_add_ps(_mm_mul_ps(value_1, scale_1), offset_1)
+		);
+		_mm_storeu_ps(
+			data + i + 8, _mm_add_ps(_mm_mul_ps(value_2, scale_2), offset_2)
+		);
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale[i % 3] + offset[i % 3];
+}
+
+SSE4_TARGET static FloatRange sse4_min_max(std::span<const float> values) {
+	const float* data = values.data();
+	const size_t size = values.size();
+	__m128 min = _mm_set1_ps(data[0]);
+	__m128 max = min;
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const __m128 value = _mm_loadu_ps(data + i);
+		min = _mm_min_ps(value, min);
+		max = _mm_max_ps(value, max);
+	}
+	std::array<float, 4> mins{};
+	std::array<float, 4> maxs{};
+	_mm_storeu_ps(mins.data(), min);
+	_mm_storeu_ps(maxs.data(), max);
+	FloatRange range{.min = mins[0], .max = maxs[0]};
+	for (size_t lane = 1; lane < 4; lane++) {
+		range.min = mins[lane] < range.min ? mins[lane] : range.min;
+		range.max = maxs[lane] > range.max ? maxs[lane] : range.max;
+	}
+	for (; i < size; i++) {
+		range.min = data[i] < range.min ? data[i] : range.min;
+		range.max = data[i] > range.max ? data[i] : range.max;
+	}
+	return range;
+}
+
+SSE4_TARGET static void sse4_rgba_to_rgb(
+	std::span<const uint8_t> pixels,
+	std::span<float> rgb,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	const uint8_t* source = pixels.data();
+	float* destination = rgb.data();
+	const size_t pixel_count = rgb.size() / 3;
+	const __m128 scales = _mm_setr_ps(scale[0], scale[1], scale[2], 0.0f);
+	const __m128 offsets = _mm_setr_ps(offset[0], offset[1], offset[2], 0.0f);
+	// r, g, b, a of a pixel widened to the 4 lanes. the stores overlap, the
+	// fourth lane is overwritten by the next pixel, so the last pixel is
+	// converted separately
+	size_t i = 0;
+	for (; i + 1 < pixel_count; i++) {
+		int32_t word = 0;
+		std::memcpy(&word, source + 4 * i, sizeof(word));
+		const __m128 value =
+			_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(word)));
+		_mm_storeu_ps(
+			destination + 3 * i, _mm_add_ps(_mm_mul_ps(value, scales), offsets)
+		);
+	}
+	for (; i < pixel_count; i++) {
+		for (size_t channel = 0; channel < 3; channel++) {
+			destination[3 * i + channel] =
+				(float)source[4 * i + channel] * scale[channel] +
+				offset[channel];
+		}
+	}
+}
+
+SSE4_TARGET static void sse4_dequantize_uint8(
+	std::span<const uint8_t> quantized_values,
+	std::span<float> real_values,
+	float scale,
+	int32_t zero_point
+) {
+	const uint8_t* source = quantized_values.data();
+	float* destination = real_values.data();
+	const size_t size = real_values.size();
+	const __m128 scales = _mm_set1_ps(scale);
+	const __m128i zero_points = _mm_set1_epi32(zero_point);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		int32_t word = 0;
+		std::memcpy(&word, source + i, sizeof(word));
+		const __m128i value = _mm_sub_epi32(
+			_mm_cvtepu8_epi32(_mm_cvtsi32_si128(word)), zero_points
+		);
+		_mm_storeu_ps(
+			destination + i, _mm_mul_ps(scales, _mm_cvtepi32_ps(value))
+		);
+	}
+	for (; i < size; i++)
+		destination[i] = scale * (float)((int32_t)source[i] - zero_point);
+}
+
+AVX2_TARGET static void
+avx2_scale_offset(std::span<float> values, float scale, float offset) {
+	float* data = values.data();
+	const size_t size = values.size();
+	const __m256 scales = _mm256_set1_ps(scale);
+	const __m256 offsets = _mm256_set1_ps(offset);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256 value = _mm256_loadu_ps(data + i);
+		_mm256_storeu_ps(
+			data + i, _mm256_add_ps(_mm256_mul_ps(value, scales), offsets)
+		);
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale + offset;
+}
+
+AVX2_TARGET static void avx2_scale_offset_rgb(
+	std::span<float> values,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	float* data = values.data();
+	const size_t size = values.size() - values.size() % 3;
+	// 8 pixels are 3 vectors, the channel pattern rotates between them
+	std::array<float, 24> pattern_scale{};
+	std::array<float, 24> pattern_offset{};
+	for (size_t lane = 0; lane < 24; lane++) {
+		pattern_scale[lane] = scale[lane % 3];
+		pattern_offset[lane] = offset[lane % 3];
+	}
+	const __m256 scale_0 = _mm256_loadu_ps(pattern_scale.data());
+	const __m256 scale_1 = _mm256_loadu_ps(pattern_scale.data() + 8);
+	const __m256 scale_2 = _mm256_loadu_ps(pattern_scale.data() + 16);
+	const __m256 offset_0 = _mm256_loadu_ps(pattern_offset.data());
+	const __m256 offset_1 = _mm256_loadu_ps(pattern_offset.data() + 8);
+	const __m256 offset_2 = _mm256_loadu_ps(pattern_offset.data() + 16);
+	size_t i = 0;
+	for (; i + 24 <= size; i += 24) {
+		const __m256 value_0 = _mm256_loadu_ps(data + i);
+		const __m256 value_1 = _mm256_loadu_ps(data + i + 8);
+		const __m256 value_2 = _mm256_loadu_ps(data + i + 16);
+		_mm256_storeu_ps(
+			data + i, _mm256_add_ps(_mm256_mul_ps(value_0, scale_0), offset_0)
+		);
+		_mm256_storeu_ps(
+			data + i + 8,
+			_mm256_add_ps(_mm256_mul_ps(value_1, scale_1), offset_1)
+		);
+		_mm256_storeu_ps(
+			data + i + 16,
+			_mm256_add_ps(_mm256_mul_ps(value_2, scale_2), offset_2)
+		);
+	}
+	for (; i < size; i++)
+		data[i] = data[i] * scale[i % 3] + offset[i % 3];
+}
+
+AVX2_TARGET static FloatRange avx2_min_max(std::span<const float> values) {
+	const float* data = values.data();
+	const size_t size = values.size();
+	__m256 min = _mm256_set1_ps(data[0]);
+	__m256 max = min;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256 value = _mm256_loadu_ps(data + i);
+		min = _mm256_min_ps(value, min);
+		max = _mm256_max_ps(value, max);
+	}
+	std::array<float, 8> mins{};
+	std::array<float, 8> maxs{};
+	_mm256_storeu_ps(mins.data(), min);
+	_mm256_storeu_ps(maxs.data(), max);
+	FloatRange range{.min = mins[0], .max = maxs[0]};
+	for (size_t lane = 1; lane < 8; lane++) {
+		range.min = mins[lane] < range.min ? mins[lane] : range.min;
+		range.max = maxs[lane] > range.max ? maxs[lane] : range.max;
+	}
+	for (; i < size; i++) {
+		range.min = data[i] < range.min ? data[i] : range.min;
+		range.max = data[i] > range.max ? data[i] : range.max;
+	}
+	return range;
+}
+
+AVX2_TARGET static void avx2_rgba_to_rgb(
+	std::span<const uint8_t> pixels,
+	std::span<float> rgb,
+	const std::array<float, 3>& scale,
+	const std::array<float, 3>& offset
+) {
+	const uint8_t* source = pixels.data();
+	float* destination = rgb.data();
+	const size_t pixel_count = rgb.size() / 3;
+	const __m256 scales = _mm256_setr_ps(
+		scale[0], scale[1], scale[2], 0.0f, scale[0], scale[1], scale[2], 0.0f
+	);
+	const __m256 offsets = _mm256_setr_ps(
+		offset[0], offset[1], offset[2], 0.0f, offset[0], offset[1], offset[2],
+		0.0f
+	);
+	// drops the alpha lanes, the two last lanes are overwritten by the next
+	// pair of pixels
+	const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+	size_t i = 0;
+	for (; i + 3 <= pixel_count; i += 2) {
+		const __m256 value = _mm256_cvtepi32_ps(
+			_mm256_cvtepu8_epi32(load_low_64(source + 4 * i))
+		);
+		const __m256 scaled =
+			_mm256_add_ps(_mm256_mul_ps(value, scales), offsets);
+		_mm256_storeu_ps(
+			destination + 3 * i, _mm256_permutevar8x32_ps(scaled, compact)
+		);
+	}
+	for (; i < pixel_count; i++) {
+		for (size_t channel = 0; channel < 3; channel++) {
+			destination[3 * i + channel] =
+				(float)source[4 * i + channel] * scale[channel] +
+				offset[channel];
+		}
+	}
+}
+
+AVX2_TARGET static void avx2_dequantize_uint8(
+	std::span<const uint8_t> quantized_values,
+	std::span<float> real_values,
+	float scale,
+	int32_t zero_point
+) {
+	const uint8_t* source = quantized_values.data();
+	float* destination = real_values.data();
+	const size_t size = real_values.size();
+	const __m256 scales = _mm256_set1_ps(scale);
+	const __m256i zero_points = _mm256_set1_epi32(zero_point);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m256i value = _mm256_sub_epi32(
+			_mm256_cvtepu8_epi32(load_low_64(source + i)), zero_points
+		);
+		_mm256_storeu_ps(
+			destination + i, _mm256_mul_ps(scales, _mm256_cvtepi32_ps(value))
+		);
+	}
+	for (; i < size; i++)
+		destination[i] = scale * (float)((int32_t)source[i] - zero_point);
+}
+
+const SimdKernels SSE4_KERNELS = {
+	.name = "sse4.1",
+	.scale_offset = sse4_scale_offset,
+	.scale_offset_rgb = sse4_scale_offset_rgb,
+	.min_max = sse4_min_max,
+	.rgba_to_rgb = sse4_rgba_to_rgb,
+	.dequantize_uint8 = sse4_dequantize_uint8,
+};
+
+const SimdKernels AVX2_KERNELS = {
+	.name = "avx2",
+	.scale_offset = avx2_scale_offset,
+	.scale_offset_rgb = avx2_scale_offset_rgb,
+	.min_max = avx2_min_max,
+	.rgba_to_rgb = avx2_rgba_to_rgb,
+	.dequantize_uint8 = avx2_dequantize_uint8,
+};
+#endif
\ No newline at end of file
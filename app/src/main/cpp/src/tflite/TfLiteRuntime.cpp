@@ -4,6 +4,7 @@
 
 #include "tflite/c/common.h"
 #include <cassert>
+#include <format>
 
 static void
 tflite_error_callback(void* /*user_data*/, const char* format, va_list args);
@@ -13,24 +14,45 @@ tflite_error_callback(void* /*user_data*/, const char* format, va_list args);
 TfLiteRuntime::TfLiteRuntime(
 	std::span<const int8_t> model_data,
 	std::string_view gpu_delegate_serialization_dir,
-	std::string_view model_token
+	std::string_view model_token,
+	TfLiteRuntimeOptions options
 )
-	: model(nullptr), interpreter(nullptr), interpreter_options(nullptr),
-	  gpu_delegate(nullptr) {
+	: model_buffer(model_data.begin(), model_data.end()), model(nullptr),
+	  interpreter(nullptr), interpreter_options(nullptr),
+	  gpu_delegate(nullptr), model_token(model_token) {
 
 	PROFILE_DEPTH_SCOPE("Initialize TfLiteRuntime")
 
-	model = TfLiteModelCreate(model_data.data(), model_data.size());
+	model_memory = TrackedMemory(
+		get_depth_profiling_frame().memory(),
+		std::format("TfLiteRuntime ({}): model", model_token),
+		model_buffer.size()
+	);
+
+	const ResidentMemoryDelta tensor_arena_delta;
+
+	model = TfLiteModelCreate(model_buffer.data(), model_buffer.size());
 
 	interpreter_options = TfLiteInterpreterOptionsCreate();
 	TfLiteInterpreterOptionsSetErrorReporter(
 		interpreter_options, tflite_error_callback, nullptr
 	);
-	TfLiteInterpreterOptionsSetNumThreads(interpreter_options, 4);
+	TfLiteInterpreterOptionsSetNumThreads(
+		interpreter_options, options.thread_count
+	);
 
-	gpu_delegate =
-		create_gpu_delegate(gpu_delegate_serialization_dir, model_token);
-	TfLiteInterpreterOptionsAddDelegate(interpreter_options, gpu_delegate);
+#ifdef __ANDROID__
+	if (options.use_gpu_delegate) {
+		gpu_delegate = create_gpu_delegate(
+			gpu_delegate_serialization_dir, model_token,
+			options.allow_precision_loss
+		);
+		if (gpu_delegate != nullptr)
+			TfLiteInterpreterOptionsAddDelegate(
+				interpreter_options, gpu_delegate
+			);
+	}
+#endif
 
 	interpreter = TfLiteInterpreterCreate(model, interpreter_options);
 
@@ -38,6 +60,19 @@ TfLiteRuntime::TfLiteRuntime(
 		TfLiteInterpreterAllocateTensors(interpreter),
 		"failed to allocate tensors"
 	);
+
+	tensor_arena_memory = TrackedMemory(
+		get_depth_profiling_frame().memory(),
+		std::format("TfLiteRuntime ({}): tensor arena", model_token),
+		tensor_arena_delta.finish()
+	);
+
+	const auto* input_tensor = TfLiteInterpreterGetInputTensor(interpreter, 0);
+	input_dims.resize(TfLiteTensorNumDims(input_tensor));
+	for (size_t i = 0; i < input_dims.size(); i++)
+		input_dims[i] = TfLiteTensorDim(input_tensor, (int32_t)i);
+	if (!input_dims.empty())
+		batch_size = (size_t)input_dims[0];
 }
 // NOLINTEND(modernize-use-default-member-init,
 // cppcoreguidelines-prefer-member-initializer)
@@ -46,12 +81,46 @@ TfLiteRuntime::~TfLiteRuntime() {
 	PROFILE_DEPTH_SCOPE("Shutdown TfLiteRuntime")
 
 	TfLiteInterpreterDelete(interpreter);
+#ifdef __ANDROID__
 	if (gpu_delegate != nullptr)
 		TfLiteGpuDelegateV2Delete(gpu_delegate);
+#endif
 	TfLiteInterpreterOptionsDelete(interpreter_options);
 	TfLiteModelDelete(model);
 }
 
+void TfLiteRuntime::resize_batch(size_t new_batch_size) {
+	if (new_batch_size == batch_size || input_dims.empty())
+		return;
+
+	PROFILE_DEPTH_FUNCTION()
+
+	const ResidentMemoryDelta tensor_arena_delta;
+
+	auto dims = input_dims;
+	dims[0] = (int)new_batch_size;
+	throw_on_tflite_status(
+		TfLiteInterpreterResizeInputTensor(
+			interpreter, 0, dims.data(), (int32_t)dims.size()
+		),
+		"failed to resize input tensor"
+	);
+	throw_on_tflite_status(
+		TfLiteInterpreterAllocateTensors(interpreter),
+		"failed to allocate tensors"
+	);
+	batch_size = new_batch_size;
+
+	// larger batches need a larger arena
+	const size_t growth = tensor_arena_delta.finish();
+	if (growth > 0)
+		tensor_arena_memory = TrackedMemory(
+			get_depth_profiling_frame().memory(),
+			std::format("TfLiteRuntime ({}): tensor arena", model_token),
+			tensor_arena_memory.size() + growth
+		);
+}
+
 void TfLiteRuntime::load_nonquantized_input(
 	std::span<const std::byte> input_bytes,
 	TfLiteTensor* input_tensor,
@@ -68,6 +137,29 @@ void TfLiteRuntime::load_nonquantized_input(
 	);
 }
 
+std::span<const float> TfLiteRuntime::output_view() {
+	const auto* output_tensor = TfLiteInterpreterGetOutputTensor(interpreter, 0);
+
+	if (output_tensor->type == kTfLiteFloat32) {
+		const void* data = TfLiteTensorData(output_tensor);
+		if (data == nullptr)
+			throw TensorNotYetCreatedException();
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		return {
+			reinterpret_cast<const float*>(data),
+			TfLiteTensorByteSize(output_tensor) / sizeof(float)
+		};
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	}
+
+	size_t element_count = 1;
+	for (int32_t i = 0; i < TfLiteTensorNumDims(output_tensor); i++)
+		element_count *= (size_t)TfLiteTensorDim(output_tensor, i);
+	converted_output.resize(element_count);
+	read_output<float>(converted_output);
+	return converted_output;
+}
+
 void TfLiteRuntime::read_nonquantized_output(
 	std::span<std::byte> output_bytes,
 	const TfLiteTensor* output_tensor,
@@ -7,22 +7,49 @@
 #include "utils/Profiling.hpp"
 #include <cassert>
 #include <span>
+#include <string>
 #include <string_view>
+#include <vector>
+
+struct TfLiteRuntimeOptions {
+	/// the cpu is used if disabled or if gpu delegates are not supported on
+	/// this device (always disabled on host builds)
+	bool use_gpu_delegate = true;
+	/// lets the gpu delegate compute in fp16
+	bool allow_precision_loss = true;
+	int thread_count = 4;
+};
 
 /** Helper class that wraps the tflite c api */
 class TfLiteRuntime {
   private:
+	/// tflite requires the model buffer to outlive the model and interpreter
+	std::vector<int8_t> model_buffer;
 	TfLiteModel* model = nullptr;
 	TfLiteInterpreter* interpreter = nullptr;
 	TfLiteInterpreterOptions* interpreter_options = nullptr;
 	/// can be null if GPU delegates are not supported on this device
 	TfLiteDelegate* gpu_delegate = nullptr;
 
+	TrackedMemory model_memory;
+	/// resident memory growth during interpreter creation and tensor
+	/// allocation (tensor arena + delegate buffers)
+	TrackedMemory tensor_arena_memory;
+
+	std::string model_token;
+	/// input tensor shape of the model, the first dimension is the batch
+	std::vector<int> input_dims;
+	size_t batch_size = 1;
+	/// converted output of run_inference_in_place for outputs that are not
+	/// float
+	std::vector<float> converted_output;
+
   public:
 	explicit TfLiteRuntime(
 		std::span<const int8_t> model_data,
 		std::string_view gpu_delegate_serialization_dir,
-		std::string_view model_token
+		std::string_view model_token,
+		TfLiteRuntimeOptions options = {}
 	);
 	~TfLiteRuntime();
 
@@ -33,8 +60,20 @@ class TfLiteRuntime {
 
 	template<typename I, typename O>
 	void run_inference(std::span<const I> input, std::span<O> output) {
+		run_batch_inference<I, O>(input, output, 1);
+	}
+
+	/// runs new_batch_size inputs (stored after each other) in a single
+	/// invoke, the input tensor is resized when the batch size changes
+	template<typename I, typename O>
+	void run_batch_inference(
+		std::span<const I> input,
+		std::span<O> output,
+		size_t new_batch_size
+	) {
 		PROFILE_DEPTH_FUNCTION()
 
+		resize_batch(new_batch_size);
 		load_input<I>(input);
 		{
 			PROFILE_DEPTH_SCOPE("Invoking of model")
@@ -47,7 +86,33 @@ class TfLiteRuntime {
 		read_output<O>(output);
 	}
 
+	/// runs a single input and returns the output tensor without copying it,
+	/// valid until the next run. outputs that are not float are converted into
+	/// a buffer of the runtime
+	template<typename I>
+	std::span<const float> run_inference_in_place(std::span<const I> input) {
+		PROFILE_DEPTH_FUNCTION()
+
+		resize_batch(1);
+		load_input<I>(input);
+		{
+			PROFILE_DEPTH_SCOPE("Invoking of model")
+
+			throw_on_tflite_status(
+				TfLiteInterpreterInvoke(interpreter),
+				"failed to invoke interpreter"
+			);
+		}
+		return output_view();
+	}
+
   private:
+	std::span<const float> output_view();
+
+	/// resizes the batch dimension (the first one) of the input tensor and
+	/// reallocates the tensors, does nothing if the size didn't change
+	void resize_batch(size_t new_batch_size);
+
 	template<typename I>
 	void load_input(std::span<const I> input) {
 		PROFILE_DEPTH_SCOPE("Loading input")
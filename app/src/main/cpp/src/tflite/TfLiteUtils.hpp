@@ -1,5 +1,6 @@
 #pragma once
 
+#include "simd/SimdKernels.hpp"
 #include "utils/Log.hpp"
 #include "utils/Profiling.hpp"
 #include <cassert>
@@ -95,13 +96,15 @@ inline static void dequantize(
 
 inline static TfLiteDelegate* create_gpu_delegate(
 	std::string_view gpu_delegate_serialization_dir,
-	std::string_view model_token
+	std::string_view model_token,
+	bool allow_precision_loss
 ) {
 	PROFILE_DEPTH_FUNCTION()
 
 	TfLiteGpuDelegateOptionsV2 gpu_delegate_options =
 		TfLiteGpuDelegateOptionsV2Default();
-	gpu_delegate_options.is_precision_loss_allowed = (int32_t)true;
+	gpu_delegate_options.is_precision_loss_allowed =
+		(int32_t)allow_precision_loss;
 	gpu_delegate_options.inference_preference =
 		TFLITE_GPU_INFERENCE_PREFERENCE_FAST_SINGLE_ANSWER;
 	gpu_delegate_options.experimental_flags |= TfLiteGpuExperimentalFlags::
@@ -167,12 +170,14 @@ void dequantize<float>(
 		throw UnsupportedAsymmetricQuantizationException();
 	const int quantization_zero_point = quantization.zero_point->data[0];
 
-	for (size_t i = 0; i < real_values.size(); i++) {
-		static_assert(sizeof(std::byte) == sizeof(uint8_t));
-		const auto quantized = (const uint8_t)quantized_values[i];
-		real_values[i] =
-			quantization_scale * (float)(quantized - quantization_zero_point);
-	}
+	static_assert(sizeof(std::byte) == sizeof(uint8_t));
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	simd_kernels().dequantize_uint8(
+		{reinterpret_cast<const uint8_t*>(quantized_values.data()),
+		 quantized_values.size()},
+		real_values, quantization_scale, quantization_zero_point
+	);
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
 }
 
 template<typename T>
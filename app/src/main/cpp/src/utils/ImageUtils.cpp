@@ -1,9 +1,72 @@
 #include "ImageUtils.hpp"
 #include "Exceptions.hpp"
 #include "Log.hpp"
+#include "PixelConversion.hpp"
 #include "Profiling.hpp"
 #include <cstddef>
+#include <stdexcept>
 
+/// the ints reinterpreted as the bitmap memory they were read from, one row
+static RgbaImageView int_pixels_view(std::span<const int> pixels) {
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	return {
+		.pixels = {reinterpret_cast<const uint8_t*>(pixels.data()),
+				   pixels.size_bytes()},
+		.width = pixels.size(),
+		.height = 1,
+		.stride = pixels.size_bytes(),
+	};
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+void rgba_pixels_to_rgb_hwc_255_float_array(
+	std::span<const int> pixels,
+	std::span<float> out_float_array
+) {
+	PROFILE_CAMERA_FUNCTION()
+
+	if (out_float_array.size() != pixels.size() * 3)
+		throw std::invalid_argument("out_float_array");
+
+	convert_pixels<PixelFormat::Rgba, ImageLayout::Hwc>(
+		int_pixels_view(pixels), out_float_array
+	);
+}
+
+void rgba_pixels_to_rgb_chw_float_array(
+	std::span<const int> pixels,
+	std::span<float> out_float_array
+) {
+	PROFILE_CAMERA_FUNCTION()
+
+	if (out_float_array.size() != pixels.size() * 3)
+		throw std::invalid_argument("out_float_array");
+
+	convert_pixels<PixelFormat::Rgba, ImageLayout::Chw>(
+		int_pixels_view(pixels), out_float_array,
+		ChannelScaling::normalized(1.0f)
+	);
+}
+
+void image_bytes_to_argb_int_array(
+	const std::span<const int8_t> image_bytes,
+	std::span<int32_t> out_pixels
+) {
+	PROFILE_CAMERA_FUNCTION()
+
+	if (image_bytes.size_bytes() != out_pixels.size_bytes())
+		throw std::invalid_argument("out_pixels");
+
+	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+	packed_pixels_to_argb<PixelFormat::Rgba>(
+		{reinterpret_cast<const uint8_t*>(image_bytes.data()),
+		 image_bytes.size()},
+		out_pixels
+	);
+	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+#ifdef __ANDROID__
 void check_android_bitmap_result(int result) {
 	if (result == ANDROID_BITMAP_RESULT_SUCCESS)
 		return;
@@ -24,115 +87,58 @@ void check_android_bitmap_result(int result) {
 	}
 }
 
-void bitmap_to_rgb_hwc_255_float_array(
-	JNIEnv* env,
-	jobject bitmap,
-	std::span<float> out_float_array
-) {
-	PROFILE_CAMERA_FUNCTION()
-
+AndroidBitmapPixels::AndroidBitmapPixels(JNIEnv* env, jobject bitmap)
+	: env(env), bitmap(bitmap) {
 	AndroidBitmapInfo info;
 	check_android_bitmap_result(AndroidBitmap_getInfo(env, bitmap, &info));
-
 	if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888)
 		throw FormatNotRGBA888Exception(info.format);
 
-	if (out_float_array.size() != (size_t)info.width * (size_t)info.height * 3)
-		throw std::invalid_argument("out_float_array");
-
 	void* address_ptr = nullptr;
 	check_android_bitmap_result(
 		AndroidBitmap_lockPixels(env, bitmap, &address_ptr)
 	);
 	if (address_ptr == nullptr)
 		throw FailedToLockPixelsException();
-	// RGBA 8888 -> one int for each pixel, lint supression needed because of c
-	// api
+
 	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
-	const auto pixel_ptr = std::span<int>(
-		reinterpret_cast<int*>(address_ptr),
-		(size_t)info.width * (size_t)info.height
-	);
+	locked_image = MutableRgbaImageView{
+		.pixels = {reinterpret_cast<uint8_t*>(address_ptr),
+				   (size_t)info.stride * (size_t)info.height},
+		.width = info.width,
+		.height = info.height,
+		.stride = info.stride,
+	};
 	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+}
 
-	size_t i = 0;
-	size_t j = 0;
-	for (; i < (size_t)info.width * (size_t)info.height; i++) {
-		const int pixel_color = pixel_ptr[i];
-		out_float_array[j++] = (float)red_channel_from_argb_color(pixel_color);
-		out_float_array[j++] =
-			(float)green_channel_from_argb_color(pixel_color);
-		out_float_array[j++] = (float)blue_channel_from_argb_color(pixel_color);
-	}
-
+AndroidBitmapPixels::~AndroidBitmapPixels() noexcept {
 	check_android_bitmap_result(AndroidBitmap_unlockPixels(env, bitmap));
 }
 
-void bitmap_to_rgb_chw_float_array(
+void bitmap_to_rgb_hwc_255_float_array(
 	JNIEnv* env,
 	jobject bitmap,
 	std::span<float> out_float_array
 ) {
 	PROFILE_CAMERA_FUNCTION()
 
-	AndroidBitmapInfo info;
-	check_android_bitmap_result(AndroidBitmap_getInfo(env, bitmap, &info));
-
-	if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888)
-		throw FormatNotRGBA888Exception(info.format);
-
-	if (out_float_array.size() != (size_t)info.width * (size_t)info.height * 3)
-		throw std::invalid_argument("out_float_array");
-
-	void* address_ptr = nullptr;
-	check_android_bitmap_result(
-		AndroidBitmap_lockPixels(env, bitmap, &address_ptr)
+	const AndroidBitmapPixels pixels(env, bitmap);
+	convert_pixels<PixelFormat::Rgba, ImageLayout::Hwc>(
+		pixels.image(), out_float_array
 	);
-	if (address_ptr == nullptr)
-		throw FailedToLockPixelsException();
-	// RGBA 8888 -> one int for each pixel
-	// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
-	const auto int_pixels = std::span<int>(
-		reinterpret_cast<int*>(address_ptr),
-		(size_t)info.width * (size_t)info.height
-	);
-	// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
-
-	const size_t red_channel_offset = 0;
-	const size_t green_channel_offset =
-		(size_t)info.width * (size_t)info.height;
-	const size_t blue_channel_offset =
-		2 * (size_t)info.width * (size_t)info.height;
-
-	for (size_t i = 0; i < (size_t)info.width * (size_t)info.height; i++) {
-		const int pixel_color = int_pixels[i];
-		out_float_array[red_channel_offset + i] =
-			(float)red_channel_from_argb_color(pixel_color) / 255.f;
-		out_float_array[green_channel_offset + i] =
-			(float)green_channel_from_argb_color(pixel_color) / 255.f;
-		out_float_array[blue_channel_offset + i] =
-			(float)blue_channel_from_argb_color(pixel_color) / 255.f;
-	}
-
-	check_android_bitmap_result(AndroidBitmap_unlockPixels(env, bitmap));
 }
 
-void image_bytes_to_argb_int_array(
-	const std::span<const jbyte> image_bytes,
-	std::span<jint> out_pixels
+void bitmap_to_rgb_chw_float_array(
+	JNIEnv* env,
+	jobject bitmap,
+	std::span<float> out_float_array
 ) {
 	PROFILE_CAMERA_FUNCTION()
 
-	if (image_bytes.size_bytes() != out_pixels.size_bytes())
-		throw std::invalid_argument("out_pixels");
-
-	size_t i = 0;
-	size_t j = 0;
-	for (; i < out_pixels.size(); i++) {
-		auto r = image_bytes[j++];
-		auto g = image_bytes[j++];
-		auto b = image_bytes[j++];
-		auto a = image_bytes[j++];
-		out_pixels[i] = color_argb(a, r, g, b);
-	}
-}
\ No newline at end of file
+	const AndroidBitmapPixels pixels(env, bitmap);
+	convert_pixels<PixelFormat::Rgba, ImageLayout::Chw>(
+		pixels.image(), out_float_array, ChannelScaling::normalized(1.0f)
+	);
+}
+#endif
\ No newline at end of file
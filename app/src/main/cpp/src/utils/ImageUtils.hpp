@@ -1,8 +1,23 @@
 #pragma once
 
-#include <android/bitmap.h>
+#include <cstddef>
+#include <cstdint>
 #include <span>
 
+#ifdef __ANDROID__
+#include <android/bitmap.h>
+#endif
+
+constexpr size_t RGB_CHANNELS = 3;
+
+/// memory layout of rgb model inputs
+enum class ImageLayout {
+	/// interleaved (r, g, b, r, g, b, ...), used by the tflite models
+	Hwc,
+	/// planar (all r, then all g, then all b), used by the onnx models
+	Chw,
+};
+
 /// argb 8888 formatted
 constexpr int color_argb(int a, int r, int g, int b) {
 	return (a << 24) | (r << 16) | (g << 8) | b;
@@ -21,8 +36,78 @@ constexpr int green_channel_from_argb_color(int color) {
 }
 constexpr int blue_channel_from_argb_color(int color) { return color & 255; }
 
+/// rgba 8888 image (android bitmap memory layout: r, g, b, a bytes)
+struct RgbaImageView {
+	std::span<const uint8_t> pixels;
+	size_t width = 0;
+	size_t height = 0;
+	/// bytes per row, at least 4 * width
+	size_t stride = 0;
+};
+
+/// writable RgbaImageView
+struct MutableRgbaImageView {
+	std::span<uint8_t> pixels;
+	size_t width = 0;
+	size_t height = 0;
+	size_t stride = 0;
+
+	explicit(false) operator RgbaImageView() const {
+		return {
+			.pixels = pixels,
+			.width = width,
+			.height = height,
+			.stride = stride,
+		};
+	}
+};
+
+/// converts rgba 8888 pixels (one int for each pixel, the bitmap memory
+/// reinterpreted) into float array with (height, width, channel) shape and 3
+/// rgb-channels each in the range of 0.0f to 255.0f
+void rgba_pixels_to_rgb_hwc_255_float_array(
+	std::span<const int> pixels,
+	std::span<float> out_float_array
+);
+
+/// converts rgba 8888 pixels (one int for each pixel, the bitmap memory
+/// reinterpreted) into float array with (channel, height, width) shape and 3
+/// rgb-channels each in the range of 0.0f to 1.0f
+void rgba_pixels_to_rgb_chw_float_array(
+	std::span<const int> pixels,
+	std::span<float> out_float_array
+);
+
+/// image_bytes should have 4 bytes (r, g, b, a) for each pixel, out_pixels
+/// gets argb ints
+void image_bytes_to_argb_int_array(
+	std::span<const int8_t> image_bytes,
+	std::span<int32_t> out_pixels
+);
+
+#ifdef __ANDROID__
 void check_android_bitmap_result(int result);
 
+/// locks the pixels of an RGBA_8888 bitmap for its lifetime
+class AndroidBitmapPixels {
+  public:
+	/// throws FormatNotRGBA888Exception / FailedToLockPixelsException
+	AndroidBitmapPixels(JNIEnv* env, jobject bitmap);
+	~AndroidBitmapPixels() noexcept;
+
+	AndroidBitmapPixels(const AndroidBitmapPixels&) = delete;
+	AndroidBitmapPixels(AndroidBitmapPixels&&) = delete;
+	void operator=(const AndroidBitmapPixels&) = delete;
+	void operator=(AndroidBitmapPixels&&) = delete;
+
+	[[nodiscard]] MutableRgbaImageView image() const { return locked_image; }
+
+  private:
+	JNIEnv* env;
+	jobject bitmap;
+	MutableRgbaImageView locked_image;
+};
+
 /// converts pixel from bitmap into float array with (height, width, channel)
 /// shape and 3 rgb-channels each in the range of 0.0f to 255.0f
 /// often the right format for use with tflite models
@@ -40,9 +125,4 @@ void bitmap_to_rgb_chw_float_array(
 	jobject bitmap,
 	std::span<float> out_float_array
 );
-
-/// image_bytes should have 4 bytes (4 argb channels) for each pixel
-void image_bytes_to_argb_int_array(
-	std::span<const jbyte> image_bytes,
-	std::span<jint> out_pixels
-);
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "Log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <semaphore>
+#include <thread>
+
+#ifndef __ANDROID__
+#include <cstdio>
+#endif
+
+/// longer messages get truncated
+constexpr size_t LOG_MESSAGE_CAPACITY = 512;
+/// number of messages that can be queued, messages are dropped if the log
+/// thread can't keep up
+constexpr size_t LOG_QUEUE_CAPACITY = 128;
+/// repeats of the same message are collapsed into a single "repeated n times"
+/// line, at the latest after this delay
+constexpr auto LOG_REPEAT_FLUSH_DELAY = std::chrono::seconds(1);
+
+using log_clock = std::chrono::steady_clock;
+
+/// head of the list of all call sites that logged at least once
+static std::atomic<LogCallSite*> log_call_sites = nullptr;
+
+LogCallSite::LogCallSite(const char* file, uint32_t line) noexcept
+	: file(file), line(line) {
+	next = log_call_sites.load(std::memory_order_relaxed);
+	while (!log_call_sites.compare_exchange_weak(
+		next, this, std::memory_order_release, std::memory_order_relaxed
+	)) {
+	}
+}
+
+static int64_t log_clock_ms() noexcept {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+			   log_clock::now().time_since_epoch()
+	)
+		.count();
+}
+
+/// wakes the log thread to report a burst of dropped messages once it ended
+static void notify_suppressed_burst() noexcept;
+
+bool acquire_log_rate_limit(LogCallSite& site, uint32_t& suppressed_count
+) noexcept {
+	const int64_t now_ms = log_clock_ms();
+	int64_t window_start_ms =
+		site.window_start_ms.load(std::memory_order_relaxed);
+	if (now_ms - window_start_ms >= 1000 &&
+		site.window_start_ms.compare_exchange_strong(window_start_ms, now_ms))
+		site.window_message_count.store(0, std::memory_order_relaxed);
+
+	if (site.window_message_count.fetch_add(1, std::memory_order_relaxed) >=
+		LOG_CALL_SITE_MESSAGES_PER_SECOND) {
+		if (site.suppressed_count.fetch_add(1, std::memory_order_relaxed) == 0)
+			notify_suppressed_burst();
+		return false;
+	}
+	suppressed_count = site.suppressed_count.exchange(0);
+	return true;
+}
+
+struct LogRecord {
+	int priority = ANDROID_LOG_INFO;
+	uint32_t suppressed_count = 0;
+	size_t length = 0;
+	// one extra byte for the null terminator that the log thread adds
+	std::array<char, LOG_MESSAGE_CAPACITY + 1> message{};
+
+	[[nodiscard]] std::string_view view() const {
+		return {message.data(), length};
+	}
+};
+
+/// bounded multi producer queue (Vyukov), each slot has a sequence number
+/// that tells producers and the consumer whose turn it is
+class LogQueue {
+  public:
+	LogQueue() {
+		for (size_t i = 0; i < LOG_QUEUE_CAPACITY; i++)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool try_push(
+		int priority,
+		std::string_view message,
+		uint32_t suppressed_count
+	) noexcept {
+		size_t position = enqueue_position.load(std::memory_order_relaxed);
+		Slot* slot = nullptr;
+		while (true) {
+			slot = &slots[position % LOG_QUEUE_CAPACITY];
+			const size_t sequence =
+				slot->sequence.load(std::memory_order_acquire);
+			const auto difference = (intptr_t)sequence - (intptr_t)position;
+			if (difference == 0) {
+				if (enqueue_position.compare_exchange_weak(
+						position, position + 1, std::memory_order_relaxed
+					))
+					break;
+			} else if (difference < 0) {
+				return false; // full
+			} else {
+				position = enqueue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		auto& record = slot->record;
+		record.priority = priority;
+		record.suppressed_count = suppressed_count;
+		record.length = std::min(message.size(), LOG_MESSAGE_CAPACITY);
+		std::memcpy(record.message.data(), message.data(), record.length);
+		if (message.size() > LOG_MESSAGE_CAPACITY)
+			std::memcpy(&record.message[LOG_MESSAGE_CAPACITY - 3], "...", 3);
+
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// only called from the log thread
+	[[nodiscard]] bool is_empty() const noexcept {
+		return slots[dequeue_position % LOG_QUEUE_CAPACITY].sequence.load(
+				   std::memory_order_acquire
+			   ) != dequeue_position + 1;
+	}
+
+	/// only called from the log thread
+	bool try_pop(LogRecord& record) noexcept {
+		auto& slot = slots[dequeue_position % LOG_QUEUE_CAPACITY];
+		if (slot.sequence.load(std::memory_order_acquire) !=
+			dequeue_position + 1)
+			return false;
+
+		record = slot.record;
+		slot.sequence.store(
+			dequeue_position + LOG_QUEUE_CAPACITY, std::memory_order_release
+		);
+		dequeue_position++;
+		return true;
+	}
+
+  private:
+	struct Slot {
+		std::atomic<size_t> sequence = 0;
+		LogRecord record;
+	};
+
+	std::array<Slot, LOG_QUEUE_CAPACITY> slots;
+	std::atomic<size_t> enqueue_position = 0;
+	size_t dequeue_position = 0;
+};
+
+static void write_log(int priority, const char* message) {
+#ifdef __ANDROID__
+	__android_log_write(priority, "Native Lib", message);
+#else
+	std::fprintf(
+		stderr, "[Native Lib] [%s] %s\n",
+		priority >= ANDROID_LOG_ERROR ? "error" : "info", message
+	);
+#endif
+}
+
+/// owns the background thread that writes the queued messages
+class Logger {
+  public:
+	Logger() : thread([this] { run(); }) {}
+
+	~Logger() noexcept {
+		stopping.store(true);
+		wake_up.release();
+		thread.join();
+	}
+
+	Logger(const Logger&) = delete;
+	Logger(Logger&&) = delete;
+	void operator=(const Logger&) = delete;
+	void operator=(Logger&&) = delete;
+
+	void push(
+		int priority,
+		std::string_view message,
+		uint32_t suppressed_count
+	) noexcept {
+		if (!queue.try_push(priority, message, suppressed_count))
+			dropped_count.fetch_add(1, std::memory_order_relaxed);
+
+		if (sleeping.exchange(false))
+			wake_up.release();
+	}
+
+	void notify_suppressed_burst() noexcept {
+		suppressed_burst.store(true);
+		if (sleeping.exchange(false))
+			wake_up.release();
+	}
+
+  private:
+	void run() noexcept {
+		LogRecord record;
+		while (true) {
+			while (queue.try_pop(record))
+				write(record);
+			write_dropped_count();
+
+			if (stopping.load()) {
+				write_repeats();
+				write_ended_bursts(true);
+				return;
+			}
+			suppressed_burst.store(false);
+			const bool pending_bursts = write_ended_bursts(false);
+
+			sleeping.store(true);
+			if (!queue.is_empty() || suppressed_burst.load()) {
+				sleeping.store(false);
+				continue;
+			}
+			// with pending repeats or bursts the thread has to wake up by
+			// itself to write the "repeated n times" line or the count of the
+			// dropped messages
+			if (repeat_count > 0 || pending_bursts) {
+				if (!wake_up.try_acquire_for(LOG_REPEAT_FLUSH_DELAY))
+					write_repeats();
+			} else {
+				wake_up.acquire();
+			}
+			sleeping.store(false);
+		}
+	}
+
+	void write(const LogRecord& record) noexcept {
+		if (record.priority == last_record.priority &&
+			record.view() == last_record.view()) {
+			repeat_count++;
+			last_record.suppressed_count += record.suppressed_count;
+			return;
+		}
+		write_repeats();
+
+		last_record = record;
+		last_record.suppressed_count = 0;
+		last_record.message[record.length] = '\0';
+		write_log(record.priority, last_record.message.data());
+		if (record.suppressed_count > 0)
+			write_suppressed(record.priority, record.suppressed_count);
+	}
+
+	void write_repeats() noexcept {
+		if (repeat_count == 0)
+			return;
+
+		write_formatted(
+			last_record.priority, "(last message repeated {} times)",
+			repeat_count
+		);
+		if (last_record.suppressed_count > 0)
+			write_suppressed(last_record.priority, last_record.suppressed_count);
+		repeat_count = 0;
+		last_record.suppressed_count = 0;
+	}
+
+	void write_suppressed(int priority, uint32_t suppressed_count) noexcept {
+		write_formatted(
+			priority, "({} more messages of this call site were rate limited)",
+			suppressed_count
+		);
+	}
+
+	/// reports the dropped messages of call sites whose last rate limit window
+	/// ended (all if flush_all), a burst that continues is reported by its
+	/// next message that gets through. returns whether bursts are left
+	bool write_ended_bursts(bool flush_all) noexcept {
+		const int64_t now_ms = log_clock_ms();
+		bool pending = false;
+		for (auto* site = log_call_sites.load(std::memory_order_acquire);
+			 site != nullptr; site = site->next) {
+			if (site->suppressed_count.load(std::memory_order_relaxed) == 0)
+				continue;
+			if (!flush_all &&
+				now_ms - site->window_start_ms.load(std::memory_order_relaxed) <
+					1000) {
+				pending = true;
+				continue;
+			}
+			const uint32_t suppressed = site->suppressed_count.exchange(0);
+			if (suppressed == 0)
+				continue;
+			std::string_view file = site->file;
+			file.remove_prefix(file.rfind('/') + 1);
+			write_formatted(
+				ANDROID_LOG_ERROR,
+				"({} messages of {}:{} were rate limited)", suppressed, file,
+				site->line
+			);
+		}
+		return pending;
+	}
+
+	void write_dropped_count() noexcept {
+		const uint32_t dropped = dropped_count.exchange(0);
+		if (dropped > 0)
+			write_formatted(
+				ANDROID_LOG_ERROR, "({} log messages dropped, queue full)",
+				dropped
+			);
+	}
+
+	template<typename... Args>
+	void write_formatted(
+		int priority,
+		std::format_string<Args...> format,
+		Args&&... args
+	) noexcept {
+		// NOLINTBEGIN(bugprone-empty-catch)
+		try {
+			write_log(
+				priority,
+				std::format(format, std::forward<Args>(args)...).c_str()
+			);
+		} catch (const std::exception&) {
+		}
+		// NOLINTEND(bugprone-empty-catch)
+	}
+
+	LogQueue queue;
+	std::atomic<uint32_t> dropped_count = 0;
+	std::atomic<bool> sleeping = false;
+	std::atomic<bool> stopping = false;
+	/// set when a call site starts dropping messages
+	std::atomic<bool> suppressed_burst = false;
+	std::counting_semaphore<> wake_up{0};
+
+	// only accessed by the log thread
+	LogRecord last_record;
+	uint32_t repeat_count = 0;
+
+	std::thread thread;
+};
+
+static Logger& get_logger() {
+	static Logger logger;
+	return logger;
+}
+
+static void notify_suppressed_burst() noexcept {
+	get_logger().notify_suppressed_burst();
+}
+
+void enqueue_log_message(
+	int priority,
+	std::string_view message,
+	uint32_t suppressed_count
+) noexcept {
+	get_logger().push(priority, message, suppressed_count);
+}
\ No newline at end of file
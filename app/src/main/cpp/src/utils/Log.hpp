@@ -1,19 +1,85 @@
 #pragma once
 
-#include <android/log.h>
+#include <atomic>
+#include <cstdint>
 #include <exception>
 #include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#else
+// host builds (benchmarks, tools) log to stderr instead of logcat
+enum { ANDROID_LOG_INFO = 4, ANDROID_LOG_ERROR = 6 };
+#endif
+
+/// maximum number of messages per second that a single log call site (macro
+/// expansion) may emit, additional messages are dropped before formatting
+constexpr uint32_t LOG_CALL_SITE_MESSAGES_PER_SECOND = 5;
+
+/// rate limit of a single log call site, a static of the expansion of
+/// LOG_INFO / LOG_ERROR. all call sites are linked into a list, so the log
+/// thread can report the dropped messages of bursts that ended
+struct LogCallSite {
+	LogCallSite(const char* file, uint32_t line) noexcept;
+
+	const char* file;
+	uint32_t line;
+	std::atomic<int64_t> window_start_ms = 0;
+	std::atomic<uint32_t> window_message_count = 0;
+	std::atomic<uint32_t> suppressed_count = 0;
+	LogCallSite* next = nullptr;
+};
+
+/// returns false if the message should be dropped, otherwise
+/// suppressed_count is set to the amount of messages of this call site that
+/// were dropped since the last one got through
+bool acquire_log_rate_limit(LogCallSite& site, uint32_t& suppressed_count
+) noexcept;
+
+/// copies the formatted message into the lock free log queue, it gets written
+/// (logcat / stderr) and deduplicated by the background log thread
+void enqueue_log_message(
+	int priority,
+	std::string_view message,
+	uint32_t suppressed_count
+) noexcept;
 
 template<typename... Args>
-void formatted_log(int priority, const char* format, Args... args) {
-	const std::string formatted =
-		std::vformat(format, std::make_format_args(args...));
+void formatted_log(
+	LogCallSite& site,
+	int priority,
+	const char* format,
+	Args... args
+) {
+	uint32_t suppressed_count = 0;
+	if (!acquire_log_rate_limit(site, suppressed_count))
+		return;
 
-	__android_log_write(priority, "Native Lib", formatted.c_str());
+	// the arguments don't outlive this call (e.what()), so formatting happens
+	// here, into a buffer that is reused so logging doesn't allocate
+	thread_local std::string formatted;
+	formatted.clear();
+	std::vformat_to(
+		std::back_inserter(formatted), format, std::make_format_args(args...)
+	);
+	enqueue_log_message(priority, formatted, suppressed_count);
 }
 
-#define LOG_INFO(...) formatted_log(ANDROID_LOG_INFO, __VA_ARGS__)
-#define LOG_ERROR(...) formatted_log(ANDROID_LOG_ERROR, __VA_ARGS__)
+/// the LogCallSite of the expansion, every expansion has its own lambda and
+/// with it its own static
+#define LOG_CALL_SITE()                                                        \
+	[]() -> LogCallSite& {                                                     \
+		static LogCallSite site(__FILE__, __LINE__);                           \
+		return site;                                                           \
+	}()
+
+#define LOG_INFO(...)                                                          \
+	formatted_log(LOG_CALL_SITE(), ANDROID_LOG_INFO, __VA_ARGS__)
+#define LOG_ERROR(...)                                                         \
+	formatted_log(LOG_CALL_SITE(), ANDROID_LOG_ERROR, __VA_ARGS__)
 
 #define LOG_ON_EXCEPTION(...)                                                  \
 	try {                                                                      \
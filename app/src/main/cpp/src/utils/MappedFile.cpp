@@ -0,0 +1,101 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+FileOperationException::FileOperationException(
+	std::string_view operation,
+	std::string_view path
+)
+	: std::runtime_error(std::format(
+		  "failed to {} {}: {}", operation, path, std::strerror(errno)
+	  )) {}
+
+FileDescriptor::FileDescriptor(const std::string& path, int flags, int mode)
+	: fd(open(path.c_str(), flags | O_CLOEXEC, mode)), file_path(path) {
+	if (fd < 0)
+		throw FileOperationException("open", path);
+}
+
+FileDescriptor::~FileDescriptor() noexcept {
+	if (fd >= 0)
+		close(fd);
+}
+
+FileDescriptor::FileDescriptor(FileDescriptor&& other) noexcept
+	: fd(std::exchange(other.fd, -1)), file_path(std::move(other.file_path)) {}
+
+FileDescriptor& FileDescriptor::operator=(FileDescriptor&& other) noexcept {
+	if (this != &other) {
+		if (fd >= 0)
+			close(fd);
+		fd = std::exchange(other.fd, -1);
+		file_path = std::move(other.file_path);
+	}
+	return *this;
+}
+
+size_t FileDescriptor::size() const {
+	struct stat file_stat{};
+	if (fstat(fd, &file_stat) != 0)
+		throw FileOperationException("stat", file_path);
+	return (size_t)file_stat.st_size;
+}
+
+void FileDescriptor::truncate(size_t size) const {
+	if (ftruncate(fd, (off_t)size) != 0)
+		throw FileOperationException("resize", file_path);
+}
+
+void write_all(int fd, std::span<const uint8_t> bytes) {
+	while (!bytes.empty()) {
+		const ssize_t written = write(fd, bytes.data(), bytes.size());
+		if (written < 0)
+			throw FileOperationException("write", std::format("fd {}", fd));
+		bytes = bytes.subspan((size_t)written);
+	}
+}
+
+MappedRegion::MappedRegion(
+	const FileDescriptor& file,
+	size_t offset,
+	size_t size,
+	bool writable
+)
+	: length(size) {
+	if (size == 0)
+		return;
+
+	void* mapping = mmap(
+		nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+		writable ? MAP_SHARED : MAP_PRIVATE, file.get(), (off_t)offset
+	);
+	if (mapping == MAP_FAILED)
+		throw FileOperationException("map", file.path());
+	data = static_cast<uint8_t*>(mapping);
+}
+
+MappedRegion::~MappedRegion() noexcept {
+	if (data != nullptr)
+		munmap(data, length);
+}
+
+MappedRegion::MappedRegion(MappedRegion&& other) noexcept
+	: data(std::exchange(other.data, nullptr)),
+	  length(std::exchange(other.length, 0)) {}
+
+MappedRegion& MappedRegion::operator=(MappedRegion&& other) noexcept {
+	if (this != &other) {
+		if (data != nullptr)
+			munmap(data, length);
+		data = std::exchange(other.data, nullptr);
+		length = std::exchange(other.length, 0);
+	}
+	return *this;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/// failed posix file operation, the message includes strerror(errno)
+class FileOperationException : public std::runtime_error {
+  public:
+	FileOperationException(std::string_view operation, std::string_view path);
+};
+
+/// owning posix file descriptor
+class FileDescriptor {
+  public:
+	FileDescriptor() = default;
+	/// open(2), throws FileOperationException on failure
+	FileDescriptor(const std::string& path, int flags, int mode = 0644);
+	~FileDescriptor() noexcept;
+
+	FileDescriptor(const FileDescriptor&) = delete;
+	FileDescriptor(FileDescriptor&& other) noexcept;
+	void operator=(const FileDescriptor&) = delete;
+	FileDescriptor& operator=(FileDescriptor&& other) noexcept;
+
+	[[nodiscard]] int get() const { return fd; }
+	[[nodiscard]] bool is_open() const { return fd >= 0; }
+	[[nodiscard]] const std::string& path() const { return file_path; }
+
+	[[nodiscard]] size_t size() const;
+	void truncate(size_t size) const;
+
+  private:
+	int fd = -1;
+	std::string file_path;
+};
+
+/// write(2) until all bytes are written, throws FileOperationException
+void write_all(int fd, std::span<const uint8_t> bytes);
+
+/// memory mapping of a range of a file, unmapped on destruction
+class MappedRegion {
+  public:
+	MappedRegion() = default;
+	/// offset has to be a multiple of the page size (MAPPING_ALIGNMENT is a
+	/// multiple of all android page sizes). writable mappings are shared, so
+	/// writes reach the file even if the process is killed
+	MappedRegion(
+		const FileDescriptor& file,
+		size_t offset,
+		size_t size,
+		bool writable
+	);
+	~MappedRegion() noexcept;
+
+	MappedRegion(const MappedRegion&) = delete;
+	MappedRegion(MappedRegion&& other) noexcept;
+	void operator=(const MappedRegion&) = delete;
+	MappedRegion& operator=(MappedRegion&& other) noexcept;
+
+	[[nodiscard]] std::span<uint8_t> bytes() const { return {data, length}; }
+	[[nodiscard]] bool is_mapped() const { return data != nullptr; }
+
+  private:
+	uint8_t* data = nullptr;
+	size_t length = 0;
+};
+
+/// alignment of mapped file offsets, covers 4k and 16k pages
+constexpr size_t MAPPING_ALIGNMENT = 64 * 1024;
+
+constexpr size_t align_up(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "MemoryProfiling.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <format>
+#include <utility>
+
+std::string MemoryRecord::formatted() const {
+	return std::format(
+		"{}: {} (peak {}, {} allocs this frame, {} total)", name,
+		format_memory_bytes(current_bytes), format_memory_bytes(peak_bytes),
+		frame_allocation_count, total_allocation_count
+	);
+}
+
+void MemoryTracker::allocated(std::string_view name, size_t bytes) noexcept {
+	// NOLINTBEGIN(bugprone-empty-catch)
+	try {
+		const std::lock_guard lock(mutex);
+		auto& record = find_or_create_record(name);
+		record.current_bytes += bytes;
+		record.peak_bytes = std::max(record.peak_bytes, record.current_bytes);
+		record.frame_allocation_count++;
+		record.total_allocation_count++;
+	} catch (const std::exception&) {
+	}
+	// NOLINTEND(bugprone-empty-catch)
+}
+
+void MemoryTracker::freed(std::string_view name, size_t bytes) noexcept {
+	// NOLINTBEGIN(bugprone-empty-catch)
+	try {
+		const std::lock_guard lock(mutex);
+		auto& record = find_or_create_record(name);
+		record.current_bytes -= std::min(record.current_bytes, bytes);
+	} catch (const std::exception&) {
+	}
+	// NOLINTEND(bugprone-empty-catch)
+}
+
+std::string MemoryTracker::finish_frame() {
+	const std::lock_guard lock(mutex);
+
+	size_t tracked_bytes = 0;
+	for (const auto& record : memory_records)
+		tracked_bytes += record.current_bytes;
+
+	std::string formatted = std::format(
+		"Memory: {} tracked, {} resident (peak {})\n",
+		format_memory_bytes(tracked_bytes),
+		format_memory_bytes(read_resident_memory_bytes()),
+		format_memory_bytes(read_peak_resident_memory_bytes())
+	);
+	for (auto& record : memory_records) {
+		formatted += std::format("        {}\n", record.formatted());
+		record.frame_allocation_count = 0;
+	}
+	return formatted;
+}
+
+std::vector<MemoryRecord> MemoryTracker::records() const {
+	const std::lock_guard lock(mutex);
+	return memory_records;
+}
+
+MemoryRecord& MemoryTracker::find_or_create_record(std::string_view name) {
+	auto iter = std::ranges::find(memory_records, name, &MemoryRecord::name);
+	if (iter != memory_records.end())
+		return *iter;
+
+	return memory_records.emplace_back(MemoryRecord{.name = std::string(name)}
+	);
+}
+
+TrackedMemory::TrackedMemory(
+	MemoryTracker& tracker,
+	std::string_view name,
+	size_t bytes
+)
+	: tracker(&tracker), name(name), bytes(bytes) {
+	tracker.allocated(name, bytes);
+}
+
+TrackedMemory::~TrackedMemory() noexcept { release(); }
+
+TrackedMemory::TrackedMemory(TrackedMemory&& other) noexcept
+	: tracker(std::exchange(other.tracker, nullptr)),
+	  name(std::move(other.name)), bytes(std::exchange(other.bytes, 0)) {}
+
+TrackedMemory& TrackedMemory::operator=(TrackedMemory&& other) noexcept {
+	if (this != &other) {
+		release();
+		tracker = std::exchange(other.tracker, nullptr);
+		name = std::move(other.name);
+		bytes = std::exchange(other.bytes, 0);
+	}
+	return *this;
+}
+
+void TrackedMemory::release() noexcept {
+	if (tracker != nullptr)
+		tracker->freed(name, bytes);
+	tracker = nullptr;
+}
+
+ResidentMemoryDelta::ResidentMemoryDelta()
+	: start_resident_bytes(read_resident_memory_bytes()) {}
+
+size_t ResidentMemoryDelta::finish() const {
+	const size_t end_resident_bytes = read_resident_memory_bytes();
+	if (end_resident_bytes < start_resident_bytes)
+		return 0;
+	return end_resident_bytes - start_resident_bytes;
+}
+
+/// reads a "<key>: <value> kB" line of /proc/self/status
+static size_t read_proc_status_kilobytes(std::string_view key) {
+	// NOLINTBEGIN(cppcoreguidelines-owning-memory)
+	FILE* status_file = std::fopen("/proc/self/status", "r");
+	if (status_file == nullptr)
+		return 0;
+
+	size_t kilobytes = 0;
+	std::array<char, 256> line{};
+	while (std::fgets(line.data(), (int)line.size(), status_file) != nullptr) {
+		const std::string_view line_view(line.data());
+		if (!line_view.starts_with(key) || line_view.size() <= key.size() ||
+			line_view[key.size()] != ':')
+			continue;
+
+		const auto value_start =
+			line_view.find_first_of("0123456789", key.size());
+		if (value_start != std::string_view::npos) {
+			std::from_chars(
+				line_view.data() + value_start,
+				line_view.data() + line_view.size(), kilobytes
+			);
+		}
+		break;
+	}
+
+	std::fclose(status_file);
+	// NOLINTEND(cppcoreguidelines-owning-memory)
+	return kilobytes * 1024;
+}
+
+size_t read_resident_memory_bytes() {
+	return read_proc_status_kilobytes("VmRSS");
+}
+
+size_t read_peak_resident_memory_bytes() {
+	return read_proc_status_kilobytes("VmHWM");
+}
+
+std::string format_memory_bytes(size_t bytes) {
+	constexpr size_t KILOBYTE = 1024;
+	constexpr size_t MEGABYTE = KILOBYTE * 1024;
+
+	if (bytes >= MEGABYTE)
+		return std::format("{:.2f} MB", (double)bytes / (double)MEGABYTE);
+	if (bytes >= KILOBYTE)
+		return std::format("{:.1f} KB", (double)bytes / (double)KILOBYTE);
+	return std::format("{} B", bytes);
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// bookkeeping of a single named memory consumer, for example
+/// "TfLiteRuntime (model.tflite): tensor arena"
+struct MemoryRecord {
+	std::string name;
+	size_t current_bytes = 0;
+	size_t peak_bytes = 0;
+	size_t frame_allocation_count = 0;
+	size_t total_allocation_count = 0;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/// thread safe accounting of native memory usage, grouped by name (runtime,
+/// stage and model)
+class MemoryTracker {
+  public:
+	void allocated(std::string_view name, size_t bytes) noexcept;
+	void freed(std::string_view name, size_t bytes) noexcept;
+
+	/// returns formatted info of all records and resets the per frame
+	/// allocation counts
+	std::string finish_frame();
+
+	[[nodiscard]] std::vector<MemoryRecord> records() const;
+
+  private:
+	MemoryRecord& find_or_create_record(std::string_view name);
+
+	mutable std::mutex mutex;
+	std::vector<MemoryRecord> memory_records;
+};
+
+/// registers an allocation of a tracker for as long as this object lives,
+/// used for long lived allocations like models or tensor arenas
+class TrackedMemory {
+  public:
+	TrackedMemory() = default;
+	explicit TrackedMemory(
+		MemoryTracker& tracker,
+		std::string_view name,
+		size_t bytes
+	);
+	~TrackedMemory() noexcept;
+
+	TrackedMemory(const TrackedMemory&) = delete;
+	TrackedMemory(TrackedMemory&& other) noexcept;
+	void operator=(const TrackedMemory&) = delete;
+	TrackedMemory& operator=(TrackedMemory&& other) noexcept;
+
+	[[nodiscard]] size_t size() const { return bytes; }
+
+  private:
+	void release() noexcept;
+
+	MemoryTracker* tracker = nullptr;
+	std::string name;
+	size_t bytes = 0;
+};
+
+/// measures how much the resident set size grew between construction and
+/// finish(), used for allocations hidden inside of the runtime libraries
+/// (tflite tensor arena, onnx arena allocator)
+class ResidentMemoryDelta {
+  public:
+	ResidentMemoryDelta();
+
+	/// returns the growth of the resident set size in bytes (0 if it shrunk)
+	[[nodiscard]] size_t finish() const;
+
+  private:
+	size_t start_resident_bytes = 0;
+};
+
+/// current resident set size of this process in bytes, 0 if unavailable
+size_t read_resident_memory_bytes();
+
+/// high-water mark of the resident set size of this process in bytes, 0 if
+/// unavailable
+size_t read_peak_resident_memory_bytes();
+
+std::string format_memory_bytes(size_t bytes);
\ No newline at end of file
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "ImageUtils.hpp"
+#include "simd/SimdKernels.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+/// byte order of source pixels
+enum class PixelFormat {
+	/// r, g, b, a bytes (android bitmaps and RGBA_8888 camera images)
+	Rgba,
+	/// b, g, r, a bytes (argb ints in little endian memory)
+	Bgra,
+	/// a, r, g, b bytes
+	Argb,
+	/// full resolution luma plane, then interleaved v, u at half resolution
+	/// (android camera default), bt.601 full range
+	Nv21,
+	/// as Nv21 with u, v order
+	Nv12,
+};
+
+constexpr bool is_yuv_format(PixelFormat format) {
+	return format == PixelFormat::Nv21 || format == PixelFormat::Nv12;
+}
+
+/// semi planar 4:2:0 image, the chroma plane has (width + 1) / 2 interleaved
+/// pairs per row and (height + 1) / 2 rows
+struct YuvImageView {
+	std::span<const uint8_t> luma;
+	std::span<const uint8_t> chroma;
+	size_t width = 0;
+	size_t height = 0;
+	/// bytes per row of both planes
+	size_t luma_stride = 0;
+	size_t chroma_stride = 0;
+};
+
+/// 4 byte pixels use RgbaImageView, their byte order is the PixelFormat
+template<PixelFormat FORMAT>
+using PixelSourceView =
+	std::conditional_t<is_yuv_format(FORMAT), YuvImageView, RgbaImageView>;
+
+/// ieee 754 half precision bits (as TfLiteFloat16 and Ort::Float16_t)
+struct Float16 {
+	uint16_t bits;
+};
+
+/// rounds to nearest even, overflows to infinity
+constexpr Float16 float_to_float16(float value) {
+#if defined(__FLT16_MAX__) && (defined(__aarch64__) || defined(__F16C__))
+	// fcvt / vcvtps2ph, vectorized by the compiler
+	if (!std::is_constant_evaluated())
+		return {std::bit_cast<uint16_t>((_Float16)value)};
+#endif
+	const auto bits = std::bit_cast<uint32_t>(value);
+	const auto sign = (uint16_t)((bits >> 16) & 0x8000U);
+	const uint32_t magnitude = bits & 0x7fffffffU;
+	if (magnitude > 0x7f800000U)
+		return {(uint16_t)(sign | 0x7e00U)};
+	// at least 65520, the first value that rounds past the largest half
+	if (magnitude >= 0x477ff000U)
+		return {(uint16_t)(sign | 0x7c00U)};
+	if (magnitude < 0x38800000U) {
+		// subnormal half: adding 0.5 leaves the value in multiples of 2^-24
+		// in the low mantissa bits, rounded to nearest even by the fpu
+		const float shifted = std::bit_cast<float>(magnitude) + 0.5f;
+		const uint32_t subnormal =
+			std::bit_cast<uint32_t>(shifted) - 0x3f000000U;
+		return {(uint16_t)(sign | subnormal)};
+	}
+	// rebias the exponent from 127 to 15, round the 13 dropped mantissa bits
+	const uint32_t rounded = magnitude + 0xfffU + ((magnitude >> 13) & 1U);
+	return {(uint16_t)(sign | ((rounded - 0x38000000U) >> 13))};
+}
+
+/// value = channel byte * scale + offset, for each rgb channel
+struct ChannelScaling {
+	std::array<float, RGB_CHANNELS> scale = {1.0f, 1.0f, 1.0f};
+	std::array<float, RGB_CHANNELS> offset = {0.0f, 0.0f, 0.0f};
+
+	/// bytes to 0.0f to max_value, then (value - mean) / stddev (the
+	/// normalize_rgb step folded into the conversion)
+	static constexpr ChannelScaling normalized(
+		float max_value,
+		std::array<float, RGB_CHANNELS> mean = {0.0f, 0.0f, 0.0f},
+		std::array<float, RGB_CHANNELS> stddev = {1.0f, 1.0f, 1.0f}
+	) {
+		ChannelScaling scaling;
+		for (size_t channel = 0; channel < RGB_CHANNELS; channel++) {
+			scaling.scale[channel] = max_value / 255.0f / stddev[channel];
+			scaling.offset[channel] = -mean[channel] / stddev[channel];
+		}
+		return scaling;
+	}
+};
+
+/// byte offsets of r, g, b and a within a 4 byte pixel
+constexpr std::array<size_t, 4> packed_channel_offsets(PixelFormat format) {
+	switch (format) {
+	case PixelFormat::Bgra:
+		return {2, 1, 0, 3};
+	case PixelFormat::Argb:
+		return {1, 2, 3, 0};
+	default:
+		return {0, 1, 2, 3};
+	}
+}
+
+/// bit shift of a byte within a 4 byte pixel loaded as one word
+constexpr uint32_t packed_byte_shift(size_t offset) {
+	return std::endian::native == std::endian::little
+			   ? (uint32_t)(8 * offset)
+			   : (uint32_t)(8 * (3 - offset));
+}
+
+using RgbValues = std::array<float, RGB_CHANNELS>;
+
+/// r, g, b from 0.0f to 255.0f. the pixel is loaded as a word and split with
+/// constant shifts, which vectorizes without structure loads
+template<PixelFormat FORMAT>
+inline RgbValues decode_packed_pixel(const uint8_t* pixel) {
+	static_assert(!is_yuv_format(FORMAT));
+	constexpr auto OFFSETS = packed_channel_offsets(FORMAT);
+
+	uint32_t word = 0;
+	std::memcpy(&word, pixel, sizeof(word));
+	return {
+		(float)((word >> packed_byte_shift(OFFSETS[0])) & 255U),
+		(float)((word >> packed_byte_shift(OFFSETS[1])) & 255U),
+		(float)((word >> packed_byte_shift(OFFSETS[2])) & 255U),
+	};
+}
+
+/// r, g, b from 0.0f to 255.0f of the pixel x of a row
+template<PixelFormat FORMAT>
+inline RgbValues
+decode_yuv_pixel(const uint8_t* luma, const uint8_t* chroma, size_t x) {
+	static_assert(is_yuv_format(FORMAT));
+	constexpr size_t U_OFFSET = FORMAT == PixelFormat::Nv12 ? 0 : 1;
+	constexpr size_t V_OFFSET = 1 - U_OFFSET;
+
+	const size_t pair = (x / 2) * 2;
+	const auto y = (float)luma[x];
+	const float u = (float)chroma[pair + U_OFFSET] - 128.0f;
+	const float v = (float)chroma[pair + V_OFFSET] - 128.0f;
+	return {
+		std::clamp(y + 1.402f * v, 0.0f, 255.0f),
+		std::clamp(y - 0.344136f * u - 0.714136f * v, 0.0f, 255.0f),
+		std::clamp(y + 1.772f * u, 0.0f, 255.0f),
+	};
+}
+
+template<typename Element> inline Element convert_channel_value(float value) {
+	if constexpr (std::is_same_v<Element, float>)
+		return value;
+	else if constexpr (std::is_same_v<Element, Float16>)
+		return float_to_float16(value);
+	else if constexpr (std::is_same_v<Element, uint8_t>)
+		return (uint8_t)std::clamp(value + 0.5f, 0.0f, 255.0f);
+	else
+		static_assert(!sizeof(Element), "unsupported element type");
+}
+
+/// converts one row, source_row points to the pixels (or the luma) of the
+/// row, plane_size is only used by Chw
+template<PixelFormat FORMAT, ImageLayout LAYOUT, typename Element>
+inline void convert_pixel_row(
+	const uint8_t* source_row,
+	const uint8_t* chroma_row,
+	Element* row,
+	size_t width,
+	size_t plane_size,
+	const ChannelScaling& scaling
+) {
+	const auto [red_scale, green_scale, blue_scale] = scaling.scale;
+	const auto [red_offset, green_offset, blue_offset] = scaling.offset;
+	for (size_t x = 0; x < width; x++) {
+		RgbValues rgb;
+		if constexpr (is_yuv_format(FORMAT))
+			rgb = decode_yuv_pixel<FORMAT>(source_row, chroma_row, x);
+		else
+			rgb = decode_packed_pixel<FORMAT>(&source_row[x * 4]);
+		const auto red = convert_channel_value<Element>(
+			rgb[0] * red_scale + red_offset
+		);
+		const auto green = convert_channel_value<Element>(
+			rgb[1] * green_scale + green_offset
+		);
+		const auto blue = convert_channel_value<Element>(
+			rgb[2] * blue_scale + blue_offset
+		);
+		if constexpr (LAYOUT == ImageLayout::Hwc) {
+			row[x * RGB_CHANNELS] = red;
+			row[x * RGB_CHANNELS + 1] = green;
+			row[x * RGB_CHANNELS + 2] = blue;
+		} else {
+			row[x] = red;
+			row[plane_size + x] = green;
+			row[2 * plane_size + x] = blue;
+		}
+	}
+}
+
+/// converts pixels into a rgb model input of the same size. every
+/// combination of source format, layout and element type (float, Float16,
+/// uint8_t) is its own kernel without branches in the pixel loop: decoding,
+/// scaling and the stores into the layout are fused into one pass per row
+/// (Chw writes three sequential streams, the planes of the row). Rgba to Hwc
+/// float, the tflite input, uses the rgba_to_rgb kernel of simd_kernels()
+template<PixelFormat FORMAT, ImageLayout LAYOUT, typename Element>
+void convert_pixels(
+	const PixelSourceView<FORMAT>& source,
+	std::span<Element> destination,
+	const ChannelScaling& scaling = {}
+) {
+	const size_t width = source.width;
+	const size_t height = source.height;
+	if (destination.size() != width * height * RGB_CHANNELS)
+		throw std::invalid_argument("destination");
+	if (width == 0 || height == 0)
+		return;
+
+	if constexpr (is_yuv_format(FORMAT)) {
+		const size_t chroma_rows = (height + 1) / 2;
+		const size_t chroma_row_size = 2 * ((width + 1) / 2);
+		if (source.luma_stride < width ||
+			source.luma.size() < source.luma_stride * (height - 1) + width)
+			throw std::invalid_argument("luma");
+		if (source.chroma_stride < chroma_row_size ||
+			source.chroma.size() <
+				source.chroma_stride * (chroma_rows - 1) + chroma_row_size)
+			throw std::invalid_argument("chroma");
+	} else {
+		if (source.stride < width * 4 ||
+			source.pixels.size() < source.stride * (height - 1) + width * 4)
+			throw std::invalid_argument("source");
+	}
+
+	const size_t plane_size = width * height;
+	for (size_t y = 0; y < height; y++) {
+		Element* row = &destination
+			[LAYOUT == ImageLayout::Hwc ? y * width * RGB_CHANNELS : y * width];
+		const uint8_t* source_row = nullptr;
+		const uint8_t* chroma_row = nullptr;
+		if constexpr (is_yuv_format(FORMAT)) {
+			source_row = &source.luma[y * source.luma_stride];
+			chroma_row = &source.chroma[(y / 2) * source.chroma_stride];
+		} else {
+			source_row = &source.pixels[y * source.stride];
+		}
+		if constexpr (
+			FORMAT == PixelFormat::Rgba && LAYOUT == ImageLayout::Hwc &&
+			std::is_same_v<Element, float>
+		) {
+			// the bitmap to tflite input conversion, explicitly vectorized
+			simd_kernels().rgba_to_rgb(
+				{source_row, width * 4}, {row, width * RGB_CHANNELS},
+				scaling.scale, scaling.offset
+			);
+		} else {
+			convert_pixel_row<FORMAT, LAYOUT>(
+				source_row, chroma_row, row, width, plane_size, scaling
+			);
+		}
+	}
+}
+
+/// 4 byte pixels to argb ints (as Bitmap.createBitmap(int[]) expects them),
+/// the channels are read as unsigned bytes
+template<PixelFormat FORMAT>
+void packed_pixels_to_argb(
+	std::span<const uint8_t> pixels,
+	std::span<int32_t> out_pixels
+) {
+	static_assert(!is_yuv_format(FORMAT));
+	constexpr auto OFFSETS = packed_channel_offsets(FORMAT);
+
+	if (pixels.size() != out_pixels.size() * 4)
+		throw std::invalid_argument("out_pixels");
+
+	for (size_t i = 0; i < out_pixels.size(); i++) {
+		const uint8_t* pixel = &pixels[i * 4];
+		out_pixels[i] = (int32_t)(((uint32_t)pixel[OFFSETS[3]] << 24) |
+								  ((uint32_t)pixel[OFFSETS[0]] << 16) |
+								  ((uint32_t)pixel[OFFSETS[1]] << 8) |
+								  (uint32_t)pixel[OFFSETS[2]]);
+	}
+}
\ No newline at end of file
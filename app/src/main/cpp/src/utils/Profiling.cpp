@@ -19,10 +19,18 @@ static std::string format_duration_millis(profile_clock::duration duration) {
 }
 
 ProfileScope::ProfileScope(std::string_view name, ProfilingFrame& frame)
-	: name(name), frame(frame), start(profile_clock::now()),
-	  scope_depth(frame.start_scope()) {}
+	: name(name), frame(frame), recording(frame.is_recording()) {
+	if (!recording)
+		return;
+
+	scope_depth = frame.start_scope();
+	start = profile_clock::now();
+}
 
 ProfileScope::~ProfileScope() noexcept {
+	if (!recording)
+		return;
+
 	auto duration = profile_clock::now() - start;
 	frame.end_scope(ProfileScopeRecord(name, scope_depth, start, duration));
 }
@@ -41,6 +49,7 @@ int ProfilingFrame::start_scope() noexcept {
 void ProfilingFrame::end_scope(ProfileScopeRecord scope) noexcept {
 	// NOLINTBEGIN(bugprone-empty-catch)
 	try {
+		const std::scoped_lock lock(profile_scopes_mutex);
 		profile_scopes.push_back(scope);
 	} catch (const std::exception&) {
 	}
@@ -48,8 +57,18 @@ void ProfilingFrame::end_scope(ProfileScopeRecord scope) noexcept {
 	current_frame_scope_depth--;
 }
 
-std::string ProfilingFrame::finish() {
+std::optional<std::string> ProfilingFrame::finish() {
 	auto end = profile_clock::now();
+	const std::scoped_lock lock(profile_scopes_mutex);
+
+	const bool was_recording = is_recording();
+	frame_index++;
+	if (!was_recording) {
+		profile_scopes.clear();
+		current_frame_scope_depth = 0;
+		start = profile_clock::now();
+		return std::nullopt;
+	}
 
 	std::ranges::sort(profile_scopes, [](const auto& a, const auto& b) -> bool {
 		return a.start < b.start;
@@ -67,8 +86,9 @@ std::string ProfilingFrame::finish() {
 		1000.0f;
 	auto frame_fps = 1.0 / (frame_duration_ms / 1000.0f);
 	auto formatted = std::format(
-		"{} Frame: {:.2f} fps ({:.2f} ms)\n{}", name, frame_fps,
-		frame_duration_ms, profile_scopes_formatted
+		"{} Frame: {:.2f} fps ({:.2f} ms)\n{}    {}", name, frame_fps,
+		frame_duration_ms, profile_scopes_formatted,
+		memory_tracker.finish_frame()
 	);
 
 	profile_scopes.clear();
@@ -1,9 +1,30 @@
 #pragma once
 
+#include "MemoryProfiling.hpp"
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <vector>
 
+/// build-level profiling mode, set with the DEPTH_CAMERA_PROFILING cmake
+/// option:
+/// - off: all profiling macros compile to nothing
+/// - sampled: only every DEPTH_CAMERA_PROFILING_SAMPLE_INTERVAL-th frame is
+///   recorded, scopes of the other frames only check a flag
+/// - full: every frame is recorded
+#define PROFILING_MODE_OFF 0
+#define PROFILING_MODE_SAMPLED 1
+#define PROFILING_MODE_FULL 2
+
+#ifndef DEPTH_CAMERA_PROFILING_MODE
+#define DEPTH_CAMERA_PROFILING_MODE PROFILING_MODE_FULL
+#endif
+#ifndef DEPTH_CAMERA_PROFILING_SAMPLE_INTERVAL
+#define DEPTH_CAMERA_PROFILING_SAMPLE_INTERVAL 30
+#endif
+
 using profile_clock = std::chrono::high_resolution_clock;
 
 class ProfilingFrame;
@@ -21,6 +42,8 @@ struct ProfileScope {
 	std::string_view name;
 	int scope_depth = 0;
 	ProfilingFrame& frame;
+	/// false if the frame is not sampled, nothing is measured then
+	bool recording = false;
 	profile_clock::time_point start;
 };
 
@@ -42,14 +65,34 @@ class ProfilingFrame {
 
 	void end_scope(ProfileScopeRecord scope) noexcept;
 
-	/// returns formatted info of the finished frame and clears all contents to
-	/// start a new frame
-	std::string finish();
+	/// whether scopes of the current frame are measured, always true in the
+	/// full profiling mode and only true for sampled frames in the sampled
+	/// mode
+	[[nodiscard]] bool is_recording() const noexcept {
+#if DEPTH_CAMERA_PROFILING_MODE == PROFILING_MODE_FULL
+		return true;
+#elif DEPTH_CAMERA_PROFILING_MODE == PROFILING_MODE_SAMPLED
+		return frame_index % DEPTH_CAMERA_PROFILING_SAMPLE_INTERVAL == 0;
+#else
+		return false;
+#endif
+	}
+
+	/// returns formatted info of the finished frame (nullopt if it was not
+	/// recorded) and clears all contents to start a new frame
+	std::optional<std::string> finish();
+
+	/// memory accounting that is reported together with each finished frame
+	MemoryTracker& memory() { return memory_tracker; }
 
   private:
 	std::string_view name;
+	/// scopes can end on worker threads (tiled inference)
+	std::mutex profile_scopes_mutex;
 	std::vector<ProfileScopeRecord> profile_scopes;
-	int current_frame_scope_depth = 0;
+	MemoryTracker memory_tracker;
+	std::atomic<int> current_frame_scope_depth = 0;
+	size_t frame_index = 0;
 	profile_clock::time_point start = profile_clock::now();
 };
 
@@ -63,14 +106,6 @@ std::string& get_last_camera_profiling_frame_formatted();
 
 #define COMBINE(x, y) x##y
 #define COMBINE2(x, y) COMBINE(x, y)
-#define PROFILE_DEPTH_SCOPE(name)                                              \
-	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
-		name, get_depth_profiling_frame()                                      \
-	);
-#define PROFILE_CAMERA_SCOPE(name)                                             \
-	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
-		name, get_camera_profiling_frame()                                     \
-	);
 
 #ifndef __FUNCTION_NAME__
 #ifdef WIN32 // WINDOWS
@@ -80,6 +115,17 @@ std::string& get_last_camera_profiling_frame_formatted();
 #endif
 #endif
 
+#if DEPTH_CAMERA_PROFILING_MODE != PROFILING_MODE_OFF
+
+#define PROFILE_DEPTH_SCOPE(name)                                              \
+	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
+		name, get_depth_profiling_frame()                                      \
+	);
+#define PROFILE_CAMERA_SCOPE(name)                                             \
+	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
+		name, get_camera_profiling_frame()                                     \
+	);
+
 #define PROFILE_DEPTH_FUNCTION()                                               \
 	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
 		FUNCTION_NAME(), get_depth_profiling_frame()                           \
@@ -87,4 +133,30 @@ std::string& get_last_camera_profiling_frame_formatted();
 #define PROFILE_CAMERA_FUNCTION()                                              \
 	const ProfileScope COMBINE2(__profile_scope_, __LINE__)(                   \
 		FUNCTION_NAME(), get_camera_profiling_frame()                          \
-	);
\ No newline at end of file
+	);
+
+/// tracks a transient buffer of the given size until the end of the scope
+/// (only on recorded frames)
+#define PROFILE_DEPTH_MEMORY(name, bytes)                                      \
+	const TrackedMemory COMBINE2(__tracked_memory_, __LINE__) =                \
+		get_depth_profiling_frame().is_recording()                             \
+			? TrackedMemory(get_depth_profiling_frame().memory(), name, bytes) \
+			: TrackedMemory();
+#define PROFILE_CAMERA_MEMORY(name, bytes)                                     \
+	const TrackedMemory COMBINE2(__tracked_memory_, __LINE__) =                \
+		get_camera_profiling_frame().is_recording()                            \
+			? TrackedMemory(                                                   \
+				  get_camera_profiling_frame().memory(), name, bytes           \
+			  )                                                                \
+			: TrackedMemory();
+
+#else
+
+#define PROFILE_DEPTH_SCOPE(name)
+#define PROFILE_CAMERA_SCOPE(name)
+#define PROFILE_DEPTH_FUNCTION()
+#define PROFILE_CAMERA_FUNCTION()
+#define PROFILE_DEPTH_MEMORY(name, bytes)
+#define PROFILE_CAMERA_MEMORY(name, bytes)
+
+#endif
\ No newline at end of file
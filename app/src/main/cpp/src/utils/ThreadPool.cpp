@@ -0,0 +1,89 @@
+#include "ThreadPool.hpp"
+
+#include <utility>
+
+ThreadPool::ThreadPool(size_t thread_count) {
+	threads.reserve(thread_count);
+	for (size_t worker = 0; worker < thread_count; worker++)
+		threads.emplace_back([this, worker] { run_worker(worker); });
+}
+
+ThreadPool::~ThreadPool() noexcept {
+	{
+		const std::scoped_lock lock(mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void ThreadPool::parallel_for(
+	size_t count,
+	const std::function<void(size_t index, size_t worker)>& task
+) {
+	if (count == 0)
+		return;
+
+	if (threads.empty()) {
+		for (size_t index = 0; index < count; index++)
+			task(index, 0);
+		return;
+	}
+
+	const std::scoped_lock parallel_for_lock(parallel_for_mutex);
+
+	std::unique_lock lock(mutex);
+	current_task = &task;
+	task_count = count;
+	next_index.store(0);
+	busy_workers = threads.size();
+	first_exception = nullptr;
+	generation++;
+	work_available.notify_all();
+
+	work_finished.wait(lock, [this] { return busy_workers == 0; });
+	current_task = nullptr;
+
+	if (first_exception)
+		std::rethrow_exception(std::exchange(first_exception, nullptr));
+}
+
+void ThreadPool::run_worker(size_t worker) noexcept {
+	uint64_t finished_generation = 0;
+	while (true) {
+		{
+			std::unique_lock lock(mutex);
+			work_available.wait(lock, [&] {
+				return stopping || generation != finished_generation;
+			});
+			if (stopping)
+				return;
+			finished_generation = generation;
+		}
+
+		run_tasks(worker);
+
+		const std::scoped_lock lock(mutex);
+		if (--busy_workers == 0)
+			work_finished.notify_one();
+	}
+}
+
+void ThreadPool::run_tasks(size_t worker) noexcept {
+	while (true) {
+		const size_t index = next_index.fetch_add(1);
+		if (index >= task_count)
+			return;
+
+		try {
+			(*current_task)(index, worker);
+		} catch (...) {
+			const std::scoped_lock lock(mutex);
+			if (!first_exception)
+				first_exception = std::current_exception();
+			// skip the remaining tasks
+			next_index.store(task_count);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// fixed set of worker threads for data parallel loops. tasks know the index
+/// of the worker that runs them, so per worker resources (runtime instances,
+/// scratch buffers) can be used without locking
+class ThreadPool {
+  public:
+	/// with 0 threads parallel_for runs everything on the calling thread
+	explicit ThreadPool(size_t thread_count);
+	~ThreadPool() noexcept;
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	void operator=(const ThreadPool&) = delete;
+	void operator=(ThreadPool&&) = delete;
+
+	/// number of distinct worker indices passed to the tasks (at least 1)
+	[[nodiscard]] size_t worker_count() const {
+		return std::max<size_t>(threads.size(), 1);
+	}
+
+	/// runs task(index, worker) for every index in [0, count) and blocks until
+	/// all of them finished. the first exception thrown by a task is rethrown
+	/// here (the remaining indices are skipped)
+	void parallel_for(
+		size_t count,
+		const std::function<void(size_t index, size_t worker)>& task
+	);
+
+  private:
+	void run_worker(size_t worker) noexcept;
+	void run_tasks(size_t worker) noexcept;
+
+	std::vector<std::thread> threads;
+
+	/// serializes parallel_for calls from different threads
+	std::mutex parallel_for_mutex;
+
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_finished;
+	const std::function<void(size_t, size_t)>* current_task = nullptr;
+	size_t task_count = 0;
+	std::atomic<size_t> next_index = 0;
+	size_t busy_workers = 0;
+	uint64_t generation = 0;
+	bool stopping = false;
+	std::exception_ptr first_exception;
+};
\ No newline at end of file
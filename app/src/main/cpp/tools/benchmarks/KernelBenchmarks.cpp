@@ -0,0 +1,1109 @@
+/// Isolated microbenchmarks of the native per-pixel kernels.
+///
+/// Usage: KernelBenchmarks [--output results.json] [--baseline baseline.json]
+///                         [--threshold 5] [--filter normalize]
+///                         [--min-sample-ms 2]
+///        KernelBenchmarks --verify
+///
+/// Results are written as json (ns/pixel and GB/s per kernel and
+/// resolution). With --baseline, every result is compared against the saved
+/// baseline and the process exits with 2 if any kernel regressed by more than
+/// the threshold (in percent).
+///
+/// KernelBenchmarks --verify compares every SimdKernels set that the cpu
+/// supports with the scalar reference on random inputs instead and exits
+/// with 3 on a mismatch.
+
+#include "processing/Colormaps.hpp"
+#include "processing/DepthRegions.hpp"
+#include "processing/GuidedUpsampling.hpp"
+#include "processing/LazyDepth.hpp"
+#include "processing/MotionGate.hpp"
+#include "processing/PointCloud.hpp"
+#include "processing/Postprocessing.hpp"
+#include "processing/Preprocessing.hpp"
+#include "processing/RobustNormalization.hpp"
+#include "recording/DepthRecording.hpp"
+#include "simd/SimdKernels.hpp"
+#include "tflite/TfLiteUtils.hpp"
+#include "utils/ImageUtils.hpp"
+#include "utils/PixelConversion.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Resolution {
+	std::string_view name;
+	size_t width;
+	size_t height;
+
+	[[nodiscard]] size_t pixel_count() const { return width * height; }
+};
+
+constexpr std::array<Resolution, 5> RESOLUTIONS = {
+	Resolution{.name = "210x210", .width = 210, .height = 210},
+	Resolution{.name = "256x256", .width = 256, .height = 256},
+	Resolution{.name = "518x518", .width = 518, .height = 518},
+	Resolution{.name = "720p", .width = 1280, .height = 720},
+	Resolution{.name = "1080p", .width = 1920, .height = 1080},
+};
+
+/// a kernel benchmark prepares its buffers for a resolution and returns the
+/// function that is timed
+struct KernelBenchmark {
+	std::string name;
+	/// bytes read + written by one run for a single pixel
+	size_t bytes_per_pixel;
+	std::function<std::function<void()>(const Resolution&)> setup;
+};
+
+struct BenchmarkResult {
+	std::string kernel;
+	std::string resolution;
+	size_t pixel_count = 0;
+	size_t iterations = 0;
+	double median_ns = 0.0;
+	double ns_per_pixel = 0.0;
+	double gigabytes_per_second = 0.0;
+	std::optional<double> baseline_ns_per_pixel;
+};
+
+static std::vector<float> random_floats(size_t count, float min, float max) {
+	std::mt19937 random_engine(42);
+	std::uniform_real_distribution<float> distribution(min, max);
+	std::vector<float> values(count);
+	for (float& value : values)
+		value = distribution(random_engine);
+	return values;
+}
+
+/// smooth depth like model outputs, random values don't compress
+static std::vector<uint16_t> smooth_depth(const Resolution& resolution) {
+	std::vector<uint16_t> depth(resolution.pixel_count());
+	for (size_t y = 0; y < resolution.height; y++) {
+		for (size_t x = 0; x < resolution.width; x++) {
+			const float value = 0.5f + 0.3f * std::sin((float)x * 0.02f) *
+										   std::cos((float)y * 0.03f);
+			depth[y * resolution.width + x] = (uint16_t)(value * 65535.0f);
+		}
+	}
+	return depth;
+}
+
+static std::vector<int> random_pixels(size_t count) {
+	std::mt19937 random_engine(42);
+	std::uniform_int_distribution<uint32_t> distribution;
+	std::vector<int> pixels(count);
+	for (int& pixel : pixels)
+		pixel = (int)distribution(random_engine);
+	return pixels;
+}
+
+/// TfLiteAffineQuantization with a single scale and zero point, without
+/// needing the tflite library for TfLiteFloatArrayCreate
+struct SingleAffineQuantization {
+	struct FloatArray {
+		int size = 1;
+		float data = 1.0f;
+	};
+	struct IntArray {
+		int size = 1;
+		int data = 0;
+	};
+
+	SingleAffineQuantization(float scale, int zero_point) {
+		scale_array.data = scale;
+		zero_point_array.data = zero_point;
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		quantization.scale = reinterpret_cast<TfLiteFloatArray*>(&scale_array);
+		quantization.zero_point =
+			reinterpret_cast<TfLiteIntArray*>(&zero_point_array);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+		quantization.quantized_dimension = 0;
+	}
+
+	FloatArray scale_array;
+	IntArray zero_point_array;
+	TfLiteAffineQuantization quantization{};
+};
+
+static std::vector<KernelBenchmark> create_kernel_benchmarks() {
+	std::vector<KernelBenchmark> benchmarks;
+
+	benchmarks.push_back(
+		{.name = "normalize_rgb",
+		 .bytes_per_pixel = 2 * 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto values = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count() * 3, 0.0f, 255.0f)
+			 );
+			 return [values]() {
+				 normalize_rgb(
+					 *values, {123.675f, 116.28f, 103.53f},
+					 {58.395f, 57.12f, 57.375f}
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "min_max_scaling",
+		 .bytes_per_pixel = 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto values = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), -10.0f, 1000.0f)
+			 );
+			 return [values]() { min_max_scaling(*values); };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "robust_normalization",
+		 .bytes_per_pixel = 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto values = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), -10.0f, 1000.0f)
+			 );
+			 auto output =
+				 std::make_shared<std::vector<float>>(values->size());
+			 auto normalizer = std::make_shared<RobustDepthNormalizer>(
+				 RobustNormalizationOptions{.bounds_smoothing = 0.3f}
+			 );
+			 auto thread_pool = std::make_shared<ThreadPool>(0);
+			 // the first frame has to find the bin range
+			 normalizer->update(*values, *thread_pool);
+			 return [values, output, normalizer, thread_pool]() {
+				 normalizer->update(*values, *thread_pool);
+				 normalizer->normalize(*values, *output, *thread_pool);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "lazy_depth_range_and_samples",
+		 .bytes_per_pixel = sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto values = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), -10.0f, 1000.0f)
+			 );
+			 return [values, resolution]() {
+				 const LazyDepthFrame frame(
+					 *values, resolution.width, resolution.height
+				 );
+				 for (size_t i = 0; i < 16; i++)
+					 (void)frame.sample((float)i / 16.0f, 0.5f);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "depth_colormap",
+		 .bytes_per_pixel = sizeof(float) + sizeof(int),
+		 .setup = [](const Resolution& resolution) {
+			 auto depth = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), 0.0f, 1.0f)
+			 );
+			 auto pixels =
+				 std::make_shared<std::vector<int>>(resolution.pixel_count());
+			 return [depth, pixels]() { depth_colormap(*depth, *pixels); };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "inferno_depth_colormap",
+		 .bytes_per_pixel = sizeof(float) + sizeof(int),
+		 .setup = [](const Resolution& resolution) {
+			 auto depth = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), 0.0f, 1.0f)
+			 );
+			 auto pixels =
+				 std::make_shared<std::vector<int>>(resolution.pixel_count());
+			 return [depth, pixels]() {
+				 for (size_t i = 0; i < depth->size(); i++)
+					 (*pixels)[i] = inferno_depth_colormap((*depth)[i]);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "colormap_depth_turbo_4096_bitmap",
+		 .bytes_per_pixel = sizeof(float) + 4,
+		 .setup = [](const Resolution& resolution) {
+			 auto depth = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count(), 0.0f, 1.0f)
+			 );
+			 auto pixels = std::make_shared<std::vector<uint8_t>>(
+				 resolution.pixel_count() * 4
+			 );
+			 return [depth, pixels, resolution]() {
+				 colormap_depth(
+					 *depth, resolution.width, resolution.height,
+					 MutableRgbaImageView{
+						 .pixels = *pixels,
+						 .width = resolution.width,
+						 .height = resolution.height,
+						 .stride = resolution.width * 4,
+					 },
+					 {.colormap = Colormap::Turbo,
+					  .resolution = ColormapResolution::Entries4096}
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "rgba_pixels_to_rgb_hwc_255_float_array",
+		 .bytes_per_pixel = sizeof(int) + 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto pixels = std::make_shared<std::vector<int>>(
+				 random_pixels(resolution.pixel_count())
+			 );
+			 auto output = std::make_shared<std::vector<float>>(
+				 resolution.pixel_count() * 3
+			 );
+			 return [pixels, output]() {
+				 rgba_pixels_to_rgb_hwc_255_float_array(*pixels, *output);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "rgba_pixels_to_rgb_chw_float_array",
+		 .bytes_per_pixel = sizeof(int) + 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto pixels = std::make_shared<std::vector<int>>(
+				 random_pixels(resolution.pixel_count())
+			 );
+			 auto output = std::make_shared<std::vector<float>>(
+				 resolution.pixel_count() * 3
+			 );
+			 return [pixels, output]() {
+				 rgba_pixels_to_rgb_chw_float_array(*pixels, *output);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "convert_pixels_rgba_to_chw_float16",
+		 .bytes_per_pixel = 4 + 3 * sizeof(Float16),
+		 .setup = [](const Resolution& resolution) {
+			 auto pixels = std::make_shared<std::vector<int>>(
+				 random_pixels(resolution.pixel_count())
+			 );
+			 auto output = std::make_shared<std::vector<Float16>>(
+				 resolution.pixel_count() * 3
+			 );
+			 return [resolution, pixels, output]() {
+				 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+				 const RgbaImageView image{
+					 .pixels = {reinterpret_cast<const uint8_t*>(pixels->data()),
+								pixels->size() * sizeof(int)},
+					 .width = resolution.width,
+					 .height = resolution.height,
+					 .stride = resolution.width * 4,
+				 };
+				 // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+				 convert_pixels<PixelFormat::Rgba, ImageLayout::Chw>(
+					 image, std::span(*output),
+					 ChannelScaling::normalized(
+						 1.0f, {0.485f, 0.456f, 0.406f},
+						 {0.229f, 0.224f, 0.225f}
+					 )
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "convert_pixels_nv21_to_hwc_float",
+		 .bytes_per_pixel = 2 + 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 const size_t chroma_stride = 2 * ((resolution.width + 1) / 2);
+			 const size_t chroma_size =
+				 chroma_stride * ((resolution.height + 1) / 2);
+			 auto planes = std::make_shared<std::vector<int>>(random_pixels(
+				 (resolution.pixel_count() + chroma_size + 3) / 4
+			 ));
+			 auto output = std::make_shared<std::vector<float>>(
+				 resolution.pixel_count() * 3
+			 );
+			 return [resolution, chroma_stride, chroma_size, planes, output]() {
+				 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+				 const auto* bytes =
+					 reinterpret_cast<const uint8_t*>(planes->data());
+				 // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+				 const YuvImageView image{
+					 .luma = {bytes, resolution.pixel_count()},
+					 .chroma = {bytes + resolution.pixel_count(), chroma_size},
+					 .width = resolution.width,
+					 .height = resolution.height,
+					 .luma_stride = resolution.width,
+					 .chroma_stride = chroma_stride,
+				 };
+				 convert_pixels<PixelFormat::Nv21, ImageLayout::Hwc>(
+					 image, std::span(*output)
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "image_bytes_to_argb_int_array",
+		 .bytes_per_pixel = 4 + sizeof(int32_t),
+		 .setup = [](const Resolution& resolution) {
+			 auto pixels = std::make_shared<std::vector<int>>(
+				 random_pixels(resolution.pixel_count())
+			 );
+			 auto output =
+				 std::make_shared<std::vector<int32_t>>(resolution.pixel_count());
+			 return [pixels, output]() {
+				 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+				 const auto bytes = std::span<const int8_t>(
+					 reinterpret_cast<const int8_t*>(pixels->data()),
+					 pixels->size() * sizeof(int)
+				 );
+				 // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+				 image_bytes_to_argb_int_array(bytes, *output);
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "motion_gate_evaluate",
+		 .bytes_per_pixel = 3 * sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto frames = std::make_shared<std::array<std::vector<float>, 2>>(
+			 );
+			 for (auto& frame : *frames)
+				 frame = random_floats(resolution.pixel_count() * 3, 0.0f, 255.0f);
+			 auto depth = std::make_shared<std::vector<float>>(
+				 resolution.pixel_count()
+			 );
+			 auto motion_gate = std::make_shared<MotionGate>();
+			 (void)motion_gate->evaluate(
+				 (*frames)[0], resolution.width, resolution.height,
+				 ImageLayout::Hwc, 255.0f
+			 );
+			 motion_gate->update_reference(*depth);
+			 // a changed frame, the worst case that includes the global
+			 // motion search
+			 return [frames, motion_gate, resolution]() {
+				 (void)motion_gate->evaluate(
+					 (*frames)[1], resolution.width, resolution.height,
+					 ImageLayout::Hwc, 255.0f
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "quantize",
+		 .bytes_per_pixel = 3 * (sizeof(float) + sizeof(uint8_t)),
+		 .setup = [](const Resolution& resolution) {
+			 auto values = std::make_shared<std::vector<float>>(
+				 random_floats(resolution.pixel_count() * 3, 0.0f, 255.0f)
+			 );
+			 auto quantized = std::make_shared<std::vector<std::byte>>(
+				 resolution.pixel_count() * 3
+			 );
+			 auto quantization =
+				 std::make_shared<SingleAffineQuantization>(1.0f, 0);
+			 return [values, quantized, quantization]() {
+				 quantize<float>(
+					 *values, *quantized, kTfLiteUInt8,
+					 quantization->quantization
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "dequantize",
+		 .bytes_per_pixel = sizeof(uint8_t) + sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 auto quantized = std::make_shared<std::vector<std::byte>>(
+				 resolution.pixel_count()
+			 );
+			 for (size_t i = 0; i < quantized->size(); i++)
+				 (*quantized)[i] = (std::byte)(i * 31);
+			 auto values =
+				 std::make_shared<std::vector<float>>(resolution.pixel_count());
+			 auto quantization =
+				 std::make_shared<SingleAffineQuantization>(0.05f, 12);
+			 return [quantized, values, quantization]() {
+				 dequantize<float>(
+					 *quantized, *values, kTfLiteUInt8,
+					 quantization->quantization
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "depth_encode",
+		 .bytes_per_pixel = sizeof(uint16_t),
+		 .setup = [](const Resolution& resolution) {
+			 auto quantized = std::make_shared<std::vector<uint16_t>>(
+				 smooth_depth(resolution)
+			 );
+			 auto encoded = std::make_shared<std::vector<uint8_t>>();
+			 return [quantized, encoded, resolution]() {
+				 encoded->clear();
+				 encode_depth_rows(
+					 *quantized, resolution.width, resolution.height, *encoded
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "depth_decode",
+		 .bytes_per_pixel = sizeof(uint16_t),
+		 .setup = [](const Resolution& resolution) {
+			 auto encoded = std::make_shared<std::vector<uint8_t>>();
+			 encode_depth_rows(
+				 smooth_depth(resolution), resolution.width, resolution.height,
+				 *encoded
+			 );
+			 auto quantized = std::make_shared<std::vector<uint16_t>>(
+				 resolution.pixel_count()
+			 );
+			 return [encoded, quantized, resolution]() {
+				 decode_depth_rows(
+					 *encoded, resolution.width, resolution.height, *quantized
+				 );
+			 };
+		 }}
+	);
+
+	const auto point_cloud_benchmark = [](float voxel_size) {
+		return [voxel_size](const Resolution& resolution) {
+			const auto quantized = smooth_depth(resolution);
+			auto depth = std::make_shared<std::vector<float>>(quantized.size());
+			std::ranges::transform(
+				quantized, depth->begin(),
+				[](uint16_t value) { return 0.05f + (float)value / 65535.0f; }
+			);
+			auto colors = std::make_shared<std::vector<int>>(
+				resolution.pixel_count(), color_rgb(200, 100, 50)
+			);
+			auto generator = std::make_shared<PointCloudGenerator>();
+			const PointCloudOptions options{
+				.intrinsics = intrinsics_from_field_of_view(
+					resolution.width, resolution.height, 1.2f
+				),
+				.voxel_size = voxel_size,
+			};
+			return [depth, colors, generator, options, resolution]() {
+				(void)generator->generate(
+					*depth, resolution.width, resolution.height, *colors,
+					options
+				);
+			};
+		};
+	};
+
+	benchmarks.push_back(
+		{.name = "point_cloud",
+		 .bytes_per_pixel = sizeof(float) + sizeof(int) + sizeof(PointXYZRGB),
+		 .setup = point_cloud_benchmark(0.0f)}
+	);
+
+	benchmarks.push_back(
+		{.name = "point_cloud_voxel_downsample",
+		 .bytes_per_pixel = sizeof(float) + sizeof(int) + sizeof(PointXYZRGB),
+		 .setup = point_cloud_benchmark(0.05f)}
+	);
+
+	benchmarks.push_back(
+		{.name = "guided_upsampling_from_256x256",
+		 .bytes_per_pixel = 4 + sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 constexpr size_t DEPTH_SIZE = 256;
+			 const auto quantized = smooth_depth(
+				 Resolution{.width = DEPTH_SIZE, .height = DEPTH_SIZE}
+			 );
+			 auto depth = std::make_shared<std::vector<float>>(quantized.size());
+			 std::ranges::transform(
+				 quantized, depth->begin(),
+				 [](uint16_t value) { return (float)value / 65535.0f; }
+			 );
+			 auto guide = std::make_shared<std::vector<uint8_t>>(
+				 resolution.pixel_count() * 4
+			 );
+			 std::mt19937 random_engine(42);
+			 std::ranges::generate(*guide, [&]() {
+				 return (uint8_t)random_engine();
+			 });
+			 auto output =
+				 std::make_shared<std::vector<float>>(resolution.pixel_count());
+			 auto upsampler = std::make_shared<GuidedDepthUpsampler>();
+			 // single threaded, comparable to the other kernels
+			 auto thread_pool = std::make_shared<ThreadPool>(0);
+			 return [depth, guide, output, upsampler, thread_pool, resolution]() {
+				 upsampler->upsample(
+					 *depth, DEPTH_SIZE, DEPTH_SIZE,
+					 RgbaImageView{
+						 .pixels = *guide,
+						 .width = resolution.width,
+						 .height = resolution.height,
+						 .stride = resolution.width * 4,
+					 },
+					 *output, *thread_pool
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "depth_bokeh",
+		 .bytes_per_pixel = 4 + sizeof(float) + 4,
+		 .setup = [](const Resolution& resolution) {
+			 const auto quantized = smooth_depth(resolution);
+			 auto depth = std::make_shared<std::vector<float>>(quantized.size());
+			 std::ranges::transform(
+				 quantized, depth->begin(),
+				 [](uint16_t value) { return (float)value / 65535.0f; }
+			 );
+			 auto image = std::make_shared<std::vector<uint8_t>>(
+				 resolution.pixel_count() * 4
+			 );
+			 std::mt19937 random_engine(42);
+			 std::ranges::generate(*image, [&]() {
+				 return (uint8_t)random_engine();
+			 });
+			 auto output = std::make_shared<std::vector<uint8_t>>(image->size());
+			 auto renderer = std::make_shared<DepthBokehRenderer>();
+			 auto thread_pool = std::make_shared<ThreadPool>(0);
+			 return [depth, image, output, renderer, thread_pool, resolution]() {
+				 renderer->render(
+					 RgbaImageView{
+						 .pixels = *image,
+						 .width = resolution.width,
+						 .height = resolution.height,
+						 .stride = resolution.width * 4,
+					 },
+					 *depth, resolution.width, resolution.height,
+					 MutableRgbaImageView{
+						 .pixels = *output,
+						 .width = resolution.width,
+						 .height = resolution.height,
+						 .stride = resolution.width * 4,
+					 },
+					 *thread_pool, {.focus_depth = 0.5f}
+				 );
+			 };
+		 }}
+	);
+
+	benchmarks.push_back(
+		{.name = "depth_region_index",
+		 .bytes_per_pixel = sizeof(float),
+		 .setup = [](const Resolution& resolution) {
+			 const auto quantized = smooth_depth(resolution);
+			 auto depth = std::make_shared<std::vector<float>>(quantized.size());
+			 std::ranges::transform(
+				 quantized, depth->begin(),
+				 [](uint16_t value) { return (float)value / 65535.0f; }
+			 );
+			 auto index = std::make_shared<DepthRegionIndex>();
+			 return [depth, index, resolution]() {
+				 index->build(*depth, resolution.width, resolution.height);
+				 // a few object sized queries, as the ui would run per frame
+				 for (size_t i = 0; i < 16; i++) {
+					 const DepthRegion region{
+						 .x = i * resolution.width / 16,
+						 .y = i * resolution.height / 16,
+						 .width = resolution.width / 4,
+						 .height = resolution.height / 4,
+					 };
+					 (void)index->stats(region);
+					 (void)index->percentile(region, 0.5f);
+				 }
+			 };
+		 }}
+	);
+
+	// every kernel set that the cpu supports, compared with the scalar
+	// reference they show the gain of the explicit vectorization
+	for (const SimdKernels* kernels : supported_simd_kernels()) {
+		benchmarks.push_back(
+			{.name = std::format("simd_scale_offset_rgb_{}", kernels->name),
+			 .bytes_per_pixel = 2 * 3 * sizeof(float),
+			 .setup = [kernels](const Resolution& resolution) {
+				 auto values = std::make_shared<std::vector<float>>(
+					 random_floats(resolution.pixel_count() * 3, 0.0f, 255.0f)
+				 );
+				 return [kernels, values]() {
+					 kernels->scale_offset_rgb(
+						 *values,
+						 {1.0f / 58.395f, 1.0f / 57.12f, 1.0f / 57.375f},
+						 {-2.118f, -2.036f, -1.804f}
+					 );
+				 };
+			 }}
+		);
+
+		benchmarks.push_back(
+			{.name = std::format("simd_min_max_{}", kernels->name),
+			 .bytes_per_pixel = sizeof(float),
+			 .setup = [kernels](const Resolution& resolution) {
+				 auto values = std::make_shared<std::vector<float>>(
+					 random_floats(resolution.pixel_count(), -10.0f, 1000.0f)
+				 );
+				 return [kernels, values]() {
+					 (void)kernels->min_max(*values);
+				 };
+			 }}
+		);
+
+		benchmarks.push_back(
+			{.name = std::format("simd_rgba_to_rgb_{}", kernels->name),
+			 .bytes_per_pixel = 4 + 3 * sizeof(float),
+			 .setup = [kernels](const Resolution& resolution) {
+				 auto pixels = std::make_shared<std::vector<int>>(
+					 random_pixels(resolution.pixel_count())
+				 );
+				 auto output = std::make_shared<std::vector<float>>(
+					 resolution.pixel_count() * 3
+				 );
+				 return [kernels, pixels, output]() {
+					 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+					 kernels->rgba_to_rgb(
+						 {reinterpret_cast<const uint8_t*>(pixels->data()),
+						  pixels->size() * sizeof(int)},
+						 *output, {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}
+					 );
+					 // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+				 };
+			 }}
+		);
+
+		benchmarks.push_back(
+			{.name = std::format("simd_dequantize_uint8_{}", kernels->name),
+			 .bytes_per_pixel = 1 + sizeof(float),
+			 .setup = [kernels](const Resolution& resolution) {
+				 auto pixels = std::make_shared<std::vector<int>>(
+					 random_pixels((resolution.pixel_count() + 3) / 4)
+				 );
+				 auto output = std::make_shared<std::vector<float>>(
+					 resolution.pixel_count()
+				 );
+				 return [kernels, pixels, output]() {
+					 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+					 kernels->dequantize_uint8(
+						 {reinterpret_cast<const uint8_t*>(pixels->data()),
+						  output->size()},
+						 *output, 0.05f, 3
+					 );
+					 // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+				 };
+			 }}
+		);
+	}
+
+	return benchmarks;
+}
+
+/// true if the values agree up to float rounding
+static bool
+nearly_equal(std::span<const float> expected, std::span<const float> actual) {
+	for (size_t i = 0; i < expected.size(); i++) {
+		const float tolerance = 1e-5f * std::max(1.0f, std::fabs(expected[i]));
+		if (!(std::fabs(expected[i] - actual[i]) <= tolerance))
+			return false;
+	}
+	return true;
+}
+
+/// runs every kernel of every supported kernel set on random inputs around
+/// the vector widths and compares the results with the scalar reference.
+/// the outputs are followed by guard values that must not be written
+static bool verify_simd_kernels() {
+	constexpr size_t GUARD_SIZE = 16;
+	constexpr float GUARD_VALUE = -12345.0f;
+
+	std::vector<size_t> sizes;
+	for (size_t size = 1; size <= 67; size++)
+		sizes.push_back(size);
+	sizes.insert(sizes.end(), {255, 1000, 4099});
+
+	std::mt19937 random_engine(7);
+	std::uniform_real_distribution<float> float_distribution(-1000.0f, 1000.0f);
+	std::uniform_int_distribution<uint32_t> byte_distribution(0, 255);
+	const auto random_values = [&](size_t count) {
+		std::vector<float> values(count + GUARD_SIZE, GUARD_VALUE);
+		for (size_t i = 0; i < count; i++)
+			values[i] = float_distribution(random_engine);
+		return values;
+	};
+	const auto random_bytes = [&](size_t count) {
+		std::vector<uint8_t> bytes(count);
+		for (uint8_t& byte : bytes)
+			byte = (uint8_t)byte_distribution(random_engine);
+		return bytes;
+	};
+	const auto guard_intact = [&](std::span<const float> values, size_t count) {
+		return std::ranges::all_of(values.subspan(count), [&](float value) {
+			return value == GUARD_VALUE;
+		});
+	};
+
+	const std::array<float, 3> scale = {0.017f, -0.5f, 3.0f};
+	const std::array<float, 3> offset = {-2.1f, 7.0f, 0.25f};
+	const auto& reference = SCALAR_KERNELS;
+
+	bool all_passed = true;
+	for (const SimdKernels* kernels : supported_simd_kernels()) {
+		if (kernels == &reference)
+			continue;
+
+		std::vector<std::string> failures;
+		const auto check =
+			[&](bool passed, std::string_view kernel, size_t size) {
+				if (!passed) {
+					failures.push_back(
+						std::format("{} ({} values)", kernel, size)
+					);
+				}
+			};
+		for (const size_t size : sizes) {
+			{
+				auto expected = random_values(size);
+				auto actual = expected;
+				reference.scale_offset(
+					std::span(expected).first(size), scale[0], offset[0]
+				);
+				kernels->scale_offset(
+					std::span(actual).first(size), scale[0], offset[0]
+				);
+				check(
+					nearly_equal(expected, actual) &&
+						guard_intact(actual, size),
+					"scale_offset", size
+				);
+			}
+			{
+				auto expected = random_values(size * 3);
+				auto actual = expected;
+				reference.scale_offset_rgb(
+					std::span(expected).first(size * 3), scale, offset
+				);
+				kernels->scale_offset_rgb(
+					std::span(actual).first(size * 3), scale, offset
+				);
+				check(
+					nearly_equal(expected, actual) &&
+						guard_intact(actual, size * 3),
+					"scale_offset_rgb", size * 3
+				);
+			}
+			{
+				const auto values = random_values(size);
+				const auto expected =
+					reference.min_max(std::span(values).first(size));
+				const auto actual =
+					kernels->min_max(std::span(values).first(size));
+				check(
+					expected.min == actual.min && expected.max == actual.max,
+					"min_max", size
+				);
+			}
+			{
+				const auto pixels = random_bytes(size * 4);
+				std::vector<float> expected(size * 3 + GUARD_SIZE, GUARD_VALUE);
+				auto actual = expected;
+				reference.rgba_to_rgb(
+					pixels, std::span(expected).first(size * 3), scale, offset
+				);
+				kernels->rgba_to_rgb(
+					pixels, std::span(actual).first(size * 3), scale, offset
+				);
+				check(
+					nearly_equal(expected, actual) &&
+						guard_intact(actual, size * 3),
+					"rgba_to_rgb", size
+				);
+			}
+			{
+				const auto quantized = random_bytes(size);
+				std::vector<float> expected(size + GUARD_SIZE, GUARD_VALUE);
+				auto actual = expected;
+				reference.dequantize_uint8(
+					quantized, std::span(expected).first(size), 0.05f, 131
+				);
+				kernels->dequantize_uint8(
+					quantized, std::span(actual).first(size), 0.05f, 131
+				);
+				check(
+					nearly_equal(expected, actual) &&
+						guard_intact(actual, size),
+					"dequantize_uint8", size
+				);
+			}
+		}
+
+		std::fprintf(
+			stderr, "%s\n",
+			std::format(
+				"{:<8} {}", kernels->name,
+				failures.empty() ? "matches the scalar kernels"
+								 : std::format("{} mismatches", failures.size())
+			)
+				.c_str()
+		);
+		for (const auto& failure : failures)
+			std::fprintf(stderr, "  %s\n", failure.c_str());
+		all_passed &= failures.empty();
+	}
+	return all_passed;
+}
+
+/// the kernels record profiling scopes, which have to be flushed so that the
+/// records do not pile up over thousands of iterations
+static void reset_profiling_frames() {
+	(void)get_depth_profiling_frame().finish();
+	(void)get_camera_profiling_frame().finish();
+}
+
+static BenchmarkResult run_benchmark(
+	const KernelBenchmark& benchmark,
+	const Resolution& resolution,
+	profile_clock::duration min_sample_duration
+) {
+	constexpr size_t WARMUP_RUNS = 3;
+	constexpr size_t SAMPLE_COUNT = 21;
+
+	const auto kernel = benchmark.setup(resolution);
+
+	for (size_t i = 0; i < WARMUP_RUNS; i++)
+		kernel();
+	reset_profiling_frames();
+
+	// calibrate the number of runs per sample so that each sample is long
+	// enough for the clock resolution
+	size_t runs_per_sample = 1;
+	while (true) {
+		const auto start = profile_clock::now();
+		for (size_t i = 0; i < runs_per_sample; i++)
+			kernel();
+		const auto duration = profile_clock::now() - start;
+		reset_profiling_frames();
+		if (duration >= min_sample_duration || runs_per_sample >= (1 << 20))
+			break;
+		runs_per_sample *= 2;
+	}
+
+	std::vector<double> sample_ns_per_run;
+	sample_ns_per_run.reserve(SAMPLE_COUNT);
+	for (size_t sample = 0; sample < SAMPLE_COUNT; sample++) {
+		const auto start = profile_clock::now();
+		for (size_t i = 0; i < runs_per_sample; i++)
+			kernel();
+		const auto duration = profile_clock::now() - start;
+		reset_profiling_frames();
+
+		sample_ns_per_run.push_back(
+			(double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				duration
+			)
+				.count() /
+			(double)runs_per_sample
+		);
+	}
+	std::ranges::sort(sample_ns_per_run);
+	const double median_ns = sample_ns_per_run[SAMPLE_COUNT / 2];
+
+	const auto pixel_count = resolution.pixel_count();
+	return BenchmarkResult{
+		.kernel = std::string(benchmark.name),
+		.resolution = std::string(resolution.name),
+		.pixel_count = pixel_count,
+		.iterations = runs_per_sample * SAMPLE_COUNT,
+		.median_ns = median_ns,
+		.ns_per_pixel = median_ns / (double)pixel_count,
+		// bytes per nanosecond equals gigabytes per second
+		.gigabytes_per_second =
+			(double)(benchmark.bytes_per_pixel * pixel_count) / median_ns,
+	};
+}
+
+static std::string format_results_json(std::span<const BenchmarkResult> results
+) {
+	std::string json = "{\n\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& result = results[i];
+		json += std::format(
+			"\t\t{{\"kernel\": \"{}\", \"resolution\": \"{}\", "
+			"\"pixels\": {}, \"iterations\": {}, \"median_ns\": {:.1f}, "
+			"\"ns_per_pixel\": {:.4f}, \"gigabytes_per_second\": {:.3f}",
+			result.kernel, result.resolution, result.pixel_count,
+			result.iterations, result.median_ns, result.ns_per_pixel,
+			result.gigabytes_per_second
+		);
+		if (result.baseline_ns_per_pixel.has_value()) {
+			json += std::format(
+				", \"baseline_ns_per_pixel\": {:.4f}, \"speedup\": {:.3f}",
+				*result.baseline_ns_per_pixel,
+				*result.baseline_ns_per_pixel / result.ns_per_pixel
+			);
+		}
+		json += i + 1 < results.size() ? "},\n" : "}\n";
+	}
+	json += "\t]\n}\n";
+	return json;
+}
+
+/// extracts the value of "key": in a flat json object, strings are returned
+/// without quotes
+static std::optional<std::string>
+find_json_value(std::string_view object, std::string_view key) {
+	const auto key_position = object.find(std::format("\"{}\":", key));
+	if (key_position == std::string_view::npos)
+		return std::nullopt;
+
+	auto value = object.substr(key_position + key.size() + 3);
+	value.remove_prefix(std::min(value.find_first_not_of(" \t"), value.size())
+	);
+	if (value.starts_with('"')) {
+		value.remove_prefix(1);
+		return std::string(value.substr(0, value.find('"')));
+	}
+	return std::string(value.substr(0, value.find_first_of(",}")));
+}
+
+/// reads a json file written by format_results_json
+static std::vector<BenchmarkResult> read_baseline(const std::string& path) {
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path));
+	std::stringstream content;
+	content << file.rdbuf();
+	const std::string json = content.str();
+
+	std::vector<BenchmarkResult> baseline;
+	size_t object_start = json.find("{\"kernel\"");
+	while (object_start != std::string::npos) {
+		const size_t object_end = json.find('}', object_start);
+		const auto object = std::string_view(json).substr(
+			object_start, object_end - object_start + 1
+		);
+
+		const auto kernel = find_json_value(object, "kernel");
+		const auto resolution = find_json_value(object, "resolution");
+		const auto ns_per_pixel = find_json_value(object, "ns_per_pixel");
+		if (kernel && resolution && ns_per_pixel) {
+			baseline.push_back(BenchmarkResult{
+				.kernel = *kernel,
+				.resolution = *resolution,
+				.ns_per_pixel = std::stod(*ns_per_pixel),
+			});
+		}
+
+		object_start = json.find("{\"kernel\"", object_end);
+	}
+	return baseline;
+}
+
+int main(int argc, char** argv) {
+	std::optional<std::string> output_path;
+	std::optional<std::string> baseline_path;
+	std::string filter;
+	double regression_threshold_percent = 5.0;
+	double min_sample_ms = 2.0;
+
+	const std::vector<std::string_view> args(argv + 1, argv + argc);
+	for (size_t i = 0; i < args.size(); i++) {
+		const bool has_value = i + 1 < args.size();
+		if (args[i] == "--output" && has_value) {
+			output_path = std::string(args[++i]);
+		} else if (args[i] == "--baseline" && has_value) {
+			baseline_path = std::string(args[++i]);
+		} else if (args[i] == "--filter" && has_value) {
+			filter = std::string(args[++i]);
+		} else if (args[i] == "--threshold" && has_value) {
+			regression_threshold_percent = std::stod(std::string(args[++i]));
+		} else if (args[i] == "--min-sample-ms" && has_value) {
+			min_sample_ms = std::stod(std::string(args[++i]));
+		} else if (args[i] == "--verify") {
+			return verify_simd_kernels() ? 0 : 3;
+		} else {
+			std::fprintf(stderr, "unknown argument: %s\n", args[i].data());
+			return 1;
+		}
+	}
+
+	const auto min_sample_duration =
+		std::chrono::duration_cast<profile_clock::duration>(
+			std::chrono::duration<double, std::milli>(min_sample_ms)
+		);
+
+	std::vector<BenchmarkResult> baseline;
+	if (baseline_path.has_value())
+		baseline = read_baseline(*baseline_path);
+
+	std::vector<BenchmarkResult> results;
+	bool regressed = false;
+	for (const auto& benchmark : create_kernel_benchmarks()) {
+		if (!filter.empty() && benchmark.name.find(filter) == std::string_view::npos)
+			continue;
+
+		for (const auto& resolution : RESOLUTIONS) {
+			auto result =
+				run_benchmark(benchmark, resolution, min_sample_duration);
+
+			std::string comparison;
+			const auto baseline_result =
+				std::ranges::find_if(baseline, [&](const auto& entry) {
+					return entry.kernel == result.kernel &&
+						   entry.resolution == result.resolution;
+				});
+			if (baseline_result != baseline.end()) {
+				result.baseline_ns_per_pixel = baseline_result->ns_per_pixel;
+				const double change_percent =
+					(result.ns_per_pixel / baseline_result->ns_per_pixel -
+					 1.0) *
+					100.0;
+				const bool is_regression =
+					change_percent > regression_threshold_percent;
+				regressed |= is_regression;
+				comparison = std::format(
+					"  {:+.1f}% vs baseline{}", change_percent,
+					is_regression ? " (REGRESSION)" : ""
+				);
+			}
+
+			std::fprintf(
+				stderr, "%s\n",
+				std::format(
+					"{:<40} {:>8}: {:8.3f} ns/pixel {:8.2f} GB/s{}",
+					result.kernel, result.resolution, result.ns_per_pixel,
+					result.gigabytes_per_second, comparison
+				)
+					.c_str()
+			);
+			results.push_back(std::move(result));
+		}
+	}
+
+	const std::string json = format_results_json(results);
+	if (output_path.has_value()) {
+		std::ofstream(*output_path) << json;
+	} else {
+		std::fputs(json.c_str(), stdout);
+	}
+
+	return regressed ? 2 : 0;
+}
\ No newline at end of file
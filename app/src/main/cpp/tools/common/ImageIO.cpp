@@ -0,0 +1,331 @@
+#include "ImageIO.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+std::vector<std::byte> read_file_bytes(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string())
+		);
+
+	const auto size = (size_t)file.tellg();
+	std::vector<std::byte> bytes(size);
+	file.seekg(0);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	file.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)size);
+	return bytes;
+}
+
+/// reads the next whitespace separated header token, skipping comments
+static std::string read_header_token(std::istream& stream) {
+	std::string token;
+	while (stream >> token) {
+		if (!token.starts_with('#'))
+			return token;
+		std::string comment;
+		std::getline(stream, comment);
+	}
+	throw std::runtime_error("unexpected end of image header");
+}
+
+RgbaImage read_ppm(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string())
+		);
+
+	if (read_header_token(file) != "P6")
+		throw std::runtime_error(
+			std::format("{} is not a binary ppm (P6) image", path.string())
+		);
+	RgbaImage image;
+	image.width = std::stoul(read_header_token(file));
+	image.height = std::stoul(read_header_token(file));
+	if (std::stoul(read_header_token(file)) != 255)
+		throw std::runtime_error(
+			std::format("{}: only 8 bit ppm images are supported", path.string())
+		);
+	file.get(); // single whitespace after the header
+
+	std::vector<uint8_t> rgb(image.pixel_count() * 3);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	file.read(reinterpret_cast<char*>(rgb.data()), (std::streamsize)rgb.size());
+	if (!file)
+		throw std::runtime_error(std::format("{} is truncated", path.string()));
+
+	image.pixels.resize(image.pixel_count() * 4);
+	for (size_t i = 0; i < image.pixel_count(); i++) {
+		image.pixels[i * 4 + 0] = rgb[i * 3 + 0];
+		image.pixels[i * 4 + 1] = rgb[i * 3 + 1];
+		image.pixels[i * 4 + 2] = rgb[i * 3 + 2];
+		image.pixels[i * 4 + 3] = 255;
+	}
+	return image;
+}
+
+static uint32_t read_big_endian_u32(const std::byte* bytes) {
+	return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+		   ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+static uint8_t paeth_predictor(uint8_t left, uint8_t up, uint8_t up_left) {
+	const int estimate = (int)left + (int)up - (int)up_left;
+	const int distance_left = std::abs(estimate - (int)left);
+	const int distance_up = std::abs(estimate - (int)up);
+	const int distance_up_left = std::abs(estimate - (int)up_left);
+	if (distance_left <= distance_up && distance_left <= distance_up_left)
+		return left;
+	return distance_up <= distance_up_left ? up : up_left;
+}
+
+RgbaImage read_png(const std::filesystem::path& path) {
+	constexpr std::array<uint8_t, 8> PNG_SIGNATURE = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+	};
+
+	const auto bytes = read_file_bytes(path);
+	if (bytes.size() < PNG_SIGNATURE.size() ||
+		std::memcmp(bytes.data(), PNG_SIGNATURE.data(), PNG_SIGNATURE.size()) !=
+			0)
+		throw std::runtime_error(
+			std::format("{} is not a png image", path.string())
+		);
+
+	RgbaImage image;
+	size_t channels = 0;
+	std::vector<uint8_t> compressed;
+	for (size_t offset = PNG_SIGNATURE.size(); offset + 12 <= bytes.size();) {
+		const uint32_t length = read_big_endian_u32(&bytes[offset]);
+		const auto type = std::string_view(
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			reinterpret_cast<const char*>(&bytes[offset + 4]), 4
+		);
+		const std::byte* data = &bytes[offset + 8];
+		if (offset + 12 + length > bytes.size())
+			throw std::runtime_error(std::format("{} is truncated", path.string()));
+
+		if (type == "IHDR") {
+			image.width = read_big_endian_u32(data);
+			image.height = read_big_endian_u32(data + 4);
+			const auto bit_depth = (uint8_t)data[8];
+			const auto color_type = (uint8_t)data[9];
+			const auto interlace = (uint8_t)data[12];
+			channels = color_type == 0   ? 1
+					   : color_type == 4 ? 2
+					   : color_type == 2 ? 3
+					   : color_type == 6 ? 4
+										 : 0;
+			if (bit_depth != 8 || channels == 0 || interlace != 0)
+				throw std::runtime_error(std::format(
+					"{}: only non interlaced 8 bit gray / rgb(a) png images "
+					"are supported",
+					path.string()
+				));
+		} else if (type == "IDAT") {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			const auto* idat = reinterpret_cast<const uint8_t*>(data);
+			compressed.insert(compressed.end(), idat, idat + length);
+		} else if (type == "IEND") {
+			break;
+		}
+		offset += 12 + length;
+	}
+	if (channels == 0)
+		throw std::runtime_error(
+			std::format("{} has no IHDR chunk", path.string())
+		);
+
+	// every row starts with its filter type
+	const size_t stride = image.width * channels;
+	std::vector<uint8_t> filtered((stride + 1) * image.height);
+	auto filtered_size = (uLongf)filtered.size();
+	if (uncompress(
+			filtered.data(), &filtered_size, compressed.data(),
+			(uLong)compressed.size()
+		) != Z_OK ||
+		filtered_size != filtered.size())
+		throw std::runtime_error(
+			std::format("{}: invalid image data", path.string())
+		);
+
+	std::vector<uint8_t> pixels(stride * image.height);
+	for (size_t y = 0; y < image.height; y++) {
+		const uint8_t filter = filtered[y * (stride + 1)];
+		const uint8_t* source = &filtered[y * (stride + 1) + 1];
+		uint8_t* row = &pixels[y * stride];
+		const uint8_t* previous_row = y > 0 ? &pixels[(y - 1) * stride] : nullptr;
+
+		for (size_t i = 0; i < stride; i++) {
+			const uint8_t left = i >= channels ? row[i - channels] : 0;
+			const uint8_t up = previous_row != nullptr ? previous_row[i] : 0;
+			const uint8_t up_left = previous_row != nullptr && i >= channels
+										? previous_row[i - channels]
+										: 0;
+			uint8_t prediction = 0;
+			switch (filter) {
+			case 0:
+				break;
+			case 1:
+				prediction = left;
+				break;
+			case 2:
+				prediction = up;
+				break;
+			case 3:
+				prediction = (uint8_t)(((int)left + (int)up) / 2);
+				break;
+			case 4:
+				prediction = paeth_predictor(left, up, up_left);
+				break;
+			default:
+				throw std::runtime_error(std::format(
+					"{}: invalid filter type {}", path.string(), filter
+				));
+			}
+			row[i] = (uint8_t)(source[i] + prediction);
+		}
+	}
+
+	image.pixels.resize(image.pixel_count() * 4);
+	for (size_t i = 0; i < image.pixel_count(); i++) {
+		const uint8_t* pixel = &pixels[i * channels];
+		const bool gray = channels <= 2;
+		image.pixels[i * 4 + 0] = pixel[0];
+		image.pixels[i * 4 + 1] = gray ? pixel[0] : pixel[1];
+		image.pixels[i * 4 + 2] = gray ? pixel[0] : pixel[2];
+		image.pixels[i * 4 + 3] = channels == 2   ? pixel[1]
+								  : channels == 4 ? pixel[3]
+												  : 255;
+	}
+	return image;
+}
+
+RgbaImage read_image(const std::filesystem::path& path) {
+	if (path.extension() == ".png")
+		return read_png(path);
+	return read_ppm(path);
+}
+
+DepthImage read_pfm(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string())
+		);
+
+	if (read_header_token(file) != "Pf")
+		throw std::runtime_error(
+			std::format("{} is not a grayscale pfm image", path.string())
+		);
+	DepthImage image;
+	image.width = std::stoul(read_header_token(file));
+	image.height = std::stoul(read_header_token(file));
+	const float scale = std::stof(read_header_token(file));
+	file.get();
+
+	const bool little_endian = scale < 0.0f;
+	image.values.resize(image.width * image.height);
+	// pfm rows are stored bottom to top
+	for (size_t row = 0; row < image.height; row++) {
+		auto* row_data = &image.values[(image.height - 1 - row) * image.width];
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		file.read(
+			reinterpret_cast<char*>(row_data),
+			(std::streamsize)(image.width * sizeof(float))
+		);
+		if (little_endian != (std::endian::native == std::endian::little)) {
+			for (size_t i = 0; i < image.width; i++) {
+				uint32_t bits = 0;
+				std::memcpy(&bits, &row_data[i], sizeof(bits));
+				bits = __builtin_bswap32(bits);
+				std::memcpy(&row_data[i], &bits, sizeof(bits));
+			}
+		}
+	}
+	if (!file)
+		throw std::runtime_error(std::format("{} is truncated", path.string()));
+	return image;
+}
+
+void write_pfm(const std::filesystem::path& path, const DepthImage& image) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(
+			std::format("failed to create {}", path.string())
+		);
+
+	write_pfm(file, image);
+}
+
+void write_pfm(std::ostream& stream, const DepthImage& image) {
+	const float scale =
+		std::endian::native == std::endian::little ? -1.0f : 1.0f;
+	stream << std::format("Pf\n{} {}\n{}\n", image.width, image.height, scale);
+	for (size_t row = 0; row < image.height; row++) {
+		const auto* row_data =
+			&image.values[(image.height - 1 - row) * image.width];
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		stream.write(
+			reinterpret_cast<const char*>(row_data),
+			(std::streamsize)(image.width * sizeof(float))
+		);
+	}
+}
+
+RgbaImage resize_bilinear(const RgbaImage& image, size_t width, size_t height) {
+	RgbaImage resized{
+		.width = width,
+		.height = height,
+		.pixels = std::vector<uint8_t>(width * height * 4),
+	};
+
+	const float scale_x = (float)image.width / (float)width;
+	const float scale_y = (float)image.height / (float)height;
+
+	for (size_t y = 0; y < height; y++) {
+		// sample at pixel centers
+		const float source_y =
+			std::max(((float)y + 0.5f) * scale_y - 0.5f, 0.0f);
+		const auto y0 = std::min((size_t)source_y, image.height - 1);
+		const auto y1 = std::min(y0 + 1, image.height - 1);
+		const float weight_y = source_y - (float)y0;
+
+		for (size_t x = 0; x < width; x++) {
+			const float source_x =
+				std::max(((float)x + 0.5f) * scale_x - 0.5f, 0.0f);
+			const auto x0 = std::min((size_t)source_x, image.width - 1);
+			const auto x1 = std::min(x0 + 1, image.width - 1);
+			const float weight_x = source_x - (float)x0;
+
+			for (size_t channel = 0; channel < 4; channel++) {
+				const auto sample = [&](size_t sample_x, size_t sample_y) {
+					return (float)image.pixels
+						[(sample_y * image.width + sample_x) * 4 + channel];
+				};
+				const float top = sample(x0, y0) * (1.0f - weight_x) +
+								  sample(x1, y0) * weight_x;
+				const float bottom = sample(x0, y1) * (1.0f - weight_x) +
+									 sample(x1, y1) * weight_x;
+				resized.pixels[(y * width + x) * 4 + channel] = (uint8_t
+				)std::clamp(
+					top * (1.0f - weight_y) + bottom * weight_y + 0.5f, 0.0f,
+					255.0f
+				);
+			}
+		}
+	}
+	return resized;
+}
+
+std::vector<int> to_bitmap_pixels(const RgbaImage& image) {
+	std::vector<int> pixels(image.pixel_count());
+	std::memcpy(pixels.data(), image.pixels.data(), image.pixels.size());
+	return pixels;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <vector>
+
+/// 8 bit per channel rgba image, same memory layout as an android
+/// ARGB_8888 bitmap (bytes r, g, b, a for each pixel)
+struct RgbaImage {
+	size_t width = 0;
+	size_t height = 0;
+	std::vector<uint8_t> pixels;
+
+	[[nodiscard]] size_t pixel_count() const { return width * height; }
+};
+
+/// single channel float image (depth maps)
+struct DepthImage {
+	size_t width = 0;
+	size_t height = 0;
+	std::vector<float> values;
+};
+
+std::vector<std::byte> read_file_bytes(const std::filesystem::path& path);
+
+/// reads a binary (P6) ppm image with 8 bit channels
+RgbaImage read_ppm(const std::filesystem::path& path);
+
+/// reads a non interlaced 8 bit png image (gray, gray + alpha, rgb or rgba)
+RgbaImage read_png(const std::filesystem::path& path);
+
+/// reads a ppm or png image, based on the file extension
+RgbaImage read_image(const std::filesystem::path& path);
+
+/// reads a grayscale (Pf) pfm image
+DepthImage read_pfm(const std::filesystem::path& path);
+
+/// writes a grayscale (Pf) pfm image
+void write_pfm(const std::filesystem::path& path, const DepthImage& image);
+void write_pfm(std::ostream& stream, const DepthImage& image);
+
+/// bilinear resampling, like android's Bitmap.scale with filtering
+RgbaImage resize_bilinear(const RgbaImage& image, size_t width, size_t height);
+
+/// reinterprets the pixels as the ints that the native code reads from a
+/// locked android bitmap
+std::vector<int> to_bitmap_pixels(const RgbaImage& image);
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "ToolUtils.hpp"
+
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+std::array<float, RGB_CHANNELS> parse_rgb_values(std::string_view text) {
+	std::array<float, RGB_CHANNELS> values{};
+	std::stringstream stream{std::string(text)};
+	std::string value;
+	for (float& channel_value : values) {
+		if (!std::getline(stream, value, ','))
+			throw std::runtime_error(
+				std::format("expected 3 comma separated values: {}", text)
+			);
+		channel_value = std::stof(value);
+	}
+	return values;
+}
\ No newline at end of file
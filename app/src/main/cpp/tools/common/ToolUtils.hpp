@@ -0,0 +1,86 @@
+#pragma once
+
+#include "processing/Preprocessing.hpp"
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+/// parses "r,g,b" (mean / stddev arguments)
+std::array<float, RGB_CHANNELS> parse_rgb_values(std::string_view text);
+
+/// blocking queue with a maximum size between two pipeline stages, push
+/// blocks while it is full and pop while it is empty
+template<typename T>
+class BoundedQueue {
+  public:
+	explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+	/// returns false if the queue was closed (the consumer stopped)
+	bool push(T value) {
+		std::unique_lock lock(mutex);
+		not_full.wait(lock, [this] {
+			return items.size() < capacity || closed;
+		});
+		if (closed)
+			return false;
+
+		items.push_back(std::move(value));
+		not_empty.notify_one();
+		return true;
+	}
+
+	/// like push, but drops the oldest value instead of blocking while the
+	/// queue is full, like the camera analyzer that only keeps the latest frame
+	bool push_latest(T value) {
+		const std::scoped_lock lock(mutex);
+		if (closed)
+			return false;
+
+		if (items.size() >= capacity) {
+			items.pop_front();
+			dropped++;
+		}
+		items.push_back(std::move(value));
+		not_empty.notify_one();
+		return true;
+	}
+
+	/// values that were dropped by push_latest
+	[[nodiscard]] size_t dropped_count() {
+		const std::scoped_lock lock(mutex);
+		return dropped;
+	}
+
+	/// nullopt once the queue is closed and empty
+	std::optional<T> pop() {
+		std::unique_lock lock(mutex);
+		not_empty.wait(lock, [this] { return !items.empty() || closed; });
+		if (items.empty())
+			return std::nullopt;
+
+		T value = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return value;
+	}
+
+	/// no more values will be pushed, remaining values can still be popped
+	void close() {
+		const std::scoped_lock lock(mutex);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+  private:
+	size_t capacity;
+	std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<T> items;
+	size_t dropped = 0;
+	bool closed = false;
+};
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "VideoIO.hpp"
+
+#include "processing/Postprocessing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+Y4mReader::Y4mReader(const std::filesystem::path& path)
+	: path(path), file(path, std::ios::binary) {
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string())
+		);
+
+	std::string header;
+	std::getline(file, header);
+	std::stringstream tokens(header);
+	std::string token;
+	tokens >> token;
+	if (token != "YUV4MPEG2")
+		throw std::runtime_error(
+			std::format("{} is not a YUV4MPEG2 video", path.string())
+		);
+
+	while (tokens >> token) {
+		const auto value = std::string_view(token).substr(1);
+		switch (token[0]) {
+		case 'W':
+			width = std::stoul(std::string(value));
+			break;
+		case 'H':
+			height = std::stoul(std::string(value));
+			break;
+		case 'I':
+			if (value != "p" && value != "?")
+				throw std::runtime_error(std::format(
+					"{}: interlaced videos are not supported", path.string()
+				));
+			break;
+		case 'C':
+			if (value.starts_with("420")) {
+				subsampled_chroma = true;
+			} else if (value.starts_with("444") && !value.starts_with("444alpha")) {
+				subsampled_chroma = false;
+			} else if (value == "mono") {
+				has_chroma = false;
+			} else {
+				throw std::runtime_error(std::format(
+					"{}: unsupported chroma format {}", path.string(), value
+				));
+			}
+			break;
+		default:
+			// frame rate, aspect ratio and extensions are not needed
+			break;
+		}
+	}
+	if (width == 0 || height == 0)
+		throw std::runtime_error(
+			std::format("{}: missing frame size", path.string())
+		);
+
+	const size_t chroma_size = !has_chroma ? 0
+							   : subsampled_chroma
+								   ? ((width + 1) / 2) * ((height + 1) / 2)
+								   : width * height;
+	frame_bytes.resize(width * height + 2 * chroma_size);
+}
+
+std::optional<RgbaImage> Y4mReader::read_frame() {
+	std::string frame_header;
+	if (!std::getline(file, frame_header))
+		return std::nullopt;
+	if (!frame_header.starts_with("FRAME"))
+		throw std::runtime_error(
+			std::format("{}: expected a FRAME header", path.string())
+		);
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	file.read(
+		reinterpret_cast<char*>(frame_bytes.data()),
+		(std::streamsize)frame_bytes.size()
+	);
+	if (!file)
+		throw std::runtime_error(std::format("{} is truncated", path.string()));
+
+	RgbaImage image{
+		.width = width,
+		.height = height,
+		.pixels = std::vector<uint8_t>(width * height * 4),
+	};
+	const size_t chroma_width = subsampled_chroma ? (width + 1) / 2 : width;
+	const size_t chroma_height = subsampled_chroma ? (height + 1) / 2 : height;
+	const uint8_t* luma_plane = frame_bytes.data();
+	const uint8_t* u_plane = luma_plane + width * height;
+	const uint8_t* v_plane = u_plane + chroma_width * chroma_height;
+
+	for (size_t y = 0; y < height; y++) {
+		const size_t chroma_y = subsampled_chroma ? y / 2 : y;
+		for (size_t x = 0; x < width; x++) {
+			const size_t chroma_x = subsampled_chroma ? x / 2 : x;
+			const size_t chroma_index = chroma_y * chroma_width + chroma_x;
+
+			// bt.601 limited range
+			const float luma = 1.164f * ((float)luma_plane[y * width + x] - 16.0f);
+			const float u = has_chroma ? (float)u_plane[chroma_index] - 128.0f
+									   : 0.0f;
+			const float v = has_chroma ? (float)v_plane[chroma_index] - 128.0f
+									   : 0.0f;
+			const auto to_byte = [](float value) {
+				return (uint8_t)std::clamp(value + 0.5f, 0.0f, 255.0f);
+			};
+
+			uint8_t* pixel = &image.pixels[(y * width + x) * 4];
+			pixel[0] = to_byte(luma + 1.596f * v);
+			pixel[1] = to_byte(luma - 0.392f * u - 0.813f * v);
+			pixel[2] = to_byte(luma + 2.017f * u);
+			pixel[3] = 255;
+		}
+	}
+	return image;
+}
+
+ImageSequenceReader::ImageSequenceReader(const std::filesystem::path& directory
+) {
+	for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+		const auto extension = entry.path().extension();
+		if (extension == ".ppm" || extension == ".png")
+			image_paths.push_back(entry.path());
+	}
+	std::ranges::sort(image_paths);
+	if (image_paths.empty())
+		throw std::runtime_error(std::format(
+			"{} contains no .ppm or .png images", directory.string()
+		));
+}
+
+std::optional<RgbaImage> ImageSequenceReader::read_frame() {
+	if (next_image >= image_paths.size())
+		return std::nullopt;
+	return read_image(image_paths[next_image++]);
+}
+
+SessionReplayReader::SessionReplayReader(
+	const std::filesystem::path& path,
+	ReplayPacing pacing
+)
+	: recording(path.string()), pacing(pacing) {
+	if (recording.frames().empty())
+		throw std::runtime_error(
+			std::format("{} contains no frames", path.string())
+		);
+}
+
+std::optional<RgbaImage> SessionReplayReader::read_frame() {
+	const auto frames = recording.frames();
+	if (next_frame >= frames.size())
+		return std::nullopt;
+	const auto& frame = frames[next_frame++];
+
+	if (pacing == ReplayPacing::OriginalCadence) {
+		if (next_frame == 1)
+			replay_start = std::chrono::steady_clock::now();
+		std::this_thread::sleep_until(
+			replay_start + std::chrono::nanoseconds(
+							   frame.timestamp_ns - frames[0].timestamp_ns
+						   )
+		);
+	}
+
+	if (frame.pixel_format != RecordedPixelFormat::Rgba8888)
+		throw std::runtime_error(std::format(
+			"unsupported pixel format {}", (uint32_t)frame.pixel_format
+		));
+
+	const bool swaps_axes = frame.rotation_degrees % 180 == 90;
+	RgbaImage image{
+		.width = swaps_axes ? frame.height : frame.width,
+		.height = swaps_axes ? frame.width : frame.height,
+		.pixels = std::vector<uint8_t>(frame.pixels.size()),
+	};
+	rotate_pixels(
+		frame.pixels, frame.width, frame.height, frame.rotation_degrees,
+		image.pixels
+	);
+	return image;
+}
+
+std::unique_ptr<FrameReader>
+open_frame_reader(const std::filesystem::path& path, ReplayPacing pacing) {
+	if (std::filesystem::is_directory(path))
+		return std::make_unique<ImageSequenceReader>(path);
+	if (path.extension() == ".y4m")
+		return std::make_unique<Y4mReader>(path);
+	if (path.extension() == ".session")
+		return std::make_unique<SessionReplayReader>(path, pacing);
+	throw std::runtime_error(std::format(
+		"{}: expected a .y4m video, a .session recording or a directory of "
+		"images",
+		path.string()
+	));
+}
+
+DepthStreamWriter::DepthStreamWriter(
+	const std::filesystem::path& path,
+	DepthOutputFormat format
+)
+	: path(path), format(format) {
+	if (format == DepthOutputFormat::Compressed) {
+		recording = std::make_unique<DepthRecordingWriter>(path.string());
+		return;
+	}
+
+	file.open(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(
+			std::format("failed to create {}", path.string())
+		);
+}
+
+void DepthStreamWriter::write_frame(
+	std::span<const float> depth,
+	size_t width,
+	size_t height
+) {
+	if (depth.size() != width * height)
+		throw std::invalid_argument("depth");
+
+	if (recording != nullptr) {
+		const size_t start = recording->written_bytes();
+		const auto timestamp =
+			std::chrono::steady_clock::now().time_since_epoch();
+		recording->write_frame(
+			depth, width, height,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp)
+				.count()
+		);
+		bytes += recording->written_bytes() - start;
+		return;
+	}
+
+	const auto start = file.tellp();
+	switch (format) {
+	case DepthOutputFormat::Float:
+		write_pfm(
+			file, DepthImage{
+					  .width = width,
+					  .height = height,
+					  .values = std::vector<float>(depth.begin(), depth.end()),
+				  }
+		);
+		break;
+	case DepthOutputFormat::Uint16: {
+		file << std::format("P5\n{} {}\n65535\n", width, height);
+		encoded.resize(depth.size() * 2);
+		for (size_t i = 0; i < depth.size(); i++) {
+			const auto value = (uint16_t)std::lround(
+				std::clamp(depth[i], 0.0f, 1.0f) * 65535.0f
+			);
+			// pgm samples are big endian
+			encoded[i * 2] = (uint8_t)(value >> 8);
+			encoded[i * 2 + 1] = (uint8_t)(value & 0xff);
+		}
+		break;
+	}
+	case DepthOutputFormat::Colormap: {
+		file << std::format("P6\n{} {}\n255\n", width, height);
+		colormapped.resize(depth.size());
+		depth_colormap(depth, colormapped);
+		encoded.resize(depth.size() * 3);
+		for (size_t i = 0; i < depth.size(); i++) {
+			// argb ints, like android bitmaps
+			const auto color = (uint32_t)colormapped[i];
+			encoded[i * 3] = (uint8_t)(color >> 16);
+			encoded[i * 3 + 1] = (uint8_t)(color >> 8);
+			encoded[i * 3 + 2] = (uint8_t)color;
+		}
+		break;
+	}
+	case DepthOutputFormat::Compressed:
+		break;
+	}
+
+	if (format != DepthOutputFormat::Float) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		file.write(
+			reinterpret_cast<const char*>(encoded.data()),
+			(std::streamsize)encoded.size()
+		);
+	}
+	if (!file)
+		throw std::runtime_error(
+			std::format("failed to write to {}", path.string())
+		);
+	bytes += (size_t)(file.tellp() - start);
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ImageIO.hpp"
+#include "recording/DepthRecording.hpp"
+#include "recording/SessionRecording.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+/// streaming source of rgba frames, frames are decoded one at a time
+class FrameReader {
+  public:
+	FrameReader() = default;
+	virtual ~FrameReader() = default;
+
+	FrameReader(const FrameReader&) = delete;
+	FrameReader(FrameReader&&) = delete;
+	void operator=(const FrameReader&) = delete;
+	void operator=(FrameReader&&) = delete;
+
+	/// nullopt after the last frame
+	virtual std::optional<RgbaImage> read_frame() = 0;
+};
+
+/// raw YUV4MPEG2 video with 4:2:0, 4:4:4 or mono chroma (as written by
+/// ffmpeg -f yuv4mpegpipe), assumes bt.601 limited range
+class Y4mReader : public FrameReader {
+  public:
+	explicit Y4mReader(const std::filesystem::path& path);
+
+	std::optional<RgbaImage> read_frame() override;
+
+  private:
+	std::filesystem::path path;
+	std::ifstream file;
+	size_t width = 0;
+	size_t height = 0;
+	/// chroma planes are subsampled by 2 in both directions (4:2:0)
+	bool subsampled_chroma = true;
+	bool has_chroma = true;
+	std::vector<uint8_t> frame_bytes;
+};
+
+/// directory of ppm / png images, read in file name order
+class ImageSequenceReader : public FrameReader {
+  public:
+	explicit ImageSequenceReader(const std::filesystem::path& directory);
+
+	std::optional<RgbaImage> read_frame() override;
+
+  private:
+	std::vector<std::filesystem::path> image_paths;
+	size_t next_image = 0;
+};
+
+enum class ReplayPacing {
+	/// frames are returned as soon as they are requested
+	AsFastAsPossible,
+	/// read_frame waits until the frame is due, relative to the capture
+	/// timestamp of the first frame
+	OriginalCadence,
+};
+
+/// camera session recorded on a device (SessionRecorder), frames are rotated
+/// upright like in the app
+class SessionReplayReader : public FrameReader {
+  public:
+	SessionReplayReader(const std::filesystem::path& path, ReplayPacing pacing);
+
+	std::optional<RgbaImage> read_frame() override;
+
+  private:
+	SessionRecording recording;
+	ReplayPacing pacing;
+	size_t next_frame = 0;
+	std::chrono::steady_clock::time_point replay_start;
+};
+
+/// Y4mReader for .y4m files, SessionReplayReader for .session recordings and
+/// ImageSequenceReader for directories
+std::unique_ptr<FrameReader> open_frame_reader(
+	const std::filesystem::path& path,
+	ReplayPacing pacing = ReplayPacing::AsFastAsPossible
+);
+
+enum class DepthOutputFormat {
+	/// 32 bit float pfm
+	Float,
+	/// 16 bit pgm, 0 to 65535 for relative depth 0 to 1
+	Uint16,
+	/// 8 bit ppm with the inferno colormap
+	Colormap,
+	/// DepthRecordingWriter container (quantized to 16 bit, lossless
+	/// compression, seekable)
+	Compressed,
+};
+
+/// writes depth frames as a stream of concatenated images (pfm, pgm or ppm
+/// depending on the format), which can be read with ffmpeg -f image2pipe, or
+/// as a compressed depth recording
+class DepthStreamWriter {
+  public:
+	DepthStreamWriter(const std::filesystem::path& path, DepthOutputFormat format);
+
+	/// depth values between 0 and 1
+	void write_frame(std::span<const float> depth, size_t width, size_t height);
+
+	[[nodiscard]] size_t written_bytes() const { return bytes; }
+
+  private:
+	std::filesystem::path path;
+	std::ofstream file;
+	std::unique_ptr<DepthRecordingWriter> recording;
+	DepthOutputFormat format;
+	std::vector<uint8_t> encoded;
+	std::vector<int> colormapped;
+	size_t bytes = 0;
+};
\ No newline at end of file
@@ -0,0 +1,531 @@
+/// Accuracy vs. latency evaluation of model / backend / precision
+/// configurations.
+///
+/// Usage: DepthEvaluation --images <dir with .ppm images> --configs <file>
+///                        [--golden-dir <dir>] [--runs 3]
+///                        [--output results.json]
+///
+/// Every line of the configs file describes one configuration as
+/// whitespace separated key=value pairs, for example:
+///
+///   name=midas backend=tflite model=midas_v2_1_256x256.tflite input_dim=256
+///     mean=123.675,116.28,103.53 stddev=58.395,57.12,57.375 accelerator=0
+///   name=midas_quantized backend=tflite
+///     model=midas_v2_1_256x256_quantized.tflite input_dim=256
+///     mean=123.675,116.28,103.53 stddev=58.395,57.12,57.375 reference=midas
+///
+/// (each configuration on a single line). accelerator enables the gpu delegate
+/// (tflite) or nnapi (onnx), fp16 allows them to compute in half precision.
+/// tiled_dim=N runs the model on overlapping input_dim tiles of the image
+/// resized to N x N (tile_overlap=32, spread over tile_runtimes=2 runtime
+/// instances, tile_batch=1 tiles per invoke); outputs of a different size
+/// than their golden outputs are resampled before comparing.
+/// Configurations with a reference are compared against the outputs of that
+/// (earlier) configuration. Configurations without a reference are the golden
+/// float outputs: with --golden-dir they are compared against
+/// <golden-dir>/<name>/<image>.pfm, which is written if it does not exist yet.
+///
+/// Errors are computed after a least squares scale/shift alignment, since all
+/// outputs are relative depth: AbsRel (mean |pred - golden| / golden) and the
+/// scale-invariant log RMSE.
+
+#include "DepthEstimation.hpp"
+#include "TiledDepthEstimation.hpp"
+#include "ImageIO.hpp"
+#include "ToolUtils.hpp"
+#include "utils/ImageUtils.hpp"
+#include "utils/Profiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+enum class Backend { TfLite, Onnx };
+
+struct EvaluationConfig {
+	std::string name;
+	Backend backend = Backend::TfLite;
+	std::filesystem::path model_path;
+	size_t input_dim = 0;
+	std::array<float, RGB_CHANNELS> mean{};
+	std::array<float, RGB_CHANNELS> stddev{};
+	bool use_accelerator = false;
+	bool fp16 = false;
+	std::optional<std::string> reference;
+	/// 0 if the image is resized to the model input instead of tiled
+	size_t tiled_dim = 0;
+	size_t tile_overlap = 32;
+	size_t tile_runtimes = 2;
+	size_t tile_batch = 1;
+
+	/// resolution of the model input (tiled_dim for tiled configurations)
+	/// and of the depth output
+	[[nodiscard]] size_t processing_dim() const {
+		return tiled_dim > 0 ? tiled_dim : input_dim;
+	}
+};
+
+struct DepthErrorMetrics {
+	double abs_rel = 0.0;
+	double si_rmse = 0.0;
+};
+
+struct EvaluationResult {
+	std::string config_name;
+	size_t image_count = 0;
+	double mean_latency_ms = 0.0;
+	double p50_latency_ms = 0.0;
+	double p90_latency_ms = 0.0;
+	std::optional<DepthErrorMetrics> error;
+};
+
+using Runtime =
+	std::variant<std::unique_ptr<TfLiteRuntime>, std::unique_ptr<OnnxRuntime>>;
+
+static std::vector<EvaluationConfig>
+read_configs(const std::filesystem::path& path) {
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string())
+		);
+
+	std::vector<EvaluationConfig> configs;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line.starts_with('#'))
+			continue;
+
+		EvaluationConfig config;
+		std::stringstream tokens(line);
+		std::string token;
+		while (tokens >> token) {
+			const auto separator = token.find('=');
+			if (separator == std::string::npos)
+				throw std::runtime_error(
+					std::format("expected key=value, got {}", token)
+				);
+			const auto key = std::string_view(token).substr(0, separator);
+			const auto value = std::string_view(token).substr(separator + 1);
+
+			if (key == "name")
+				config.name = value;
+			else if (key == "backend" && value == "tflite")
+				config.backend = Backend::TfLite;
+			else if (key == "backend" && value == "onnx")
+				config.backend = Backend::Onnx;
+			else if (key == "model")
+				config.model_path = path.parent_path() / value;
+			else if (key == "input_dim")
+				config.input_dim = std::stoul(std::string(value));
+			else if (key == "mean")
+				config.mean = parse_rgb_values(value);
+			else if (key == "stddev")
+				config.stddev = parse_rgb_values(value);
+			else if (key == "accelerator")
+				config.use_accelerator = value == "1";
+			else if (key == "fp16")
+				config.fp16 = value == "1";
+			else if (key == "reference")
+				config.reference = std::string(value);
+			else if (key == "tiled_dim")
+				config.tiled_dim = std::stoul(std::string(value));
+			else if (key == "tile_overlap")
+				config.tile_overlap = std::stoul(std::string(value));
+			else if (key == "tile_batch")
+				config.tile_batch =
+					std::max<size_t>(std::stoul(std::string(value)), 1);
+			else if (key == "tile_runtimes")
+				config.tile_runtimes =
+					std::max<size_t>(std::stoul(std::string(value)), 1);
+			else
+				throw std::runtime_error(std::format("unknown key: {}", token));
+		}
+
+		if (config.name.empty() || config.model_path.empty() ||
+			config.input_dim == 0)
+			throw std::runtime_error(
+				std::format("name, model and input_dim are required: {}", line)
+			);
+		configs.push_back(std::move(config));
+	}
+	return configs;
+}
+
+static Runtime create_runtime(const EvaluationConfig& config) {
+	const auto model_data = read_file_bytes(config.model_path);
+
+	if (config.backend == Backend::TfLite) {
+		const auto gpu_delegate_serialization_dir =
+			std::filesystem::temp_directory_path().string();
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		return std::make_unique<TfLiteRuntime>(
+			std::span<const int8_t>(
+				reinterpret_cast<const int8_t*>(model_data.data()),
+				model_data.size()
+			),
+			gpu_delegate_serialization_dir, config.name,
+			TfLiteRuntimeOptions{
+				.use_gpu_delegate = config.use_accelerator,
+				.allow_precision_loss = config.fp16,
+			}
+		);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	}
+
+	return std::make_unique<OnnxRuntime>(
+		model_data, config.name,
+		OnnxRuntimeOptions{
+			.use_nnapi = config.use_accelerator,
+			.use_fp16 = config.fp16,
+		}
+	);
+}
+
+/// converts the image into the input layout the app uses for this backend
+static std::vector<float>
+preprocess(const RgbaImage& image, const EvaluationConfig& config) {
+	const auto resized =
+		resize_bilinear(image, config.processing_dim(), config.processing_dim());
+	const auto pixels = to_bitmap_pixels(resized);
+
+	std::vector<float> input(pixels.size() * RGB_CHANNELS);
+	if (config.backend == Backend::TfLite)
+		rgba_pixels_to_rgb_hwc_255_float_array(pixels, input);
+	else
+		rgba_pixels_to_rgb_chw_float_array(pixels, input);
+	return input;
+}
+
+/// runtime pointers of one backend, as the tiled depth estimation expects them
+template<typename R>
+static std::vector<R*> get_runtime_pointers(std::span<Runtime> runtimes) {
+	std::vector<R*> pointers;
+	for (auto& runtime : runtimes)
+		pointers.push_back(std::get<std::unique_ptr<R>>(runtime).get());
+	return pointers;
+}
+
+static double percentile(std::vector<double> values, double fraction) {
+	if (values.empty())
+		return 0.0;
+	std::ranges::sort(values);
+	const auto index = (size_t)std::round(fraction * (double)(values.size() - 1));
+	return values[index];
+}
+
+static DepthErrorMetrics compute_depth_error(
+	std::span<const float> prediction,
+	std::span<const float> golden
+) {
+	constexpr double VALID_EPSILON = 1e-3;
+
+	// least squares alignment: minimize |scale * prediction + shift - golden|
+	double sum_p = 0.0;
+	double sum_g = 0.0;
+	double sum_pp = 0.0;
+	double sum_pg = 0.0;
+	for (size_t i = 0; i < prediction.size(); i++) {
+		sum_p += prediction[i];
+		sum_g += golden[i];
+		sum_pp += (double)prediction[i] * prediction[i];
+		sum_pg += (double)prediction[i] * golden[i];
+	}
+	const auto count = (double)prediction.size();
+	const double determinant = count * sum_pp - sum_p * sum_p;
+	const double scale =
+		determinant > 0.0 ? (count * sum_pg - sum_p * sum_g) / determinant
+						  : 1.0;
+	const double shift = (sum_g - scale * sum_p) / count;
+
+	double abs_rel_sum = 0.0;
+	double log_difference_sum = 0.0;
+	double log_difference_squared_sum = 0.0;
+	size_t valid_count = 0;
+	for (size_t i = 0; i < prediction.size(); i++) {
+		const double golden_value = golden[i];
+		if (golden_value <= VALID_EPSILON)
+			continue;
+		const double aligned = std::max(
+			scale * (double)prediction[i] + shift, VALID_EPSILON
+		);
+
+		abs_rel_sum += std::abs(aligned - golden_value) / golden_value;
+		const double log_difference =
+			std::log(aligned) - std::log(golden_value);
+		log_difference_sum += log_difference;
+		log_difference_squared_sum += log_difference * log_difference;
+		valid_count++;
+	}
+	if (valid_count == 0)
+		return {};
+
+	const auto valid = (double)valid_count;
+	const double mean_log_difference = log_difference_sum / valid;
+	return DepthErrorMetrics{
+		.abs_rel = abs_rel_sum / valid,
+		.si_rmse = std::sqrt(std::max(
+			log_difference_squared_sum / valid -
+				mean_log_difference * mean_log_difference,
+			0.0
+		)),
+	};
+}
+
+static void reset_profiling_frames() {
+	(void)get_depth_profiling_frame().finish();
+	(void)get_camera_profiling_frame().finish();
+}
+
+static std::string
+format_results_json(std::span<const EvaluationResult> results) {
+	std::string json = "{\n\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& result = results[i];
+		json += std::format(
+			"\t\t{{\"config\": \"{}\", \"images\": {}, "
+			"\"mean_latency_ms\": {:.3f}, \"p50_latency_ms\": {:.3f}, "
+			"\"p90_latency_ms\": {:.3f}",
+			result.config_name, result.image_count, result.mean_latency_ms,
+			result.p50_latency_ms, result.p90_latency_ms
+		);
+		if (result.error.has_value()) {
+			json += std::format(
+				", \"abs_rel\": {:.6f}, \"si_rmse\": {:.6f}",
+				result.error->abs_rel, result.error->si_rmse
+			);
+		}
+		json += i + 1 < results.size() ? "},\n" : "}\n";
+	}
+	json += "\t]\n}\n";
+	return json;
+}
+
+int main(int argc, char** argv) {
+	std::optional<std::filesystem::path> images_dir;
+	std::optional<std::filesystem::path> configs_path;
+	std::optional<std::filesystem::path> golden_dir;
+	std::optional<std::filesystem::path> output_path;
+	size_t runs = 3;
+
+	const std::vector<std::string_view> args(argv + 1, argv + argc);
+	for (size_t i = 0; i < args.size(); i++) {
+		const bool has_value = i + 1 < args.size();
+		if (args[i] == "--images" && has_value) {
+			images_dir = args[++i];
+		} else if (args[i] == "--configs" && has_value) {
+			configs_path = args[++i];
+		} else if (args[i] == "--golden-dir" && has_value) {
+			golden_dir = args[++i];
+		} else if (args[i] == "--output" && has_value) {
+			output_path = args[++i];
+		} else if (args[i] == "--runs" && has_value) {
+			runs = std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+		} else {
+			std::fprintf(stderr, "unknown argument: %s\n", args[i].data());
+			return 1;
+		}
+	}
+	if (!images_dir.has_value() || !configs_path.has_value()) {
+		std::fprintf(
+			stderr, "usage: DepthEvaluation --images <dir> --configs <file> "
+					"[--golden-dir <dir>] [--runs 3] [--output <file>]\n"
+		);
+		return 1;
+	}
+
+	std::vector<std::filesystem::path> image_paths;
+	for (const auto& entry : std::filesystem::directory_iterator(*images_dir))
+		if (entry.path().extension() == ".ppm")
+			image_paths.push_back(entry.path());
+	std::ranges::sort(image_paths);
+
+	std::vector<RgbaImage> images;
+	images.reserve(image_paths.size());
+	for (const auto& image_path : image_paths)
+		images.push_back(read_ppm(image_path));
+
+	const auto configs = read_configs(*configs_path);
+
+	// outputs of every configuration (per image), used as golden outputs of
+	// configurations that reference it
+	std::map<std::string, std::vector<std::vector<float>>> config_outputs;
+	std::vector<EvaluationResult> results;
+
+	for (const auto& config : configs) {
+		std::fprintf(stderr, "evaluating %s\n", config.name.c_str());
+		std::vector<Runtime> runtimes;
+		std::optional<TiledDepthEstimator> tiled_estimator;
+		if (config.tiled_dim > 0) {
+			for (size_t i = 0; i < config.tile_runtimes; i++)
+				runtimes.push_back(create_runtime(config));
+			tiled_estimator.emplace(
+				TilingOptions{
+					.tile_width = config.input_dim,
+					.tile_height = config.input_dim,
+					.overlap = config.tile_overlap,
+					.tile_batch_size = config.tile_batch,
+				},
+				config.tile_runtimes
+			);
+		} else {
+			runtimes.push_back(create_runtime(config));
+		}
+		const size_t output_dim = config.processing_dim();
+
+		std::vector<double> latencies_ms;
+		std::vector<std::vector<float>> outputs;
+		double abs_rel_sum = 0.0;
+		double si_rmse_sum = 0.0;
+		size_t compared_count = 0;
+
+		for (size_t image_index = 0; image_index < images.size();
+			 image_index++) {
+			const auto input = preprocess(images[image_index], config);
+			std::vector<float> output(output_dim * output_dim);
+
+			// the first run includes delegate compilation / arena allocation
+			for (size_t run = 0; run < runs + 1; run++) {
+				auto normalized_input = input;
+				const auto start = profile_clock::now();
+				if (!tiled_estimator.has_value()) {
+					std::visit(
+						[&](auto& runtime_ptr) {
+							run_depth_estimation(
+								*runtime_ptr, normalized_input, output,
+								config.mean, config.stddev
+							);
+						},
+						runtimes.front()
+					);
+				} else if (config.backend == Backend::TfLite) {
+					tiled_estimator->run(
+						get_runtime_pointers<TfLiteRuntime>(runtimes), input,
+						output_dim, output_dim, output, config.mean,
+						config.stddev
+					);
+				} else {
+					tiled_estimator->run(
+						get_runtime_pointers<OnnxRuntime>(runtimes), input,
+						output_dim, output_dim, output, config.mean,
+						config.stddev
+					);
+				}
+				const auto duration = profile_clock::now() - start;
+				reset_profiling_frames();
+				if (run > 0)
+					latencies_ms.push_back(
+						std::chrono::duration<double, std::milli>(duration)
+							.count()
+					);
+			}
+
+			std::optional<std::vector<float>> golden;
+			if (config.reference.has_value()) {
+				const auto reference_outputs =
+					config_outputs.find(*config.reference);
+				if (reference_outputs == config_outputs.end())
+					throw std::runtime_error(std::format(
+						"reference {} of {} has to be listed before it",
+						*config.reference, config.name
+					));
+				golden = reference_outputs->second[image_index];
+			} else if (golden_dir.has_value()) {
+				const auto golden_path =
+					*golden_dir / config.name /
+					image_paths[image_index].stem().concat(".pfm");
+				if (std::filesystem::exists(golden_path)) {
+					golden = read_pfm(golden_path).values;
+				} else {
+					std::filesystem::create_directories(
+						golden_path.parent_path()
+					);
+					write_pfm(
+						golden_path,
+						DepthImage{
+							.width = output_dim,
+							.height = output_dim,
+							.values = output,
+						}
+					);
+				}
+			}
+
+			if (golden.has_value()) {
+				// all outputs are square
+				const auto golden_dim =
+					(size_t)std::lround(std::sqrt((double)golden->size()));
+				if (golden_dim * golden_dim != golden->size())
+					throw std::runtime_error(std::format(
+						"{}: golden output with {} values is not square",
+						config.name, golden->size()
+					));
+				std::vector<float> compared_output = output;
+				if (golden_dim != output_dim) {
+					compared_output.resize(golden->size());
+					resample_bilinear(
+						output, output_dim, output_dim, compared_output,
+						golden_dim, golden_dim
+					);
+				}
+				const auto error = compute_depth_error(compared_output, *golden);
+				abs_rel_sum += error.abs_rel;
+				si_rmse_sum += error.si_rmse;
+				compared_count++;
+			}
+
+			outputs.push_back(std::move(output));
+		}
+
+		EvaluationResult result{
+			.config_name = config.name,
+			.image_count = images.size(),
+			.p50_latency_ms = percentile(latencies_ms, 0.5),
+			.p90_latency_ms = percentile(latencies_ms, 0.9),
+		};
+		for (const double latency_ms : latencies_ms)
+			result.mean_latency_ms +=
+				latency_ms / (double)std::max<size_t>(latencies_ms.size(), 1);
+		if (compared_count > 0) {
+			result.error = DepthErrorMetrics{
+				.abs_rel = abs_rel_sum / (double)compared_count,
+				.si_rmse = si_rmse_sum / (double)compared_count,
+			};
+		}
+
+		std::fprintf(
+			stderr, "%s\n",
+			std::format(
+				"{:<32} {:8.2f} ms mean {:8.2f} ms p50 {:8.2f} ms p90{}",
+				result.config_name, result.mean_latency_ms,
+				result.p50_latency_ms, result.p90_latency_ms,
+				result.error.has_value()
+					? std::format(
+						  "  AbsRel {:.4f}  SI-RMSE {:.4f}",
+						  result.error->abs_rel, result.error->si_rmse
+					  )
+					: std::string()
+			)
+				.c_str()
+		);
+
+		config_outputs.emplace(config.name, std::move(outputs));
+		results.push_back(std::move(result));
+	}
+
+	const std::string json = format_results_json(results);
+	if (output_path.has_value()) {
+		std::ofstream(*output_path) << json;
+	} else {
+		std::fputs(json.c_str(), stdout);
+	}
+	return 0;
+}
\ No newline at end of file
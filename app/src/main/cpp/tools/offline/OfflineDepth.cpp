@@ -0,0 +1,435 @@
+/// Offline depth estimation of recorded videos and image sequences.
+///
+/// Usage: OfflineDepth --input <video.y4m | recording.session |
+///                             dir with .ppm/.png frames>
+///                     --output <file> --model <model.tflite | model.onnx>
+///                     --input-dim 256 --mean r,g,b --stddev r,g,b
+///                     [--format float|u16|colormap|compressed]
+///                     [--full-resolution]
+///                     [--batch 1] [--threads 4] [--queue 4] [--realtime]
+///
+/// The frames are streamed through three pipeline stages that work on
+/// different frames at the same time: decoding + preprocessing, inference
+/// (normalize_rgb, model, min_max_scaling; --batch frames per invoke) and
+/// postprocessing + encoding. The output is a stream of concatenated images,
+/// one per frame: 32 bit pfm, 16 bit pgm or colormapped ppm (readable with
+/// ffmpeg -f image2pipe), or a compressed depth recording (DepthRecording).
+/// Depth maps have the model resolution, or the frame resolution with
+/// --full-resolution.
+///
+/// --realtime replays the frames at their original cadence (capture timestamps
+/// of .session recordings) and drops the oldest waiting frame when inference
+/// can't keep up, like the camera analyzer of the app. Other inputs are read
+/// as fast as possible and never dropped.
+///
+/// The sustained throughput and the busy time of every stage are reported on
+/// stderr.
+
+#include "DepthEstimation.hpp"
+#include "ImageIO.hpp"
+#include "ToolUtils.hpp"
+#include "VideoIO.hpp"
+#include "utils/ImageUtils.hpp"
+#include "utils/Profiling.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+enum class Backend { TfLite, Onnx };
+
+struct OfflineOptions {
+	std::filesystem::path input_path;
+	std::filesystem::path output_path;
+	std::filesystem::path model_path;
+	size_t input_dim = 0;
+	std::array<float, RGB_CHANNELS> mean{};
+	std::array<float, RGB_CHANNELS> stddev{};
+	DepthOutputFormat format = DepthOutputFormat::Float;
+	bool full_resolution = false;
+	size_t batch_size = 1;
+	int thread_count = 4;
+	size_t queue_size = 4;
+	bool realtime = false;
+
+	[[nodiscard]] Backend backend() const {
+		return model_path.extension() == ".onnx" ? Backend::Onnx
+												 : Backend::TfLite;
+	}
+};
+
+struct PreprocessedFrame {
+	size_t index = 0;
+	size_t source_width = 0;
+	size_t source_height = 0;
+	/// model input in the layout of the backend
+	std::vector<float> input;
+};
+
+struct DepthFrame {
+	size_t index = 0;
+	size_t source_width = 0;
+	size_t source_height = 0;
+	std::vector<float> depth;
+};
+
+/// busy time of a pipeline stage
+struct StageTime {
+	std::string_view name;
+	profile_clock::duration busy{};
+};
+
+using Runtime =
+	std::variant<std::unique_ptr<TfLiteRuntime>, std::unique_ptr<OnnxRuntime>>;
+
+static Runtime create_runtime(const OfflineOptions& options) {
+	const auto model_data = read_file_bytes(options.model_path);
+	const auto model_name = options.model_path.filename().string();
+
+	if (options.backend() == Backend::TfLite) {
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+		return std::make_unique<TfLiteRuntime>(
+			std::span<const int8_t>(
+				reinterpret_cast<const int8_t*>(model_data.data()),
+				model_data.size()
+			),
+			std::filesystem::temp_directory_path().string(), model_name,
+			TfLiteRuntimeOptions{
+				.use_gpu_delegate = false,
+				.thread_count = options.thread_count,
+			}
+		);
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+	}
+
+	return std::make_unique<OnnxRuntime>(
+		model_data, model_name,
+		OnnxRuntimeOptions{
+			.use_nnapi = false,
+			.inter_op_thread_count = options.thread_count,
+		}
+	);
+}
+
+static PreprocessedFrame preprocess(
+	const RgbaImage& frame,
+	size_t index,
+	const OfflineOptions& options
+) {
+	const auto pixels = to_bitmap_pixels(
+		resize_bilinear(frame, options.input_dim, options.input_dim)
+	);
+
+	PreprocessedFrame preprocessed{
+		.index = index,
+		.source_width = frame.width,
+		.source_height = frame.height,
+		.input = std::vector<float>(pixels.size() * RGB_CHANNELS),
+	};
+	if (options.backend() == Backend::TfLite)
+		rgba_pixels_to_rgb_hwc_255_float_array(pixels, preprocessed.input);
+	else
+		rgba_pixels_to_rgb_chw_float_array(pixels, preprocessed.input);
+	return preprocessed;
+}
+
+static std::optional<OfflineOptions> parse_options(int argc, char** argv) {
+	OfflineOptions options;
+	const std::vector<std::string_view> args(argv + 1, argv + argc);
+	for (size_t i = 0; i < args.size(); i++) {
+		const bool has_value = i + 1 < args.size();
+		if (args[i] == "--full-resolution") {
+			options.full_resolution = true;
+		} else if (args[i] == "--realtime") {
+			options.realtime = true;
+		} else if (!has_value) {
+			std::fprintf(stderr, "missing value of %s\n", args[i].data());
+			return std::nullopt;
+		} else if (args[i] == "--input") {
+			options.input_path = args[++i];
+		} else if (args[i] == "--output") {
+			options.output_path = args[++i];
+		} else if (args[i] == "--model") {
+			options.model_path = args[++i];
+		} else if (args[i] == "--input-dim") {
+			options.input_dim = std::stoul(std::string(args[++i]));
+		} else if (args[i] == "--mean") {
+			options.mean = parse_rgb_values(args[++i]);
+		} else if (args[i] == "--stddev") {
+			options.stddev = parse_rgb_values(args[++i]);
+		} else if (args[i] == "--format") {
+			const auto format = args[++i];
+			if (format == "float") {
+				options.format = DepthOutputFormat::Float;
+			} else if (format == "u16") {
+				options.format = DepthOutputFormat::Uint16;
+			} else if (format == "colormap") {
+				options.format = DepthOutputFormat::Colormap;
+			} else if (format == "compressed") {
+				options.format = DepthOutputFormat::Compressed;
+			} else {
+				std::fprintf(stderr, "unknown format: %s\n", format.data());
+				return std::nullopt;
+			}
+		} else if (args[i] == "--batch") {
+			options.batch_size =
+				std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+		} else if (args[i] == "--threads") {
+			options.thread_count = std::max(std::stoi(std::string(args[++i])), 1);
+		} else if (args[i] == "--queue") {
+			options.queue_size =
+				std::max<size_t>(std::stoul(std::string(args[++i])), 1);
+		} else {
+			std::fprintf(stderr, "unknown argument: %s\n", args[i].data());
+			return std::nullopt;
+		}
+	}
+
+	if (options.input_path.empty() || options.output_path.empty() ||
+		options.model_path.empty() || options.input_dim == 0 ||
+		options.stddev == std::array<float, RGB_CHANNELS>{}) {
+		std::fprintf(
+			stderr,
+			"usage: OfflineDepth --input <video.y4m | recording.session | dir> "
+			"--output <file> --model <model> --input-dim <n> --mean r,g,b "
+			"--stddev r,g,b [--format float|u16|colormap|compressed] "
+			"[--full-resolution] [--batch 1] [--threads 4] [--queue 4] "
+			"[--realtime]\n"
+		);
+		return std::nullopt;
+	}
+	return options;
+}
+
+/// runs one pipeline stage, an exception stops the whole pipeline
+class PipelineErrors {
+  public:
+	template<typename F>
+	void run(F&& stage, std::initializer_list<std::function<void()>> on_error) {
+		try {
+			stage();
+		} catch (...) {
+			{
+				const std::scoped_lock lock(mutex);
+				if (!first_exception)
+					first_exception = std::current_exception();
+			}
+			for (const auto& close : on_error)
+				close();
+		}
+	}
+
+	void rethrow() {
+		if (first_exception)
+			std::rethrow_exception(first_exception);
+	}
+
+  private:
+	std::mutex mutex;
+	std::exception_ptr first_exception;
+};
+
+int main(int argc, char** argv) {
+	const auto options = parse_options(argc, argv);
+	if (!options.has_value())
+		return 1;
+
+	auto reader = open_frame_reader(
+		options->input_path, options->realtime
+								 ? ReplayPacing::OriginalCadence
+								 : ReplayPacing::AsFastAsPossible
+	);
+	DepthStreamWriter writer(options->output_path, options->format);
+	Runtime runtime = create_runtime(*options);
+
+	BoundedQueue<PreprocessedFrame> preprocessed_frames(options->queue_size);
+	BoundedQueue<DepthFrame> depth_frames(options->queue_size);
+	const auto close_queues = std::initializer_list<std::function<void()>>{
+		[&] { preprocessed_frames.close(); },
+		[&] { depth_frames.close(); },
+	};
+	PipelineErrors errors;
+
+	StageTime decode_time{.name = "decode + preprocess"};
+	StageTime inference_time{.name = "inference"};
+	StageTime encode_time{.name = "postprocess + encode"};
+	std::atomic<size_t> written_frames = 0;
+
+	const auto start = profile_clock::now();
+
+	std::thread decode_thread([&] {
+		errors.run(
+			[&] {
+				for (size_t index = 0;; index++) {
+					const auto stage_start = profile_clock::now();
+					const auto frame = reader->read_frame();
+					if (!frame.has_value())
+						break;
+					auto preprocessed = preprocess(*frame, index, *options);
+					decode_time.busy += profile_clock::now() - stage_start;
+
+					const bool pushed =
+						options->realtime
+							? preprocessed_frames.push_latest(std::move(preprocessed))
+							: preprocessed_frames.push(std::move(preprocessed));
+					if (!pushed)
+						return;
+				}
+				preprocessed_frames.close();
+			},
+			close_queues
+		);
+	});
+
+	std::thread encode_thread([&] {
+		errors.run(
+			[&] {
+				std::vector<float> resampled;
+				while (auto frame = depth_frames.pop()) {
+					const auto stage_start = profile_clock::now();
+					if (options->full_resolution) {
+						resampled.resize(
+							frame->source_width * frame->source_height
+						);
+						resample_bilinear(
+							frame->depth, options->input_dim,
+							options->input_dim, resampled, frame->source_width,
+							frame->source_height
+						);
+						writer.write_frame(
+							resampled, frame->source_width,
+							frame->source_height
+						);
+					} else {
+						writer.write_frame(
+							frame->depth, options->input_dim, options->input_dim
+						);
+					}
+					encode_time.busy += profile_clock::now() - stage_start;
+
+					const size_t written = ++written_frames;
+					if (written % 100 == 0) {
+						const auto elapsed =
+							std::chrono::duration<double>(
+								profile_clock::now() - start
+							)
+								.count();
+						std::fprintf(
+							stderr, "%zu frames, %.2f fps\n", written,
+							(double)written / elapsed
+						);
+					}
+				}
+			},
+			close_queues
+		);
+	});
+
+	// inference stage on the main thread
+	errors.run(
+		[&] {
+			const size_t frame_pixels = options->input_dim * options->input_dim;
+			std::vector<PreprocessedFrame> batch;
+			std::vector<float> batch_inputs;
+			std::vector<float> batch_outputs;
+
+			bool input_finished = false;
+			while (!input_finished) {
+				batch.clear();
+				while (batch.size() < options->batch_size) {
+					auto frame = preprocessed_frames.pop();
+					if (!frame.has_value()) {
+						input_finished = true;
+						break;
+					}
+					batch.push_back(std::move(*frame));
+				}
+				if (batch.empty())
+					break;
+
+				const auto stage_start = profile_clock::now();
+				batch_inputs.resize(batch.size() * frame_pixels * RGB_CHANNELS);
+				batch_outputs.resize(batch.size() * frame_pixels);
+				for (size_t i = 0; i < batch.size(); i++)
+					std::ranges::copy(
+						batch[i].input,
+						batch_inputs.begin() +
+							(ptrdiff_t)(i * frame_pixels * RGB_CHANNELS)
+					);
+
+				const auto depths = std::visit(
+					[&](auto& runtime_ptr) {
+						return run_depth_estimation_batch(
+							*runtime_ptr, batch_inputs, batch_outputs,
+							batch.size(), options->mean, options->stddev
+						);
+					},
+					runtime
+				);
+				// the profiling records would otherwise grow with every frame
+				(void)get_depth_profiling_frame().finish();
+				(void)get_camera_profiling_frame().finish();
+				inference_time.busy += profile_clock::now() - stage_start;
+
+				for (size_t i = 0; i < batch.size(); i++) {
+					const bool pushed = depth_frames.push(DepthFrame{
+						.index = batch[i].index,
+						.source_width = batch[i].source_width,
+						.source_height = batch[i].source_height,
+						.depth =
+							std::vector<float>(depths[i].begin(), depths[i].end()),
+					});
+					if (!pushed)
+						return;
+				}
+			}
+			depth_frames.close();
+		},
+		close_queues
+	);
+
+	decode_thread.join();
+	encode_thread.join();
+	errors.rethrow();
+
+	const double elapsed_seconds =
+		std::chrono::duration<double>(profile_clock::now() - start).count();
+	const size_t frames = written_frames.load();
+	std::fprintf(
+		stderr, "%s\n",
+		std::format(
+			"{} frames in {:.2f} s: {:.2f} fps, {:.1f} MB written",
+			frames, elapsed_seconds, (double)frames / elapsed_seconds,
+			(double)writer.written_bytes() / 1e6
+		)
+			.c_str()
+	);
+	if (options->realtime)
+		std::fprintf(
+			stderr, "%zu frames dropped\n", preprocessed_frames.dropped_count()
+		);
+	// the slowest stage limits the sustained throughput
+	for (const auto* stage : {&decode_time, &inference_time, &encode_time}) {
+		const double busy_ms =
+			std::chrono::duration<double, std::milli>(stage->busy).count();
+		std::fprintf(
+			stderr, "%s\n",
+			std::format(
+				"    {:<22} {:8.2f} ms/frame ({:.0f}% busy)", stage->name,
+				busy_ms / (double)std::max<size_t>(frames, 1),
+				100.0 * busy_ms / (elapsed_seconds * 1000.0)
+			)
+				.c_str()
+		);
+	}
+	return 0;
+}
\ No newline at end of file
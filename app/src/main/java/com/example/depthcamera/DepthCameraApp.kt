@@ -3,8 +3,10 @@ package com.example.depthcamera
 import android.app.Application
 import android.util.Log
 import com.example.depthcamera.camera.CameraManager
+import com.example.depthcamera.depth.DepthCache
 import com.example.depthcamera.depth.DepthModel
 import com.example.depthcamera.depth.DepthModelInfo
+import java.io.File
 
 /**
  * App class that holds everything that should persist when switching to another app,
@@ -16,9 +18,39 @@ class DepthCameraApp : Application() {
 		private set
 	lateinit var depthModel: DepthModel
 
+	/** depth of still images, opened on first use */
+	val depthCache by lazy { DepthCache(this) }
+
 	companion object {
 		const val APP_LOG_TAG = "Depth Camera"
 
+		/**
+		 * Records the camera images with their timestamps to files/camera.session in the external
+		 * app storage (adb pull), for replaying them with the OfflineDepth tool
+		 */
+		const val RECORD_CAMERA_SESSION = false
+
+		/** Records the compressed depth output to files/depth.depthrec in the external app storage */
+		const val RECORD_DEPTH = false
+
+		/**
+		 * Shows the depth at camera resolution, upsampled with the camera image as guide instead of
+		 * stretching the model resolution depth
+		 */
+		const val UPSAMPLE_DEPTH = false
+
+		/**
+		 * Normalizes the depth between the 1st and 99th percentile instead of its min and max, with
+		 * the bounds smoothed over time
+		 */
+		const val ROBUST_DEPTH_NORMALIZATION = false
+
+		/**
+		 * Skips the inference for frames where the scene didn't change and reuses (or shifts) the
+		 * depth of the last inference, for at most 30 frames in a row
+		 */
+		const val SKIP_UNCHANGED_FRAMES = false
+
 		val MODELS = arrayOf(
 			DepthModelInfo(
 				"MiDaS V2.1",
@@ -51,6 +83,15 @@ class DepthCameraApp : Application() {
 		super.onCreate()
 
 		depthModel = MODELS[selectedModelIndex].createDepthModel(this)!!
+
+		if (RECORD_CAMERA_SESSION)
+			NativeLib.startSessionRecording(File(getExternalFilesDir(null), "camera.session").path)
+		if (RECORD_DEPTH)
+			NativeLib.startDepthRecording(File(getExternalFilesDir(null), "depth.depthrec").path)
+		if (ROBUST_DEPTH_NORMALIZATION)
+			NativeLib.configureRobustNormalization(true, 0.01f, 0.99f, 0.3f)
+		if (SKIP_UNCHANGED_FRAMES)
+			NativeLib.configureDepthMotionGate(true, 0.03f, 0.02f, true, 30)
 	}
 
 	fun switchModel(newModelIndex: Int) {
@@ -1,5 +1,8 @@
 package com.example.depthcamera
 
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.net.Uri
 import android.os.Bundle
 import android.os.Handler
 import android.os.Looper
@@ -12,6 +15,7 @@ import android.widget.LinearLayout
 import android.widget.TextView
 import androidx.activity.ComponentActivity
 import androidx.activity.enableEdgeToEdge
+import androidx.activity.result.contract.ActivityResultContracts
 import androidx.camera.view.PreviewView
 import androidx.appcompat.app.AlertDialog
 import com.example.depthcamera.camera.CameraFrameAnalyzer
@@ -27,6 +31,10 @@ class MainActivity : ComponentActivity() {
 	private var allowCameraPermission: Button? = null
 	private var enableFlashlightCheckbox: CheckBox? = null
 	private var switchModelButton: Button? = null
+	private var openImageButton: Button? = null
+
+	private val openImage =
+		registerForActivityResult(ActivityResultContracts.GetContent(), ::onImageOpened)
 
 	private var depthPreviewImage: ImageView? = null
 
@@ -87,6 +95,11 @@ class MainActivity : ComponentActivity() {
 				.show()
 		}
 
+		openImageButton = findViewById(R.id.open_image_button)
+		openImageButton!!.setOnClickListener {
+			openImage.launch("image/*")
+		}
+
 		cameraFrameAnalyzer =
 			CameraFrameAnalyzer(
 				depthCameraApp(),
@@ -121,6 +134,27 @@ class MainActivity : ComponentActivity() {
 		}
 	}
 
+	private fun onImageOpened(uri: Uri?) {
+		if (uri == null) return
+
+		val options = BitmapFactory.Options()
+		options.inPreferredConfig = Bitmap.Config.ARGB_8888
+		val image = contentResolver.openInputStream(uri)?.use {
+			BitmapFactory.decodeStream(it, null, options)
+		} ?: return
+
+		cameraFrameAnalyzer!!.predictStillImage(image) { depth ->
+			val depthImage = ImageView(this)
+			depthImage.adjustViewBounds = true
+			depthImage.setImageBitmap(depth)
+
+			MaterialAlertDialogBuilder(this)
+				.setView(depthImage)
+				.setPositiveButton(android.R.string.ok, null)
+				.show()
+		}
+	}
+
 	private fun depthCameraApp(): DepthCameraApp {
 		return application as DepthCameraApp
 	}
@@ -6,6 +6,7 @@ import android.graphics.PixelFormat
 import android.media.Image
 import android.util.Log
 import android.util.Size
+import com.example.depthcamera.depth.DepthColormap
 
 /** Kotlin interface with NativeLib c++ code */
 object NativeLib {
@@ -26,8 +27,11 @@ object NativeLib {
 
 	external fun shutdownDepthTfLiteRuntime()
 
+	/** @return [com.example.depthcamera.depth.DepthSource] ordinal */
 	external fun runDepthTfLiteInference(
 		input: FloatArray,
+		inputWidth: Int,
+		inputHeight: Int,
 		output: FloatArray,
 		meanR: Float,
 		meanG: Float,
@@ -35,14 +39,40 @@ object NativeLib {
 		stddevR: Float,
 		stddevG: Float,
 		stddevB: Float
-	)
+	): Int
 
-	external fun initDepthOnnxRuntime(model: ByteArray)
+	/**
+	 * The normalization is folded into the model graph, the folded model is cached in
+	 * [modelCacheDir] for [modelToken]. Models that can't be folded are normalized at run time
+	 * @param displayColormap [DepthColormap] ordinal, or -1 for a model that outputs depth. With a
+	 * colormap the postprocessing is appended to the model graph, which then only runs with
+	 * [runDepthOnnxColormapInference]
+	 * @param displayLutSize entries of the color lookup table, 1024 or 4096
+	 * @param displayDownscale the depth is averaged over blocks of this size before colormapping
+	 */
+	external fun initDepthOnnxRuntime(
+		model: ByteArray,
+		modelName: String,
+		modelCacheDir: String,
+		modelToken: String,
+		meanR: Float,
+		meanG: Float,
+		meanB: Float,
+		stddevR: Float,
+		stddevG: Float,
+		stddevB: Float,
+		displayColormap: Int,
+		displayLutSize: Int,
+		displayDownscale: Int
+	)
 
 	external fun shutdownDepthOnnxRuntime()
 
+	/** @return [com.example.depthcamera.depth.DepthSource] ordinal */
 	external fun runDepthOnnxInference(
 		inputData: FloatArray,
+		inputWidth: Int,
+		inputHeight: Int,
 		outputData: FloatArray,
 		meanR: Float,
 		meanG: Float,
@@ -50,40 +80,396 @@ object NativeLib {
 		stddevR: Float,
 		stddevG: Float,
 		stddevB: Float
+	): Int
+
+	/**
+	 * Runs a model initialized with a display colormap, the range normalization and the
+	 * colormapping run inside the same session run. The motion gate, the depth cache and the depth
+	 * recording are bypassed
+	 * @param colormappedPixels argb ints of the (downscaled) model output size
+	 * @return false if the inference failed
+	 */
+	external fun runDepthOnnxColormapInference(
+		inputData: FloatArray,
+		colormappedPixels: IntArray,
+		meanR: Float,
+		meanG: Float,
+		meanB: Float,
+		stddevR: Float,
+		stddevG: Float,
+		stddevB: Float
+	): Boolean
+
+	/**
+	 * Runs the model but only computes the range of the output, which stays in the buffers of the
+	 * runtime. Read it with [sampleLazyDepth], [sampleLazyDepthRegions], [lazyDepth] or
+	 * [lazyDepthColormap] until the next inference. The motion gate and the depth recording are
+	 * bypassed
+	 * @return false if the inference failed
+	 */
+	external fun runDepthTfLiteLazyInference(
+		input: FloatArray,
+		inputWidth: Int,
+		inputHeight: Int,
+		meanR: Float,
+		meanG: Float,
+		meanB: Float,
+		stddevR: Float,
+		stddevG: Float,
+		stddevB: Float
+	): Boolean
+
+	/** See [runDepthTfLiteLazyInference] */
+	external fun runDepthOnnxLazyInference(
+		inputData: FloatArray,
+		inputWidth: Int,
+		inputHeight: Int,
+		meanR: Float,
+		meanG: Float,
+		meanB: Float,
+		stddevR: Float,
+		stddevG: Float,
+		stddevB: Float
+	): Boolean
+
+	/**
+	 * Relative depth of the last lazy inference at a few points, interpolated between the pixels
+	 * @param points 2 floats per point: x and y between 0.0f and 1.0f of the image
+	 * @param results a value per point between 0.0f and 1.0f
+	 * @return false if there is no lazy depth
+	 */
+	external fun sampleLazyDepth(points: FloatArray, results: FloatArray): Boolean
+
+	/**
+	 * Relative depth statistics of rectangles of the last lazy inference
+	 * @param regions 4 ints per rectangle: x, y, width and height in depth pixels
+	 * @param results 3 floats per rectangle: mean, min and max
+	 * @return false if there is no lazy depth or a rectangle is outside of the depth map
+	 */
+	external fun sampleLazyDepthRegions(regions: IntArray, results: FloatArray): Boolean
+
+	/**
+	 * Normalizes the whole output of the last lazy inference
+	 * @param output relative depth for each pixel between 0.0f and 1.0f
+	 * @return false if there is no lazy depth
+	 */
+	external fun lazyDepth(output: FloatArray): Boolean
+
+	/**
+	 * Colormaps the whole output of the last lazy inference, normalized in the same pass
+	 * @return false if there is no lazy depth
+	 */
+	external fun lazyDepthColormap(colormappedPixels: IntArray): Boolean
+
+	/**
+	 * Configures the skipping of inferences for frames that didn't change since the last inference
+	 * @param blockChangeThreshold luma difference (0.0f to 1.0f) above which a block counts as changed
+	 * @param maxChangedBlockFraction the inference is skipped if at most this fraction of blocks changed
+	 * @param warpCachedDepth reuse the depth for translating cameras, shifted by the global motion
+	 * @param maxReusedFrames forces an inference after this many consecutive reused frames
+	 */
+	external fun configureDepthMotionGate(
+		enabled: Boolean,
+		blockChangeThreshold: Float,
+		maxChangedBlockFraction: Float,
+		warpCachedDepth: Boolean,
+		maxReusedFrames: Int
+	)
+
+	/**
+	 * Normalizes the depth between percentiles of its histogram instead of its min and max, so a
+	 * few outlier pixels don't compress the range of the whole frame. Applied from the next
+	 * inference on, including the lazy inferences
+	 * @param lowPercentile fraction of the pixels that maps to 0.0f (clipped), e.g. 0.01f
+	 * @param highPercentile fraction of the pixels below 1.0f, e.g. 0.99f
+	 * @param boundsSmoothing weight of the bounds of a new frame against the previous bounds, 1.0f
+	 * disables the temporal smoothing
+	 */
+	external fun configureRobustNormalization(
+		enabled: Boolean,
+		lowPercentile: Float,
+		highPercentile: Float,
+		boundsSmoothing: Float
+	)
+
+	/** Number of bins of [depthHistogram], without the underflow and overflow */
+	const val DEPTH_HISTOGRAM_BIN_COUNT = 256
+
+	/**
+	 * Histogram of the raw output of the last inference with robust normalization
+	 * @param bins [DEPTH_HISTOGRAM_BIN_COUNT] + 2 pixel counts: the values below the bins, the bins
+	 * and the values above the bins
+	 * @param ranges 6 floats: range of the bins, range of the frame and the normalization bounds
+	 * @return false if robust normalization is disabled or there was no inference yet
+	 */
+	external fun depthHistogram(bins: IntArray, ranges: FloatArray): Boolean
+
+	/** Opens the persistent cache of depth maps for still images */
+	external fun openDepthCache(directory: String, maxBytes: Long)
+
+	/**
+	 * @param modelToken should change whenever the model file changes
+	 * @return content hash of the bitmap, the model parameters and the configured depth normalization
+	 * ([configureRobustNormalization]), for [depthCacheLoad] and [depthCacheStore], null if the
+	 * bitmap can't be read
+	 */
+	external fun depthCacheKey(
+		bitmap: Bitmap,
+		modelToken: String,
+		inputWidth: Int,
+		inputHeight: Int,
+		meanR: Float,
+		meanG: Float,
+		meanB: Float,
+		stddevR: Float,
+		stddevG: Float,
+		stddevB: Float
+	): LongArray?
+
+	/** @return false if the depth of this key is not cached */
+	external fun depthCacheLoad(key: LongArray, depth: FloatArray, width: Int, height: Int): Boolean
+
+	external fun depthCacheStore(key: LongArray, depth: FloatArray, width: Int, height: Int)
+
+	/**
+	 * Writes the depth as 16 bit grayscale png, compressed on a small native thread pool
+	 * @param depth values should be between 0.0f and 1.0f
+	 * @param fd writable file descriptor, e.g. [android.os.ParcelFileDescriptor.getFd] of a
+	 * MediaStore uri, it is not closed
+	 * @return false if the export failed
+	 */
+	external fun exportDepthPng(depth: FloatArray, width: Int, height: Int, fd: Int): Boolean
+
+	/**
+	 * Writes the unquantized float depth as pfm, see [exportDepthPng]
+	 * @return false if the export failed
+	 */
+	external fun exportDepthPfm(depth: FloatArray, width: Int, height: Int, fd: Int): Boolean
+
+	/**
+	 * Back-projects the depth into camera space points (x right, y down, z forward)
+	 * @param colors argb pixels of the depth size, or an empty array
+	 * @param fx focal length and principal point in pixels of the depth map
+	 * @param inverseDepth whether the values are inverse depth (the relative depth models)
+	 * @param scale metric depth = scale * value + shift (for inverse depth 1 / (scale * value + shift))
+	 * @param voxelSize points are averaged in voxels of this size, 0.0f disables the downsampling
+	 * @param outPoints 4 floats per point: x, y, z and the argb color ([Float.toRawBits]), should
+	 * be reused between frames
+	 * @return number of points written to outPoints
+	 */
+	external fun depthToPointCloud(
+		depth: FloatArray,
+		width: Int,
+		height: Int,
+		colors: IntArray,
+		fx: Float,
+		fy: Float,
+		cx: Float,
+		cy: Float,
+		inverseDepth: Boolean,
+		scale: Float,
+		shift: Float,
+		maxDepth: Float,
+		voxelSize: Float,
+		outPoints: FloatArray
+	): Int
+
+	/**
+	 * Creates the volume that [integrateTsdfFrame] fuses depth frames into, replacing the previous
+	 * one
+	 * @param voxelSize edge length of a voxel in meters
+	 * @param truncationDistance integrated distance around the surface, a few voxels
+	 * @param maxBlocks memory bound, 2 KiB per block of 8x8x8 voxels
+	 */
+	external fun createTsdfVolume(voxelSize: Float, truncationDistance: Float, maxBlocks: Int)
+
+	external fun releaseTsdfVolume()
+
+	/**
+	 * Fuses a depth frame into the volume, the depth parameters are the same as for
+	 * [depthToPointCloud]
+	 * @param cameraToWorld column major 4x4 pose of the camera ([android.opengl.Matrix] layout)
+	 */
+	external fun integrateTsdfFrame(
+		depth: FloatArray,
+		width: Int,
+		height: Int,
+		fx: Float,
+		fy: Float,
+		cx: Float,
+		cy: Float,
+		inverseDepth: Boolean,
+		scale: Float,
+		shift: Float,
+		maxDepth: Float,
+		cameraToWorld: FloatArray
+	)
+
+	/**
+	 * Extracts the surface of the volume and writes it as binary ply, see [exportDepthPng] for fd
+	 * @return false if the export failed
+	 */
+	external fun exportTsdfMesh(fd: Int): Boolean
+
+	/**
+	 * Upsamples the depth to the resolution of the guide image with a guided filter, so that depth
+	 * edges line up with the image edges
+	 * @param guide RGBA_8888 image the depth was predicted from
+	 * @param output guide.width * guide.height values
+	 * @param radius filter radius in depth pixels, doesn't change the cost
+	 * @param epsilon larger values smooth across weaker image edges
+	 */
+	external fun upsampleDepth(
+		depth: FloatArray,
+		depthWidth: Int,
+		depthHeight: Int,
+		guide: Bitmap,
+		output: FloatArray,
+		radius: Int,
+		epsilon: Float
 	)
 
+	/**
+	 * Blurs the image by the depth distance from the focus depth (synthetic depth of field), the
+	 * cost doesn't depend on the radius
+	 * @param image RGBA_8888 image the depth was predicted from
+	 * @param output mutable RGBA_8888 bitmap of the image size, can be reused between frames
+	 * @param focusDepth relative depth (0.0f to 1.0f) that stays sharp
+	 * @param focusRange depth distance around the focus depth that stays sharp
+	 * @param maxRadius blur radius in pixels at the largest depth distance
+	 */
+	external fun depthBokeh(
+		image: Bitmap,
+		depth: FloatArray,
+		depthWidth: Int,
+		depthHeight: Int,
+		output: Bitmap,
+		focusDepth: Float,
+		focusRange: Float,
+		maxRadius: Int
+	)
+
+	/**
+	 * Indexes the depth of every following inference for [depthRegionQueries], costs about two
+	 * passes over the depth per frame
+	 */
+	external fun configureDepthRegionIndex(enabled: Boolean)
+
+	/**
+	 * Statistics of rectangles of the last indexed depth, e.g. the depth of detected objects. Each
+	 * query takes the same time regardless of the rectangle size
+	 * @param regions 4 ints per rectangle: x, y, width and height in depth pixels, rectangles are
+	 * clipped to the depth map
+	 * @param percentile between 0.0f and 1.0f, e.g. 0.5f for the median (approximate, about 1/32
+	 * of the depth range)
+	 * @param results 4 floats per rectangle: mean, min, max and the percentile
+	 * @return false if no depth was indexed or a rectangle is outside of the depth map
+	 */
+	external fun depthRegionQueries(regions: IntArray, percentile: Float, results: FloatArray): Boolean
+
 	external fun depthColormap(depthValues: FloatArray, colormappedPixels: IntArray)
 
+	/**
+	 * Colormaps the depth straight into the pixels of the bitmap
+	 * @param bitmap mutable RGBA_8888 bitmap of the depth size
+	 * @param colormap [DepthColormap] ordinal
+	 * @param lutSize entries of the color lookup table, 1024 or 4096
+	 * @param minDepth depth of the first color, values outside are clamped
+	 * @param maxDepth depth of the last color
+	 */
+	external fun depthColormapBitmap(
+		depth: FloatArray,
+		width: Int,
+		height: Int,
+		bitmap: Bitmap,
+		colormap: Int,
+		lutSize: Int,
+		minDepth: Float,
+		maxDepth: Float
+	)
+
 	external fun bitmapToRgbChwFloatArray(bitmap: Bitmap, outFloatArray: FloatArray)
 
 	external fun bitmapToRgbHwc255FloatArray(bitmap: Bitmap, outFloatArray: FloatArray)
 
-	external fun imageBytesToArgbIntArray(imageBytes: ByteArray, outIntArray: IntArray)
+	/**
+	 * Also appends the image to the session recording, if one was started
+	 * @param timestampNs capture time of the image ([Image.getTimestamp])
+	 */
+	external fun imageBytesToArgbIntArray(
+		imageBytes: ByteArray,
+		width: Int,
+		height: Int,
+		rotationDegrees: Int,
+		timestampNs: Long,
+		outIntArray: IntArray
+	)
+
+	/**
+	 * Records all following camera images into a session file, which can be replayed with the
+	 * OfflineDepth tool to reproduce performance problems
+	 */
+	external fun startSessionRecording(path: String)
+
+	external fun stopSessionRecording()
+
+	/**
+	 * Records the depth output of all following inferences, quantized to 16 bit and losslessly
+	 * compressed (about 4x smaller than raw float depth for smooth depth maps)
+	 */
+	external fun startDepthRecording(path: String)
+
+	external fun stopDepthRecording()
 
 	/** @param input values should be between 0.0f and 1.0f */
-	fun depthColorMap(input: FloatArray, inputImageSize: Size): Bitmap {
+	fun depthColorMap(
+		input: FloatArray,
+		inputImageSize: Size,
+		colormap: DepthColormap = DepthColormap.INFERNO
+	): Bitmap {
+		val bitmap = Bitmap.createBitmap(
+			inputImageSize.width,
+			inputImageSize.height,
+			Bitmap.Config.ARGB_8888
+		)
 		if (input.size != inputImageSize.width * inputImageSize.height) {
 			Log.e(
 				DepthCameraApp.APP_LOG_TAG,
 				"input depth array length does not match output bitmap size"
 			)
-			return Bitmap.createBitmap(
-				inputImageSize.width,
-				inputImageSize.height,
-				Bitmap.Config.ARGB_8888
-			)
+			return bitmap
 		}
 
-		val colormappedPixels = IntArray(input.size)
-
-		depthColormap(input, colormappedPixels)
-
-		return Bitmap.createBitmap(
-			colormappedPixels,
+		depthColormapBitmap(
+			input,
 			inputImageSize.width,
 			inputImageSize.height,
-			Bitmap.Config.ARGB_8888
+			bitmap,
+			colormap.ordinal,
+			1024,
+			0.0f,
+			1.0f
 		)
+
+		return bitmap
+	}
+
+	fun upsampleDepth(depth: FloatArray, depthSize: Size, guide: Bitmap): FloatArray {
+		val output = FloatArray(guide.width * guide.height)
+
+		upsampleDepth(depth, depthSize.width, depthSize.height, guide, output, 4, 1e-4f)
+
+		return output
+	}
+
+	/** Bokeh focused on the depth at the image center, see [depthBokeh] */
+	fun depthBokeh(image: Bitmap, depth: FloatArray, depthSize: Size): Bitmap {
+		val output = Bitmap.createBitmap(image.width, image.height, Bitmap.Config.ARGB_8888)
+		val focusDepth = depth[(depthSize.height / 2) * depthSize.width + depthSize.width / 2]
+
+		depthBokeh(image, depth, depthSize.width, depthSize.height, output, focusDepth, 0.1f, 24)
+
+		return output
 	}
 
 	fun bitmapToRgbChwFloatArray(bitmap: Bitmap): FloatArray {
@@ -112,7 +498,14 @@ object NativeLib {
 
 		val pixels = IntArray(image.width * image.height)
 
-		imageBytesToArgbIntArray(pixelBytes, pixels)
+		imageBytesToArgbIntArray(
+			pixelBytes,
+			image.width,
+			image.height,
+			rotationDegrees.toInt(),
+			image.timestamp,
+			pixels
+		)
 
 		return rotateBitmap(
 			Bitmap.createBitmap(
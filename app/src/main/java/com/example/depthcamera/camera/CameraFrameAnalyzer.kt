@@ -2,6 +2,7 @@ package com.example.depthcamera.camera
 
 import android.annotation.SuppressLint
 import android.graphics.Bitmap
+import android.util.Size
 import android.widget.ImageView
 import android.widget.TextView
 import androidx.annotation.OptIn
@@ -11,6 +12,7 @@ import androidx.camera.core.ImageProxy
 import com.example.depthcamera.DepthCameraApp
 import com.example.depthcamera.NativeLib
 import com.example.depthcamera.depth.DepthModel
+import com.example.depthcamera.depth.DepthSource
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.asCoroutineDispatcher
@@ -32,26 +34,63 @@ class CameraFrameAnalyzer(
 
 	private var processingExecutor = Executors.newSingleThreadExecutor()
 	private var latestCameraFrame = AtomicReference<Bitmap?>(null)
+	private var pendingStillImage = AtomicReference<StillImage?>(null)
+
+	private class StillImage(val image: Bitmap, val onDepth: (Bitmap) -> Unit)
 
 	init {
 		CoroutineScope(processingExecutor.asCoroutineDispatcher()).launch {
 			while (isActive) {
+				// still images share the depth model with the camera frames, so they run here too
+				val stillImage = pendingStillImage.getAndSet(null)
+				if (stillImage != null) {
+					val prediction = depthCameraApp.depthCache.predictDepth(
+						depthCameraApp.depthModel,
+						DepthCameraApp.MODELS[depthCameraApp.selectedModelIndex],
+						stillImage.image
+					)
+					val colorMappedImage = NativeLib.depthColorMap(
+						prediction.depth,
+						depthCameraApp.depthModel.getInputSize()
+					)
+					withContext(Dispatchers.Main) {
+						stillImage.onDepth(colorMappedImage)
+					}
+				}
+
 				val frame = latestCameraFrame.getAndSet(null)
 
 				if (frame != null) {
 					NativeLib.newDepthFrame()
 
-					val predictionOutput = depthCameraApp.depthModel.predictDepth(frame)
+					val prediction = depthCameraApp.depthModel.predictDepth(frame)
 
 					val inputWidth = frame.width
 					val inputHeight = frame.height
 
+					// upsampled on this thread, the native buffers belong to the depth thread
+					val upsampledDepth =
+						if (DepthCameraApp.UPSAMPLE_DEPTH && prediction.source != DepthSource.REUSED)
+							NativeLib.upsampleDepth(
+								prediction.depth,
+								depthCameraApp.depthModel.getInputSize(),
+								frame
+							)
+						else null
+
 					withContext(Dispatchers.Main) {
-						val colorMappedImage = NativeLib.depthColorMap(
-							predictionOutput,
-							depthCameraApp.depthModel.getInputSize()
-						)
-						depthView.setImageBitmap(colorMappedImage)
+						// a reused depth is identical to the one that is already shown
+						if (prediction.source != DepthSource.REUSED) {
+							val colorMappedImage = if (upsampledDepth != null) {
+								NativeLib.depthColorMap(upsampledDepth, Size(inputWidth, inputHeight))
+							} else {
+								NativeLib.depthColorMap(
+									prediction.depth,
+									depthCameraApp.depthModel.getInputSize()
+								)
+							}
+							depthView.setImageBitmap(colorMappedImage)
+						}
 
 						val formattedInputResolution = "${inputWidth}x${inputHeight}"
 						val modelName = depthCameraApp.depthModel.getName()
@@ -59,13 +98,22 @@ class CameraFrameAnalyzer(
 						val formattedModelInputSize =
 							"${modelInputSize.width}x${modelInputSize.height}"
 						performanceText.text =
-							"Model: $modelName\nCamera resolution: $formattedInputResolution --> Model input: $formattedModelInputSize\n\n${NativeLib.formatDepthFrame()}\n${NativeLib.formatCameraFrame()}"
+							"Model: $modelName\nCamera resolution: $formattedInputResolution --> Model input: $formattedModelInputSize\nDepth: ${prediction.source.name.lowercase()}\n\n${NativeLib.formatDepthFrame()}\n${NativeLib.formatCameraFrame()}"
 					}
 				}
 			}
 		}
 	}
 
+	/**
+	 * Predicts the depth of a still image (e.g. a gallery photo) through the
+	 * [com.example.depthcamera.depth.DepthCache], so images that were seen before skip the model
+	 * @param onDepth receives the colormapped depth on the main thread
+	 */
+	fun predictStillImage(image: Bitmap, onDepth: (Bitmap) -> Unit) {
+		pendingStillImage.set(StillImage(image, onDepth))
+	}
+
 	@OptIn(ExperimentalGetImage::class)
 	override fun analyze(image: ImageProxy) {
 		if (image.image != null) {
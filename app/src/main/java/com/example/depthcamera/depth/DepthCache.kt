@@ -0,0 +1,48 @@
+package com.example.depthcamera.depth
+
+import android.content.Context
+import android.graphics.Bitmap
+import com.example.depthcamera.NativeLib
+import java.io.File
+
+/**
+ * Persistent cache of depth maps for still images (gallery photos), keyed by a hash of the pixels,
+ * the model and its preprocessing parameters. The least recently used depth maps are evicted once
+ * the cache grows beyond [maxBytes]
+ */
+class DepthCache(private val context: Context, maxBytes: Long = DEFAULT_MAX_BYTES) {
+	companion object {
+		const val DEFAULT_MAX_BYTES = 64L * 1024 * 1024
+	}
+
+	init {
+		NativeLib.openDepthCache(File(context.cacheDir, "depth_cache").path, maxBytes)
+	}
+
+	/** @return the cached depth of [input], or the prediction of [model] which is then cached */
+	fun predictDepth(model: DepthModel, modelInfo: DepthModelInfo, input: Bitmap): DepthPrediction {
+		val inputSize = model.getInputSize()
+		val key = NativeLib.depthCacheKey(
+			input,
+			getModelToken(context, modelInfo.fileName),
+			inputSize.width,
+			inputSize.height,
+			modelInfo.normMean[0],
+			modelInfo.normMean[1],
+			modelInfo.normMean[2],
+			modelInfo.normStddev[0],
+			modelInfo.normStddev[1],
+			modelInfo.normStddev[2]
+		) ?: return model.predictDepth(input)
+
+		val depth = FloatArray(inputSize.width * inputSize.height)
+		if (NativeLib.depthCacheLoad(key, depth, inputSize.width, inputSize.height))
+			return DepthPrediction(depth, DepthSource.CACHED)
+
+		// a reused or warped depth belongs to an earlier camera frame, not to this image
+		val prediction = model.predictDepth(input)
+		if (prediction.source == DepthSource.FRESH && prediction.depth.size == depth.size)
+			NativeLib.depthCacheStore(key, prediction.depth, inputSize.width, inputSize.height)
+		return prediction
+	}
+}
\ No newline at end of file
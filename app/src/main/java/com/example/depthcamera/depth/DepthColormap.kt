@@ -0,0 +1,10 @@
+package com.example.depthcamera.depth
+
+/** Colormaps of the depth preview, same order as the native Colormap enum */
+enum class DepthColormap {
+	INFERNO,
+	MAGMA,
+	VIRIDIS,
+	TURBO,
+	GRAYSCALE
+}
\ No newline at end of file
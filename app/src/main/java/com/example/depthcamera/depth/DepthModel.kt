@@ -42,15 +42,48 @@ class DepthModelInfo(
 	}
 }
 
+/** Where the depth of a frame came from, same order as the native DepthSource enum */
+enum class DepthSource {
+	/** the model was invoked for this frame */
+	FRESH,
+
+	/** the scene didn't change, the depth of the last inference was reused */
+	REUSED,
+
+	/** the camera moved, the depth of the last inference was shifted by the global motion */
+	WARPED,
+
+	/** the image was seen before, the depth was loaded from the [DepthCache] */
+	CACHED;
+
+	companion object {
+		fun fromNative(ordinal: Int): DepthSource = entries.getOrElse(ordinal) { FRESH }
+	}
+}
+
+class DepthPrediction(
+	/** relative depth for each pixel between 0.0f and 1.0f */
+	val depth: FloatArray,
+	val source: DepthSource
+)
+
 /** Base class that all depth estimation models implement */
 interface DepthModel : AutoCloseable {
 	fun getName(): String
 
 	/**
 	 * @param input is not enforced to match output of [getInputSize], but should be at least a bit larger
-	 * @return relative depth for each pixel between 0.0f and 1.0f
+	 * @return relative depth for each pixel between 0.0f and 1.0f, which may be reused from a previous
+	 * frame if the scene didn't change
+	 */
+	fun predictDepth(input: Bitmap): DepthPrediction
+
+	/**
+	 * Runs the model without normalizing the whole output, for consumers that only need the depth
+	 * at a few points, see [com.example.depthcamera.NativeLib.runDepthTfLiteLazyInference]
+	 * @return false if the inference failed
 	 */
-	fun predictDepth(input: Bitmap): FloatArray
+	fun predictLazyDepth(input: Bitmap): Boolean
 
 	/** @return preferred input image dimensions of the model */
 	fun getInputSize(): Size
@@ -63,6 +96,14 @@ fun createSerializedGpuDelegateCacheDirectory(context: Context): File {
 	return gpuDelegateCacheDirectory
 }
 
+/** holds the onnx models with their input normalization folded into the graph */
+fun createOnnxModelCacheDirectory(context: Context): File {
+	val onnxModelCacheDirectory = File(context.cacheDir, "onnx_model_cache")
+	if (!onnxModelCacheDirectory.exists())
+		onnxModelCacheDirectory.mkdirs()
+	return onnxModelCacheDirectory
+}
+
 private fun getLastAppUpdateTime(context: Context): Long {
 	try {
 		val packageInfo = context.packageManager.getPackageInfo(context.packageName, 0)
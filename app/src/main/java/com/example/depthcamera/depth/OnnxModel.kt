@@ -13,12 +13,50 @@ class OnnxModel(
 	val fileName: String,
 	val inputDim: Int,
 	val normMean: FloatArray,
-	val normStddev: FloatArray
+	val normStddev: FloatArray,
+	/**
+	 * Appends the colormapping to the model graph, the model then only supports
+	 * [predictDepthColormap]
+	 */
+	val displayColormap: DepthColormap? = null,
+	val displayDownscale: Int = 1
 ) : DepthModel {
 	init {
 		val modelData = context.assets.open(fileName).readBytes()
 
-		NativeLib.initDepthOnnxRuntime(modelData)
+		val modelCacheDirectory = createOnnxModelCacheDirectory(context)
+		val modelToken = getModelToken(context, fileName)
+
+		// cleanup models folded by older versions of the app
+		for (file in modelCacheDirectory.listFiles().orEmpty()) {
+			if (!file.name.contains(modelToken)) {
+				try {
+					Log.i(
+						DepthCameraApp.APP_LOG_TAG,
+						"Deleting old folded model: ${file.name}"
+					)
+					file.delete()
+				} catch (_: SecurityException) {
+				}
+			}
+		}
+
+		// normMean and normStddev have 3 elements, see DepthModelInfo.createDepthModel
+		NativeLib.initDepthOnnxRuntime(
+			modelData,
+			fileName,
+			modelCacheDirectory.path,
+			modelToken,
+			normMean[0],
+			normMean[1],
+			normMean[2],
+			normStddev[0],
+			normStddev[1],
+			normStddev[2],
+			displayColormap?.ordinal ?: -1,
+			1024,
+			displayDownscale
+		)
 	}
 
 	override fun close() {
@@ -29,21 +67,23 @@ class OnnxModel(
 
 	override fun getInputSize(): Size = Size(inputDim, inputDim)
 
-	override fun predictDepth(input: Bitmap): FloatArray {
+	override fun predictDepth(input: Bitmap): DepthPrediction {
 		if (normMean.size != 3 || normStddev.size != 3) {
 			Log.e(
 				DepthCameraApp.APP_LOG_TAG,
 				"normMean and normStddev should have exactly 3 elements for each rgb channel!"
 			)
-			return FloatArray(0)
+			return DepthPrediction(FloatArray(0), DepthSource.FRESH)
 		}
 
 		val scaled = input.scale(inputDim, inputDim)
 		val input = NativeLib.bitmapToRgbChwFloatArray(scaled)
 		var output = FloatArray(inputDim * inputDim)
 
-		NativeLib.runDepthOnnxInference(
+		val source = NativeLib.runDepthOnnxInference(
 			input,
+			inputDim,
+			inputDim,
 			output,
 			normMean[0],
 			normMean[1],
@@ -53,6 +93,59 @@ class OnnxModel(
 			normStddev[2]
 		)
 
-		return output
+		return DepthPrediction(output, DepthSource.fromNative(source))
+	}
+
+	override fun predictLazyDepth(input: Bitmap): Boolean {
+		if (normMean.size != 3 || normStddev.size != 3) {
+			Log.e(
+				DepthCameraApp.APP_LOG_TAG,
+				"normMean and normStddev should have exactly 3 elements for each rgb channel!"
+			)
+			return false
+		}
+
+		val scaled = input.scale(inputDim, inputDim)
+		val input = NativeLib.bitmapToRgbChwFloatArray(scaled)
+
+		return NativeLib.runDepthOnnxLazyInference(
+			input,
+			inputDim,
+			inputDim,
+			normMean[0],
+			normMean[1],
+			normMean[2],
+			normStddev[0],
+			normStddev[1],
+			normStddev[2]
+		)
+	}
+
+	/**
+	 * Runs a model created with [displayColormap], which outputs the colormapped depth directly
+	 * @return null if the inference failed
+	 */
+	fun predictDepthColormap(input: Bitmap): Bitmap? {
+		if (displayColormap == null || normMean.size != 3 || normStddev.size != 3) return null
+
+		val scaled = input.scale(inputDim, inputDim)
+		val input = NativeLib.bitmapToRgbChwFloatArray(scaled)
+		val outputDim = inputDim / displayDownscale
+		val pixels = IntArray(outputDim * outputDim)
+
+		if (!NativeLib.runDepthOnnxColormapInference(
+				input,
+				pixels,
+				normMean[0],
+				normMean[1],
+				normMean[2],
+				normStddev[0],
+				normStddev[1],
+				normStddev[2]
+			)
+		)
+			return null
+
+		return Bitmap.createBitmap(pixels, outputDim, outputDim, Bitmap.Config.ARGB_8888)
 	}
 }
\ No newline at end of file
@@ -53,21 +53,23 @@ class TfLiteDepthModel(
 
 	override fun getInputSize(): Size = Size(inputDim, inputDim)
 
-	override fun predictDepth(input: Bitmap): FloatArray {
+	override fun predictDepth(input: Bitmap): DepthPrediction {
 		if (normMean.size != 3 || normStddev.size != 3) {
 			Log.e(
 				DepthCameraApp.APP_LOG_TAG,
 				"normMean and normStddev should have exactly 3 elements for each rgb channel!"
 			)
-			return FloatArray(0)
+			return DepthPrediction(FloatArray(0), DepthSource.FRESH)
 		}
 
 		val scaled = input.scale(inputDim, inputDim)
 		val input = NativeLib.bitmapToRgbHwc255FloatArray(scaled)
 		var output = FloatArray(inputDim * inputDim)
 
-		NativeLib.runDepthTfLiteInference(
+		val source = NativeLib.runDepthTfLiteInference(
 			input,
+			inputDim,
+			inputDim,
 			output,
 			normMean[0],
 			normMean[1],
@@ -77,6 +79,31 @@ class TfLiteDepthModel(
 			normStddev[2]
 		)
 
-		return output
+		return DepthPrediction(output, DepthSource.fromNative(source))
+	}
+
+	override fun predictLazyDepth(input: Bitmap): Boolean {
+		if (normMean.size != 3 || normStddev.size != 3) {
+			Log.e(
+				DepthCameraApp.APP_LOG_TAG,
+				"normMean and normStddev should have exactly 3 elements for each rgb channel!"
+			)
+			return false
+		}
+
+		val scaled = input.scale(inputDim, inputDim)
+		val input = NativeLib.bitmapToRgbHwc255FloatArray(scaled)
+
+		return NativeLib.runDepthTfLiteLazyInference(
+			input,
+			inputDim,
+			inputDim,
+			normMean[0],
+			normMean[1],
+			normMean[2],
+			normStddev[0],
+			normStddev[1],
+			normStddev[2]
+		)
 	}
 }
\ No newline at end of file